@@ -106,7 +106,7 @@ struct tion3s_state_t {
   }
 
   enum { GATE_ERROR_NUM = 5 };
-  static std::string decode_errors(uint32_t errors);
+  static size_t decode_errors(uint32_t errors, char *buf, size_t size);
   static void report_errors(uint32_t errors);
 };
 
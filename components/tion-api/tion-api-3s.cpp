@@ -1,11 +1,15 @@
+#include "tion-api-defines.h"
+#ifdef TION_API_3S
 #include <cstring>
 #include <cinttypes>
 #include <cstdlib>
+#include <cstdio>
+#include <algorithm>
 
 #include "log.h"
 #include "utils.h"
 #include "tion-api-3s.h"
-#include "tion-api-defines.h"
+#include "tion-api-text.h"
 
 namespace dentra {
 namespace tion {
@@ -22,7 +26,7 @@ using tion::TionTraits;
 
 constexpr size_t ERRORS_COUNT = 17;
 
-static const char *const ERRORS[ERRORS_COUNT] = {
+constexpr const char *const ERRORS_TEXT[ERRORS_COUNT] = {
     // EC01
     "Температура воздуха на входе в устройство выше максимально допустимой",
     // EC02
@@ -58,20 +62,40 @@ static const char *const ERRORS[ERRORS_COUNT] = {
     // EC17
     "Замыкание в цепи датчика выходного (верхнего) датчика температуры",
 };
+constexpr const char *const ERRORS_DICT[] = {
+    "Температура воздуха на ",
+    " допустимой",
+    " максимально",
+    "Неисправность в цепи одного из датчиков температуры выходящего воздуха",
+    "Неисправность в цепи датчика температуры входящего воздуха",
+    "Блок заслонки из режима \"",
+    "\" не перешел в режим \"",
+    "Рециркуляция",
+    "Переохлаждение платы ",
+    " платы силовой",
+    " в цепи датчика выходного (верхнего) датчика температуры",
+    " устройств",
+};
+TION_TEXT_TABLE(ERRORS, ERRORS_TEXT, ERRORS_DICT);
 
-std::string tion3s_state_t::decode_errors(uint32_t errors) {
+size_t tion3s_state_t::decode_errors(uint32_t errors, char *buf, size_t size) {
+  if (buf == nullptr || size == 0) {
+    return 0;
+  }
   if (errors == 0) {
-    return {};
+    buf[0] = 0;
+    return 0;
   }
-
-  return "EC" + std::to_string(errors);
+  const int len = std::snprintf(buf, size, "EC%" PRIu32, errors);
+  return len < 0 ? 0 : std::min<size_t>(len, size - 1);
 }
 
 void tion3s_state_t::report_errors(uint32_t errors) {
   if (errors > 0) {
     uint8_t err = static_cast<uint8_t>(errors);
-    if (errors < ERRORS_COUNT) {
-      TION_REPORT_EC(tion::TAG, static_cast<int>(err), ERRORS[err - 1]);
+    char msg[ERRORS.buf_size];
+    if (ERRORS.get(errors - 1, msg, sizeof(msg))) {
+      TION_REPORT_EC(tion::TAG, static_cast<int>(err), msg);
     } else {
       TION_REPORT_EC_UNK(tion::TAG, static_cast<int>(err));
     }
@@ -105,10 +129,12 @@ void Tion3sApi::read_frame(uint16_t frame_type, const void *frame_data, size_t f
   // }
   if (frame_type == FRAME_TYPE_RSP(FRAME_TYPE_STATE_GET)) {
     TION_LOGD(TAG, "Response State Get");
+    this->write_slot_.ack();
     this->update_state_(*static_cast<const tion3s_state_t *>(frame_data));
     this->notify_state_(0);
   } else if (frame_type == FRAME_TYPE_RSP(FRAME_TYPE_STATE_SET)) {
     TION_LOGD(TAG, "Response State Set");
+    this->write_slot_.ack();
     this->update_state_(*static_cast<const tion3s_state_t *>(frame_data));
     this->notify_state_(0);
   } else if (frame_type == FRAME_TYPE_RSP(FRAME_TYPE_TIMERS_GET)) {
@@ -152,6 +178,17 @@ bool Tion3sApi::request_state_() const {
   return this->write_frame(FRAME_TYPE_REQ(FRAME_TYPE_STATE_GET));
 }
 
+void Tion3sApi::write_state(tion::TionStateCall *call) {
+  this->write_slot_.put(this->make_write_state_(call, this->write_slot_.get_base(this->state_)));
+}
+
+void Tion3sApi::flush_write() {
+  const auto now = tion::millis();
+  if (this->write_slot_.is_ready(now)) {
+    this->write_state_(this->write_slot_.take(now));
+  }
+}
+
 bool Tion3sApi::write_state_(const tion::TionState &state) const {
   TION_LOGD(TAG, "Request State Set");
   if (!state.is_initialized()) {
@@ -221,6 +258,7 @@ bool Tion3sApi::factory_reset_(const tion::TionState &state) const {
 Tion3sApi::Tion3sApi() {
   this->traits_.errors_decode = tion3s_state_t::decode_errors;
   this->traits_.errors_report = tion3s_state_t::report_errors;
+  this->traits_.errors_is_code = true;
 
   this->traits_.supports_sound_state = true;
   this->traits_.supports_gate_position_change = true;
@@ -306,3 +344,5 @@ void Tion3sApi::dump_state_(const tion_3s::tion3s_state_t &state) const {
 
 }  // namespace tion
 }  // namespace dentra
+
+#endif  // TION_API_3S
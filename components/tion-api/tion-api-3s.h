@@ -3,6 +3,7 @@
 #include <functional>
 
 #include "tion-api-writer.h"
+#include "tion-api-write-slot.h"
 #include "tion-api-3s-internal.h"
 
 namespace dentra {
@@ -20,11 +21,17 @@ class Tion3sApi : public TionApiBase, public tion::TionApiWriter {
 
   bool request_command4() const;
 
-  void request_state() override { this->request_state_(); }
-  void write_state(tion::TionStateCall *call) override { this->write_state_(this->make_write_state_(call)); }
-  void reset_filter() override { this->reset_filter_(this->state_); }
+  void request_state() TION_API_OVERRIDE { this->request_state_(); }
+  void write_state(tion::TionStateCall *call) TION_API_OVERRIDE;
+  void reset_filter() TION_API_OVERRIDE { this->reset_filter_(this->state_); }
+
+  /// Отправляет ожидающее в слоте записи состояние, если канал свободен.
+  void flush_write();
+  TionWriteSlot &write_slot() { return this->write_slot_; }
 
  protected:
+  TionWriteSlot write_slot_;
+
   bool request_state_() const;
   bool write_state_(const tion::TionState &state) const;
   bool reset_filter_(const tion::TionState &state) const;
@@ -1,11 +1,17 @@
+#include "tion-api-defines.h"
+#ifdef TION_API_4S
 #include <cstddef>
 #include <cmath>
 #include <cinttypes>
+#include <cstring>
 
 #include "log.h"
 #include "utils.h"
 #include "tion-api-4s.h"
-#include "tion-api-defines.h"
+#include "tion-api-text.h"
+#ifdef TION_ENABLE_UPDATE
+#include "crc.h"
+#endif
 
 namespace dentra {
 namespace tion_4s {
@@ -20,7 +26,7 @@ using tion::TionTraits;
 using tion::TionState;
 
 constexpr size_t ERRORS_COUNT = tion4s_state_t::ERROR_MAX_BIT - tion4s_state_t::ERROR_MIN_BIT + 1;
-static const char *const ERRORS[ERRORS_COUNT] = {
+constexpr const char *const ERRORS_TEXT[ERRORS_COUNT] = {
     // EC01
     "При движении заслонки целевой концевой выключатель не меняет состояние в отличие от исходного",
     // EC02
@@ -47,9 +53,23 @@ static const char *const ERRORS[ERRORS_COUNT] = {
     // EC11
     "Обрыв электрической цепи питания нагревателя",
 };
+constexpr const char *const ERRORS_DICT[] = {
+    "При движении заслонки ",
+    " не меняет состояние",
+    "Показания выходного датчика ",
+    " целевой температуры",
+    "и показания входного датчика меньше целевой температуры",
+    "Температура на выходе из устройства ",
+    " допустимой или замыкание на ",
+    " допустимой или обрыв на ",
+    " выходн",
+    " датчик",
+    "концев",
+};
+TION_TEXT_TABLE(ERRORS, ERRORS_TEXT, ERRORS_DICT);
 
 constexpr size_t WARNINGS_COUNT = tion4s_state_t::WARNING_MAX_BIT - tion4s_state_t::WARNING_MIN_BIT + 1;
-static const char *const WARNINGS[WARNINGS_COUNT] = {
+constexpr const char *const WARNINGS_TEXT[WARNINGS_COUNT] = {
     // WS01
     "Температура поступающего воздуха выше допустимого значения",
     // WS02
@@ -63,20 +83,30 @@ static const char *const WARNINGS[WARNINGS_COUNT] = {
     // WS06
     "Температура силовой платы ниже допустимого значения",
 };
+constexpr const char *const WARNINGS_DICT[] = {
+    "Температура ",
+    " допустимого значения",
+    "поступающего воздуха ",
+    "платы управления ",
+    "силовой платы ",
+};
+TION_TEXT_TABLE(WARNINGS, WARNINGS_TEXT, WARNINGS_DICT);
 
 void tion4s_state_t::report_errors(uint32_t errors) {
   tion::enum_errors(errors, tion4s_state_t::ERROR_MIN_BIT, tion4s_state_t::ERROR_MAX_BIT, nullptr,
                     [](uint8_t err, const void *) {
-                      if (err > 0 && (err - 1) < ERRORS_COUNT) {
-                        TION_REPORT_EC(TAG, err, ERRORS[err - 1]);
+                      char msg[ERRORS.buf_size];
+                      if (ERRORS.get(err - 1, msg, sizeof(msg))) {
+                        TION_REPORT_EC(TAG, err, msg);
                       } else {
                         TION_REPORT_EC_UNK(TAG, err);
                       }
                     });
   tion::enum_errors(errors, tion4s_state_t::WARNING_MIN_BIT, tion4s_state_t::WARNING_MAX_BIT, nullptr,
                     [](uint8_t err, const void *) {
-                      if (err > 0 && (err - 1) < WARNINGS_COUNT) {
-                        TION_REPORT_WS(TAG, err, WARNINGS[err - 1]);
+                      char msg[WARNINGS.buf_size];
+                      if (WARNINGS.get(err - 1, msg, sizeof(msg))) {
+                        TION_REPORT_WS(TAG, err, msg);
                       } else {
                         TION_REPORT_WS_UNK(TAG, err);
                       }
@@ -170,7 +200,19 @@ void Tion4sApi::read_frame(uint16_t frame_type, const void *frame_data, size_t f
     } else {
       auto *frame = static_cast<const RawTimerFrame *>(frame_data);
       TION_LOGD(TAG, "Response[%" PRIu32 "] Timer %u", frame->request_id, frame->data.timer_id);
+      const uint8_t timer_id = frame->data.timer_id;
+      if (timer_id < tion4s_timers_state_t::TIMERS_COUNT) {
+        this->timers_.timers[timer_id] = frame->data.timer;
+        // таймер уже установлен, запись не требуется
+        if ((this->timers_.write & (1 << timer_id)) &&
+            std::memcmp(&this->timers_.pending[timer_id], &frame->data.timer, sizeof(tion4s_timer_t)) == 0) {
+          this->timers_.write &= ~(1 << timer_id);
+        }
+      }
       this->on_timer.call_if(frame->data.timer_id, frame->data.timer, frame->request_id);
+      if (timer_id < tion4s_timers_state_t::TIMERS_COUNT) {
+        this->timers_update_(timer_id);
+      }
     }
     return;
   }
@@ -186,7 +228,9 @@ void Tion4sApi::read_frame(uint16_t frame_type, const void *frame_data, size_t f
     } else {
       auto *frame = static_cast<const RawTimersStateFrame *>(frame_data);
       TION_LOGD(TAG, "Response[%" PRIu32 "] Timers state", frame->request_id);
+      this->timers_.state = frame->data;
       this->on_timers_state.call_if(frame->data, frame->request_id);
+      this->timers_update_(TIMERS_STATE_BIT);
     }
     return;
   }
@@ -219,6 +263,11 @@ void Tion4sApi::read_frame(uint16_t frame_type, const void *frame_data, size_t f
     }
     return;
   }
+#endif
+#ifdef TION_ENABLE_UPDATE
+  if (this->update_read_frame_(frame_type, frame_data, frame_data_size)) {
+    return;
+  }
 #endif
   TION_LOGW(TAG, "Unsupported frame %04X: %s", frame_type, tion::hex_cstr(frame_data, frame_data_size));
 }
@@ -335,6 +384,104 @@ bool Tion4sApi::request_timers_state(const uint32_t request_id) const {
   return this->write_frame(FRAME_TYPE_TIMERS_STATE_REQ, req);
 }
 
+void Tion4sApi::timers_sync(bool force) {
+  this->timers_.read |= force ? TIMERS_ALL : TIMERS_ALL & ~this->timers_.valid;
+  this->timers_next_();
+}
+
+bool Tion4sApi::set_timer(uint8_t timer_id, const tion4s_timer_t &timer) {
+  if (timer_id >= tion4s_timers_state_t::TIMERS_COUNT) {
+    TION_LOGW(TAG, "Invalid timer %u", timer_id);
+    return false;
+  }
+  const uint16_t bit = 1 << timer_id;
+  if ((this->timers_.valid & bit) &&
+      std::memcmp(&this->timers_.timers[timer_id], &timer, sizeof(tion4s_timer_t)) == 0) {
+    // отменяем ранее запрошенную запись, если она еще не выполнена
+    this->timers_.write &= ~bit;
+    return false;
+  }
+  this->timers_.pending[timer_id] = timer;
+  this->timers_.write |= bit;
+  // сначала читаем таймер, запись будет отменена если значения совпадут
+  if (!(this->timers_.valid & bit)) {
+    this->timers_.read |= bit;
+  }
+  this->timers_next_();
+  return true;
+}
+
+const tion4s_timer_t *Tion4sApi::get_timer(uint8_t timer_id) const {
+  if (timer_id >= tion4s_timers_state_t::TIMERS_COUNT || !(this->timers_.valid & (1 << timer_id))) {
+    return nullptr;
+  }
+  return &this->timers_.timers[timer_id];
+}
+
+const tion4s_timers_state_t *Tion4sApi::get_timers_state() const {
+  return (this->timers_.valid & (1 << TIMERS_STATE_BIT)) ? &this->timers_.state : nullptr;
+}
+
+void Tion4sApi::timers_update_(uint8_t bit) {
+  this->timers_.valid |= 1 << bit;
+  this->timers_.read &= ~(1 << bit);
+  if (this->timers_.in_flight == bit) {
+    this->timers_.in_flight = TIMERS_NONE;
+    this->timers_.retries = 0;
+  }
+  this->timers_next_();
+}
+
+void Tion4sApi::timers_next_() {
+  auto &tmr = this->timers_;
+  if (tmr.in_flight != TIMERS_NONE) {
+    return;
+  }
+  // чтение выполняется раньше записи, чтобы не записывать уже установленные таймеры
+  for (uint8_t bit = 0; bit <= TIMERS_STATE_BIT; bit++) {
+    if (tmr.read & (1 << bit)) {
+      tmr.in_flight = bit;
+      tmr.in_flight_write = false;
+      tmr.time = tion::millis();
+      if (bit == TIMERS_STATE_BIT) {
+        this->request_timers_state(++this->request_id_);
+      } else {
+        this->request_timer(bit, ++this->request_id_);
+      }
+      return;
+    }
+  }
+  for (uint8_t timer_id = 0; timer_id < tion4s_timers_state_t::TIMERS_COUNT; timer_id++) {
+    if (tmr.write & (1 << timer_id)) {
+      tmr.write &= ~(1 << timer_id);
+      // перечитываем таймер и состояние таймеров после записи
+      tmr.read |= (1 << timer_id) | (1 << TIMERS_STATE_BIT);
+      tmr.in_flight = timer_id;
+      tmr.in_flight_write = true;
+      tmr.time = tion::millis();
+      TION_LOGD(TAG, "Write timer %u", timer_id);
+      this->write_timer(timer_id, tmr.pending[timer_id], ++this->request_id_);
+      return;
+    }
+  }
+}
+
+void Tion4sApi::timers_poll() {
+  auto &tmr = this->timers_;
+  if (tmr.in_flight == TIMERS_NONE || tion::millis() - tmr.time < TIMERS_TIMEOUT) {
+    return;
+  }
+  const uint8_t bit = tmr.in_flight;
+  tmr.in_flight = TIMERS_NONE;
+  // бризер может не отвечать на запись, результат будет получен повторным чтением
+  if (!tmr.in_flight_write && ++tmr.retries > TIMERS_MAX_RETRIES) {
+    TION_LOGW(TAG, "Timer %u request timeout", bit);
+    tmr.read &= ~(1 << bit);
+    tmr.retries = 0;
+  }
+  this->timers_next_();
+}
+
 bool Tion4sApi::set_time(time_t time, uint32_t request_id) const {
   const tion4s_raw_frame_t<tion4s_time_t> req{.request_id = request_id, .data = {.unix_time = time}};
   TION_LOGD(TAG, "Request[%" PRIu32 "] Time %lld", request_id, req.data.unix_time);
@@ -487,5 +634,212 @@ void Tion4sApi::boost_enable_native_(bool state) {
   this->set_turbo(this->traits_.boost_time, ++this->request_id_);
 }
 
+#ifdef TION_ENABLE_UPDATE
+using namespace tion::firmware;
+
+bool Tion4sApi::update_start(uint32_t size, update_reader_type &&reader, uint8_t window) {
+  auto state = this->update_.state;
+  if (state != UpdateState::IDLE && state != UpdateState::DONE && state != UpdateState::ERROR) {
+    TION_LOGW(TAG, "Update is already in progress");
+    return false;
+  }
+  if (size == 0 || !reader.is_valid()) {
+    TION_LOGW(TAG, "Invalid update image");
+    return false;
+  }
+  this->update_ = {};
+  this->update_.reader = reader;
+  this->update_.size = size;
+  this->update_.window = window == 0 ? 1 : window > UPDATE_MAX_WINDOW ? UPDATE_MAX_WINDOW : window;
+  this->update_.crc_sent = 0xFFFF;
+  this->update_.crc_acked = 0xFFFF;
+  TION_LOGI(TAG, "Update start: size=%" PRIu32 ", window=%u", size, this->update_.window);
+  this->update_set_state_(UpdateState::PREPARE);
+  return this->write_frame(FRAME_TYPE_UPDATE_PREPARE_REQ);
+}
+
+void Tion4sApi::update_cancel() {
+  if (this->update_.state != UpdateState::IDLE) {
+    TION_LOGW(TAG, "Update canceled at %" PRIu32, this->update_.acked);
+    this->update_set_state_(UpdateState::ERROR);
+  }
+}
+
+void Tion4sApi::update_poll() {
+  auto state = this->update_.state;
+  if (state == UpdateState::IDLE || state == UpdateState::DONE || state == UpdateState::ERROR) {
+    return;
+  }
+  if (tion::millis() - this->update_.time < UPDATE_TIMEOUT) {
+    return;
+  }
+  if (++this->update_.retries > UPDATE_MAX_RETRIES) {
+    TION_LOGW(TAG, "Update timeout at %" PRIu32, this->update_.acked);
+    this->update_set_state_(UpdateState::ERROR);
+    return;
+  }
+  TION_LOGW(TAG, "Update retry %u at %" PRIu32, this->update_.retries, this->update_.acked);
+  this->update_.time = tion::millis();
+  // do not use switch statement
+  if (state == UpdateState::PREPARE) {
+    this->write_frame(FRAME_TYPE_UPDATE_PREPARE_REQ);
+  } else if (state == UpdateState::START) {
+    this->update_send_info_(FRAME_TYPE_UPDATE_START_REQ);
+  } else if (state == UpdateState::CRC) {
+    this->update_send_crc_();
+  } else if (state == UpdateState::FINISH) {
+    this->update_send_info_(FRAME_TYPE_UPDATE_FINISH_REQ);
+  } else {
+    // бризер ожидает данные строго по порядку, продолжаем с последнего подтвержденного смещения
+    this->update_rewind_();
+    this->update_send_chunks_();
+  }
+}
+
+void Tion4sApi::update_set_state_(UpdateState state) {
+  this->update_.state = state;
+  this->update_.time = tion::millis();
+  this->on_update.call_if(state, this->update_.acked, this->update_.size);
+}
+
+void Tion4sApi::update_rewind_() {
+  this->update_.sent = this->update_.acked;
+  this->update_.crc_sent = this->update_.crc_acked;
+  this->update_.in_flight = 0;
+  this->update_.head = 0;
+  this->update_.state = UpdateState::CHUNKS;
+}
+
+bool Tion4sApi::update_send_info_(uint16_t frame_type) const {
+  FirmwareInfo info{.size = static_cast<uint32_t>(this->update_.size + sizeof(FirmwareInfo::data) +  //-//
+                                                  sizeof(FirmwareChunkCRC::crc))};
+  for (size_t i = 0; i < sizeof(info.data); i++) {
+    info.data[i] = i;
+  }
+  return this->write_frame(frame_type, info);
+}
+
+bool Tion4sApi::update_send_crc_() const {
+  // CRC, как и в кадре, передается в big-endian
+  const FirmwareChunkCRC crc{.crc = __builtin_bswap16(this->update_.crc_acked)};
+  // структура выровнена, поэтому отправляем только значимые поля
+  return this->write_frame(FRAME_TYPE_UPDATE_CHUNK_REQ, &crc, sizeof(crc.marker) + sizeof(crc.crc));
+}
+
+bool Tion4sApi::update_send_chunks_() {
+  auto &upd = this->update_;
+  while (upd.in_flight < upd.window && upd.sent < upd.size) {
+    FirmwareChunk chunk;
+    chunk.offset = upd.sent;
+    size_t size = upd.size - upd.sent;
+    if (size > sizeof(chunk.data)) {
+      size = sizeof(chunk.data);
+    }
+    size = upd.reader(upd.sent, chunk.data, size);
+    if (size == 0) {
+      TION_LOGW(TAG, "Update read failed at %" PRIu32, upd.sent);
+      this->update_set_state_(UpdateState::ERROR);
+      return false;
+    }
+    TION_LOGV(TAG, "Update chunk at %" PRIu32 ", size=%zu", upd.sent, size);
+    if (!this->write_frame(FRAME_TYPE_UPDATE_CHUNK_REQ, &chunk, sizeof(chunk.offset) + size)) {
+      // повторим по таймауту
+      return false;
+    }
+    upd.crc_sent = tion::crc16_ccitt_false(upd.crc_sent, chunk.data, size);
+    upd.sent += size;
+    auto &slot = upd.chunks[(upd.head + upd.in_flight) % UPDATE_MAX_WINDOW];
+    slot.end = upd.sent;
+    slot.crc = upd.crc_sent;
+    upd.in_flight++;
+  }
+  return true;
+}
+
+bool Tion4sApi::update_read_frame_(uint16_t frame_type, const void *frame_data, size_t frame_data_size) {
+  auto &upd = this->update_;
+  if (frame_type == FRAME_TYPE_UPDATE_PREPARE_RSP) {
+    if (upd.state != UpdateState::PREPARE) {
+      TION_LOGW(TAG, "Unexpected update prepare response");
+      return true;
+    }
+    if (frame_data_size == sizeof(FirmwareVersions)) {
+      auto *ver = static_cast<const FirmwareVersions *>(frame_data);
+      TION_LOGD(TAG, "Response Update prepare: device=%08" PRIX32 ", hardware=%04X", ver->device_type,
+                ver->hardware_version);
+    }
+    upd.retries = 0;
+    this->update_set_state_(UpdateState::START);
+    this->update_send_info_(FRAME_TYPE_UPDATE_START_REQ);
+    return true;
+  }
+
+  if (frame_type == FRAME_TYPE_UPDATE_START_RSP) {
+    if (upd.state != UpdateState::START) {
+      TION_LOGW(TAG, "Unexpected update start response");
+      return true;
+    }
+    TION_LOGD(TAG, "Response Update start");
+    upd.retries = 0;
+    this->update_set_state_(UpdateState::CHUNKS);
+    this->update_send_chunks_();
+    return true;
+  }
+
+  if (frame_type == FRAME_TYPE_UPDATE_CHUNK_RSP) {
+    if (upd.state == UpdateState::CRC) {
+      TION_LOGD(TAG, "Response Update crc");
+      upd.retries = 0;
+      this->update_set_state_(UpdateState::FINISH);
+      this->update_send_info_(FRAME_TYPE_UPDATE_FINISH_REQ);
+      return true;
+    }
+    if (upd.state != UpdateState::CHUNKS || upd.in_flight == 0) {
+      TION_LOGW(TAG, "Unexpected update chunk response");
+      return true;
+    }
+    // бризер отвечает по порядку, подтверждаем самую старую часть
+    const auto &slot = upd.chunks[upd.head];
+    upd.acked = slot.end;
+    upd.crc_acked = slot.crc;
+    upd.head = (upd.head + 1) % UPDATE_MAX_WINDOW;
+    upd.in_flight--;
+    upd.retries = 0;
+    upd.time = tion::millis();
+    this->on_update.call_if(upd.state, upd.acked, upd.size);
+    if (upd.acked < upd.size) {
+      this->update_send_chunks_();
+      return true;
+    }
+    TION_LOGD(TAG, "Update crc: %04X", upd.crc_acked);
+    this->update_set_state_(UpdateState::CRC);
+    this->update_send_crc_();
+    return true;
+  }
+
+  if (frame_type == FRAME_TYPE_UPDATE_FINISH_RSP) {
+    if (upd.state != UpdateState::FINISH) {
+      TION_LOGW(TAG, "Unexpected update finish response");
+      return true;
+    }
+    TION_LOGI(TAG, "Update finished: %" PRIu32 " bytes", upd.acked);
+    this->update_set_state_(UpdateState::DONE);
+    return true;
+  }
+
+  if (frame_type == FRAME_TYPE_UPDATE_ERROR) {
+    TION_LOGW(TAG, "Update error at %" PRIu32 ": %s", upd.acked, tion::hex_cstr(frame_data, frame_data_size));
+    if (upd.state != UpdateState::IDLE) {
+      this->update_set_state_(UpdateState::ERROR);
+    }
+    return true;
+  }
+
+  return false;
+}
+#endif
+
 }  // namespace tion_4s
 }  // namespace dentra
+
+#endif  // TION_API_4S
@@ -4,6 +4,9 @@
 
 #include "tion-api-writer.h"
 #include "tion-api-4s-internal.h"
+#ifdef TION_ENABLE_UPDATE
+#include "tion-api-firmware.h"
+#endif
 
 namespace dentra {
 namespace tion_4s {
@@ -67,21 +70,71 @@ class Tion4sApi : public tion::TionApiBase, public tion::TionApiWriter {
   /// Callback listener for response to request_timers_state command request.
   on_timers_state_type on_timers_state{};
 
+  /// Время ожидания ответа при синхронизации таймеров, мс.
+  static constexpr uint32_t TIMERS_TIMEOUT = 2000;
+  /// Количество повторов запроса таймера.
+  static constexpr uint8_t TIMERS_MAX_RETRIES = 3;
+
+  /// Синхронизирует кэш таймеров с бризером. force - перечитать уже полученные таймеры.
+  /// Запросы отправляются по одному, следующий - после ответа на предыдущий.
+  void timers_sync(bool force = false);
+  /// Устанавливает таймер. Запись выполняется только если таймер на бризере отличается.
+  /// Возвращает false, если таймер уже установлен.
+  bool set_timer(uint8_t timer_id, const tion4s_timer_t &timer);
+  /// Таймер из кэша, nullptr - таймер еще не получен.
+  const tion4s_timer_t *get_timer(uint8_t timer_id) const;
+  /// Состояние таймеров из кэша, nullptr - состояние еще не получено.
+  const tion4s_timers_state_t *get_timers_state() const;
+  /// Кэш таймеров синхронизирован и нет ожидающих записи таймеров.
+  bool is_timers_synced() const {
+    return this->timers_.valid == TIMERS_ALL && this->timers_.read == 0 && this->timers_.write == 0;
+  }
+  /// Проверка таймаутов синхронизации таймеров, необходимо вызывать периодически.
+  void timers_poll();
 #endif
 #ifdef TION_ENABLE_DIAGNOSTIC
   bool request_errors() const;
   bool request_test() const;
 #endif
 
+#ifdef TION_ENABLE_UPDATE
+  enum class UpdateState : uint8_t { IDLE, PREPARE, START, CHUNKS, CRC, FINISH, DONE, ERROR };
+  /// Читатель образа прошивки. Должен заполнить buf данными с указанного смещения
+  /// и вернуть количество прочитанных байт, 0 - ошибка чтения.
+  using update_reader_type = etl::delegate<size_t(uint32_t offset, uint8_t *buf, size_t size)>;
+  /// Callback listener for update progress.
+  using on_update_type = etl::delegate<void(UpdateState state, uint32_t offset, uint32_t size)>;
+
+  /// Максимальное количество неподтвержденных частей прошивки.
+  static constexpr uint8_t UPDATE_MAX_WINDOW = 8;
+  /// Время ожидания ответа при обновлении, мс.
+  static constexpr uint32_t UPDATE_TIMEOUT = 3000;
+  /// Количество повторов с последнего подтвержденного смещения.
+  static constexpr uint8_t UPDATE_MAX_RETRIES = 3;
+
+  /// Callback listener for update progress.
+  on_update_type on_update{};
+  /// Запускает обновление прошивки размером size байт.
+  /// window - количество частей, отправляемых без ожидания подтверждения.
+  bool update_start(uint32_t size, update_reader_type &&reader, uint8_t window = 4);
+  void update_cancel();
+  /// Проверка таймаутов, необходимо вызывать периодически.
+  void update_poll();
+  UpdateState get_update_state() const { return this->update_.state; }
+  uint32_t get_update_offset() const { return this->update_.acked; }
+#endif
+
   void enable_native_boost_support();
-  void request_state() override;
-  void write_state(tion::TionStateCall *call) override {
+  void request_state() TION_API_OVERRIDE;
+  void write_state(tion::TionStateCall *call) TION_API_OVERRIDE {
     this->write_state(this->make_write_state_(call), ++this->request_id_);
   }
-  void reset_filter() override { this->reset_filter(this->state_, ++this->request_id_); }
+  void reset_filter() TION_API_OVERRIDE { this->reset_filter(this->state_, ++this->request_id_); }
 
  protected:
-  void boost_enable_native_(bool state) override;
+  // вызов boost_enable_native_ из TION_API_IMPL
+  friend class tion::TionApiBase;
+  void boost_enable_native_(bool state) TION_API_OVERRIDE;
 
   bool request_turbo_() const;
   bool request_dev_info_() const;
@@ -91,6 +144,65 @@ class Tion4sApi : public tion::TionApiBase, public tion::TionApiWriter {
   void update_state_(const tion4s_state_t &state);
   void update_dev_info_(const tion::tion_dev_info_t &dev_info);
   void update_turbo_(const tion4s_turbo_t &turbo);
+
+#ifdef TION_ENABLE_SCHEDULER
+  // биты масок кэша: номер таймера, TIMERS_STATE_BIT - состояние таймеров
+  static constexpr uint8_t TIMERS_STATE_BIT = tion4s_timers_state_t::TIMERS_COUNT;
+  static constexpr uint16_t TIMERS_ALL = (1 << (TIMERS_STATE_BIT + 1)) - 1;
+  static constexpr uint8_t TIMERS_NONE = 0xFF;
+  struct {
+    tion4s_timer_t timers[tion4s_timers_state_t::TIMERS_COUNT]{};
+    // значения ожидающих записи таймеров
+    tion4s_timer_t pending[tion4s_timers_state_t::TIMERS_COUNT]{};
+    tion4s_timers_state_t state{};
+    // полученные от бризера значения
+    uint16_t valid{};
+    // ожидающие чтения
+    uint16_t read{};
+    // ожидающие записи
+    uint16_t write{};
+    // бит ожидающего ответа запроса или TIMERS_NONE
+    uint8_t in_flight{TIMERS_NONE};
+    bool in_flight_write{};
+    uint8_t retries{};
+    uint32_t time{};
+  } timers_{};
+
+  void timers_next_();
+  void timers_update_(uint8_t bit);
+#endif
+#ifdef TION_ENABLE_UPDATE
+  struct {
+    update_reader_type reader{};
+    UpdateState state{};
+    uint8_t window{};
+    uint8_t retries{};
+    // количество отправленных, но не подтвержденных частей
+    uint8_t in_flight{};
+    uint32_t size{};
+    // смещение следующей отправляемой части
+    uint32_t sent{};
+    // смещение, до которого данные подтверждены бризером
+    uint32_t acked{};
+    // crc отправленных и подтвержденных данных
+    uint16_t crc_sent{};
+    uint16_t crc_acked{};
+    uint32_t time{};
+    // смещение конца и crc на конец каждой неподтвержденной части
+    struct {
+      uint32_t end;
+      uint16_t crc;
+    } chunks[UPDATE_MAX_WINDOW]{};
+    uint8_t head{};
+  } update_{};
+
+  bool update_read_frame_(uint16_t frame_type, const void *frame_data, size_t frame_data_size);
+  void update_set_state_(UpdateState state);
+  bool update_send_info_(uint16_t frame_type) const;
+  bool update_send_crc_() const;
+  bool update_send_chunks_();
+  void update_rewind_();
+#endif
 };
 
 }  // namespace tion_4s
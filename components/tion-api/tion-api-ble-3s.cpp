@@ -1,3 +1,5 @@
+#include "tion-api-defines.h"
+#if (defined(TION_API_3S) && defined(TION_TRANSPORT_BLE)) || defined(TION_RC_3S)
 #include <utility>
 #include <cstring>
 #include <cstdlib>
@@ -43,13 +45,16 @@ bool Tion3sBleProtocol::read_data(const uint8_t *data, size_t size) {
   }
   if (size != sizeof(Tion3sRawBleFrame)) {
     TION_LOGW(TAG, "Invalid frame size %zu", size);
+    this->stats_.inc(TionProtocolStats::INVALID_SIZE);
     return false;
   }
   const auto *frame = reinterpret_cast<const Tion3sRawBleFrame *>(data);
   if (frame->magic != Tion3sRawBleFrame::FRAME_MAGIC) {
     TION_LOGW(TAG, "Invalid frame magic %02X", frame->magic);
+    this->stats_.inc(TionProtocolStats::INVALID_MAGIC);
     return false;
   }
+  this->stats_.inc(TionProtocolStats::RX_FRAMES);
   this->reader(*reinterpret_cast<const tion_any_frame_t *>(&frame->data), sizeof(frame->data));
   return true;
 }
@@ -63,8 +68,10 @@ bool Tion3sBleProtocol::write_frame(uint16_t frame_type, const void *frame_data,
   if (frame_data_size <= sizeof(frame.data.data)) {
     std::memcpy(frame.data.data, frame_data, frame_data_size);
   }
-  return this->writer(reinterpret_cast<const uint8_t *>(&frame), sizeof(frame));
+  return this->count_write_(this->writer(reinterpret_cast<const uint8_t *>(&frame), sizeof(frame)));
 }
 
 }  // namespace tion
 }  // namespace dentra
+
+#endif
@@ -1,3 +1,5 @@
+#include "tion-api-defines.h"
+#if ((defined(TION_API_LT) || defined(TION_API_4S)) && defined(TION_TRANSPORT_BLE)) || defined(TION_RC_4S)
 #include <utility>
 #include <cstring>
 #include <cstdlib>
@@ -55,36 +57,72 @@ bool TionLtBleProtocol::read_data(const uint8_t *data, size_t size) {
 
   if (pkt->type == TionLtRawBlePacket::TYPE_LONE) {
     TION_LOGV(TAG, "Packet LONE");
+    if (!this->rx_buf_.empty()) {
+      this->drop_rx_buf_();
+    }
     this->read_frame_(pkt->data, data_size);
     return true;
   }
 
   if (pkt->type == TionLtRawBlePacket::TYPE_FRST) {
     TION_LOGV(TAG, "Packet FRST");
-    this->rx_buf_.clear();
-    this->rx_buf_.insert(this->rx_buf_.end(), pkt->data, pkt->data + data_size);
-    return true;
+    if (!this->rx_buf_.empty()) {
+      this->drop_rx_buf_();
+    }
+    return this->append_rx_buf_(pkt->data, data_size);
   }
 
   if (pkt->type == TionLtRawBlePacket::TYPE_CURR) {
     TION_LOGV(TAG, "Packet CURR");
-    this->rx_buf_.insert(this->rx_buf_.end(), pkt->data, pkt->data + data_size);
-    return true;
+    if (this->rx_buf_.empty()) {
+      TION_LOGW(TAG, "Packet CURR without FRST");
+      this->stats_.inc(TionProtocolStats::REASSEMBLY_DROPS);
+      return false;
+    }
+    return this->append_rx_buf_(pkt->data, data_size);
   }
 
   if (pkt->type == TionLtRawBlePacket::TYPE_LAST) {
     TION_LOGV(TAG, "Packet LAST");
-    this->rx_buf_.insert(rx_buf_.end(), pkt->data, pkt->data + data_size);
+    if (this->rx_buf_.empty()) {
+      TION_LOGW(TAG, "Packet LAST without FRST");
+      this->stats_.inc(TionProtocolStats::REASSEMBLY_DROPS);
+      return false;
+    }
+    if (!this->append_rx_buf_(pkt->data, data_size)) {
+      return false;
+    }
     this->read_frame_(this->rx_buf_.data(), this->rx_buf_.size());
     this->rx_buf_.clear();
+#ifndef TION_NO_HEAP
     this->rx_buf_.shrink_to_fit();
+#endif
     return true;
   }
 
   TION_LOGW(TAG, "Unknown packet type 0x%02X", pkt->type);
+  this->stats_.inc(TionProtocolStats::UNKNOWN_TYPES);
   return false;
 }
 
+bool TionLtBleProtocol::append_rx_buf_(const uint8_t *data, size_t size) {
+#ifdef TION_NO_HEAP
+  if (this->rx_buf_.available() < size) {
+    TION_LOGW(TAG, "Frame is too large");
+    this->drop_rx_buf_();
+    return false;
+  }
+#endif
+  this->rx_buf_.insert(this->rx_buf_.end(), data, data + size);
+  return true;
+}
+
+void TionLtBleProtocol::drop_rx_buf_() {
+  TION_LOGW(TAG, "Drop incomplete frame: %s", hex_cstr(this->rx_buf_.data(), this->rx_buf_.size()));
+  this->stats_.inc(TionProtocolStats::REASSEMBLY_DROPS);
+  this->rx_buf_.clear();
+}
+
 // TODO remove return type
 bool TionLtBleProtocol::read_frame_(const void *data, uint32_t size) {
   TION_LOGV(TAG, "Read frame: %s", hex_cstr(data, size));
@@ -96,19 +134,23 @@ bool TionLtBleProtocol::read_frame_(const void *data, uint32_t size) {
   const TionLtRawBleFrame *frame = static_cast<const TionLtRawBleFrame *>(data);
   if (frame->magic != TionLtRawBleFrame::FRAME_MAGIC) {
     TION_LOGW(TAG, "Invalid frame magic: 0x%02X", frame->magic);
+    this->stats_.inc(TionProtocolStats::INVALID_MAGIC);
     return false;
   }
   if (frame->size != size) {
     TION_LOGW(TAG, "Invalid frame size: %u", frame->size);
+    this->stats_.inc(TionProtocolStats::INVALID_SIZE);
     return false;
   }
   if (this->rx_crc_) {
     const uint16_t crc = crc16_ccitt_false_ffff(frame, size);
     if (crc != 0) {
       TION_LOGW(TAG, "Invalid frame crc: %04X", crc);
+      this->stats_.inc(TionProtocolStats::CRC_ERRORS);
       return false;
     }
   }
+  this->stats_.inc(TionProtocolStats::RX_FRAMES);
   this->reader(*reinterpret_cast<const tion_any_ble_frame_t *>(&frame->data),
                frame->size - sizeof(TionLtRawBleFrame) + sizeof(tion_any_ble_frame_t));
   return true;
@@ -130,7 +172,7 @@ bool TionLtBleProtocol::write_frame(uint16_t frame_type, const void *frame_data,
   uint16_t crc = __builtin_bswap16(crc16_ccitt_false_ffff(tx_frame, sizeof(tx_buf) - sizeof(crc)));
   std::memcpy(&tx_frame->data.data[frame_data_size], &crc, sizeof(crc));
 
-  return this->write_packet_(tx_frame, sizeof(tx_buf));
+  return this->count_write_(this->write_packet_(tx_frame, sizeof(tx_buf)));
 }
 
 bool TionLtBleProtocol::write_packet_(const void *data, uint16_t size) const {
@@ -175,3 +217,5 @@ bool TionLtBleProtocol::write_packet_(const void *data, uint16_t size) const {
 
 }  // namespace tion
 }  // namespace dentra
+
+#endif
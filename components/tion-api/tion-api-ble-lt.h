@@ -1,5 +1,11 @@
 #pragma once
 
+#ifdef TION_NO_HEAP
+#include <etl/vector.h>
+#else
+#include <vector>
+#endif
+
 #include "tion-api-protocol.h"
 
 namespace dentra {
@@ -19,10 +25,19 @@ class TionLtBleProtocol : public TionProtocol<tion_any_ble_frame_t> {
 
  protected:
   bool rx_crc_;
+#ifdef TION_NO_HEAP
+  /// Максимальный размер собираемого кадра.
+  static constexpr size_t RX_BUF_SIZE = 128;
+  etl::vector<uint8_t, RX_BUF_SIZE> rx_buf_;
+#else
   std::vector<uint8_t> rx_buf_;
+#endif
 
   bool write_packet_(const void *data, uint16_t size) const;
   bool read_frame_(const void *data, uint32_t size);
+  /// Отбрасывает не собранный до конца кадр.
+  void drop_rx_buf_();
+  bool append_rx_buf_(const uint8_t *data, size_t size);
 };
 
 }  // namespace tion
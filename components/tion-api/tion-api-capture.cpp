@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "log.h"
+#include "utils.h"
+
+#include "tion-api-capture.h"
+
+namespace dentra {
+namespace tion {
+
+static const char *const TAG = "tion-api-capture";
+
+// байт в одной строке лога, см. tests/capture2bin.py
+static constexpr size_t LOG_CHUNK_SIZE = 32;
+
+// выводит данные строками "<prefix>:XX.XX..." без размера, чтобы tests/capture2bin.py собрал их обратно
+static void log_chunks(const char *prefix, const uint8_t *data, size_t size) {
+  char str[LOG_CHUNK_SIZE * 3];
+  for (size_t pos = 0; pos < size;) {
+    const size_t len = std::min(LOG_CHUNK_SIZE, size - pos);
+    char *p = str;
+    for (size_t i = 0; i < len; i++) {
+      p += std::sprintf(p, i == 0 ? "%02X" : ".%02X", data[pos + i]);
+    }
+    TION_LOGI(TAG, "%s:%s", prefix, str);
+    pos += len;
+  }
+}
+
+static size_t write_varint(uint8_t *buf, uint32_t value) {
+  size_t size = 0;
+  while (value >= 0x80) {
+    buf[size++] = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  buf[size++] = static_cast<uint8_t>(value);
+  return size;
+}
+
+size_t TionCapture::write_header(uint8_t *buf, Device device) {
+  std::memcpy(buf, MAGIC, sizeof(MAGIC));
+  buf[4] = VERSION;
+  buf[5] = device;
+  buf[6] = 0;
+  buf[7] = 0;
+  return HEADER_SIZE;
+}
+
+size_t TionCapture::write_record_head(uint8_t *buf, uint32_t delta, Direction dir, uint16_t type, size_t size) {
+  size_t pos = write_varint(buf, delta);
+  pos += write_varint(buf + pos, static_cast<uint32_t>(size << 1) | dir);
+  buf[pos++] = type & 0xFF;
+  buf[pos++] = type >> 8;
+  return pos;
+}
+
+TionCaptureWriter::TionCaptureWriter(size_t size, TionCapture::Device device)
+    : buf_(new uint8_t[size]), capacity_(size), device_(device) {}
+
+TionCaptureWriter::~TionCaptureWriter() { delete[] this->buf_; }
+
+void TionCaptureWriter::clear() {
+  this->head_ = 0;
+  this->used_ = 0;
+  this->last_time_ = 0;
+  this->records_ = 0;
+}
+
+void TionCaptureWriter::write(TionCapture::Direction dir, uint16_t type, const void *data, size_t size) {
+  const uint32_t now = tion::millis();
+  uint8_t head[TionCapture::RECORD_HEAD_MAX_SIZE];
+  const auto head_size =
+      TionCapture::write_record_head(head, this->records_ == 0 ? 0 : now - this->last_time_, dir, type, size);
+  this->last_time_ = now;
+
+  if (this->stream_) {
+    log_chunks("CAP", head, head_size);
+    log_chunks("CAP", static_cast<const uint8_t *>(data), size);
+  }
+
+  if (head_size + size > this->capacity_) {
+    this->skipped_++;
+    return;
+  }
+
+  if (this->drop_new_ && this->capacity_ - this->used_ < head_size + size) {
+    this->dropped_++;
+    return;
+  }
+
+  while (this->capacity_ - this->used_ < head_size + size) {
+    this->evict_();
+  }
+
+  this->put_(head, head_size);
+  this->put_(static_cast<const uint8_t *>(data), size);
+  this->records_++;
+}
+
+void TionCaptureWriter::put_(const uint8_t *data, size_t size) {
+  size_t pos = (this->head_ + this->used_) % this->capacity_;
+  while (size > 0) {
+    const size_t len = std::min(size, this->capacity_ - pos);
+    std::memcpy(this->buf_ + pos, data, len);
+    data += len;
+    size -= len;
+    this->used_ += len;
+    pos = 0;
+  }
+}
+
+size_t TionCaptureWriter::record_size(size_t offset) const {
+  if (offset >= this->used_) {
+    return 0;
+  }
+  size_t pos = offset;
+  // время
+  while (this->at_(pos++) & 0x80) {
+  }
+  // размер и направление
+  uint32_t size_dir = 0;
+  for (uint8_t shift = 0;; shift += 7) {
+    const uint8_t b = this->at_(pos++);
+    size_dir |= static_cast<uint32_t>(b & 0x7F) << shift;
+    if ((b & 0x80) == 0) {
+      break;
+    }
+  }
+  return pos - offset + sizeof(uint16_t) + (size_dir >> 1);
+}
+
+void TionCaptureWriter::evict_() {
+  this->consume(this->record_size(0));
+  this->records_--;
+  this->evicted_++;
+}
+
+size_t TionCaptureWriter::peek(const uint8_t *&data) const {
+  data = this->buf_ + this->head_;
+  return std::min(this->used_, this->capacity_ - this->head_);
+}
+
+void TionCaptureWriter::consume(size_t size) {
+  size = std::min(size, this->used_);
+  this->head_ = (this->head_ + size) % this->capacity_;
+  this->used_ -= size;
+}
+
+void TionCaptureWriter::copy(size_t offset, uint8_t *buf, size_t size) const {
+  for (size_t i = 0; i < size; i++) {
+    buf[i] = this->at_(offset + i);
+  }
+}
+
+size_t TionCaptureWriter::read(uint8_t *buf, size_t size) const {
+  if (size < TionCapture::HEADER_SIZE) {
+    return 0;
+  }
+  size_t pos = TionCapture::write_header(buf, this->device_);
+  const size_t len = std::min(size - pos, this->used_);
+  const size_t first = std::min(len, this->capacity_ - this->head_);
+  std::memcpy(buf + pos, this->buf_ + this->head_, first);
+  std::memcpy(buf + pos + first, this->buf_, len - first);
+  return pos + len;
+}
+
+void TionCaptureWriter::dump() const {
+  uint8_t buf[LOG_CHUNK_SIZE];
+  TionCapture::write_header(buf, this->device_);
+  log_chunks("CAPH", buf, TionCapture::HEADER_SIZE);
+  for (size_t pos = 0; pos < this->used_;) {
+    const size_t len = std::min(sizeof(buf), this->used_ - pos);
+    this->copy(pos, buf, len);
+    log_chunks("CAP", buf, len);
+    pos += len;
+  }
+}
+
+TionCaptureReader::TionCaptureReader(const void *data, size_t size)
+    : data_(static_cast<const uint8_t *>(data)), size_(size) {
+  if (size < TionCapture::HEADER_SIZE || std::memcmp(data, TionCapture::MAGIC, sizeof(TionCapture::MAGIC)) != 0) {
+    TION_LOGW(TAG, "Invalid capture header");
+    return;
+  }
+  if (this->data_[4] != TionCapture::VERSION) {
+    TION_LOGW(TAG, "Unsupported capture version %u", this->data_[4]);
+    return;
+  }
+  this->device_ = static_cast<TionCapture::Device>(this->data_[5]);
+  this->valid_ = true;
+  this->rewind();
+}
+
+void TionCaptureReader::rewind() {
+  this->pos_ = TionCapture::HEADER_SIZE;
+  this->time_ = 0;
+  this->first_ = true;
+}
+
+bool TionCaptureReader::read_varint_(uint32_t &value) {
+  value = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    if (this->pos_ >= this->size_) {
+      return false;
+    }
+    const uint8_t b = this->data_[this->pos_++];
+    value |= static_cast<uint32_t>(b & 0x7F) << shift;
+    if ((b & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TionCaptureReader::next(TionCapture::Record &rec) {
+  if (!this->valid_ || this->pos_ >= this->size_) {
+    return false;
+  }
+  uint32_t delta;
+  uint32_t size_dir;
+  if (!this->read_varint_(delta) || !this->read_varint_(size_dir)) {
+    TION_LOGW(TAG, "Truncated record at %zu", this->pos_);
+    return false;
+  }
+  const size_t size = size_dir >> 1;
+  if (this->size_ - this->pos_ < sizeof(uint16_t) + size) {
+    TION_LOGW(TAG, "Truncated record at %zu", this->pos_);
+    return false;
+  }
+  if (!this->first_) {
+    this->time_ += delta;
+  }
+  this->first_ = false;
+
+  rec.time = this->time_;
+  rec.dir = static_cast<TionCapture::Direction>(size_dir & 1);
+  rec.type = this->data_[this->pos_] | (this->data_[this->pos_ + 1] << 8);
+  rec.data = this->data_ + this->pos_ + sizeof(uint16_t);
+  rec.size = size;
+  this->pos_ += sizeof(uint16_t) + size;
+  return true;
+}
+
+}  // namespace tion
+}  // namespace dentra
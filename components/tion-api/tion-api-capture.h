@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace dentra {
+namespace tion {
+
+/// Компактный формат записи трафика между api и бризером.
+///
+/// Заголовок (8 байт): "TCAP", версия, тип бризера, 2 байта резерв.
+/// Далее записи:
+///   varint  - время от предыдущей записи, мс;
+///   varint  - (размер данных << 1) | направление (0 - RX от бризера, 1 - TX к бризеру);
+///   uint16  - тип кадра (little endian);
+///   данные кадра.
+/// Время первой записи не несет смысла и при воспроизведении игнорируется.
+struct TionCapture {
+  static constexpr uint8_t MAGIC[4] = {'T', 'C', 'A', 'P'};
+  static constexpr uint8_t VERSION = 1;
+  static constexpr size_t HEADER_SIZE = 8;
+  /// Максимальный размер заголовка записи: 2 varint по 5 байт и тип.
+  static constexpr size_t RECORD_HEAD_MAX_SIZE = 5 + 5 + 2;
+
+  enum Device : uint8_t { DEVICE_UNKNOWN = 0, DEVICE_3S, DEVICE_4S, DEVICE_LT, DEVICE_O2 };
+  enum Direction : uint8_t { DIR_RX = 0, DIR_TX = 1 };
+
+  struct Record {
+    /// Время записи относительно первой записи, мс.
+    uint32_t time;
+    Direction dir;
+    uint16_t type;
+    const uint8_t *data;
+    size_t size;
+  };
+
+  /// Записывает заголовок, возвращает его размер.
+  static size_t write_header(uint8_t *buf, Device device);
+  /// Записывает заголовок записи, возвращает его размер.
+  static size_t write_record_head(uint8_t *buf, uint32_t delta, Direction dir, uint16_t type, size_t size);
+};
+
+/// Запись трафика в кольцевой буфер. При переполнении вытесняются самые старые записи.
+/// Дополнительно каждая запись может выводиться в лог (см. tests/capture2bin.py).
+class TionCaptureWriter {
+ public:
+  TionCaptureWriter(size_t size, TionCapture::Device device);
+  ~TionCaptureWriter();
+
+  /// Выводить каждую запись в лог.
+  void set_stream(bool stream) { this->stream_ = stream; }
+  /// При переполнении отбрасывать новые записи вместо вытеснения старых.
+  /// Используется, когда буфер вычитывается потребителем через peek/consume.
+  void set_drop_new(bool drop_new) { this->drop_new_ = drop_new; }
+
+  void write(TionCapture::Direction dir, uint16_t type, const void *data, size_t size);
+  void rx(uint16_t type, const void *data, size_t size) { this->write(TionCapture::DIR_RX, type, data, size); }
+  void tx(uint16_t type, const void *data, size_t size) { this->write(TionCapture::DIR_TX, type, data, size); }
+
+  /// Размер данных в формате TionCapture (с заголовком).
+  size_t size() const { return TionCapture::HEADER_SIZE + this->used_; }
+  /// Копирует содержимое в формате TionCapture, возвращает количество скопированных байт.
+  size_t read(uint8_t *buf, size_t size) const;
+  /// Выводит содержимое буфера в лог.
+  void dump() const;
+  void clear();
+
+  /// Размер записанных данных без заголовка.
+  size_t used() const { return this->used_; }
+  /// Возвращает непрерывный участок данных от начала буфера и его размер.
+  size_t peek(const uint8_t *&data) const;
+  /// Удаляет size байт от начала буфера.
+  void consume(size_t size);
+  /// Полный размер записи, начинающейся со смещения offset.
+  size_t record_size(size_t offset) const;
+  /// Копирует size байт со смещения offset.
+  void copy(size_t offset, uint8_t *buf, size_t size) const;
+
+  uint32_t get_records() const { return this->records_; }
+  /// Количество вытесненных записей.
+  uint32_t get_evicted() const { return this->evicted_; }
+  /// Количество записей, не поместившихся в буфер целиком.
+  uint32_t get_skipped() const { return this->skipped_; }
+  /// Количество отброшенных записей в режиме drop_new.
+  uint32_t get_dropped() const { return this->dropped_; }
+
+ protected:
+  uint8_t *buf_;
+  size_t capacity_;
+  size_t head_{};
+  size_t used_{};
+  uint32_t last_time_{};
+  uint32_t records_{};
+  uint32_t evicted_{};
+  uint32_t skipped_{};
+  uint32_t dropped_{};
+  TionCapture::Device device_;
+  bool stream_{};
+  bool drop_new_{};
+
+  uint8_t at_(size_t pos) const { return this->buf_[(this->head_ + pos) % this->capacity_]; }
+  void put_(const uint8_t *data, size_t size);
+  void evict_();
+};
+
+/// Чтение записей формата TionCapture. Работает поверх непрерывного блока памяти,
+/// поэтому большие записи можно отобразить в память (mmap) без копирования.
+class TionCaptureReader {
+ public:
+  TionCaptureReader(const void *data, size_t size);
+
+  /// Корректен ли заголовок.
+  bool is_valid() const { return this->valid_; }
+  TionCapture::Device get_device() const { return this->device_; }
+
+  /// Читает очередную запись. false - записи закончились или данные повреждены.
+  bool next(TionCapture::Record &rec);
+  /// Данные закончились ровно на границе записи.
+  bool is_eof() const { return this->pos_ == this->size_; }
+  void rewind();
+
+ protected:
+  const uint8_t *data_;
+  size_t size_;
+  size_t pos_{};
+  uint32_t time_{};
+  bool first_{};
+  bool valid_{};
+  TionCapture::Device device_{};
+
+  bool read_varint_(uint32_t &value);
+};
+
+}  // namespace tion
+}  // namespace dentra
@@ -1,5 +1,48 @@
 #pragma once
 
+// Без TION_ENABLE_VIRTUAL_API методы API, записи кадров и чтения UART разрешаются при сборке
+// для единственного типа бризера и транспорта, см. TION_API_IMPL и TION_UART_READER_IMPL.
+#ifdef TION_ENABLE_VIRTUAL_API
+#define TION_API_VIRTUAL virtual
+#define TION_API_OVERRIDE override
+#else
+#define TION_API_VIRTUAL
+#define TION_API_OVERRIDE
+#endif
+
+// Тип бризера и транспорт задаются при генерации кода, в сборку попадает только выбранное.
+// Без явного выбора, например в тестах, собирается все.
+#if defined(TION_API_ALL) || \
+    !(defined(TION_API_3S) || defined(TION_API_4S) || defined(TION_API_LT) || defined(TION_API_O2))
+#ifndef TION_API_3S
+#define TION_API_3S
+#endif
+#ifndef TION_API_4S
+#define TION_API_4S
+#endif
+#ifndef TION_API_LT
+#define TION_API_LT
+#endif
+#ifndef TION_API_O2
+#define TION_API_O2
+#endif
+#ifndef TION_RC_3S
+#define TION_RC_3S
+#endif
+#ifndef TION_RC_4S
+#define TION_RC_4S
+#endif
+#endif
+
+#if defined(TION_API_ALL) || !(defined(TION_TRANSPORT_UART) || defined(TION_TRANSPORT_BLE))
+#ifndef TION_TRANSPORT_UART
+#define TION_TRANSPORT_UART
+#endif
+#ifndef TION_TRANSPORT_BLE
+#define TION_TRANSPORT_BLE
+#endif
+#endif
+
 #define TION_DEFAULT_MIN_TEMPERATURE 1
 #define TION_DEFAULT_MAX_TEMPERATURE 25
 #define TION_DEFAULT_BOOST_TIME 1200
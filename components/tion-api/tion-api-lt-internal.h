@@ -111,8 +111,8 @@ struct tionlt_state_t {
   // Байт 56.
   uint8_t test_type;
 
-  static std::string decode_errors(uint32_t errors) {
-    return tion::decode_errors(errors, ERROR_MIN_BIT, ERROR_MAX_BIT, WARNING_MIN_BIT, WARNING_MAX_BIT);
+  static size_t decode_errors(uint32_t errors, char *buf, size_t size) {
+    return tion::decode_errors(errors, buf, size, ERROR_MIN_BIT, ERROR_MAX_BIT, WARNING_MIN_BIT, WARNING_MAX_BIT);
   }
   static void report_errors(uint32_t errors);
 };
@@ -1,10 +1,12 @@
+#include "tion-api-defines.h"
+#ifdef TION_API_LT
 #include <cmath>
 #include <cinttypes>
 
 #include "log.h"
 #include "utils.h"
 #include "tion-api-lt.h"
-#include "tion-api-defines.h"
+#include "tion-api-text.h"
 
 namespace dentra {
 namespace tion {
@@ -17,7 +19,7 @@ static const char *const TAG = "tion-api-lt";
 namespace dentra {
 namespace tion_lt {
 constexpr size_t ERRORS_COUNT = tionlt_state_t::ERROR_MAX_BIT - tionlt_state_t::ERROR_MIN_BIT + 1;
-static const char *const ERRORS[ERRORS_COUNT] = {
+constexpr const char *const ERRORS_TEXT[ERRORS_COUNT] = {
     // EC01
     "Ошибка в работе заслонки",
     // EC02
@@ -41,9 +43,15 @@ static const char *const ERRORS[ERRORS_COUNT] = {
     // EC11
     "Ошибка работы нагревателя",
 };
+constexpr const char *const ERRORS_DICT[] = {
+    "Ошибка в работе заслонки",
+    "Ошибка работы нагревателя",
+    "Ошибка измерения температуры",
+};
+TION_TEXT_TABLE(ERRORS, ERRORS_TEXT, ERRORS_DICT);
 
 constexpr size_t WARNINGS_COUNT = tionlt_state_t::WARNING_MAX_BIT - tionlt_state_t::WARNING_MIN_BIT + 1;
-static const char *const WARNINGS[WARNINGS_COUNT] = {
+constexpr const char *const WARNINGS_TEXT[WARNINGS_COUNT] = {
     // WS01
     "Температура поступающего воздуха выше допустимого значения",
     // WS02
@@ -53,20 +61,29 @@ static const char *const WARNINGS[WARNINGS_COUNT] = {
     // WS04
     "Температура платы управления ниже допустимого значения",
 };
+constexpr const char *const WARNINGS_DICT[] = {
+    "Температура ",
+    " допустимого значения",
+    "поступающего воздуха ",
+    "платы управления ",
+};
+TION_TEXT_TABLE(WARNINGS, WARNINGS_TEXT, WARNINGS_DICT);
 
 void tionlt_state_t::report_errors(uint32_t errors) {
   tion::enum_errors(errors, tionlt_state_t::ERROR_MIN_BIT, tionlt_state_t::ERROR_MAX_BIT, nullptr,
                     [](uint8_t err, const void *) {
-                      if (err > 0 && (err - 1) < ERRORS_COUNT) {
-                        TION_REPORT_EC(tion::TAG, err, ERRORS[err - 1]);
+                      char msg[ERRORS.buf_size];
+                      if (ERRORS.get(err - 1, msg, sizeof(msg))) {
+                        TION_REPORT_EC(tion::TAG, err, msg);
                       } else {
                         TION_REPORT_EC_UNK(tion::TAG, err);
                       }
                     });
   tion::enum_errors(errors, tionlt_state_t::WARNING_MIN_BIT, tionlt_state_t::WARNING_MAX_BIT, nullptr,
                     [](uint8_t err, const void *) {
-                      if (err > 0 && (err - 1) < WARNINGS_COUNT) {
-                        TION_REPORT_WS(tion::TAG, err, WARNINGS[err - 1]);
+                      char msg[WARNINGS.buf_size];
+                      if (WARNINGS.get(err - 1, msg, sizeof(msg))) {
+                        TION_REPORT_WS(tion::TAG, err, msg);
                       } else {
                         TION_REPORT_WS_UNK(tion::TAG, err);
                       }
@@ -98,6 +115,7 @@ void TionLtApi::read_frame(uint16_t frame_type, const void *frame_data, size_t f
     } else {
       const auto *frame = static_cast<const tionlt_state_get_req_t *>(frame_data);
       TION_LOGD(TAG, "Response[%" PRIu32 "] State", frame->request_id);
+      this->write_slot_.ack();
       this->update_state_(frame->state);
       this->notify_state_(frame->request_id);
     }
@@ -215,6 +233,13 @@ void TionLtApi::fix_st_set_(tionlt_state_set_req_t *set) const {
   }
 }
 
+void TionLtApi::flush_write() {
+  const auto now = tion::millis();
+  if (this->write_slot_.is_ready(now)) {
+    this->write_state(this->write_slot_.take(now), ++this->request_id_);
+  }
+}
+
 void TionLtApi::request_state() {
   if (this->state_.firmware_version == 0) {
     this->request_dev_info_();
@@ -318,3 +343,5 @@ void TionLtApi::enable_kiv_support() { this->traits_.supports_kiv = true; }
 
 }  // namespace tion
 }  // namespace dentra
+
+#endif  // TION_API_LT
@@ -3,6 +3,7 @@
 #include <functional>
 
 #include "tion-api-writer.h"
+#include "tion-api-write-slot.h"
 #include "tion-api-lt-internal.h"
 #include "tion-api-defines.h"
 
@@ -24,15 +25,21 @@ class TionLtApi : public TionApiBase, public tion::TionApiWriter {
 
   void set_button_presets(const dentra::tion_lt::button_presets_t &button_presets);
 
-  void request_state() override;
-  void write_state(TionStateCall *call) override {
-    this->write_state(this->make_write_state_(call), ++this->request_id_);
+  void request_state() TION_API_OVERRIDE;
+  void write_state(TionStateCall *call) TION_API_OVERRIDE {
+    this->write_slot_.put(this->make_write_state_(call, this->write_slot_.get_base(this->state_)));
   }
-  void reset_filter() override { this->reset_filter(this->state_, ++this->request_id_); }
+  void reset_filter() TION_API_OVERRIDE { this->reset_filter(this->state_, ++this->request_id_); }
+
+  /// Отправляет ожидающее в слоте записи состояние, если канал свободен.
+  void flush_write();
+  TionWriteSlot &write_slot() { return this->write_slot_; }
 
   void enable_kiv_support();
 
  protected:
+  TionWriteSlot write_slot_;
+
   tion_lt::button_presets_t button_presets_{
       .tmp{
           TION_LT_BUTTON_PRESET_TMP1,
@@ -78,8 +78,8 @@ struct tiono2_state_t {
   // Байт 12,13. Остаток ресурса фильтра в секундах.
   uint32_t filter_time;
 
-  static std::string decode_errors(uint32_t errors) {
-    return tion::decode_errors(errors, ERROR_MIN_BIT, ERROR_MAX_BIT, 0, 0);
+  static size_t decode_errors(uint32_t errors, char *buf, size_t size) {
+    return tion::decode_errors(errors, buf, size, ERROR_MIN_BIT, ERROR_MAX_BIT, 0, 0);
   }
   static void report_errors(uint32_t errors);
 };
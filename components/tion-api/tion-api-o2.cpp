@@ -1,9 +1,11 @@
+#include "tion-api-defines.h"
+#ifdef TION_API_O2
 #include <cinttypes>
 
 #include "log.h"
 #include "utils.h"
 #include "tion-api-o2.h"
-#include "tion-api-defines.h"
+#include "tion-api-text.h"
 
 /*
 21.01.2023 20:58 (внешняя температура в мск T=-10 (0xF6) T=-12 (0xF4) Td=-13 (0xF3))
@@ -67,7 +69,7 @@ static const char *const TAG = "tion-api-uart-o2";
 static const uint8_t PROD[] = {0, TION_O2_AUTO_PROD};
 
 constexpr size_t ERRORS_COUNT = tiono2_state_t::ERROR_MAX_BIT - tiono2_state_t::ERROR_MIN_BIT + 1;
-static const char *const ERRORS[ERRORS_COUNT] = {
+constexpr const char *const ERRORS_TEXT[ERRORS_COUNT] = {
     // EC01
     "Температура входящего воздуха более +50 °C",
     // EC02
@@ -91,12 +93,25 @@ static const char *const ERRORS[ERRORS_COUNT] = {
     // EC11
     "Сбой передачи данных между силовой платой и платой управления",
 };
+constexpr const char *const ERRORS_DICT[] = {
+    "Температура ",
+    " воздуха",
+    " более +50 °C",
+    " в цепи датчика NTC температуры",
+    "Цепь датчика NTC температуры",
+    ", поступающего в прибор",
+    " короткозамкнута",
+    "температуры ",
+    " платы ",
+};
+TION_TEXT_TABLE(ERRORS, ERRORS_TEXT, ERRORS_DICT);
 
 void tiono2_state_t::report_errors(uint32_t errors) {
   enum_errors(errors, tiono2_state_t::ERROR_MIN_BIT, tiono2_state_t::ERROR_MAX_BIT, nullptr,
               [](uint8_t err, const void *) {
-                if (err > 0 && (err - 1) < ERRORS_COUNT) {
-                  TION_REPORT_EC(TAG, err, ERRORS[err - 1]);
+                char msg[ERRORS.buf_size];
+                if (ERRORS.get(err - 1, msg, sizeof(msg))) {
+                  TION_REPORT_EC(TAG, err, msg);
                 } else {
                   TION_REPORT_EC_UNK(TAG, err);
                 }
@@ -393,3 +408,5 @@ void TionO2Api::dump_state_(const tiono2_state_t &state) const {
 
 }  // namespace tion_o2
 }  // namespace dentra
+
+#endif  // TION_API_O2
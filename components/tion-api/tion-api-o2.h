@@ -28,9 +28,9 @@ class TionO2Api : public tion::TionApiBase, public tion::TionApiWriter {
 
   bool set_work_mode(WorkModeFlags work_mode) const;
 
-  void request_state() override;
-  void write_state(tion::TionStateCall *call) override;
-  void reset_filter() override { this->reset_filter(this->state_); }
+  void request_state() TION_API_OVERRIDE;
+  void write_state(tion::TionStateCall *call) TION_API_OVERRIDE;
+  void reset_filter() TION_API_OVERRIDE { this->reset_filter(this->state_); }
   /// отображение режима MA_CONNECTED и MA_AUTO на дисплее бризера.
   /// для того чтобы исключить моргание, необходимо вызывать не реже чем раз в 200мс.
   void update_work_mode();
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cinttypes>
 #include <etl/delegate.h>
 
@@ -24,10 +25,46 @@ template<class data_type> struct tion_ble_frame_t {
 
 using tion_any_ble_frame_t = tion_ble_frame_t<uint8_t[0]>;
 
+/// Счетчики состояния протокола.
+class TionProtocolStats {
+ public:
+  enum Counter : uint8_t {
+    // принятые кадры
+    RX_FRAMES,
+    // отправленные кадры
+    TX_FRAMES,
+    // ошибки контрольной суммы
+    CRC_ERRORS,
+    // неверный размер кадра
+    INVALID_SIZE,
+    // неверный маркер начала/конца кадра
+    INVALID_MAGIC,
+    // сброс состояния разбора после ошибки
+    RESYNCS,
+    // неизвестный тип кадра или пакета
+    UNKNOWN_TYPES,
+    // отброшенные при сборке из пакетов кадры
+    REASSEMBLY_DROPS,
+    // ответ не был получен вовремя
+    TIMEOUTS,
+    // ошибки записи
+    WRITE_ERRORS,
+    COUNTERS,
+  };
+
+  void inc(Counter counter) const { this->counters_[counter].fetch_add(1, std::memory_order_relaxed); }
+  uint32_t get(Counter counter) const { return this->counters_[counter].load(std::memory_order_relaxed); }
+
+ protected:
+  mutable std::atomic<uint32_t> counters_[COUNTERS]{};
+};
+
 template<class frame_spec_t> class TionProtocol {
  public:
   using frame_spec_type = frame_spec_t;
 
+  const TionProtocolStats &get_stats() const { return this->stats_; }
+
   using reader_type = etl::delegate<void(const frame_spec_t &data, size_t size)>;
   // TODO move to protected
   reader_type reader{};
@@ -37,6 +74,15 @@ template<class frame_spec_t> class TionProtocol {
   // TODO move to protected
   writer_type writer{};
   void set_writer(writer_type &&writer) { this->writer = writer; }
+
+ protected:
+  TionProtocolStats stats_;
+
+  /// Учитывает результат записи кадра.
+  bool count_write_(bool res) const {
+    this->stats_.inc(res ? TionProtocolStats::TX_FRAMES : TionProtocolStats::WRITE_ERRORS);
+    return res;
+  }
 };
 
 }  // namespace tion
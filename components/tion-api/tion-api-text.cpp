@@ -0,0 +1,57 @@
+#include "tion-api-text.h"
+
+namespace dentra {
+namespace tion {
+
+// пропускает count строк
+static const uint8_t *text_skip(const uint8_t *str, size_t count) {
+  while (count != 0) {
+    if (pgm_read_byte(str++) == 0) {
+      count--;
+    }
+  }
+  return str;
+}
+
+bool text_decode(const uint8_t *table, size_t index, char *buf, size_t size) {
+  if (buf == nullptr || size == 0) {
+    return false;
+  }
+  buf[0] = 0;
+  if (index >= pgm_read_byte(table)) {
+    return false;
+  }
+  const uint8_t *dict = table + 2;
+  const uint8_t *str = text_skip(dict, pgm_read_byte(table + 1) + index);
+  size_t len = 0;
+  for (uint8_t c; (c = pgm_read_byte(str++)) != 0;) {
+    if (c > text::DICT_MAX) {
+      if (len + 1 < size) {
+        buf[len++] = static_cast<char>(c);
+      }
+      continue;
+    }
+    for (const uint8_t *word = text_skip(dict, c - 1); (c = pgm_read_byte(word++)) != 0;) {
+      if (len + 1 < size) {
+        buf[len++] = static_cast<char>(c);
+      }
+    }
+  }
+  // при обрезке не оставляем неполный символ UTF-8
+  size_t lead = len;
+  while (lead > 0 && (static_cast<uint8_t>(buf[lead - 1]) & 0xC0) == 0x80) {
+    lead--;
+  }
+  if (lead > 0) {
+    const uint8_t c = buf[lead - 1];
+    const size_t need = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+    if (len - (lead - 1) < need) {
+      len = lead - 1;
+    }
+  }
+  buf[len] = 0;
+  return true;
+}
+
+}  // namespace tion
+}  // namespace dentra
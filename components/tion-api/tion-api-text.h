@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+
+#if defined(ESP8266)
+#include <pgmspace.h>
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t *>(addr))
+#endif
+#ifndef pgm_read_word
+#define pgm_read_word(addr) (*reinterpret_cast<const uint16_t *>(addr))
+#endif
+#ifndef strncpy_P
+#define strncpy_P strncpy
+#endif
+#ifndef strncmp_P
+#define strncmp_P strncmp
+#endif
+#ifndef snprintf_P
+#define snprintf_P snprintf
+#endif
+#endif
+
+namespace dentra {
+namespace tion {
+
+/// Декодирует строку index из упакованной таблицы TionTextTable в buf.
+/// Возвращает false, если строки нет, buf при этом содержит пустую строку.
+bool text_decode(const uint8_t *table, size_t index, char *buf, size_t size);
+
+namespace text {
+
+/// Ссылки на слова словаря кодируются байтами 1..DICT_MAX.
+constexpr uint8_t DICT_MAX = 31;
+
+constexpr size_t length(const char *s) {
+  size_t len = 0;
+  while (s[len] != 0) {
+    len++;
+  }
+  return len;
+}
+
+template<size_t D> constexpr size_t match(const char *s, const char *const (&dict)[D], size_t *word) {
+  size_t res = 0;
+  for (size_t i = 0; i < D; i++) {
+    size_t len = 0;
+    while (dict[i][len] != 0 && dict[i][len] == s[len]) {
+      len++;
+    }
+    if (dict[i][len] == 0 && len > res) {
+      res = len;
+      *word = i;
+    }
+  }
+  return res;
+}
+
+// строки подряд, каждая завершается '\0', вхождения слов словаря заменены ссылками
+template<size_t N, size_t D>
+constexpr size_t pack(const char *const (&strs)[N], const char *const (&dict)[D], uint8_t *out) {
+  size_t pos = 0;
+  for (size_t i = 0; i < N; i++) {
+    for (const char *s = strs[i]; *s != 0;) {
+      size_t word = 0;
+      const size_t len = match(s, dict, &word);
+      const uint8_t c = len > 1 ? word + 1 : static_cast<uint8_t>(*s);
+      s += len > 1 ? len : 1;
+      if (out) {
+        out[pos] = c;
+      }
+      pos++;
+    }
+    if (out) {
+      out[pos] = 0;
+    }
+    pos++;
+  }
+  return pos;
+}
+
+// байты 1..DICT_MAX (например \t, \n, \r) в исходных строках декодировались бы как ссылки словаря
+template<size_t N> constexpr bool is_plain(const char *const (&strs)[N]) {
+  for (size_t i = 0; i < N; i++) {
+    for (const char *s = strs[i]; *s != 0; s++) {
+      if (static_cast<uint8_t>(*s) <= DICT_MAX) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template<size_t N> constexpr size_t max_length(const char *const (&strs)[N]) {
+  size_t res = 0;
+  for (size_t i = 0; i < N; i++) {
+    if (length(strs[i]) > res) {
+      res = length(strs[i]);
+    }
+  }
+  return res;
+}
+
+// пустой словарь, таблица без сжатия
+constexpr const char *const NO_DICT[] = {""};
+
+}  // namespace text
+
+/// Таблица строк во флеш-памяти со сжатием по словарю часто встречающихся подстрок.
+/// Формат: кол-во строк, кол-во слов словаря, слова словаря, строки.
+template<size_t SIZE, size_t MAX_LEN> struct TionTextTable {
+  /// Размер буфера, достаточный для любой строки таблицы.
+  static constexpr size_t buf_size = MAX_LEN + 1;
+
+  uint8_t data[SIZE]{};
+
+  template<size_t N, size_t D>
+  constexpr TionTextTable(const char *const (&strs)[N], const char *const (&dict)[D]) {
+    static_assert(N <= UINT8_MAX, "Too many strings");
+    static_assert(D <= text::DICT_MAX, "Dictionary is too large");
+    this->data[0] = N;
+    this->data[1] = D;
+    const size_t dict_size = text::pack(dict, text::NO_DICT, this->data + 2);
+    text::pack(strs, dict, this->data + 2 + dict_size);
+  }
+
+  bool get(size_t index, char *buf, size_t size) const { return text_decode(this->data, index, buf, size); }
+};
+
+}  // namespace tion
+}  // namespace dentra
+
+/// Объявляет таблицу строк strs во флеш-памяти, dict - необязательный словарь для сжатия.
+#define TION_TEXT_TABLE(name, strs, ...) TION_TEXT_TABLE_(name, strs, ##__VA_ARGS__, dentra::tion::text::NO_DICT)
+#define TION_TEXT_TABLE_(name, strs, dict, ...) \
+  static_assert(dentra::tion::text::is_plain(strs) && dentra::tion::text::is_plain(dict), \
+                "Text table contains bytes reserved for dictionary references"); \
+  static constexpr dentra::tion::TionTextTable< \
+      2 + dentra::tion::text::pack(dict, dentra::tion::text::NO_DICT, nullptr) + \
+          dentra::tion::text::pack(strs, dict, nullptr), \
+      dentra::tion::text::max_length(strs)> \
+      name PROGMEM(strs, dict)
@@ -1,3 +1,5 @@
+#include "tion-api-defines.h"
+#if defined(TION_API_3S) && defined(TION_TRANSPORT_UART)
 #include <cstring>
 #include <cinttypes>
 
@@ -56,6 +58,7 @@ Tion3sUartProtocol::read_frame_result_t Tion3sUartProtocol::read_frame_(TionUart
     }
     if (frame->rx.head != this->head_type_) {
       TION_LOGW(TAG, "Unexpected byte: 0x%02X", frame->rx.head);
+      this->stats_.inc(TionProtocolStats::INVALID_MAGIC);
       return READ_THIS_LOOP;
     }
   }
@@ -67,7 +70,7 @@ Tion3sUartProtocol::read_frame_result_t Tion3sUartProtocol::read_frame_(TionUart
     }
     if (!io->read_array(&frame->rx.type, sizeof(frame->rx.type))) {
       TION_LOGW(TAG, "Failed read frame type");
-      this->reset_buf_();
+      this->resync_();
       return READ_THIS_LOOP;
     }
   }
@@ -80,7 +83,7 @@ Tion3sUartProtocol::read_frame_result_t Tion3sUartProtocol::read_frame_(TionUart
 
   if (!io->read_array(&frame->rx.data, tail_size)) {
     TION_LOGW(TAG, "Failed read frame data");
-    this->reset_buf_();
+    this->resync_();
     return READ_THIS_LOOP;
   }
 
@@ -88,10 +91,12 @@ Tion3sUartProtocol::read_frame_result_t Tion3sUartProtocol::read_frame_(TionUart
 
   if (frame->magic != FRAME_MAGIC_END) {
     TION_LOGW(TAG, "Invalid frame magic %02X", frame->magic);
-    this->reset_buf_();
+    this->stats_.inc(TionProtocolStats::INVALID_MAGIC);
+    this->resync_();
     return READ_THIS_LOOP;
   }
 
+  this->stats_.inc(TionProtocolStats::RX_FRAMES);
   tion::yield();
   this->reader(*reinterpret_cast<const tion_any_frame_t *>(&frame->data), sizeof(frame->data));
   this->reset_buf_();
@@ -112,8 +117,10 @@ bool Tion3sUartProtocol::write_frame(uint16_t frame_type, const void *frame_data
 
   TION_LOGV(TAG, "TX: %s", tion::hex_cstr(reinterpret_cast<uint8_t *>(&frame), sizeof(frame)));
 
-  return this->writer(reinterpret_cast<uint8_t *>(&frame), sizeof(frame));
+  return this->count_write_(this->writer(reinterpret_cast<uint8_t *>(&frame), sizeof(frame)));
 }
 
 }  // namespace tion
 }  // namespace dentra
+
+#endif
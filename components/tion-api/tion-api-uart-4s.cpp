@@ -1,3 +1,5 @@
+#include "tion-api-defines.h"
+#if defined(TION_API_4S) && defined(TION_TRANSPORT_UART)
 #include <utility>
 #include <cstring>
 #include <cstdlib>
@@ -50,6 +52,7 @@ Tion4sUartProtocol::read_frame_result_t Tion4sUartProtocol::read_frame_(TionUart
     }
     if (frame->magic != Tion4sRawUartFrame::FRAME_MAGIC) {
       TION_LOGW(TAG, "Unexpected byte: 0x%02X", frame->magic);
+      this->stats_.inc(TionProtocolStats::INVALID_MAGIC);
       return READ_THIS_LOOP;
     }
   }
@@ -62,14 +65,15 @@ Tion4sUartProtocol::read_frame_result_t Tion4sUartProtocol::read_frame_(TionUart
     }
     if (!io->read_array(&frame->size, frame_size_size)) {
       TION_LOGW(TAG, "Failed read frame size");
-      this->reset_buf_();
+      this->resync_();
       return READ_THIS_LOOP;
     }
   }
 
   if (frame->size < sizeof(Tion4sRawUartFrame) || frame->size > FRAME_MAX_SIZE) {
     TION_LOGW(TAG, "Invalid frame size %u", frame->size);
-    this->reset_buf_();
+    this->stats_.inc(TionProtocolStats::INVALID_SIZE);
+    this->resync_();
     return READ_THIS_LOOP;
   }
 
@@ -80,7 +84,7 @@ Tion4sUartProtocol::read_frame_result_t Tion4sUartProtocol::read_frame_(TionUart
   }
   if (!io->read_array(&frame->data.type, tail_size)) {
     TION_LOGW(TAG, "Failed read frame data");
-    this->reset_buf_();
+    this->resync_();
     return READ_THIS_LOOP;
   }
 
@@ -89,10 +93,12 @@ Tion4sUartProtocol::read_frame_result_t Tion4sUartProtocol::read_frame_(TionUart
   auto crc = dentra::tion::crc16_ccitt_false_ffff(frame, frame->size);
   if (crc != 0) {
     TION_LOGW(TAG, "Invalid CRC %04X for frame %s", crc, hex_cstr(frame, frame->size));
-    this->reset_buf_();
+    this->stats_.inc(TionProtocolStats::CRC_ERRORS);
+    this->resync_();
     return READ_NEXT_LOOP;
   }
 
+  this->stats_.inc(TionProtocolStats::RX_FRAMES);
   tion::yield();
   auto frame_data_size = frame->size - sizeof(Tion4sRawUartFrame) + sizeof(tion_any_frame_t);
   this->reader(*reinterpret_cast<const tion_any_frame_t *>(&frame->data), frame_data_size);
@@ -110,7 +116,7 @@ bool Tion4sUartProtocol::write_frame(uint16_t type, const void *data, size_t siz
   auto frame_size = sizeof(Tion4sRawUartFrame) + size;
   if (frame_size > FRAME_MAX_SIZE) {
     TION_LOGW(TAG, "Frame size is to large: %zu", size);
-    return false;
+    return this->count_write_(false);
   }
 
   uint8_t frame_buf[FRAME_MAX_SIZE];
@@ -125,8 +131,10 @@ bool Tion4sUartProtocol::write_frame(uint16_t type, const void *data, size_t siz
 
   TION_LOGV(TAG, "TX: %s", tion::hex_cstr(frame_buf, frame_size));
 
-  return this->writer(frame_buf, frame_size);
+  return this->count_write_(this->writer(frame_buf, frame_size));
 }
 
 }  // namespace tion
 }  // namespace dentra
+
+#endif
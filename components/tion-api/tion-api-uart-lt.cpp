@@ -1,15 +1,18 @@
+#include "tion-api-defines.h"
+#if defined(TION_API_LT) && defined(TION_TRANSPORT_UART)
 #include <utility>
 #include <cstring>
 #include <cstdlib>
 #include <cstdint>
+#include <cstdio>
 
 #include "utils.h"
 #include "log.h"
 
-#include "tion-api-defines.h"
 #include "tion-api-internal.h"
 #include "tion-api-lt-internal.h"
 #include "tion-api-uart-lt.h"
+#include "tion-api-text.h"
 
 /*
 logenable noit\r\n
@@ -37,59 +40,59 @@ namespace tion_lt {
 static const char *const TAG = "tion-api-uart-lt";
 
 // включение работы консоли
-static const char *const CMD_LOG_ENABLE = "logenable noit\r\n";
+static const char CMD_LOG_ENABLE[] PROGMEM = "logenable noit\r\n";
 // получение текущего состояния бризера
-static const char *const CMD_GET_STATE = "getstate\r\n";
+static const char CMD_GET_STATE[] PROGMEM = "getstate\r\n";
 // включение бризера
 // если была установлена скорость 0, то она автоматически изменится на 1
-static const char *const CMD_POWER_ON = "pon\r\n";
+static const char CMD_POWER_ON[] PROGMEM = "pon\r\n";
 // выключение бризера
-static const char *const CMD_POWER_OFF = "stby\r\n";
+static const char CMD_POWER_OFF[] PROGMEM = "stby\r\n";
 // включение обогревателя
-static const char *const CMD_SET_HEATER_ON = "set_heater_state 1\r\n";
+static const char CMD_SET_HEATER_ON[] PROGMEM = "set_heater_state 1\r\n";
 // выключение обогревателя
-static const char *const CMD_SET_HEATER_OFF = "set_heater_state 0\r\n";
+static const char CMD_SET_HEATER_OFF[] PROGMEM = "set_heater_state 0\r\n";
 // установка скорости вентилятора (доп параметр: скорость [0:6])
 // можно выставить 0 скорость, тогда заслонка останется открытой если бризер включен
-static const char *const CMD_SET_SPEED = "set_speed %u\r\n";
+static const char CMD_SET_SPEED[] PROGMEM = "set_speed %u\r\n";
 // установка температуры обогрева (доп параметр: температура [-128:127])
-static const char *const CMD_SET_TEMP = "set_temp %d\r\n";
+static const char CMD_SET_TEMP[] PROGMEM = "set_temp %d\r\n";
 // сброс до заводских настроек
-static const char *const CMD_FACTORY_RESET = "factoryreset\r\n";
+static const char CMD_FACTORY_RESET[] PROGMEM = "factoryreset\r\n";
 // сброс счетчика фильтра, устанавливает значение 15552000 (180 дней)
-static const char *const CMD_FILTER_RESET = "ftreset\r\n";
+static const char CMD_FILTER_RESET[] PROGMEM = "ftreset\r\n";
 // установка значения счетчика фильтра (доп параметр: кол-во секунд)
-static const char *const CMD_SET_FILTER_TIME = "set_filtertime %" PRIu32 "\r\n";
+static const char CMD_SET_FILTER_TIME[] PROGMEM = "set_filtertime %" PRIu32 "\r\n";
 // включение звуковых оповещений
-static const char *const CMD_SET_SOUND_STATE_ON = "set_sound_state 1\r\n";
+static const char CMD_SET_SOUND_STATE_ON[] PROGMEM = "set_sound_state 1\r\n";
 // выключение звуковых оповещений
-static const char *const CMD_SET_SOUND_STATE_OFF = "set_sound_state 0\r\n";
+static const char CMD_SET_SOUND_STATE_OFF[] PROGMEM = "set_sound_state 0\r\n";
 // включение световых оповещений
-static const char *const CMD_SET_LED_STATE_ON = "set_led_state 1\r\n";
+static const char CMD_SET_LED_STATE_ON[] PROGMEM = "set_led_state 1\r\n";
 // выключение световых оповещений
-static const char *const CMD_SET_LED_STATE_OFF = "set_led_state 0\r\n";
+static const char CMD_SET_LED_STATE_OFF[] PROGMEM = "set_led_state 0\r\n";
 
 //
 // Дополнительные неиспользуемые команды
 //
 
 // увеличение скорости вентиляции, не поднимает выше 6
-static const char *const CMD_SPEED_UP = "spup\r\n";
+static const char CMD_SPEED_UP[] PROGMEM = "spup\r\n";
 // уменьшение скорости вентиляции, не опускает ниже 1
-static const char *const CMD_SPEED_DOWN = "spdw\r\n";
+static const char CMD_SPEED_DOWN[] PROGMEM = "spdw\r\n";
 // увеличение целевой температуры нагрева, максимально 127
-static const char *const CMD_TEMP_UP = "tup\r\n";
+static const char CMD_TEMP_UP[] PROGMEM = "tup\r\n";
 // уменьшение целевой температуры нагрева, не опускает ниже 0
-static const char *const CMD_TEMP_DOWN = "tdw\r\n";
+static const char CMD_TEMP_DOWN[] PROGMEM = "tdw\r\n";
 // перезагрузка бризера
 // приведет к выключению бризера и отключает консоль
-static const char *const CMD_REBOOT = "reboot\r\n";
+static const char CMD_REBOOT[] PROGMEM = "reboot\r\n";
 // установка счетчика работы вентилятора (доп параметр кол-во секунд)
-static const char *const CMD_FAN_TIME = "set_worktime %" PRIu32 "\r\n";
+static const char CMD_FAN_TIME[] PROGMEM = "set_worktime %" PRIu32 "\r\n";
 // включение режима сопряжения BLE
-static const char *const CMD_BLE_PAIR = "pair\r\n";
+static const char CMD_BLE_PAIR[] PROGMEM = "pair\r\n";
 // отключает все подключенные BLE устройства
-static const char *const CMD_BLE_FORCE_DISCONNECT = "bledis\r\n";
+static const char CMD_BLE_FORCE_DISCONNECT[] PROGMEM = "bledis\r\n";
 // предположительно проводит внутренний тест
 // параметром запрашивает:
 // Set test type: need value
@@ -101,28 +104,28 @@ static const char *const CMD_BLE_FORCE_DISCONNECT = "bledis\r\n";
 // 4 - Triac test
 // 5 - LED test
 // 6 - Resourse test
-static const char *const CMD_SELF_TEST = "selftest\r\n";
+static const char CMD_SELF_TEST[] PROGMEM = "selftest\r\n";
 // предположительно проводит внутренний тест памяти, операция занимает продолжительное время,
 // по окончании выводит стандартный ответ состояния
-static const char *const CMD_MEMORY_TEST = "memtest\r\n";
+static const char CMD_MEMORY_TEST[] PROGMEM = "memtest\r\n";
 // результат работы команды неизвестен, команде требуются какие-то параметры
-static const char *const CMD_SET_PID = "set_pid\r\n";
+static const char CMD_SET_PID[] PROGMEM = "set_pid\r\n";
 // результат работы команды неизвестен, команде требуются какие-то параметры
-static const char *const CMD_GET_PID = "get_pid\r\n";
-
-#define ST_MODE "Current Mode: "
-#define ST_SPEED "Speed: "
-#define ST_SENS "Sensors T_set: "
-#define ST_HEAT "PID_Value: "
-#define ST_FLT_TIME "Filter Time: "
-#define ST_FAN_TIME "Working Time: "
-#define ST_WRK_TIME "Power On Time: "
-#define ST_ERROR "Error register:"
-#define ST_MAC "MAC: "
-#define ST_FIRM "Firmware Version 0x"
-
-#define ST_SENS_OUTDOOR ", T_In: "
-#define ST_SENS_INDOOR ", T_out: "
+static const char CMD_GET_PID[] PROGMEM = "get_pid\r\n";
+
+static const char ST_MODE[] PROGMEM = "Current Mode: ";
+static const char ST_SPEED[] PROGMEM = "Speed: ";
+static const char ST_SENS[] PROGMEM = "Sensors T_set: ";
+static const char ST_HEAT[] PROGMEM = "PID_Value: ";
+static const char ST_FLT_TIME[] PROGMEM = "Filter Time: ";
+static const char ST_FAN_TIME[] PROGMEM = "Working Time: ";
+static const char ST_WRK_TIME[] PROGMEM = "Power On Time: ";
+static const char ST_ERROR[] PROGMEM = "Error register:";
+static const char ST_MAC[] PROGMEM = "MAC: ";
+static const char ST_FIRM[] PROGMEM = "Firmware Version 0x";
+
+static const char ST_SENS_OUTDOOR[] PROGMEM = ", T_In: ";
+static const char ST_SENS_INDOOR[] PROGMEM = ", T_out: ";
 
 static const uint8_t PROD[] = {0, TION_LT_AUTO_PROD};
 
@@ -149,7 +152,7 @@ TionLtUartProtocol::read_frame_result_t TionLtUartProtocol::read_frame_(tion::Ti
   while (buf < end) {
     if (!io->read_array(buf, 1)) {
       TION_LOGW(TAG, "Failed read message");
-      this->reset_buf_();
+      this->resync_();
       return READ_NEXT_LOOP;
     }
     if (*buf == '\n') {
@@ -165,7 +168,8 @@ TionLtUartProtocol::read_frame_result_t TionLtUartProtocol::read_frame_(tion::Ti
 
   if (buf == end) {
     TION_LOGW(TAG, "Message is too long: %s", this->buf_);
-    this->reset_buf_();
+    this->stats_.inc(tion::TionProtocolStats::INVALID_SIZE);
+    this->resync_();
     return READ_NEXT_LOOP;
   }
 
@@ -176,30 +180,30 @@ TionLtUartProtocol::read_frame_result_t TionLtUartProtocol::read_frame_(tion::Ti
 
   auto *str = reinterpret_cast<const char *>(this->buf_);
   TION_LT_TRACE(TAG, "RX: %s", str);
-  if (std::strncmp(str, ST_MODE, sizeof(ST_MODE) - 1) == 0) {
+  if (strncmp_P(str, ST_MODE, sizeof(ST_MODE) - 1) == 0) {
     // StandBy or Work
     str = str + sizeof(ST_MODE) - 1;
     this->t_data.power_state = *str == 'W';  // "W" - is a first of "Work"
-  } else if (std::strncmp(str, ST_SPEED, sizeof(ST_SPEED) - 1) == 0) {
+  } else if (strncmp_P(str, ST_SPEED, sizeof(ST_SPEED) - 1) == 0) {
     str = str + sizeof(ST_SPEED) - 1;
     this->t_data.fan_speed = std::strtol(str, nullptr, 10);
     TION_LT_DUMP(TAG, "Got fan : %d", this->t_data.fan_speed);
-  } else if (std::strncmp(str, ST_SENS, sizeof(ST_SENS) - 1) == 0) {
+  } else if (strncmp_P(str, ST_SENS, sizeof(ST_SENS) - 1) == 0) {
     str = str + sizeof(ST_SENS) - 1;
     char *end{};
     this->t_data.target_temperature = std::strtol(str, &end, 10);
-    if ((str = end) && std::strncmp(str, ST_SENS_OUTDOOR, sizeof(ST_SENS_OUTDOOR) - 1) == 0) {
+    if ((str = end) && strncmp_P(str, ST_SENS_OUTDOOR, sizeof(ST_SENS_OUTDOOR) - 1) == 0) {
       str = end + sizeof(ST_SENS_OUTDOOR) - 1;
       end = {};
       this->t_data.outdoor_temperature = std::strtol(str, &end, 10);
-      if ((str = end) && std::strncmp(str, ST_SENS_INDOOR, sizeof(ST_SENS_INDOOR) - 1) == 0) {
+      if ((str = end) && strncmp_P(str, ST_SENS_INDOOR, sizeof(ST_SENS_INDOOR) - 1) == 0) {
         str = end + sizeof(ST_SENS_INDOOR) - 1;
         this->t_data.current_temperature = std::strtol(str, nullptr, 10);
       }
     }
     TION_LT_DUMP(TAG, "Got sens: target=%d, outdoor=%d, current=%d", this->t_data.target_temperature,
                  this->t_data.outdoor_temperature, this->t_data.current_temperature);
-  } else if (std::strncmp(str, ST_HEAT, sizeof(ST_HEAT) - 1) == 0) {
+  } else if (strncmp_P(str, ST_HEAT, sizeof(ST_HEAT) - 1) == 0) {
     str = str + sizeof(ST_HEAT) - 1;
     char *end{};
     this->t_data.heater_var = std::strtoul(str, &end, 10);
@@ -207,25 +211,26 @@ TionLtUartProtocol::read_frame_result_t TionLtUartProtocol::read_frame_(tion::Ti
       this->t_data.heater_state = std::strtoul(end, nullptr, 10);
     }
     TION_LT_DUMP(TAG, "Got heat: var=%u, state=%s", this->t_data.heater_var, ONOFF(this->t_data.heater_state));
-  } else if (std::strncmp(str, ST_FLT_TIME, sizeof(ST_FLT_TIME) - 1) == 0) {
+  } else if (strncmp_P(str, ST_FLT_TIME, sizeof(ST_FLT_TIME) - 1) == 0) {
     str = str + sizeof(ST_FLT_TIME) - 1;
     this->t_data.filter_time = std::strtoul(str, nullptr, 10);
     TION_LT_DUMP(TAG, "Got tflt: %s", str);
-  } else if (std::strncmp(str, ST_FAN_TIME, sizeof(ST_FAN_TIME) - 1) == 0) {
+  } else if (strncmp_P(str, ST_FAN_TIME, sizeof(ST_FAN_TIME) - 1) == 0) {
     str = str + sizeof(ST_FAN_TIME) - 1;
     const uint32_t fan_time = std::strtoul(str, nullptr, 10);
     // время работы вентилятора приходит после скорости, поэтому можно
     // рассчитать airflow_counter
-    const uint32_t dif_ft = fan_time - this->t_data.fan_time;
+    // счетчик бризера мог быть сброшен после восстановления сохраненного значения
+    const uint32_t dif_ft = fan_time >= this->t_data.fan_time ? fan_time - this->t_data.fan_time : 0;
     const uint32_t dif_ac = dif_ft * PROD[this->t_data.fan_speed] / tion_lt_state_counters_t::AK;
     this->t_data.airflow_counter += dif_ac;
     this->t_data.fan_time = fan_time;
     TION_LT_DUMP(TAG, "Got twrk: %s", str);
-  } else if (std::strncmp(str, ST_WRK_TIME, sizeof(ST_WRK_TIME) - 1) == 0) {
+  } else if (strncmp_P(str, ST_WRK_TIME, sizeof(ST_WRK_TIME) - 1) == 0) {
     str = str + sizeof(ST_WRK_TIME) - 1;
     this->t_data.work_time = std::strtoul(str, nullptr, 10);
     TION_LT_DUMP(TAG, "Got tpwr: %s", str);
-  } else if (std::strncmp(str, ST_ERROR, sizeof(ST_ERROR) - 1) == 0) {
+  } else if (strncmp_P(str, ST_ERROR, sizeof(ST_ERROR) - 1) == 0) {
     str = str + sizeof(ST_ERROR) - 1;
     TION_LT_DUMP(TAG, "Got err : %s", str);
     // это последняя нужная строка при получении состояния
@@ -250,8 +255,9 @@ TionLtUartProtocol::read_frame_result_t TionLtUartProtocol::read_frame_(tion::Ti
     frame.data.state.max_fan_speed = 6;
     // frame.data.state.pcb_temperature = INT8_MIN;
 
+    this->stats_.inc(tion::TionProtocolStats::RX_FRAMES);
     this->reader(*reinterpret_cast<const tion::tion_any_frame_t *>(&frame), sizeof(frame));
-  } else if (std::strncmp(str, ST_FIRM, sizeof(ST_FIRM) - 1) == 0) {
+  } else if (strncmp_P(str, ST_FIRM, sizeof(ST_FIRM) - 1) == 0) {
     str = str + sizeof(ST_FIRM) - 1;
     tion::tion_frame_t<tion::tion_dev_info_t> frame{
         .type = FRAME_TYPE_DEV_INFO_RSP,
@@ -264,9 +270,11 @@ TionLtUartProtocol::read_frame_result_t TionLtUartProtocol::read_frame_(tion::Ti
         },
     };
     TION_LT_DUMP(TAG, "Got frm : %04X", frame.data.firmware_version);
+    this->stats_.inc(tion::TionProtocolStats::RX_FRAMES);
     this->reader(*reinterpret_cast<const tion::tion_any_frame_t *>(&frame), sizeof(frame));
   } else {
     TION_LOGW(TAG, "Unsupported: %s", this->buf_);
+    this->stats_.inc(tion::TionProtocolStats::UNKNOWN_TYPES);
   }
 
   this->reset_buf_();
@@ -356,22 +364,42 @@ bool TionLtUartProtocol::write_frame(uint16_t type, const void *data, size_t siz
   return false;
 }
 
+// команды хранятся во флеш-памяти и копируются в буфер перед отправкой
 bool TionLtUartProtocol::write_cmd_(const char *cmd) {
-  TION_LT_TRACE(TAG, "TX: %s", cmd);
-  return this->writer(reinterpret_cast<const uint8_t *>(cmd), strlen(cmd));
+  char data[32];
+  strncpy_P(data, cmd, sizeof(data));
+  if (data[sizeof(data) - 1] != 0) {
+    data[sizeof(data) - 1] = 0;
+    TION_LOGW(TAG, "Command is too long: %s", data);
+    return false;
+  }
+  TION_LT_TRACE(TAG, "TX: %s", data);
+  return this->count_write_(this->writer(reinterpret_cast<const uint8_t *>(data), strlen(data)));
 }
 
 bool TionLtUartProtocol::write_cmd_(const char *cmd, int8_t param) {
-  const auto data = tion::str_sprintf(cmd, param);
-  TION_LT_TRACE(TAG, "TX: %s", data.c_str());
-  return this->writer(reinterpret_cast<const uint8_t *>(data.c_str()), data.length());
+  char data[32];
+  const int len = snprintf_P(data, sizeof(data), cmd, param);
+  if (len <= 0 || size_t(len) >= sizeof(data)) {
+    TION_LOGW(TAG, "Command is too long: %s", data);
+    return false;
+  }
+  TION_LT_TRACE(TAG, "TX: %s", data);
+  return this->count_write_(this->writer(reinterpret_cast<const uint8_t *>(data), len));
 }
 
 bool TionLtUartProtocol::write_cmd_(const char *cmd, uint32_t param) {
-  const auto data = tion::str_sprintf(cmd, param);
-  TION_LT_TRACE(TAG, "TX: %s", data.c_str());
-  return this->writer(reinterpret_cast<const uint8_t *>(data.c_str()), data.length());
+  char data[32];
+  const int len = snprintf_P(data, sizeof(data), cmd, param);
+  if (len <= 0 || size_t(len) >= sizeof(data)) {
+    TION_LOGW(TAG, "Command is too long: %s", data);
+    return false;
+  }
+  TION_LT_TRACE(TAG, "TX: %s", data);
+  return this->count_write_(this->writer(reinterpret_cast<const uint8_t *>(data), len));
 }
 
 }  // namespace tion_lt
 }  // namespace dentra
+
+#endif
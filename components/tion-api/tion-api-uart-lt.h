@@ -11,6 +11,13 @@ class TionLtUartProtocol : public tion::TionUartProtocolBase<45> {
 
   bool write_frame(uint16_t type, const void *data, size_t size);
 
+  /// Восстанавливает рассчитываемый счетчик воздуха, например после перезагрузки.
+  /// fan_time - время работы вентилятора на момент сохранения счетчика.
+  void restore_airflow_counter(uint32_t airflow_counter, uint32_t fan_time) {
+    this->t_data.airflow_counter = airflow_counter;
+    this->t_data.fan_time = fan_time;
+  }
+
  protected:
   struct {
     struct {
@@ -1,3 +1,5 @@
+#include "tion-api-defines.h"
+#if defined(TION_API_O2) && defined(TION_TRANSPORT_UART)
 #include <cstring>
 #include <cinttypes>
 
@@ -36,6 +38,7 @@ void TionO2UartProtocol::skip_uart_data_(tion::TionUartReader *io) {
     TION_LOGV(TAG, "Skipped %02X", *buf);
   }
   this->frame_size_ = 0;
+  this->stats_.inc(tion::TionProtocolStats::RESYNCS);
 }
 
 int TionO2UartProtocol::read_frame_(tion::TionUartReader *io) {
@@ -50,6 +53,7 @@ int TionO2UartProtocol::read_frame_(tion::TionUartReader *io) {
     this->frame_size_ = this->get_frame_size(frame->type);
     if (this->frame_size_ == 0) {
       TION_LOGW(TAG, "Unknown frame type [%02X]", frame->type);
+      this->stats_.inc(tion::TionProtocolStats::UNKNOWN_TYPES);
       this->skip_uart_data_(io);
       return READ_NEXT_LOOP;
     }
@@ -71,11 +75,13 @@ int TionO2UartProtocol::read_frame_(tion::TionUartReader *io) {
   if (crc != 0) {
     TION_LOGW(TAG, "Invalid CRC %02x for frame [%02X] data %s", crc, frame->type,
               tion::hex_cstr(frame->data, data_size));
+    this->stats_.inc(tion::TionProtocolStats::CRC_ERRORS);
     this->skip_uart_data_(io);
     return READ_NEXT_LOOP;
   }
 
   TION_LOGV(TAG, "RX: [%02X]:%s", frame->type, tion::hex_cstr(frame->data, data_size));
+  this->stats_.inc(tion::TionProtocolStats::RX_FRAMES);
   this->reader(*frame, data_size + frame->head_size());
   this->frame_size_ = 0;
   return READ_NEXT_LOOP;
@@ -95,7 +101,7 @@ bool TionO2UartProtocol::write_frame(uint16_t frame_type, const void *frame_data
   auto frame_size = sizeof(TionO2RawUartFrame) + frame_data_size;
   if (frame_size > FRAME_MAX_SIZE) {
     TION_LOGW(TAG, "Frame size is to large: %zu", frame_size);
-    return false;
+    return this->count_write_(false);
   }
 
   uint8_t frame_buf[FRAME_MAX_SIZE]{};
@@ -109,7 +115,7 @@ bool TionO2UartProtocol::write_frame(uint16_t frame_type, const void *frame_data
 
   TION_LOGV(TAG, "TX: %s", tion::hex_cstr(frame_buf, frame_size));
 
-  return this->writer(frame_buf, frame_size);
+  return this->count_write_(this->writer(frame_buf, frame_size));
 }
 
 uint8_t TionO2UartProtocol::crc(uint8_t init, const void *data, size_t size) const {
@@ -123,3 +129,5 @@ uint8_t TionO2UartProtocol::crc(uint8_t init, const void *data, size_t size) con
 
 }  // namespace tion_o2
 }  // namespace dentra
+
+#endif
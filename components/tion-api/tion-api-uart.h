@@ -2,6 +2,7 @@
 
 #include <cstring>  // std::memset
 
+#include "tion-api-defines.h"
 #include "tion-api-protocol.h"
 
 namespace dentra {
@@ -9,8 +10,14 @@ namespace tion {
 
 class TionUartReader {
  public:
+#ifdef TION_ENABLE_VIRTUAL_API
   virtual int available() = 0;
   virtual bool read_array(void *data, size_t size) = 0;
+#else
+  // определяются TION_UART_READER_IMPL для транспорта сборки
+  int available();
+  bool read_array(void *data, size_t size);
+#endif
 };
 
 template<size_t frame_max_size_value> class TionUartProtocolBase : public TionProtocol<tion_any_frame_t> {
@@ -25,7 +32,23 @@ template<size_t frame_max_size_value> class TionUartProtocolBase : public TionPr
   };
   uint8_t buf_[FRAME_MAX_SIZE]{};
   void reset_buf_() { std::memset(this->buf_, 0, sizeof(this->buf_)); }
+  /// Сброс состояния разбора после ошибки.
+  void resync_() {
+    this->stats_.inc(TionProtocolStats::RESYNCS);
+    this->reset_buf_();
+  }
 };
 
 }  // namespace tion
 }  // namespace dentra
+
+#ifdef TION_ENABLE_VIRTUAL_API
+#define TION_UART_READER_IMPL(...)
+#else
+/// Определяет чтение TionUartReader вызовом методов класса транспорта без виртуальной таблицы.
+#define TION_UART_READER_IMPL(...) \
+  int dentra::tion::TionUartReader::available() { return static_cast<__VA_ARGS__ *>(this)->available(); } \
+  bool dentra::tion::TionUartReader::read_array(void *data, size_t size) { \
+    return static_cast<__VA_ARGS__ *>(this)->read_array(data, size); \
+  }
+#endif
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+
+#include <etl/delegate.h>
+
+#include "tion-api.h"
+
+namespace dentra {
+namespace tion {
+
+/// Слот записи для протоколов передающих полный образ состояния (3S, LT).
+/// Хранит только последний ожидающий отправки образ, более старые отбрасываются.
+class TionWriteSlot {
+ public:
+  /// Время ожидания ответа на запись, после которого канал считается свободным, мс.
+  static constexpr uint32_t ACK_TIMEOUT = 1000;
+
+  /// Не отправлять следующий образ, пока не получен ответ на предыдущую запись.
+  void set_write_after_ack(bool write_after_ack) {
+    this->write_after_ack_ = write_after_ack;
+    if (!write_after_ack) {
+      this->sent_time_ = 0;
+    }
+  }
+  bool get_write_after_ack() const { return this->write_after_ack_; }
+
+  /// Количество отброшенных (перезаписанных более новыми) образов.
+  uint32_t get_dropped() const { return this->dropped_; }
+  /// Количество отправленных образов.
+  uint32_t get_written() const { return this->written_; }
+  /// Количество записей, ответ на которые так и не был получен.
+  uint32_t get_timeouts() const { return this->timeouts_; }
+
+  bool has_pending() const { return this->pending_; }
+
+  /// Источник метки записи (например, полосы арбитра), опрашивается при помещении образа в слот.
+  using tag_source_type = etl::delegate<uint8_t()>;
+  void set_tag_source(tag_source_type &&tag_source) { this->tag_source_ = tag_source; }
+  /// Метка ожидающего образа, наименьшая из меток объединенных в нем записей.
+  uint8_t get_tag() const { return this->tag_; }
+
+  /// Возвращает образ, на основе которого необходимо строить новую запись:
+  /// ожидающий отправки или отправленный, но еще не подтвержденный.
+  const TionState &get_base(const TionState &state) const {
+    return this->pending_ || this->sent_time_ != 0 ? this->image_ : state;
+  }
+
+  /// Помещает образ в слот. Неотправленный ранее образ отбрасывается.
+  void put(const TionState &state) {
+    const uint8_t tag = this->tag_source_ ? this->tag_source_() : 0;
+    if (this->pending_) {
+      this->dropped_++;
+      if (tag < this->tag_) {
+        this->tag_ = tag;
+      }
+    } else {
+      this->tag_ = tag;
+    }
+    this->image_ = state;
+    this->pending_ = true;
+  }
+
+  /// Проверяет можно ли отправить ожидающий образ в текущий момент.
+  bool is_ready(uint32_t now) {
+    if (!this->pending_) {
+      return false;
+    }
+    if (!this->write_after_ack_ || this->sent_time_ == 0) {
+      return true;
+    }
+    if (now - this->sent_time_ < ACK_TIMEOUT) {
+      return false;
+    }
+    this->timeouts_++;
+    this->sent_time_ = 0;
+    return true;
+  }
+
+  /// Забирает ожидающий образ для отправки.
+  const TionState &take(uint32_t now) {
+    this->pending_ = false;
+    // без ожидания подтверждения отправленный образ не используется как основа следующей записи
+    if (this->write_after_ack_) {
+      this->sent_time_ = now == 0 ? 1 : now;
+    }
+    this->written_++;
+    return this->image_;
+  }
+
+  /// Подтверждение записи. Бризер отвечает на запросы по порядку, поэтому
+  /// любой полученный после записи ответ с состоянием считается подтверждением.
+  void ack() { this->sent_time_ = 0; }
+
+ protected:
+  TionState image_{};
+  tag_source_type tag_source_{};
+  uint32_t sent_time_{};
+  uint32_t dropped_{};
+  uint32_t written_{};
+  uint32_t timeouts_{};
+  bool pending_{};
+  bool write_after_ack_{};
+  uint8_t tag_{};
+};
+
+}  // namespace tion
+}  // namespace dentra
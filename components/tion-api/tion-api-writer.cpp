@@ -10,11 +10,15 @@ static const char *const TAG = "tion-api-writer";
 
 bool TionApiWriter::write_frame(uint16_t type, const void *data, size_t size) const {
   TION_LOGV(TAG, "Write frame 0x%04X: %s", type, hex_cstr(data, size));
+#ifdef TION_ENABLE_VIRTUAL_API
   if (!this->writer_) {
     TION_LOGE(TAG, "Writer is not configured");
     return false;
   }
   return this->writer_(type, data, size);
+#else
+  return this->write_frame_impl_(type, data, size);
+#endif
 }
 
 }  // namespace tion
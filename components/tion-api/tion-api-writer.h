@@ -5,13 +5,17 @@
 #include <cinttypes>
 #include <etl/delegate.h>
 
+#include "tion-api-defines.h"
+
 namespace dentra {
 namespace tion {
 
 class TionApiWriter {
  public:
+#ifdef TION_ENABLE_VIRTUAL_API
   using writer_type = etl::delegate<bool(uint16_t type, const void *data, size_t size)>;
   void set_writer(writer_type &&writer) { this->writer_ = writer; }
+#endif
 
   // Write any frame data.
   bool write_frame(uint16_t type, const void *data, size_t size) const;
@@ -24,8 +28,24 @@ class TionApiWriter {
   }
 
  protected:
+#ifdef TION_ENABLE_VIRTUAL_API
   writer_type writer_{};
+#else
+  // определяется TION_API_WRITER_IMPL для типа API сборки
+  bool write_frame_impl_(uint16_t type, const void *data, size_t size) const;
+#endif
 };
 
 }  // namespace tion
 }  // namespace dentra
+
+#ifdef TION_ENABLE_VIRTUAL_API
+#define TION_API_WRITER_IMPL(...)
+#else
+/// Определяет запись кадров TionApiWriter вызовом write_frame_ класса-обертки API без etl::delegate.
+#define TION_API_WRITER_IMPL(...) \
+  bool dentra::tion::TionApiWriter::write_frame_impl_(uint16_t type, const void *data, size_t size) const { \
+    using impl_type = __VA_ARGS__; \
+    return const_cast<impl_type *>(static_cast<const impl_type *>(this))->write_frame_(type, data, size); \
+  }
+#endif
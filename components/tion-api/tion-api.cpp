@@ -1,6 +1,7 @@
 #include <cstdint>
 #include <cstring>
 #include <cinttypes>
+#include <cstdio>
 
 #include "utils.h"
 #include "log.h"
@@ -17,29 +18,20 @@ static const char *const TAG = "tion-api";
 void report_errors(uint32_t errors, uint8_t error_min_bit, uint8_t error_max_bit, uint8_t warning_min_bit,
                    uint8_t warning_max_bit) {}
 
-void enum_errors(uint32_t errors, uint8_t min_bit, uint8_t max_bit, const void *param,
-                 const std::function<void(uint8_t, const void *)> &fn) {
-  for (uint8_t i = min_bit; i <= max_bit; i++) {
-    uint32_t mask = 1 << i;
-    if ((errors & mask) == mask) {
-      fn(i - min_bit + 1, param);
-    }
+size_t decode_errors(uint32_t errors, char *buf, size_t size, uint8_t error_min_bit, uint8_t error_max_bit,
+                     uint8_t warning_min_bit, uint8_t warning_max_bit) {
+  if (buf == nullptr || size == 0) {
+    return 0;
   }
-}
+  size_t len = 0;
+  buf[0] = 0;
 
-std::string decode_errors(uint32_t errors, uint8_t error_min_bit, uint8_t error_max_bit, uint8_t warning_min_bit,
-                          uint8_t warning_max_bit) {
-  std::string messages;
-
-  auto add_message = [&messages](uint8_t err, const void *param) {
-    if (!messages.empty()) {
-      messages += ", ";
-    }
-    messages += static_cast<const char *>(param);
-    if (err < 10) {
-      messages += '0';
+  auto add_message = [buf, size, &len](uint8_t err, const void *param) {
+    // ", EC01" - не более 6 символов и завершающий ноль
+    if (size - len < 7) {
+      return;
     }
-    messages += std::to_string(err);
+    len += std::snprintf(buf + len, size - len, "%s%s%02u", len ? ", " : "", static_cast<const char *>(param), err);
   };
 
   enum_errors(errors, error_min_bit, error_max_bit, "EC", add_message);
@@ -48,20 +40,10 @@ std::string decode_errors(uint32_t errors, uint8_t error_min_bit, uint8_t error_
     enum_errors(errors, warning_min_bit, warning_max_bit, "WS", add_message);
   }
 
-  return messages;
+  return len;
 }
 
 void TionState::dump(const char *TAG, const TionTraits &traits) const {
-  if (this->errors) {
-    if (traits.errors_decode) {
-      const auto errors = traits.errors_decode(this->errors);
-      TION_LOGW(TAG, "Breezer alert[0x%" PRIx32 "]: %s", this->errors, errors.c_str());
-    }
-    if (traits.errors_report) {
-      traits.errors_report(this->errors);
-    }
-  }
-
   TION_DUMP(TAG, "power       : %s", ONOFF(this->power_state));
   TION_DUMP(TAG, "heater      : %s", ONOFF(this->heater_state));
   TION_DUMP(TAG, "filter_warn : %s", ONOFF(this->filter_state));
@@ -169,10 +151,9 @@ const char *TionState::get_gate_position_str(const TionTraits &traits) const {
   return this->gate_position == TionGatePosition::OPENED ? "opened" : "closed";
 }
 
-TionState TionApiBase::make_write_state_(TionStateCall *call) const {
-  const auto &cs = this->state_;
+TionState TionApiBase::make_write_state_(TionStateCall *call, const TionState &cs) const {
   // new state
-  auto ns = this->state_;
+  auto ns = cs;
 
   if (call->get_auto_state().has_value()) {
     const auto auto_state = *call->get_auto_state();
@@ -369,8 +350,69 @@ TionApiBase::TionApiBase() : auto_pi_(TION_AUTO_KP, TION_AUTO_TI, TION_AUTO_DB)
   this->traits_.boost_time = TION_BOOST_TIME;
 }
 
+void TionApiBase::update_errors_() {
+  const uint32_t errors = this->state_.errors;
+  const uint32_t prev = this->errors_;
+  if (errors == prev) {
+    return;
+  }
+  this->errors_ = errors;
+
+  if (this->traits_.errors_decode) {
+    this->traits_.errors_decode(errors, this->errors_text_, sizeof(this->errors_text_));
+  } else {
+    this->errors_text_[0] = 0;
+  }
+
+  if (errors == 0) {
+    TION_LOGI(TAG, "Breezer alerts cleared");
+    return;
+  }
+
+  TION_LOGW(TAG, "Breezer alert[0x%" PRIx32 "]: %s", errors, this->errors_text_);
+
+  const uint32_t now = tion::millis();
+  // для маски ошибок учитываем и сообщаем только появившиеся коды
+  uint32_t added = errors;
+  if (this->traits_.errors_is_code) {
+    this->errors_stats_add_(errors, now);
+  } else {
+    added &= ~prev;
+    for (uint8_t i = 0; i < 32; i++) {
+      if (added & (1UL << i)) {
+        this->errors_stats_add_(1UL << i, now);
+      }
+    }
+  }
+
+  if (added && this->traits_.errors_report) {
+    this->traits_.errors_report(added);
+  }
+}
+
+void TionApiBase::errors_stats_add_(uint32_t code, uint32_t time) {
+  for (uint8_t i = 0; i < this->errors_stats_size_; i++) {
+    auto &stat = this->errors_stats_[i];
+    if (stat.code == code) {
+      if (stat.count < UINT16_MAX) {
+        stat.count++;
+      }
+      return;
+    }
+  }
+  if (this->errors_stats_size_ == TION_ERRORS_STATS_SIZE) {
+    TION_LOGD(TAG, "No room for error 0x%" PRIx32 " stats", code);
+    return;
+  }
+  this->errors_stats_[this->errors_stats_size_++] = {.code = code, .count = 1, .first_seen = time};
+}
+
 void TionApiBase::notify_state_(uint32_t request_id) {
-  TionStateCall *call = nullptr;
+  this->update_errors_();
+
+  // изменения отправляются одним вызовом и только если они были сделаны
+  TionStateCall call(this);
+  bool perform = false;
 
   if (this->state_.boost_time_left > 0) {
     // если изменили скорость вентиляции или выключили бризер
@@ -378,10 +420,8 @@ void TionApiBase::notify_state_(uint32_t request_id) {
       TION_LOGD(TAG, "Boost canceled by user action");
       // пересохраняем изменившиеся данные, для восстановления
       this->boost_save_state_();
-      if (call == nullptr) {
-        call = new TionStateCall(this);
-      }
-      this->boost_cancel_(call);
+      this->boost_cancel_(&call);
+      perform = true;
     } else {
       // только если натив буст не поддерживается
       if (!this->traits_.supports_boost) {
@@ -389,10 +429,8 @@ void TionApiBase::notify_state_(uint32_t request_id) {
         if (boost_work_time < this->traits_.boost_time) {
           this->state_.boost_time_left = this->traits_.boost_time - boost_work_time;
         } else {
-          if (call == nullptr) {
-            call = new TionStateCall(this);
-          }
-          this->boost_cancel_(call);
+          this->boost_cancel_(&call);
+          perform = true;
         }
       }
       TION_DUMP(TAG, "Boost time left %d s", this->state_.boost_time_left);
@@ -421,7 +459,8 @@ void TionApiBase::notify_state_(uint32_t request_id) {
       }
       return false;
     };
-    if (is_preset_modified(this->presets_[this->active_preset_], this->state_)) {
+    const auto *preset = this->preset_find_(this->active_preset_.c_str());
+    if (preset == nullptr || is_preset_modified(preset->data, this->state_)) {
       this->active_preset_ = PRESET_NONE;
     }
   }
@@ -430,16 +469,13 @@ void TionApiBase::notify_state_(uint32_t request_id) {
     const auto &cs = this->state_;
     if (cs.power_state && !cs.heater_state && cs.outdoor_temperature < 0) {
       TION_LOGW(TAG, "Antifreeze protection has worked. Heater now enabled.");
-      if (call == nullptr) {
-        call = new TionStateCall(this);
-      }
-      call->set_heater_state(true);
+      call.set_heater_state(true);
+      perform = true;
     }
   }
 
-  if (call) {
-    call->perform();
-    delete call;
+  if (perform) {
+    call.perform();
   }
 
   this->on_state_fn.call_if(this->state_, request_id);
@@ -543,6 +579,17 @@ void TionApiBase::boost_enable_(uint16_t boost_time, TionStateCall *call) {
   call->set_auto_state(this->state_.auto_state);
 }
 
+void TionApiBase::restore_boost(const PresetData &save, uint32_t start_time, uint16_t time_left) {
+  if (this->traits_.supports_boost) {
+    // бризер сам отслеживает турбо-режим
+    return;
+  }
+  static_cast<PresetData &>(this->boost_save_) = save;
+  this->boost_save_.start_time = start_time;
+  this->state_.boost_time_left = time_left;
+  TION_LOGD(TAG, "Boost restored, time left %u s", time_left);
+}
+
 void TionApiBase::boost_save_state_() {
   this->boost_save_.start_time = this->state_.work_time;
   this->boost_save_.power_state = this->state_.power_state;
@@ -587,64 +634,97 @@ void TionApiBase::preset_enable_(const PresetData &preset, TionStateCall *call)
   }
 }
 
-void TionApiBase::enable_preset(const std::string &preset, TionStateCall *call) {
-  TION_LOGD(TAG, "Activate preset '%s'", preset.c_str());
-  if (preset.empty() || strcasecmp(preset.c_str(), PRESET_NONE) == 0) {
+void TionApiBase::enable_preset(const char *preset, TionStateCall *call) {
+  if (preset == nullptr) {
+    preset = "";
+  }
+  TION_LOGD(TAG, "Activate preset '%s'", preset);
+  if (*preset == 0 || strcasecmp(preset, PRESET_NONE) == 0) {
     this->active_preset_ = preset;
     return;
   }
-  const auto &it = this->presets_.find(preset);
-  if (it == this->presets_.end()) {
-    TION_LOGD(TAG, "Preset '%s' not found", preset.c_str());
+  const auto *found = this->preset_find_(preset);
+  if (found == nullptr) {
+    TION_LOGD(TAG, "Preset '%s' not found", preset);
     return;
   }
-  this->active_preset_ = preset;
-  this->preset_enable_(it->second, call);
+  this->active_preset_ = found->name;
+  this->preset_enable_(found->data, call);
 }
 
-std::set<std::string> TionApiBase::get_presets() const {
-  std::set<std::string> presets;
-  presets.emplace(PRESET_NONE);
+TionApiBase::preset_names_type TionApiBase::get_presets() const {
+  preset_names_type presets;
+  bool none = false;
   for (auto &&preset : this->presets_) {
-    presets.emplace(preset.first);
+    if (!none && std::strcmp(PRESET_NONE, preset.name.c_str()) < 0) {
+      presets.push_back(PRESET_NONE);
+      none = true;
+    }
+    presets.push_back(preset.name.c_str());
+  }
+  if (!none) {
+    presets.push_back(PRESET_NONE);
   }
   return presets;
 };
 
-TionApiBase::PresetData TionApiBase::get_preset(const std::string &name) const {
-  const auto &it = this->presets_.find(name);
-  if (it != this->presets_.end()) {
-    return it->second;
+const TionApiBase::Preset *TionApiBase::preset_find_(const char *name) const {
+  if (name == nullptr) {
+    return nullptr;
+  }
+  for (auto &&preset : this->presets_) {
+    if (preset.name == name) {
+      return &preset;
+    }
   }
-  return {};
+  return nullptr;
 }
 
-void TionApiBase::add_preset(const std::string &name, const PresetData &data) {
-  if (name.empty()) {
+TionApiBase::PresetData TionApiBase::get_preset(const char *name) const {
+  const auto *preset = this->preset_find_(name);
+  return preset ? preset->data : PresetData{};
+}
+
+void TionApiBase::add_preset(const char *name, const PresetData &data) {
+  if (name == nullptr || *name == 0) {
     TION_LOGW(TAG, "Empty preset name");
     return;
   }
-  if (strcasecmp(name.c_str(), PRESET_NONE) == 0) {
+  if (strcasecmp(name, PRESET_NONE) == 0) {
     TION_LOGW(TAG, "Skip reserved preset 'none'");
     return;
   }
   if (data.target_temperature == 0 && data.heater_state < 0 && data.power_state < 0 && data.fan_speed == 0 &&
       data.gate_position == TionGatePosition::UNKNOWN && data.auto_state < 0) {
-    TION_LOGW(TAG, "Preset '%s' has no data to change", name.c_str());
+    TION_LOGW(TAG, "Preset '%s' has no data to change", name);
     return;
   }
   if (data.target_temperature != 0 && (data.target_temperature < this->traits_.min_target_temperature ||
                                        data.target_temperature > this->traits_.max_target_temperature)) {
-    TION_LOGW(TAG, "Preset '%s' has invalid target temperature %d", name.c_str(), data.target_temperature);
+    TION_LOGW(TAG, "Preset '%s' has invalid target temperature %d", name, data.target_temperature);
     return;
   }
   if (data.fan_speed > this->traits_.max_fan_speed) {
-    TION_LOGW(TAG, "Preset '%s' has invalid fan speed %u", name.c_str(), data.fan_speed);
+    TION_LOGW(TAG, "Preset '%s' has invalid fan speed %u", name, data.fan_speed);
     return;
   }
-  TION_LOGD(TAG, "Setup preset '%s': power=%d, heat=%d, fan=%u, temp=%d, gate=%u", name.c_str(), data.power_state,
+  TION_LOGD(TAG, "Setup preset '%s': power=%d, heat=%d, fan=%u, temp=%d, gate=%u", name, data.power_state,
             data.heater_state, data.fan_speed, data.target_temperature, static_cast<uint8_t>(data.gate_position));
-  this->presets_.insert_or_assign(name, data);
+  auto it = this->presets_.begin();
+  while (it != this->presets_.end() && std::strcmp(it->name.c_str(), name) < 0) {
+    it++;
+  }
+  if (it != this->presets_.end() && it->name == name) {
+    it->data = data;
+    return;
+  }
+#ifdef TION_NO_HEAP
+  if (this->presets_.full() || std::strlen(name) > TION_PRESET_NAME_SIZE) {
+    TION_LOGW(TAG, "Preset '%s' exceeds limits: %u presets, %u chars", name, TION_MAX_PRESETS, TION_PRESET_NAME_SIZE);
+    return;
+  }
+#endif
+  this->presets_.insert(it, Preset{preset_name_type(name), data});
 }
 
 void TionApiBase::set_auto_pi_data(float kp, float ti, int db) {
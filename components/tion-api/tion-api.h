@@ -1,17 +1,35 @@
 #pragma once
 
 #include <cstddef>
-#include <map>
-#include <set>
-#include <vector>
+#include <string>
 #include <type_traits>
 
 #include <etl/delegate.h>
+#ifdef TION_NO_HEAP
+#include <etl/string.h>
+#include <etl/vector.h>
+#else
+#include <functional>
+#include <vector>
+#endif
 
 #include "tion-api-defines.h"
 #include "utils.h"
 #include "pi_controller.h"
 
+#ifndef TION_MAX_PRESETS
+#define TION_MAX_PRESETS 8
+#endif
+#ifndef TION_PRESET_NAME_SIZE
+#define TION_PRESET_NAME_SIZE 15
+#endif
+#ifndef TION_ERRORS_TEXT_SIZE
+#define TION_ERRORS_TEXT_SIZE 48
+#endif
+#ifndef TION_ERRORS_STATS_SIZE
+#define TION_ERRORS_STATS_SIZE 8
+#endif
+
 namespace dentra {
 namespace tion {
 
@@ -38,9 +56,12 @@ struct TionTraits {
     bool supports_boost : 1;
     bool supports_reset_filter : 1;
     bool supports_kiv : 1;
+    // true means errors is a single error code instead of bitmask
+    bool errors_is_code : 1;
   };
 
-  using ErrorsDecodePtr = std::add_pointer_t<std::string(uint32_t errors)>;
+  /// Расшифровывает ошибки в буфер buf размером size, возвращает длину строки.
+  using ErrorsDecodePtr = std::add_pointer_t<size_t(uint32_t errors, char *buf, size_t size)>;
   ErrorsDecodePtr errors_decode{};
   using ErrorsReportPtr = std::add_pointer_t<void(uint32_t errors)>;
   ErrorsReportPtr errors_report{};
@@ -179,7 +200,9 @@ class TionApiBase;
 class TionStateCall {
  public:
   TionStateCall(TionApiBase *api) : api_(api) {}
+#ifdef TION_ENABLE_VIRTUAL_API
   virtual ~TionStateCall() {}
+#endif
 
   void set_fan_speed(uint8_t fan_speed) { this->fan_speed_ = fan_speed; }
   void set_target_temperature(int8_t target_temperature) { this->target_temperature_ = target_temperature; }
@@ -204,7 +227,7 @@ class TionStateCall {
     this->gate_position_ = gate_state ? TionGatePosition::OPENED : TionGatePosition::CLOSED;
   }
 
-  virtual void perform();
+  TION_API_VIRTUAL void perform();
 
   bool has_changes() const;
   void reset();
@@ -223,16 +246,25 @@ class TionStateCall {
   optional<bool> auto_state_;
 };
 
-#define TION_REPORT_EC(tag, code, msg) TION_LOGW(tag, "EC%02u: %s", err, msg);
-#define TION_REPORT_WS(tag, code, msg) TION_LOGW(tag, "WS%02u: %s", err, msg);
-#define TION_REPORT_EC_UNK(tag, code) TION_REPORT_EC(tag, code, "Неизвестная ошибка")
-#define TION_REPORT_WS_UNK(tag, code) TION_REPORT_WS(tag, code, "Неизвестное предупреждение")
-
-void enum_errors(uint32_t errors, uint8_t min_bit, uint8_t max_bit, const void *param,
-                 const std::function<void(uint8_t, const void *)> &fn);
+#define TION_REPORT_EC(tag, code, msg) TION_LOGW(tag, "EC%02u: %s", code, msg);
+#define TION_REPORT_WS(tag, code, msg) TION_LOGW(tag, "WS%02u: %s", code, msg);
+// текст в строке формата, чтобы на ESP8266 он оставался во флеш-памяти
+#define TION_REPORT_EC_UNK(tag, code) TION_LOGW(tag, "EC%02u: Неизвестная ошибка", code);
+#define TION_REPORT_WS_UNK(tag, code) TION_LOGW(tag, "WS%02u: Неизвестное предупреждение", code);
+
+template<class F> void enum_errors(uint32_t errors, uint8_t min_bit, uint8_t max_bit, const void *param, F &&fn) {
+  for (uint8_t i = min_bit; i <= max_bit; i++) {
+    uint32_t mask = 1 << i;
+    if ((errors & mask) == mask) {
+      fn(i - min_bit + 1, param);
+    }
+  }
+}
 
-std::string decode_errors(uint32_t errors, uint8_t error_min_bit, uint8_t error_max_bit, uint8_t warning_min_bit,
-                          uint8_t warning_max_bit);
+/// Расшифровывает ошибки в виде "EC01, WS02" в буфер buf размером size, возвращает длину строки.
+/// Не помещающиеся в буфер коды отбрасываются.
+size_t decode_errors(uint32_t errors, char *buf, size_t size, uint8_t error_min_bit, uint8_t error_max_bit,
+                     uint8_t warning_min_bit, uint8_t warning_max_bit);
 
 class TionApiBase {
   /// Callback listener for response to request_state command request.
@@ -260,6 +292,28 @@ class TionApiBase {
     int8_t auto_state;
   };
 
+  struct ErrorStat {
+    // бит маски ошибок или код ошибки, если traits.errors_is_code
+    uint32_t code;
+    // количество появлений
+    uint16_t count;
+    // время первого появления, мс
+    uint32_t first_seen;
+  };
+
+#ifdef TION_NO_HEAP
+  using preset_name_type = etl::string<TION_PRESET_NAME_SIZE>;
+  /// Указатели на имена пресетов, действительны до изменения списка пресетов.
+  using preset_names_type = etl::vector<const char *, TION_MAX_PRESETS + 1>;
+  /// Лямбда без захвата переменных.
+  using auto_update_func_type = uint8_t (*)(uint16_t current);
+#else
+  using preset_name_type = std::string;
+  /// Указатели на имена пресетов, действительны до изменения списка пресетов.
+  using preset_names_type = std::vector<const char *>;
+  using auto_update_func_type = std::function<uint8_t(uint16_t current)>;
+#endif
+
   using on_ready_type = etl::delegate<void()>;
   /// Set callback listener for monitoring ready state
   void set_on_ready(on_ready_type &&on_ready) { this->on_ready_fn = on_ready; }
@@ -274,9 +328,16 @@ class TionApiBase {
   const TionState &get_state() const { return this->state_; }
   const TionTraits &get_traits() const { return this->traits_; }
 
+#ifdef TION_ENABLE_VIRTUAL_API
   virtual void request_state() = 0;
   virtual void write_state(TionStateCall *call) = 0;
   virtual void reset_filter() = 0;
+#else
+  // определяются TION_API_IMPL для типа API сборки
+  void request_state();
+  void write_state(TionStateCall *call);
+  void reset_filter();
+#endif
 
   // Вызывающая сторона ответственна за вызов perform..
   void enable_boost(bool state, TionStateCall *call);
@@ -285,12 +346,13 @@ class TionApiBase {
   void set_boost_heater_state(bool heater_state);
   void set_boost_target_temperature(int8_t target_temperature);
   // Вызывающая сторона ответственна за вызов perform.
-  void enable_preset(const std::string &preset, TionStateCall *call);
-  std::set<std::string> get_presets() const;
+  void enable_preset(const char *preset, TionStateCall *call);
+  /// Имена пресетов, включая none, в алфавитном порядке.
+  preset_names_type get_presets() const;
   bool has_presets() const { return !this->presets_.empty(); }
-  void add_preset(const std::string &name, const PresetData &data);
-  PresetData get_preset(const std::string &name) const;
-  const std::string &get_active_preset() const { return this->active_preset_; }
+  void add_preset(const char *name, const PresetData &data);
+  PresetData get_preset(const char *name) const;
+  const char *get_active_preset() const { return this->active_preset_.c_str(); }
   /// Вызывающая сторона ответственна за вызов perform.
   /// @return true если были изменения и требуются выполнить perform
   bool auto_update(uint16_t current, TionStateCall *call);
@@ -301,40 +363,108 @@ class TionApiBase {
   uint16_t get_auto_setpoint() const { return this->auto_setpoint_; }
   uint8_t get_auto_min_fan_speed() const { return this->auto_min_fan_speed_; }
   uint8_t get_auto_max_fan_speed() const { return this->auto_max_fan_speed_; }
-  void set_auto_update_func(std::function<uint8_t(uint16_t current)> &&func) {
+  void set_auto_update_func(auto_update_func_type &&func) {
     this->auto_update_func_ = std::move(func);
   }
   bool auto_is_valid() const;
 
+  /// Состояние до включения турбо-режима.
+  const PresetData &get_boost_save() const { return this->boost_save_; }
+  /// Время наработки на момент включения турбо-режима.
+  uint32_t get_boost_start_time() const { return this->boost_save_.start_time; }
+  /// Восстанавливает незавершенный турбо-режим, например после перезагрузки.
+  void restore_boost(const PresetData &save, uint32_t start_time, uint16_t time_left);
+
+  /// Расшифровка текущих ошибок, обновляется только при изменении маски ошибок.
+  const char *get_errors_text() const { return this->errors_text_; }
+  /// Статистика появления кодов ошибок с момента запуска.
+  const ErrorStat *get_errors_stats() const { return this->errors_stats_; }
+  size_t get_errors_stats_size() const { return this->errors_stats_size_; }
+
  protected:
   TionTraits traits_{};
   TionState state_{};
   uint32_t request_id_{};
 
-  TionState make_write_state_(TionStateCall *call) const;
+  TionState make_write_state_(TionStateCall *call) const { return this->make_write_state_(call, this->state_); }
+  // Формирует новое состояние на основе переданного cs, например еще не отправленного.
+  TionState make_write_state_(TionStateCall *call, const TionState &cs) const;
 
   struct : public PresetData {
     uint32_t start_time;
   } boost_save_{};
 
-  std::map<std::string, PresetData> presets_;
-  std::string active_preset_{PRESET_NONE};
+  struct Preset {
+    preset_name_type name;
+    PresetData data;
+  };
+  // отсортированы по имени
+#ifdef TION_NO_HEAP
+  etl::vector<Preset, TION_MAX_PRESETS> presets_;
+#else
+  std::vector<Preset> presets_;
+#endif
+  preset_name_type active_preset_{PRESET_NONE};
 
   auto_co2::PIController auto_pi_;
   int16_t auto_setpoint_{};
   uint8_t auto_min_fan_speed_{};
   uint8_t auto_max_fan_speed_{};
-  std::function<uint8_t(uint16_t current)> auto_update_func_;
+  auto_update_func_type auto_update_func_{};
+
+  uint32_t errors_{};
+  char errors_text_[TION_ERRORS_TEXT_SIZE]{};
+  ErrorStat errors_stats_[TION_ERRORS_STATS_SIZE]{};
+  uint8_t errors_stats_size_{};
 
   void notify_state_(uint32_t request_id);
+  // логирует и учитывает ошибки только при изменении маски ошибок
+  void update_errors_();
+  void errors_stats_add_(uint32_t code, uint32_t time);
+#ifdef TION_ENABLE_VIRTUAL_API
   virtual void boost_enable_native_(bool state) {}
+#else
+  void boost_enable_native_(bool state);
+  /// Проверяет, что метод объявлен в классе API, а не унаследован от TionApiBase.
+  template<class F, class C> static constexpr bool is_api_method_(F C::*) { return !std::is_same_v<C, TionApiBase>; }
+#endif
   void boost_enable_(uint16_t boost_time, TionStateCall *call);
   void boost_cancel_(TionStateCall *call);
   void boost_save_state_();
   void preset_enable_(const PresetData &preset, TionStateCall *call);
+  const Preset *preset_find_(const char *name) const;
   void auto_update_fan_speed_();
   uint8_t auto_pi_update_(uint16_t current);
 };
 
 }  // namespace tion
 }  // namespace dentra
+
+#ifdef TION_ENABLE_VIRTUAL_API
+#define TION_API_IMPL(...)
+#else
+/// Определяет методы TionApiBase вызовом методов класса API без виртуальной таблицы.
+/// Используется один раз на сборку для класса-обертки API, например TionVPortApi<frame_spec_t, api_t>.
+#define TION_API_IMPL(...) \
+  void dentra::tion::TionApiBase::request_state() { \
+    using api_type = __VA_ARGS__; \
+    static_assert(is_api_method_<void()>(&api_type::request_state), "request_state is not implemented"); \
+    static_cast<api_type *>(this)->request_state(); \
+  } \
+  void dentra::tion::TionApiBase::write_state(TionStateCall *call) { \
+    using api_type = __VA_ARGS__; \
+    static_assert(is_api_method_<void(TionStateCall *)>(&api_type::write_state), "write_state is not implemented"); \
+    static_cast<api_type *>(this)->write_state(call); \
+  } \
+  void dentra::tion::TionApiBase::reset_filter() { \
+    using api_type = __VA_ARGS__; \
+    static_assert(is_api_method_<void()>(&api_type::reset_filter), "reset_filter is not implemented"); \
+    static_cast<api_type *>(this)->reset_filter(); \
+  } \
+  void dentra::tion::TionApiBase::boost_enable_native_(bool state) { \
+    using api_type = __VA_ARGS__; \
+    if constexpr (is_api_method_<void(bool)>(&api_type::boost_enable_native_)) { \
+      static_cast<api_type *>(this)->boost_enable_native_(state); \
+    } \
+  }
+#endif
@@ -1,6 +1,8 @@
 #include <cstdlib>
 #include <string>
+#include <cinttypes>
 #include <climits>  // CHAR_BIT
+#include <cstdio>
 
 #include "utils.h"
 
@@ -44,6 +46,23 @@ std::string tion_hexencode(const void *data, uint32_t size) { return hex(data, s
 
 #endif
 
+#ifdef TION_NO_HEAP
+const char *tion_hexencode_cstr(const void *data, uint32_t size) {
+  static constexpr uint32_t MAX_SIZE = 64;
+  static char bufs[2][MAX_SIZE * 3 + 16];
+  static uint8_t buf_idx;
+  char *buf = bufs[buf_idx ^= 1];
+  const auto *bytes = static_cast<const uint8_t *>(data);
+  const uint32_t len = size < MAX_SIZE ? size : MAX_SIZE;
+  char *p = buf;
+  for (uint32_t i = 0; i < len; i++) {
+    p += std::sprintf(p, i == 0 ? "%02X" : ".%02X", bytes[i]);
+  }
+  std::sprintf(p, len < size ? "... (%" PRIu32 ")" : " (%" PRIu32 ")", size);
+  return buf;
+}
+#endif
+
 const char *get_flag_bits(uint8_t flags) {
   static char flags_bits[CHAR_BIT + 1]{};
   for (int i = 0; i < CHAR_BIT; i++) {
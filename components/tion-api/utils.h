@@ -34,7 +34,14 @@ std::string __attribute__((format(printf, 1, 2))) str_sprintf(const char *fmt, .
 #define __builtin_bswap16 __bswap_16
 #endif
 
+#ifdef TION_NO_HEAP
+/// Форматирует данные в статический буфер, длинные данные обрезаются.
+/// Буферов два, поэтому в одном вызове лога допустимо не более двух hex_cstr.
+const char *tion_hexencode_cstr(const void *data, uint32_t size);
+#define hex_cstr(data, size) tion_hexencode_cstr(data, size)
+#else
 #define hex_cstr(data, size) tion_hexencode(data, size).c_str()
+#endif
 
 const char *get_flag_bits(uint8_t flags);
 
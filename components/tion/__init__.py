@@ -10,11 +10,15 @@ from esphome.components import sensor as esphome_sensor
 from esphome.const import (
     CONF_CO2,
     CONF_FORCE_UPDATE,
+    CONF_FORMAT,
     CONF_HEATER,
     CONF_ID,
     CONF_LAMBDA,
+    CONF_HOST,
     CONF_ON_STATE,
+    CONF_PORT,
     CONF_POWER,
+    CONF_PROTOCOL,
     CONF_TEMPERATURE,
     CONF_TYPE,
 )
@@ -30,6 +34,9 @@ CONF_TION_ID = "tion_id"
 CONF_COMPONENT_CLASS = cgp.CONF_COMPONENT_CLASS
 
 CONF_PRESETS = "presets"
+# ограничения сборки TION_NO_HEAP, см. tion-api.h
+MAX_PRESETS = 8
+MAX_PRESET_NAME_SIZE = 15
 CONF_FAN_SPEED = "fan_speed"
 CONF_GATE_POSITION = "gate_position"
 CONF_AUTO = "auto"
@@ -38,6 +45,37 @@ CONF_BUTTON_PRESETS = "button_presets"
 CONF_STATE_TIMEOUT = "state_timeout"
 CONF_STATE_WARNOUT = "state_warnout"
 CONF_BATCH_TIMEOUT = "batch_timeout"
+CONF_WRITE_AFTER_ACK = "write_after_ack"
+CONF_STATS_INTERVAL = "stats_interval"
+CONF_TIMING = "timing"
+CONF_NO_HEAP = "no_heap"
+CONF_VIRTUAL_API = "virtual_api"
+CONF_ENERGY = "energy"
+CONF_PUBLISH_INTERVAL = "publish_interval"
+CONF_CAPTURE = "capture"
+CONF_CAPTURE_ID = "capture_id"
+CONF_BUFFER_SIZE = "buffer_size"
+CONF_STREAM = "stream"
+CONF_MIRROR = "mirror"
+CONF_MIRROR_ID = "mirror_id"
+CONF_HISTORY = "history"
+CONF_HISTORY_ID = "history_id"
+CONF_LEVELS = "levels"
+CONF_PERSIST = "persist"
+CONF_PERSIST_ID = "persist_id"
+CONF_WRITES_PER_DAY = "writes_per_day"
+CONF_BURST = "burst"
+CONF_INTERVAL = "interval"
+CONF_ARBITER = "arbiter"
+CONF_MAX_WAIT = "max_wait"
+
+CONF_BULK = "bulk"
+CONF_BULK_ID = "bulk_id"
+CONF_FULL_INTERVAL = "full_interval"
+CONF_ON_PUBLISH = "on_publish"
+CONF_DEADBAND = "deadband"
+CONF_MIN_INTERVAL = "min_interval"
+CONF_HEARTBEAT = "heartbeat"
 
 CONF_SETPOINT = "setpoint"
 CONF_MIN_FAN_SPEED = f"min_{CONF_FAN_SPEED}"
@@ -47,10 +85,22 @@ CONF_KP = "kp"
 CONF_TI = "ti"
 CONF_DB = "db"
 
+# тип API, для которого сгенерирован TION_API_IMPL
+DATA_API_IMPL = "tion_api_impl"
+
 tion_ns = cg.esphome_ns.namespace("tion")
 dentra_tion_ns = cg.global_ns.namespace("dentra").namespace("tion")
 
 TionVPortApi = tion_ns.class_("TionVPortApi")
+TionCaptureWriter = dentra_tion_ns.class_("TionCaptureWriter")
+TionCaptureDevice = dentra_tion_ns.namespace("TionCapture")
+TionMirror = tion_ns.class_("TionMirror", cg.Component, TionCaptureWriter)
+TionHistory = tion_ns.class_("TionHistory")
+TionPersist = tion_ns.class_("TionPersist", cg.Component)
+TionBulkPublisher = tion_ns.class_("TionBulkPublisher")
+BulkPublishTrigger = tion_ns.class_(
+    "BulkPublishTrigger", automation.Trigger.template(cg.std_string)
+)
 TionApiComponent = tion_ns.class_("TionApiComponent", cg.Component)
 
 TionStateRef = dentra_tion_ns.namespace("TionState").operator("ref").operator("const")
@@ -73,6 +123,100 @@ PRESET_GATE_POSITIONS = {
 }
 
 
+CAPTURE_DEVICES = {
+    "o2": TionCaptureDevice.DEVICE_O2,
+    "3s": TionCaptureDevice.DEVICE_3S,
+    "4s": TionCaptureDevice.DEVICE_4S,
+    "lt": TionCaptureDevice.DEVICE_LT,
+}
+
+CAPTURE_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_CAPTURE_ID): cv.declare_id(TionCaptureWriter),
+        cv.Optional(CONF_BUFFER_SIZE, default=4096): cv.int_range(min=64, max=65536),
+        cv.Optional(CONF_STREAM, default=False): cv.boolean,
+    }
+)
+
+MIRROR_PROTOCOLS = {
+    "tcp": TionMirror.enum("Protocol").PROTOCOL_TCP,
+    "udp": TionMirror.enum("Protocol").PROTOCOL_UDP,
+}
+
+MIRROR_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_MIRROR_ID): cv.declare_id(TionMirror),
+        cv.Required(CONF_HOST): cv.ipv4address,
+        cv.Required(CONF_PORT): cv.port,
+        cv.Optional(CONF_PROTOCOL, default="tcp"): cv.one_of(
+            *MIRROR_PROTOCOLS, lower=True
+        ),
+        cv.Optional(CONF_BUFFER_SIZE, default=4096): cv.int_range(min=256, max=65536),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+HISTORY_LEVEL_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_INTERVAL): cv.positive_time_period_seconds,
+        cv.Required(CONF_BUFFER_SIZE): cv.int_range(min=64, max=262144),
+    }
+)
+
+HISTORY_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_HISTORY_ID): cv.declare_id(TionHistory),
+        cv.Optional(
+            CONF_LEVELS,
+            default=[
+                {CONF_INTERVAL: "0s", CONF_BUFFER_SIZE: 2048},
+                {CONF_INTERVAL: "5min", CONF_BUFFER_SIZE: 1024},
+                {CONF_INTERVAL: "1h", CONF_BUFFER_SIZE: 1024},
+            ],
+        ): cv.All(cv.ensure_list(HISTORY_LEVEL_SCHEMA), cv.Length(min=1, max=4)),
+    }
+)
+
+ENERGY_SCHEMA = cv.Schema(
+    {
+        cv.Optional(
+            CONF_PUBLISH_INTERVAL, default="5min"
+        ): cv.positive_time_period_milliseconds,
+    }
+)
+
+ARBITER_SCHEMA = cv.Schema(
+    {
+        cv.Optional(
+            CONF_INTERVAL, default="100ms"
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_MAX_WAIT, default="1s"): cv.positive_time_period_milliseconds,
+    }
+)
+
+PERSIST_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_PERSIST_ID): cv.declare_id(TionPersist),
+        cv.Optional(CONF_WRITES_PER_DAY, default=24): cv.int_range(min=1, max=1440),
+        cv.Optional(CONF_BURST, default=3): cv.int_range(min=1, max=16),
+    }
+)
+
+BULK_FORMATS = {
+    "json": TionBulkPublisher.enum("Format").FORMAT_JSON,
+    "cbor": TionBulkPublisher.enum("Format").FORMAT_CBOR,
+}
+
+BULK_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_BULK_ID): cv.declare_id(TionBulkPublisher),
+        cv.Optional(CONF_FORMAT, default="json"): cv.one_of(*BULK_FORMATS, lower=True),
+        cv.Optional(
+            CONF_FULL_INTERVAL, default="10min"
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_ON_PUBLISH): cgp.automation_schema(BulkPublishTrigger),
+    }
+)
+
 PRESET_SCHEMA = cv.Schema(
     {
         cv.Optional(CONF_POWER, default=True): cv.boolean,
@@ -116,10 +260,45 @@ AUTO_SCHEMA = cv.Schema(
 )
 
 
+PUBLISH_INTERVAL_SCHEMA = {
+    cv.Optional(CONF_MIN_INTERVAL): cv.positive_time_period_milliseconds,
+    cv.Optional(CONF_HEARTBEAT): cv.positive_time_period_milliseconds,
+}
+
+PUBLISH_FILTER_SCHEMA = {
+    cv.Optional(CONF_DEADBAND): cv.positive_float,
+    **PUBLISH_INTERVAL_SCHEMA,
+}
+
+
+def setup_publish_filter(config: dict, var: cg.MockObj):
+    cgp.setup_value(config, CONF_DEADBAND, var.set_deadband)
+    cgp.setup_value(config, CONF_MIN_INTERVAL, var.set_min_interval)
+    cgp.setup_value(config, CONF_HEARTBEAT, var.set_heartbeat)
+
+
 def check_type(key, typ, required: bool = False):
     return cgp.validate_type(key, typ, required)
 
 
+def _validate_write_after_ack(config: dict):
+    if CONF_WRITE_AFTER_ACK in config and config[CONF_TYPE] not in ["3s", "lt"]:
+        raise cv.Invalid(f"{CONF_WRITE_AFTER_ACK} is supported only for 3s and lt")
+    return config
+
+
+# таймаут состояния отсчитывается от постановки опроса в очередь арбитра, а не от отправки
+def _validate_arbiter(config: dict):
+    if (
+        CONF_ARBITER in config
+        and config[CONF_ARBITER][CONF_MAX_WAIT] >= config[CONF_STATE_TIMEOUT]
+    ):
+        raise cv.Invalid(
+            f"{CONF_ARBITER} {CONF_MAX_WAIT} must be less than {CONF_STATE_TIMEOUT}"
+        )
+    return config
+
+
 CONFIG_SCHEMA = cv.All(
     cv.ensure_list(
         cv.Schema(
@@ -133,35 +312,71 @@ CONFIG_SCHEMA = cv.All(
                     CONF_BATCH_TIMEOUT, default="200ms"
                 ): cv.positive_time_period_milliseconds,
                 cv.Optional(CONF_FORCE_UPDATE): cv.boolean,
+                cv.Optional(CONF_WRITE_AFTER_ACK): cv.boolean,
+                cv.Optional(
+                    CONF_STATS_INTERVAL, default="60s"
+                ): cv.positive_time_period_milliseconds,
+                cv.Optional(CONF_TIMING, default=False): cv.boolean,
+                cv.Optional(CONF_NO_HEAP, default=False): cv.boolean,
+                cv.Optional(CONF_VIRTUAL_API, default=False): cv.boolean,
+                cv.Optional(CONF_ENERGY): ENERGY_SCHEMA,
+                cv.Optional(CONF_ARBITER): ARBITER_SCHEMA,
                 cv.Optional(CONF_PRESETS): cv.Schema({cv.string_strict: PRESET_SCHEMA}),
                 cv.Optional(CONF_ON_STATE): cgp.automation_schema(StateTrigger),
                 cv.Optional(CONF_AUTO): AUTO_SCHEMA,
+                cv.Optional(CONF_CAPTURE): CAPTURE_SCHEMA,
+                cv.Optional(CONF_HISTORY): HISTORY_SCHEMA,
+                cv.Optional(CONF_PERSIST): PERSIST_SCHEMA,
+                cv.Optional(CONF_BULK): BULK_SCHEMA,
+                cv.Optional(CONF_MIRROR): cv.All(
+                    MIRROR_SCHEMA, cv.requires_component("socket")
+                ),
             }
         )
         .extend(vport.VPORT_CLIENT_SCHEMA)
         .extend(cv.polling_component_schema("60s")),
         cgp.validate_type(CONF_BUTTON_PRESETS, "lt"),
+        _validate_write_after_ack,
+        _validate_arbiter,
     ),
 )
 
 
+def setup_build_type(typ: str, transport: str | None = None):
+    """В сборку попадает код только выбранных типов бризеров и транспортов."""
+    cg.add_build_flag(f"-DTION_API_{typ.upper()}")
+    if transport:
+        cg.add_build_flag(f"-DTION_TRANSPORT_{transport.upper()}")
+
+
+def _setup_api_impl(api_type: cg.MockObj):
+    # методы API разрешаются при сборке, если в ней единственный тип API
+    impl = core.CORE.data.get(DATA_API_IMPL)
+    if impl is None:
+        core.CORE.data[DATA_API_IMPL] = str(api_type)
+        cg.add_global(cpp.RawStatement(f"TION_API_IMPL({api_type})"))
+        cg.add_global(cpp.RawStatement(f"TION_API_WRITER_IMPL({api_type})"))
+    elif impl != str(api_type):
+        # например, бризеры разных моделей в одной сборке
+        cg.add_build_flag("-DTION_ENABLE_VIRTUAL_API")
+
+
 async def new_vport_api_wrapper(config: dict, component_class: MockObjClass):
     # get vport instance
     prt = await vport.vport_get_var(config)
     # create TionVPortApi wrapper
-    api = cg.new_Pvariable(
-        config[CONF_TION_ID],
-        cg.TemplateArguments(
-            vport.vport_find(config).type.class_("frame_spec_type"),
-            component_class.class_("Api"),
-        ),
-        prt,
+    template_args = cg.TemplateArguments(
+        vport.vport_find(config).type.class_("frame_spec_type"),
+        component_class.class_("Api"),
     )
+    api = cg.new_Pvariable(config[CONF_TION_ID], template_args, prt)
+    _setup_api_impl(TionVPortApi.template(template_args))
     return prt, api
 
 
 async def _setup_tion_api(config: dict):
     component_class: MockObjClass = BREEZER_TYPES[config[CONF_TYPE]]
+    setup_build_type(config[CONF_TYPE])
 
     prt, api = await new_vport_api_wrapper(config, component_class)
     cg.add(prt.set_api(api))
@@ -178,11 +393,99 @@ async def _setup_tion_api(config: dict):
 
     cg.add(var.set_state_timeout(config[CONF_STATE_TIMEOUT]))
     cg.add(var.set_batch_timeout(config[CONF_BATCH_TIMEOUT]))
+    cg.add(var.set_stats_interval(config[CONF_STATS_INTERVAL]))
+    cg.add(var.set_protocol_stats(prt.get_protocol_stats()))
+
+    if config[CONF_NO_HEAP]:
+        cg.add_build_flag("-DTION_NO_HEAP")
+    if config[CONF_VIRTUAL_API]:
+        cg.add_build_flag("-DTION_ENABLE_VIRTUAL_API")
+    if config[CONF_TIMING]:
+        cg.add_build_flag("-DTION_ENABLE_TIMING")
+        cg.add(prt.set_timing(var.get_timing()))
+        cg.add(api.set_timing(var.get_timing()))
+    if CONF_ARBITER in config:
+        cg.add_build_flag("-DTION_ENABLE_ARBITER")
+        cg.add(
+            var.set_arbiter(
+                config[CONF_ARBITER][CONF_INTERVAL],
+                config[CONF_ARBITER][CONF_MAX_WAIT],
+            )
+        )
+        cg.add(api.set_arbiter(var.get_arbiter()))
+    if CONF_ENERGY in config:
+        cg.add_build_flag("-DTION_ENABLE_ENERGY")
+        cg.add(var.set_energy_interval(config[CONF_ENERGY][CONF_PUBLISH_INTERVAL]))
     cgp.setup_value(config, CONF_FORCE_UPDATE, var.set_force_update)
+    cgp.setup_value(config, CONF_WRITE_AFTER_ACK, var.set_write_after_ack)
+
+    if CONF_CAPTURE in config:
+        _setup_capture(config[CONF_CAPTURE], config[CONF_TYPE], api)
+
+    if CONF_MIRROR in config:
+        await _setup_mirror(config[CONF_MIRROR], config[CONF_TYPE], api)
+
+    if CONF_HISTORY in config:
+        _setup_history(config[CONF_HISTORY], var)
+
+    if CONF_PERSIST in config:
+        await _setup_persist(config[CONF_PERSIST], var, prt)
+
+    if CONF_BULK in config:
+        await _setup_bulk(config[CONF_BULK], var)
 
     return var
 
 
+def _setup_capture(config: dict, typ: str, api: cg.MockObj):
+    cg.add_build_flag("-DTION_ENABLE_CAPTURE")
+    capture = cg.new_Pvariable(
+        config[CONF_CAPTURE_ID], config[CONF_BUFFER_SIZE], CAPTURE_DEVICES[typ]
+    )
+    if config[CONF_STREAM]:
+        cg.add(capture.set_stream(True))
+    cg.add(api.add_capture(capture))
+
+
+async def _setup_mirror(config: dict, typ: str, api: cg.MockObj):
+    cg.add_build_flag("-DTION_ENABLE_CAPTURE")
+    cg.add_build_flag("-DTION_ENABLE_MIRROR")
+    mirror = cg.new_Pvariable(
+        config[CONF_MIRROR_ID], config[CONF_BUFFER_SIZE], CAPTURE_DEVICES[typ]
+    )
+    await cg.register_component(mirror, config)
+    cg.add(mirror.set_address(str(config[CONF_HOST]), config[CONF_PORT]))
+    cg.add(mirror.set_protocol(MIRROR_PROTOCOLS[config[CONF_PROTOCOL]]))
+    cg.add(api.add_capture(mirror))
+
+
+def _setup_history(config: dict, var: cg.MockObj):
+    cg.add_build_flag("-DTION_ENABLE_HISTORY")
+    history = cg.new_Pvariable(config[CONF_HISTORY_ID], var)
+    for level in config[CONF_LEVELS]:
+        cg.add(
+            history.add_level(level[CONF_INTERVAL].total_seconds, level[CONF_BUFFER_SIZE])
+        )
+
+
+async def _setup_persist(config: dict, var: cg.MockObj, prt: cg.MockObj):
+    cg.add_build_flag("-DTION_ENABLE_PERSIST")
+    persist = cg.new_Pvariable(config[CONF_PERSIST_ID], var)
+    await cg.register_component(persist, config)
+    cg.add(persist.set_writes_per_day(config[CONF_WRITES_PER_DAY]))
+    cg.add(persist.set_burst(config[CONF_BURST]))
+    cg.add(persist.set_vport(prt))
+
+
+async def _setup_bulk(config: dict, var: cg.MockObj):
+    cg.add_build_flag("-DTION_ENABLE_BULK")
+    bulk = cg.new_Pvariable(
+        config[CONF_BULK_ID], var, BULK_FORMATS[config[CONF_FORMAT]]
+    )
+    cg.add(bulk.set_full_interval(config[CONF_FULL_INTERVAL]))
+    await cgp.setup_automation(config, CONF_ON_PUBLISH, bulk, (cg.std_string, "x"))
+
+
 def _setup_tion_api_presets(config: dict, var: cg.MockObj):
     if CONF_PRESETS not in config:
         return
@@ -196,6 +499,13 @@ def _setup_tion_api_presets(config: dict, var: cg.MockObj):
         if preset_name.lower() in presets:
             logging.warning("Preset '%s' is already exists", preset)
             continue
+        if config[CONF_NO_HEAP] and (
+            len(presets) >= MAX_PRESETS or len(preset_name) > MAX_PRESET_NAME_SIZE
+        ):
+            raise cv.Invalid(
+                f"Preset '{preset_name}' exceeds {CONF_NO_HEAP} limits: "
+                f"{MAX_PRESETS} presets, {MAX_PRESET_NAME_SIZE} chars"
+            )
         preset = config[CONF_PRESETS][preset_name]
         cg.add(
             var.add_preset(
@@ -238,6 +548,7 @@ async def _setup_auto(config: dict, var):
     api = var.Papi()
 
     code = f"""
+TION_ARBITER_LANE({var}->get_arbiter(), LANE_AUTO);
 auto *call = {var}->make_call();
 if ({api}->auto_update(x, call)) {{
   call->perform();
@@ -261,13 +572,15 @@ if ({api}->auto_update(x, call)) {{
             api.set_auto_pi_data,
         )
 
-    await cgp.setup_lambda(
-        config,
-        CONF_LAMBDA,
-        api.set_auto_update_func,
-        parameters=[(cg.uint16, "x")],
-        return_type=cg.uint8,
-    )
+    if CONF_LAMBDA in config:
+        # лямбда без захвата переменных совместима со сборкой TION_NO_HEAP
+        lam = await cg.process_lambda(
+            config[CONF_LAMBDA],
+            parameters=[(cg.uint16, "x")],
+            capture="",
+            return_type=cg.uint8,
+        )
+        cg.add(api.set_auto_update_func(lam))
 
 
 async def to_code(config: dict):
@@ -2,20 +2,30 @@
 
 #include "esphome/core/automation.h"
 #include "tion_component.h"
+#include "tion_bulk.h"
 
 namespace esphome {
 namespace tion {
 
-class StateTrigger : public Trigger<const dentra::tion::TionState &> {
+class StateTrigger : public Trigger<const dentra::tion::TionState &>, public TionStateListener {
  public:
-  explicit StateTrigger(TionApiComponent *api) {
-    api->add_on_state_callback([this](const auto *state) {
-      if (state) {
-        this->trigger(*state);
-      }
-    });
+  explicit StateTrigger(TionApiComponent *api) { api->add_on_state_listener(this); }
+
+  void on_tion_state(const dentra::tion::TionState *state) override {
+    if (state) {
+      this->trigger(*state);
+    }
+  }
+};
+
+#ifdef TION_ENABLE_BULK
+class BulkPublishTrigger : public Trigger<std::string> {
+ public:
+  explicit BulkPublishTrigger(TionBulkPublisher *bulk) {
+    bulk->add_on_publish_callback([this](const std::string &message) { this->trigger(message); });
   }
 };
+#endif
 
 }  // namespace tion
 }  // namespace esphome
@@ -10,7 +10,7 @@ from esphome.const import (
     ENTITY_CATEGORY_DIAGNOSTIC,
 )
 
-from .. import new_pc, cgp, tion_ns
+from .. import PUBLISH_INTERVAL_SCHEMA, new_pc, cgp, setup_publish_filter, tion_ns
 
 TionBinarySensor = tion_ns.class_(
     "TionBinarySensor", binary_sensor.BinarySensor, cg.Component
@@ -69,8 +69,9 @@ PC = new_pc(
     }
 )
 
-CONFIG_SCHEMA = PC.binary_sensor_schema(TionBinarySensor)
+CONFIG_SCHEMA = PC.binary_sensor_schema(TionBinarySensor, PUBLISH_INTERVAL_SCHEMA)
 
 
 async def to_code(config: dict):
-    await PC.new_binary_sensor(config)
+    var = await PC.new_binary_sensor(config)
+    setup_publish_filter(config, var)
@@ -15,7 +15,11 @@ namespace tion {
 
 // C - PropertyController
 template<class C>
-class TionBinarySensor : public binary_sensor::BinarySensor, public Component, public Parented<TionApiComponent> {
+class TionBinarySensor : public binary_sensor::BinarySensor,
+                         public Component,
+                         public Parented<TionApiComponent>,
+                         public property_controller::PublishFilter,
+                         public TionStateListener {
   using TionState = dentra::tion::TionState;
   using PC = property_controller::Controller<C>;
 
@@ -38,12 +42,14 @@ class TionBinarySensor : public binary_sensor::BinarySensor, public Component, p
     if (!PC::is_supported(this)) {
       return;
     }
-    this->parent_->add_on_state_callback([this](const TionState *state) {
-      if (!PC::publish_state(this, state)) {
-        this->has_state_ = false;
-        this->state_callback_.call(false);
-      }
-    });
+    this->parent_->add_on_state_listener(this);
+  }
+
+  void on_tion_state(const TionState *state) override {
+    if (!PC::publish_state(this, state)) {
+      this->has_state_ = false;
+      this->state_callback_.call(false);
+    }
   }
 };
 
@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include "esphome/core/log.h"
 
 #include "tion_climate_helpers.h"
@@ -8,13 +10,12 @@ namespace tion {
 
 static const char *const TAG = "tion_climate";
 
-int find_climate_preset(const std::string &preset) {
+int find_climate_preset(const char *preset) {
 #ifndef USE_ARDUINO
-  const auto preset_upper = str_upper_case(preset);
   for (uint8_t i = climate::CLIMATE_PRESET_NONE; i <= climate::CLIMATE_PRESET_ACTIVITY; i++) {
     const auto preset_climate_index = static_cast<climate::ClimatePreset>(i);
     const auto preset_climate = LOG_STR_ARG(climate::climate_preset_to_string(preset_climate_index));
-    if (preset_upper == preset_climate) {
+    if (strcasecmp(preset, preset_climate) == 0) {
       return preset_climate_index;
     }
   }
@@ -25,11 +26,7 @@ int find_climate_preset(const std::string &preset) {
 void TionClimate::setup() {
   ESP_LOGD(TAG, "Setting up %s...", this->get_name().c_str());
 
-  this->parent_->add_on_state_callback([this](const TionState *state) {
-    if (state) {
-      this->on_state_(*state);
-    }
-  });
+  this->parent_->add_on_state_listener(this);
 }
 
 climate::ClimateTraits TionClimate::traits() {
@@ -83,9 +80,8 @@ void TionClimate::control(const climate::ClimateCall &call) {
     if (call.get_preset().has_value()) {
       const auto preset_climate = LOG_STR_ARG(climate::climate_preset_to_string(*call.get_preset()));
       for (auto &&preset : this->parent_->api()->get_presets()) {
-        const auto preset_upper = str_upper_case(preset);
-        if (preset_upper == preset_climate) {
-          ESP_LOGD(TAG, "Set preset %s", preset.c_str());
+        if (strcasecmp(preset, preset_climate) == 0) {
+          ESP_LOGD(TAG, "Set preset %s", preset);
           this->parent_->api()->enable_preset(preset, tion);
           break;
         }
@@ -96,7 +92,7 @@ void TionClimate::control(const climate::ClimateCall &call) {
     if (call.get_custom_preset().has_value()) {
       const auto &preset = *call.get_custom_preset();
       ESP_LOGD(TAG, "Set custom preset %s", preset.c_str());
-      this->parent_->api()->enable_preset(preset, tion);
+      this->parent_->api()->enable_preset(preset.c_str(), tion);
     }
   }
 
@@ -11,7 +11,10 @@
 namespace esphome {
 namespace tion {
 
-class TionClimate : public climate::Climate, public Component, public Parented<TionApiComponent> {
+class TionClimate : public climate::Climate,
+                    public Component,
+                    public Parented<TionApiComponent>,
+                    public TionStateListener {
   using TionState = dentra::tion::TionState;
 
  public:
@@ -21,6 +24,12 @@ class TionClimate : public climate::Climate, public Component, public Parented<T
   void dump_config() override;
   void setup() override;
 
+  void on_tion_state(const TionState *state) override {
+    if (state) {
+      this->on_state_(*state);
+    }
+  }
+
   climate::ClimateTraits traits() override;
   void control(const climate::ClimateCall &call) override;
 
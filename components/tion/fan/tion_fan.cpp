@@ -11,17 +11,14 @@ static const char *const TAG = "tion_fan";
 void TionFan::setup() {
   ESP_LOGD(TAG, "Setting up %s...", this->get_name().c_str());
 
-  this->parent_->add_on_state_callback([this](const TionState *state) {
-    if (state) {
-      this->on_state_(*state);
-    }
-  });
+  this->parent_->add_on_state_listener(this);
 }
 
 fan::FanTraits TionFan::get_traits() {
   auto traits = fan::FanTraits(false, true, false, this->parent_->traits().max_fan_speed);
   if (this->parent_->api()->has_presets()) {
-    traits.set_supported_preset_modes(this->parent_->api()->get_presets());
+    const auto presets = this->parent_->api()->get_presets();
+    traits.set_supported_preset_modes(std::set<std::string>(presets.begin(), presets.end()));
   }
   return traits;
 }
@@ -36,7 +33,7 @@ void TionFan::control(const fan::FanCall &call) {
     if (!preset_mode.empty()) {
       const auto &preset = preset_mode;
       ESP_LOGD(TAG, "Set preset %s", preset.c_str());
-      this->parent_->api()->enable_preset(preset, tion);
+      this->parent_->api()->enable_preset(preset.c_str(), tion);
     }
   }
 
@@ -11,7 +11,10 @@
 namespace esphome {
 namespace tion {
 
-class TionFan : public fan::Fan, public Component, public Parented<TionApiComponent> {
+class TionFan : public fan::Fan,
+                public Component,
+                public Parented<TionApiComponent>,
+                public TionStateListener {
   using TionState = dentra::tion::TionState;
 
  public:
@@ -21,6 +24,12 @@ class TionFan : public fan::Fan, public Component, public Parented<TionApiCompon
   void dump_config() override;
   void setup() override;
 
+  void on_tion_state(const TionState *state) override {
+    if (state) {
+      this->on_state_(*state);
+    }
+  }
+
   fan::FanTraits get_traits() override;
 
  protected:
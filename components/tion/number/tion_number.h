@@ -14,7 +14,11 @@ namespace esphome {
 namespace tion {
 
 // C - PropertyController
-template<class C> class TionNumber : public number::Number, public Component, public Parented<TionApiComponent> {
+template<class C>
+class TionNumber : public number::Number,
+                   public Component,
+                   public Parented<TionApiComponent>,
+                   public TionStateListener {
   using TionState = dentra::tion::TionState;
   using PC = property_controller::Controller<C>;
   friend class property_controller::Controller<C>;
@@ -69,11 +73,13 @@ template<class C> class TionNumber : public number::Number, public Component, pu
       }
     }
 
-    this->parent_->add_on_state_callback([this](const TionState *state) {
-      if (!PC::publish_state(this, state)) {
-        this->has_state_ = false;
-      }
-    });
+    this->parent_->add_on_state_listener(this);
+  }
+
+  void on_tion_state(const TionState *state) override {
+    if (!PC::publish_state(this, state)) {
+      this->has_state_ = false;
+    }
   }
 
   void set_restore_value(bool restore_value) { this->restore_value_ = restore_value; }
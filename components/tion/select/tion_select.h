@@ -14,7 +14,11 @@ namespace esphome {
 namespace tion {
 
 // C - PropertyController
-template<class C> class TionSelect : public select::Select, public Component, public Parented<TionApiComponent> {
+template<class C>
+class TionSelect : public select::Select,
+                   public Component,
+                   public Parented<TionApiComponent>,
+                   public TionStateListener {
   using TionState = dentra::tion::TionState;
   using PC = property_controller::Controller<C>;
   constexpr static const auto *TAG = "tion_select";
@@ -46,17 +50,19 @@ template<class C> class TionSelect : public select::Select, public Component, pu
     for (auto &&opt : options) {
       ESP_LOGD(TAG, "  '%s'", opt.c_str());
     }
-    this->parent_->add_on_state_callback([this](const TionState *state) {
-      if (state) {
-        if constexpr (PC::checker().has_api_get()) {
-          this->internal_publish_state_(C::get(this->parent_));
-        } else {
-          this->internal_publish_state_(C::get(*state, this->traits.get_options()));
-        }
+    this->parent_->add_on_state_listener(this);
+  }
+
+  void on_tion_state(const TionState *state) override {
+    if (state) {
+      if constexpr (PC::checker().has_api_get()) {
+        this->internal_publish_state_(C::get(this->parent_));
       } else {
-        this->has_state_ = false;
+        this->internal_publish_state_(C::get(*state, this->traits.get_options()));
       }
-    });
+    } else {
+      this->has_state_ = false;
+    }
   }
 
  protected:
@@ -8,6 +8,7 @@ from esphome.const import (
     CONF_STATE_CLASS,
     CONF_UNIT_OF_MEASUREMENT,
     DEVICE_CLASS_DURATION,
+    DEVICE_CLASS_ENERGY,
     DEVICE_CLASS_POWER,
     DEVICE_CLASS_TEMPERATURE,
     DEVICE_CLASS_VOLUME_FLOW_RATE,
@@ -18,16 +19,19 @@ from esphome.const import (
     UNIT_CUBIC_METER,
     UNIT_CUBIC_METER_PER_HOUR,
     UNIT_KILOWATT,
+    UNIT_KILOWATT_HOURS,
+    UNIT_MILLISECOND,
     UNIT_PERCENT,
     UNIT_SECOND,
     UNIT_WATT,
 )
 
-from .. import cgp, new_pc, tion_ns
+from .. import PUBLISH_FILTER_SCHEMA, cgp, new_pc, setup_publish_filter, tion_ns
 
 TionSensor = tion_ns.class_("TionSensor", sensor.Sensor, cg.Component)
 
 UNIT_DAYS = "d"
+ICON_PROTOCOL_ERROR = "mdi:alert-circle-outline"
 
 PC = new_pc(
     {
@@ -163,6 +167,94 @@ PC = new_pc(
             CONF_UNIT_OF_MEASUREMENT: UNIT_SECOND,
             CONF_ACCURACY_DECIMALS: 0,
         },
+        "rx_frames": {
+            CONF_ENTITY_CATEGORY: ENTITY_CATEGORY_DIAGNOSTIC,
+            CONF_STATE_CLASS: STATE_CLASS_TOTAL_INCREASING,
+            CONF_ICON: "mdi:download-network",
+            CONF_ACCURACY_DECIMALS: 0,
+        },
+        "tx_frames": {
+            CONF_ENTITY_CATEGORY: ENTITY_CATEGORY_DIAGNOSTIC,
+            CONF_STATE_CLASS: STATE_CLASS_TOTAL_INCREASING,
+            CONF_ICON: "mdi:upload-network",
+            CONF_ACCURACY_DECIMALS: 0,
+        },
+        "crc_errors": {
+            CONF_ENTITY_CATEGORY: ENTITY_CATEGORY_DIAGNOSTIC,
+            CONF_STATE_CLASS: STATE_CLASS_TOTAL_INCREASING,
+            CONF_ICON: ICON_PROTOCOL_ERROR,
+            CONF_ACCURACY_DECIMALS: 0,
+        },
+        "invalid_size": {
+            CONF_ENTITY_CATEGORY: ENTITY_CATEGORY_DIAGNOSTIC,
+            CONF_STATE_CLASS: STATE_CLASS_TOTAL_INCREASING,
+            CONF_ICON: ICON_PROTOCOL_ERROR,
+            CONF_ACCURACY_DECIMALS: 0,
+        },
+        "invalid_magic": {
+            CONF_ENTITY_CATEGORY: ENTITY_CATEGORY_DIAGNOSTIC,
+            CONF_STATE_CLASS: STATE_CLASS_TOTAL_INCREASING,
+            CONF_ICON: ICON_PROTOCOL_ERROR,
+            CONF_ACCURACY_DECIMALS: 0,
+        },
+        "resyncs": {
+            CONF_ENTITY_CATEGORY: ENTITY_CATEGORY_DIAGNOSTIC,
+            CONF_STATE_CLASS: STATE_CLASS_TOTAL_INCREASING,
+            CONF_ICON: "mdi:sync-alert",
+            CONF_ACCURACY_DECIMALS: 0,
+        },
+        "unknown_types": {
+            CONF_ENTITY_CATEGORY: ENTITY_CATEGORY_DIAGNOSTIC,
+            CONF_STATE_CLASS: STATE_CLASS_TOTAL_INCREASING,
+            CONF_ICON: ICON_PROTOCOL_ERROR,
+            CONF_ACCURACY_DECIMALS: 0,
+        },
+        "reassembly_drops": {
+            CONF_ENTITY_CATEGORY: ENTITY_CATEGORY_DIAGNOSTIC,
+            CONF_STATE_CLASS: STATE_CLASS_TOTAL_INCREASING,
+            CONF_ICON: ICON_PROTOCOL_ERROR,
+            CONF_ACCURACY_DECIMALS: 0,
+        },
+        "timeouts": {
+            CONF_ENTITY_CATEGORY: ENTITY_CATEGORY_DIAGNOSTIC,
+            CONF_STATE_CLASS: STATE_CLASS_TOTAL_INCREASING,
+            CONF_ICON: "mdi:timer-alert-outline",
+            CONF_ACCURACY_DECIMALS: 0,
+        },
+        "write_errors": {
+            CONF_ENTITY_CATEGORY: ENTITY_CATEGORY_DIAGNOSTIC,
+            CONF_STATE_CLASS: STATE_CLASS_TOTAL_INCREASING,
+            CONF_ICON: ICON_PROTOCOL_ERROR,
+            CONF_ACCURACY_DECIMALS: 0,
+        },
+        **{
+            f"{section}_time_{kind}": {
+                CONF_ENTITY_CATEGORY: ENTITY_CATEGORY_DIAGNOSTIC,
+                CONF_DEVICE_CLASS: DEVICE_CLASS_DURATION,
+                CONF_STATE_CLASS: STATE_CLASS_MEASUREMENT,
+                CONF_ICON: "mdi:timer-outline",
+                CONF_UNIT_OF_MEASUREMENT: UNIT_MILLISECOND,
+                CONF_ACCURACY_DECIMALS: 3,
+            }
+            for section in ["loop", "poll", "frame", "write", "publish", "perform"]
+            for kind in ["max", "p99"]
+        },
+        "worst_frame_type": {
+            CONF_ENTITY_CATEGORY: ENTITY_CATEGORY_DIAGNOSTIC,
+            CONF_ICON: "mdi:timer-alert-outline",
+            CONF_ACCURACY_DECIMALS: 0,
+        },
+        **{
+            key: {
+                CONF_ENTITY_CATEGORY: ENTITY_CATEGORY_DIAGNOSTIC,
+                CONF_DEVICE_CLASS: DEVICE_CLASS_ENERGY,
+                CONF_STATE_CLASS: STATE_CLASS_TOTAL_INCREASING,
+                CONF_UNIT_OF_MEASUREMENT: UNIT_KILOWATT_HOURS,
+                CONF_ACCURACY_DECIMALS: 3,
+            }
+            for key in ["energy", "heater_energy", "fan_energy"]
+            + [f"fan_speed_{speed}_energy" for speed in range(7)]
+        },
         # aliases
         "fan": "fan_speed",
         "speed": "fan_speed",
@@ -171,8 +263,9 @@ PC = new_pc(
 )
 
 
-CONFIG_SCHEMA = PC.sensor_schema(TionSensor)
+CONFIG_SCHEMA = PC.sensor_schema(TionSensor, PUBLISH_FILTER_SCHEMA)
 
 
 async def to_code(config: dict):
-    await PC.new_sensor(config)
+    var = await PC.new_sensor(config)
+    setup_publish_filter(config, var)
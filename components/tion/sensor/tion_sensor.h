@@ -13,7 +13,12 @@ namespace esphome {
 namespace tion {
 
 // C - PropertyController
-template<class C> class TionSensor : public sensor::Sensor, public Component, public Parented<TionApiComponent> {
+template<class C>
+class TionSensor : public sensor::Sensor,
+                   public Component,
+                   public Parented<TionApiComponent>,
+                   public property_controller::PublishFilter,
+                   public TionStateListener {
   using TionState = dentra::tion::TionState;
   using PC = property_controller::Controller<C>;
 
@@ -37,12 +42,14 @@ template<class C> class TionSensor : public sensor::Sensor, public Component, pu
     if (!PC::is_supported(this)) {
       return;
     }
-    this->parent_->add_on_state_callback([this](const TionState *state) {
-      if (!PC::publish_state(this, state)) {
-        this->has_state_ = false;
-        this->callback_.call(NAN);
-      }
-    });
+    this->parent_->add_on_state_listener(this);
+  }
+
+  void on_tion_state(const TionState *state) override {
+    if (!PC::publish_state(this, state)) {
+      this->has_state_ = false;
+      this->callback_.call(NAN);
+    }
   }
 };
 
@@ -14,7 +14,11 @@ namespace esphome {
 namespace tion {
 
 // C - PropertyController
-template<class C> class TionSwitch : public switch_::Switch, public Component, public Parented<TionApiComponent> {
+template<class C>
+class TionSwitch : public switch_::Switch,
+                   public Component,
+                   public Parented<TionApiComponent>,
+                   public TionStateListener {
   friend class property_controller::Controller<C>;
 
   constexpr static const auto *TAG = "tion_switch";
@@ -41,10 +45,11 @@ template<class C> class TionSwitch : public switch_::Switch, public Component, p
     if (!PC::is_supported(this)) {
       return;
     }
-    this->parent_->add_on_state_callback(
-        [this](const TionState *state) { this->has_state_ = PC::publish_state(this, state); });
+    this->parent_->add_on_state_listener(this);
   }
 
+  void on_tion_state(const TionState *state) override { this->has_state_ = PC::publish_state(this, state); }
+
   bool assumed_state() override { return this->is_failed(); }
 
   bool has_state() const { return this->has_state_; }
@@ -14,7 +14,10 @@ namespace tion {
 
 // C - PropertyController
 template<class C>
-class TionTextSensor : public text_sensor::TextSensor, public Component, public Parented<TionApiComponent> {
+class TionTextSensor : public text_sensor::TextSensor,
+                       public Component,
+                       public Parented<TionApiComponent>,
+                       public TionStateListener {
   using TionState = dentra::tion::TionState;
   using PC = property_controller::Controller<C>;
 
@@ -35,12 +38,14 @@ class TionTextSensor : public text_sensor::TextSensor, public Component, public
   void setup() override {
     ESP_LOGD(TAG, "Setting up %s...", this->get_name().c_str());
 
-    this->parent_->add_on_state_callback([this](const TionState *state) {
-      if (!PC::publish_state(this, state)) {
-        this->has_state_ = false;
-        this->callback_.call("");
-      }
-    });
+    this->parent_->add_on_state_listener(this);
+  }
+
+  void on_tion_state(const TionState *state) override {
+    if (!PC::publish_state(this, state)) {
+      this->has_state_ = false;
+      this->callback_.call("");
+    }
   }
 };
 
@@ -0,0 +1,148 @@
+#ifdef TION_ENABLE_ARBITER
+#include <cstdio>
+#include <cstring>
+
+#include "esphome/core/log.h"
+
+#include "tion_arbiter.h"
+
+namespace esphome {
+namespace tion {
+
+static const char *const TAG = "tion_arbiter";
+
+TionArbiter::Result TionArbiter::write(uint32_t now, uint16_t type, const void *data, size_t size) {
+  if (this->lane_ == LANE_UPDATE) {
+    return this->send_(this->lane_, now, 0, type, data, size);
+  }
+  if (size > TION_ARBITER_FRAME_SIZE) {
+    // например блоки прошивки, отправляются без очереди
+    ESP_LOGV(TAG, "Frame %04X is too large to queue: %zu", type, size);
+    return this->send_(this->lane_, now, 0, type, data, size);
+  }
+  if (this->is_empty() && this->is_ready_(now)) {
+    return this->send_(this->lane_, now, 0, type, data, size);
+  }
+  this->push_(this->lane_, now, type, data, size);
+  return RESULT_QUEUED;
+}
+
+void TionArbiter::loop(uint32_t now) {
+  if (!this->is_ready_(now)) {
+    return;
+  }
+  const Lane lane = this->next_lane_(now);
+  if (lane == LANES) {
+    return;
+  }
+  auto &queue = this->lanes_[lane];
+  // копия, т.к. при отправке в очередь может быть помещен новый кадр
+  const Entry entry = queue.at(0);
+  queue.head = (queue.head + 1) % TION_ARBITER_QUEUE_SIZE;
+  queue.count--;
+  this->send_(lane, now, now - entry.time, entry.type, entry.data, entry.size);
+}
+
+bool TionArbiter::is_empty() const {
+  for (auto &&queue : this->lanes_) {
+    if (queue.count != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TionArbiter::push_(Lane lane, uint32_t now, uint16_t type, const void *data, size_t size) {
+  auto &queue = this->lanes_[lane];
+  Entry *entry = nullptr;
+  if (lane == LANE_POLL) {
+    // повторный запрос опроса заменяет такой же ожидающий, место в очереди сохраняется.
+    // запросы с параметрами (например, таймер с другим номером) сравниваются с данными.
+    for (uint8_t i = 0; i < queue.count; i++) {
+      const auto &queued = queue.at(i);
+      if (queued.type == type && queued.size == size && (size == 0 || std::memcmp(queued.data, data, size) == 0)) {
+        entry = &queue.at(i);
+        this->stats_[lane].dropped++;
+        break;
+      }
+    }
+  }
+  if (entry == nullptr) {
+    if (queue.count == TION_ARBITER_QUEUE_SIZE) {
+      ESP_LOGW(TAG, "Lane %s is full, drop frame %04X", get_lane_name(lane), queue.at(0).type);
+      queue.head = (queue.head + 1) % TION_ARBITER_QUEUE_SIZE;
+      queue.count--;
+      this->stats_[lane].dropped++;
+      if (this->protocol_stats_) {
+        this->protocol_stats_->inc(dentra::tion::TionProtocolStats::WRITE_ERRORS);
+      }
+    }
+    entry = &queue.at(queue.count++);
+    entry->time = now;
+  }
+  entry->type = type;
+  entry->size = size;
+  if (size) {
+    std::memcpy(entry->data, data, size);
+  }
+  ESP_LOGV(TAG, "Queue %s frame %04X, queued %u", get_lane_name(lane), type, queue.count);
+}
+
+TionArbiter::Result TionArbiter::send_(Lane lane, uint32_t now, uint32_t delay, uint16_t type, const void *data,
+                                       size_t size) {
+  this->last_time_ = now == 0 ? 1 : now;
+  this->last_lane_ = lane;
+  auto &wnd = this->windows_[lane];
+  wnd.count++;
+  wnd.delay_sum += delay;
+  if (delay > wnd.delay_max) {
+    wnd.delay_max = delay;
+  }
+  this->stats_[lane].sent++;
+  if (!this->writer_) {
+    ESP_LOGE(TAG, "Writer is not configured");
+    return RESULT_FAILED;
+  }
+  return this->writer_(type, data, size) ? RESULT_SENT : RESULT_FAILED;
+}
+
+TionArbiter::Lane TionArbiter::next_lane_(uint32_t now) const {
+  Lane next = LANES;
+  uint32_t oldest = 0;
+  for (uint8_t i = 0; i < LANES; i++) {
+    const auto &queue = this->lanes_[i];
+    if (queue.count == 0) {
+      continue;
+    }
+    if (next == LANES) {
+      next = static_cast<Lane>(i);
+    }
+    // дольше всех ожидающий кадр, если время ожидания вышло
+    const uint32_t wait = now - queue.at(0).time;
+    if (this->max_wait_ != 0 && wait >= this->max_wait_ && wait > oldest) {
+      oldest = wait;
+      next = static_cast<Lane>(i);
+    }
+  }
+  return next;
+}
+
+void TionArbiter::snapshot() {
+  for (uint8_t i = 0; i < LANES; i++) {
+    auto &wnd = this->windows_[i];
+    auto &res = this->stats_[i];
+    res.delay_avg = wnd.count ? wnd.delay_sum / wnd.count : 0;
+    res.delay_max = wnd.delay_max;
+    wnd = {};
+  }
+}
+
+const char *TionArbiter::get_lane_name(Lane lane) {
+  static const char *const NAMES[LANES] = {"rc", "user", "auto", "poll", "update"};
+  return lane < LANES ? NAMES[lane] : "";
+}
+
+}  // namespace tion
+}  // namespace esphome
+
+#endif  // TION_ENABLE_ARBITER
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <etl/delegate.h>
+
+#include "../tion-api/tion-api-protocol.h"
+
+#ifndef TION_ARBITER_QUEUE_SIZE
+#define TION_ARBITER_QUEUE_SIZE 4
+#endif
+#ifndef TION_ARBITER_FRAME_SIZE
+#define TION_ARBITER_FRAME_SIZE 48
+#endif
+
+namespace esphome {
+namespace tion {
+
+/// Арбитр канала связи с бризером.
+///
+/// Кадры от разных источников распределяются по полосам с приоритетом, пульт и управление
+/// пользователя вытесняют автоматику и опрос. Очереди полос ограничены, кадр полосы,
+/// ожидающий дольше max_wait, отправляется вне очереди приоритетов, поэтому низкие полосы
+/// не голодают. Между кадрами выдерживается интервал interval, свободный канал с пустыми
+/// очередями пропускает кадр сразу. Кадры полосы обновления прошивки не ставятся в очередь,
+/// поэтому никогда не замещаются, не отбрасываются и не меняют порядок.
+class TionArbiter {
+ public:
+  // в порядке убывания приоритета
+  enum Lane : uint8_t {
+    // пульт tion_rc
+    LANE_RC,
+    // управление сущностями, кнопками, сервисами
+    LANE_USER,
+    // auto, пресеты, турбо-режим, антизамерзание
+    LANE_AUTO,
+    // периодический опрос состояния, таймеры, диагностика
+    LANE_POLL,
+    // обновление прошивки, кадры отправляются сразу в порядке записи
+    LANE_UPDATE,
+    LANES,
+  };
+
+  enum Result : uint8_t {
+    // кадр не отправлен
+    RESULT_FAILED,
+    // кадр отправлен
+    RESULT_SENT,
+    // кадр помещен в очередь, позже может быть замещен или отброшен
+    RESULT_QUEUED,
+  };
+
+  struct Stats {
+    // отправлено кадров
+    uint32_t sent;
+    // отброшено при переполнении очереди или замещено таким же кадром опроса
+    uint32_t dropped;
+    // время ожидания в очереди за последнее окно, мс
+    uint32_t delay_avg;
+    uint32_t delay_max;
+  };
+
+  using writer_type = etl::delegate<bool(uint16_t type, const void *data, size_t size)>;
+  void set_writer(writer_type &&writer) { this->writer_ = writer; }
+
+  /// Минимальный интервал между кадрами, мс.
+  void set_interval(uint32_t interval) { this->interval_ = interval; }
+  uint32_t get_interval() const { return this->interval_; }
+  /// Максимальное время ожидания кадра в очереди до отправки вне приоритета, мс.
+  void set_max_wait(uint32_t max_wait) { this->max_wait_ = max_wait; }
+  uint32_t get_max_wait() const { return this->max_wait_; }
+  /// Счетчики протокола, отброшенные при переполнении очереди кадры учитываются как ошибки записи.
+  void set_protocol_stats(const dentra::tion::TionProtocolStats *stats) { this->protocol_stats_ = stats; }
+
+  /// Полоса, в которую помещаются записываемые кадры.
+  Lane get_lane() const { return this->lane_; }
+  void set_lane(Lane lane) { this->lane_ = lane; }
+  /// Полоса последнего отправленного кадра. Бризер отвечает на запросы по порядку,
+  /// поэтому кадры, отправляемые при обработке ответа, продолжают полосу запроса.
+  Lane get_last_lane() const { return this->last_lane_; }
+
+  /// Записывает кадр в канал или помещает в очередь текущей полосы.
+  Result write(uint32_t now, uint16_t type, const void *data, size_t size);
+  /// Отправляет следующий кадр из очередей, если канал свободен.
+  void loop(uint32_t now);
+
+  bool is_empty() const;
+  size_t get_queued(Lane lane) const { return this->lanes_[lane].count; }
+
+  /// Фиксирует статистику задержек текущего окна и начинает новое.
+  void snapshot();
+  const Stats &get_stats(Lane lane) const { return this->stats_[lane]; }
+
+  static const char *get_lane_name(Lane lane);
+
+  /// Переключает полосу на время жизни объекта.
+  class Scope {
+   public:
+    Scope(TionArbiter *arbiter, Lane lane) : arbiter_(arbiter), prev_(arbiter ? arbiter->lane_ : LANE_USER) {
+      if (arbiter) {
+        arbiter->lane_ = lane;
+      }
+    }
+    ~Scope() {
+      if (this->arbiter_) {
+        this->arbiter_->lane_ = this->prev_;
+      }
+    }
+
+   protected:
+    TionArbiter *arbiter_;
+    Lane prev_;
+  };
+
+ protected:
+  struct Entry {
+    uint32_t time;
+    uint16_t type;
+    uint8_t size;
+    uint8_t data[TION_ARBITER_FRAME_SIZE];
+  };
+  struct Queue {
+    Entry entries[TION_ARBITER_QUEUE_SIZE];
+    uint8_t head;
+    uint8_t count;
+    Entry &at(uint8_t i) { return this->entries[(this->head + i) % TION_ARBITER_QUEUE_SIZE]; }
+    const Entry &at(uint8_t i) const { return this->entries[(this->head + i) % TION_ARBITER_QUEUE_SIZE]; }
+  };
+  struct Window {
+    uint32_t count;
+    uint32_t delay_sum;
+    uint32_t delay_max;
+  };
+
+  writer_type writer_{};
+  const dentra::tion::TionProtocolStats *protocol_stats_{};
+  uint32_t interval_{};
+  uint32_t max_wait_{};
+  uint32_t last_time_{};
+  Lane lane_{LANE_USER};
+  Lane last_lane_{LANE_AUTO};
+  Queue lanes_[LANES]{};
+  Window windows_[LANES]{};
+  Stats stats_[LANES]{};
+
+  bool is_ready_(uint32_t now) const { return this->last_time_ == 0 || now - this->last_time_ >= this->interval_; }
+  void push_(Lane lane, uint32_t now, uint16_t type, const void *data, size_t size);
+  Result send_(Lane lane, uint32_t now, uint32_t delay, uint16_t type, const void *data, size_t size);
+  /// Полоса для следующей отправки, LANES если очереди пусты.
+  Lane next_lane_(uint32_t now) const;
+};
+
+#ifdef TION_ENABLE_ARBITER
+#define TION_ARBITER_LANE(arbiter, lane) \
+  esphome::tion::TionArbiter::Scope tion_arbiter_scope_(arbiter, esphome::tion::TionArbiter::lane)
+#else
+#define TION_ARBITER_LANE(arbiter, lane)
+#endif
+
+}  // namespace tion
+}  // namespace esphome
@@ -0,0 +1,166 @@
+#ifdef TION_ENABLE_BULK
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+
+#include "tion_component.h"
+#include "tion_bulk.h"
+
+namespace esphome {
+namespace tion {
+
+static const char *const TAG = "tion_bulk";
+
+namespace {
+
+// CBOR (RFC 8949): заголовок элемента с основным типом major и значением value.
+void cbor_head(std::string &out, uint8_t major, uint64_t value) {
+  major <<= 5;
+  if (value < 24) {
+    out += char(major | value);
+    return;
+  }
+  uint8_t size = value <= 0xFF ? 1 : value <= 0xFFFF ? 2 : value <= 0xFFFFFFFF ? 4 : 8;
+  out += char(major | (size == 1 ? 24 : size == 2 ? 25 : size == 4 ? 26 : 27));
+  while (size-- > 0) {
+    out += char(value >> (size * 8));
+  }
+}
+
+void cbor_int(std::string &out, int64_t value) {
+  if (value >= 0) {
+    cbor_head(out, 0, value);
+  } else {
+    cbor_head(out, 1, -1 - value);
+  }
+}
+
+void cbor_text(std::string &out, const char *str) {
+  const size_t len = std::strlen(str);
+  cbor_head(out, 3, len);
+  out.append(str, len);
+}
+
+}  // namespace
+
+TionBulkPublisher::TionBulkPublisher(TionApiComponent *parent, Format format) : format_(format) {
+  if (parent) {
+    parent->add_on_state_listener(this);
+  }
+}
+
+int64_t TionBulkPublisher::get_field(Field field, const dentra::tion::TionState &state) {
+  switch (field) {
+    case FIELD_POWER:
+      return state.power_state;
+    case FIELD_HEATER:
+      return state.heater_state;
+    case FIELD_FAN_SPEED:
+      return state.fan_speed;
+    case FIELD_TARGET_TEMPERATURE:
+      return state.target_temperature;
+    case FIELD_OUTDOOR_TEMPERATURE:
+      return state.outdoor_temperature;
+    case FIELD_CURRENT_TEMPERATURE:
+      return state.current_temperature;
+    case FIELD_GATE_POSITION:
+      return static_cast<int64_t>(state.gate_position);
+    case FIELD_AUTO:
+      return state.auto_state;
+    case FIELD_PRODUCTIVITY:
+      return state.productivity;
+    case FIELD_HEATER_VAR:
+      return state.heater_var;
+    case FIELD_FILTER:
+      return state.filter_state;
+    case FIELD_FILTER_TIME_LEFT:
+      return state.filter_time_left;
+    case FIELD_WORK_TIME:
+      return state.work_time;
+    case FIELD_AIRFLOW_COUNTER:
+      return state.airflow_counter;
+    case FIELD_BOOST_TIME_LEFT:
+      return state.boost_time_left;
+    case FIELD_ERRORS:
+      return state.errors;
+    default:
+      return 0;
+  }
+}
+
+const char *TionBulkPublisher::get_field_key(Field field) {
+  static const char *const KEYS[FIELDS] = {"p",  "h",  "s",  "tt", "to", "tc", "g",  "a",
+                                           "pr", "hv", "f",  "fl", "wt", "af", "bt", "e"};
+  return field < FIELDS ? KEYS[field] : "";
+}
+
+std::string TionBulkPublisher::make_message(uint32_t time, const dentra::tion::TionState &state) {
+  const bool full = this->full_time_ == 0 || time - this->full_time_ >= this->full_interval_;
+  if (full) {
+    this->full_time_ = time == 0 ? 1 : time;
+  }
+
+  int64_t values[FIELDS];
+  uint8_t changed = 0;
+  for (uint8_t i = 0; i < FIELDS; i++) {
+    values[i] = get_field(static_cast<Field>(i), state);
+    if (full || values[i] != this->values_[i]) {
+      changed++;
+    }
+  }
+  if (changed == 0) {
+    return {};
+  }
+
+  std::string out;
+  if (this->format_ == FORMAT_CBOR) {
+    cbor_head(out, 5, changed + full);
+    if (full) {
+      cbor_text(out, "full");
+      out += char(0xF5);  // true
+    }
+  } else {
+    out += full ? "{\"full\":true" : "{";
+  }
+  for (uint8_t i = 0; i < FIELDS; i++) {
+    if (!full && values[i] == this->values_[i]) {
+      continue;
+    }
+    this->values_[i] = values[i];
+    const char *key = get_field_key(static_cast<Field>(i));
+    if (this->format_ == FORMAT_CBOR) {
+      cbor_text(out, key);
+      cbor_int(out, values[i]);
+    } else {
+      char buf[32];
+      std::snprintf(buf, sizeof(buf), "%s\"%s\":%" PRId64, out.size() > 1 ? "," : "", key, values[i]);
+      out += buf;
+    }
+  }
+  if (this->format_ == FORMAT_JSON) {
+    out += '}';
+  }
+  return out;
+}
+
+void TionBulkPublisher::on_tion_state(const dentra::tion::TionState *state) {
+  if (state == nullptr) {
+    // после восстановления связи получатель должен получить полное состояние
+    this->reset();
+    return;
+  }
+  const auto message = this->make_message(millis(), *state);
+  if (message.empty()) {
+    return;
+  }
+  ESP_LOGV(TAG, "Publish %zu bytes", message.size());
+  this->publish_callback_.call(message);
+}
+
+}  // namespace tion
+}  // namespace esphome
+
+#endif  // TION_ENABLE_BULK
@@ -0,0 +1,77 @@
+#pragma once
+#ifdef TION_ENABLE_BULK
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "esphome/core/helpers.h"
+
+#include "../tion-api/tion-api.h"
+#include "tion_state_listener.h"
+
+namespace esphome {
+namespace tion {
+
+class TionApiComponent;
+
+/// Публикация изменений состояния бризера одним сообщением вместо отдельных публикаций сущностей.
+///
+/// Сообщение содержит только изменившиеся с предыдущего сообщения поля с короткими ключами,
+/// полное состояние передается первым сообщением, после ошибки получения состояния и не реже
+/// full_interval. Полное состояние отмечается ключом "full".
+/// Отправка сообщения (MQTT, событие Home Assistant) выполняется автоматизацией on_publish.
+class TionBulkPublisher : public TionStateListener {
+ public:
+  enum Format : uint8_t { FORMAT_JSON, FORMAT_CBOR };
+
+  enum Field : uint8_t {
+    FIELD_POWER,
+    FIELD_HEATER,
+    FIELD_FAN_SPEED,
+    FIELD_TARGET_TEMPERATURE,
+    FIELD_OUTDOOR_TEMPERATURE,
+    FIELD_CURRENT_TEMPERATURE,
+    FIELD_GATE_POSITION,
+    FIELD_AUTO,
+    FIELD_PRODUCTIVITY,
+    FIELD_HEATER_VAR,
+    FIELD_FILTER,
+    FIELD_FILTER_TIME_LEFT,
+    FIELD_WORK_TIME,
+    FIELD_AIRFLOW_COUNTER,
+    FIELD_BOOST_TIME_LEFT,
+    FIELD_ERRORS,
+    FIELDS,
+  };
+
+  TionBulkPublisher(TionApiComponent *parent, Format format);
+
+  void set_full_interval(uint32_t full_interval) { this->full_interval_ = full_interval; }
+
+  void add_on_publish_callback(std::function<void(const std::string &)> &&callback) {
+    this->publish_callback_.add(std::move(callback));
+  }
+
+  /// Формирует сообщение по новому состоянию, пустая строка - изменений нет.
+  std::string make_message(uint32_t time, const dentra::tion::TionState &state);
+  /// Следующее сообщение будет содержать полное состояние.
+  void reset() { this->full_time_ = 0; }
+
+  void on_tion_state(const dentra::tion::TionState *state) override;
+
+  static int64_t get_field(Field field, const dentra::tion::TionState &state);
+  static const char *get_field_key(Field field);
+
+ protected:
+  Format format_;
+  uint32_t full_interval_{600000};
+  uint32_t full_time_{};
+  int64_t values_[FIELDS]{};
+  CallbackManager<void(const std::string &)> publish_callback_{};
+};
+
+}  // namespace tion
+}  // namespace esphome
+
+#endif  // TION_ENABLE_BULK
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cinttypes>
+#include <cstdio>
 #include <ctime>
 
 #include "esphome/core/log.h"
@@ -13,6 +15,13 @@ static const char *const BATCH_TIMEOUT = "batch_timeout";
 
 void TionApiComponent::BatchStateCall::perform() {
   this->start_time_ = millis();
+#ifdef TION_ENABLE_ARBITER
+  // изменения пользователя, объединенные с автоматикой, отправляются с приоритетом пользователя
+  const auto lane = this->c_->arbiter_.get_lane();
+  if (lane < this->lane_) {
+    this->lane_ = lane;
+  }
+#endif
   if (this->c_->batch_timeout_) {
     this->c_->set_timeout(BATCH_TIMEOUT, this->c_->batch_timeout_, [this]() { this->perform_(); });
   } else {
@@ -21,7 +30,13 @@ void TionApiComponent::BatchStateCall::perform() {
 }
 
 void TionApiComponent::BatchStateCall::perform_() {
+  TION_TIMING_SCOPE(this->c_->get_timing(), SECTION_PERFORM);
   ESP_LOGD(TAG, "Write out batch changes");
+#ifdef TION_ENABLE_ARBITER
+  TionArbiter::Scope lane_scope(&this->c_->arbiter_,
+                                this->lane_ == TionArbiter::LANES ? TionArbiter::LANE_USER : this->lane_);
+  this->lane_ = TionArbiter::LANES;
+#endif
 #ifdef TION_ENABLE_API_CONTROL_CALLBACK
   this->c_->control_callback_.call(this);
 #endif
@@ -40,7 +55,13 @@ void TionApiComponent::call_setup() {
 
 // обработка и обновление App.app_state_ происходит только для компонентов
 // переопределяющих loop или call_loop (см. application.cpp:148)
-void TionApiComponent::call_loop() { PollingComponent::call_loop(); }
+void TionApiComponent::call_loop() {
+  TION_TIMING_SCOPE(this->get_timing(), SECTION_LOOP);
+#ifdef TION_ENABLE_ARBITER
+  this->arbiter_.loop(millis());
+#endif
+  PollingComponent::call_loop();
+}
 
 void TionApiComponent::dump_config() {
   ESP_LOGCONFIG(TAG, "%s:", this->get_component_source());
@@ -51,9 +72,23 @@ void TionApiComponent::dump_config() {
   if (this->traits().supports_manual_antifreeze) {
     ESP_LOGCONFIG(TAG, "  Manual antifreeze: enabled");
   }
+#ifdef TION_ENABLE_ARBITER
+  ESP_LOGCONFIG(TAG, "  Arbiter: interval %" PRIu32 " ms, max wait %" PRIu32 " ms, queue %u", this->arbiter_.get_interval(),
+                this->arbiter_.get_max_wait(), TION_ARBITER_QUEUE_SIZE);
+#endif
+  const auto *stats = this->api_->get_errors_stats();
+  for (size_t i = 0; i < this->api_->get_errors_stats_size(); i++) {
+    char code[TION_ERRORS_TEXT_SIZE]{};
+    if (this->traits().errors_decode) {
+      this->traits().errors_decode(stats[i].code, code, sizeof(code));
+    }
+    ESP_LOGCONFIG(TAG, "  Alert %s: %u times, first seen at %.1f s", code, stats[i].count,
+                  stats[i].first_seen * 0.001f);
+  }
 }
 
 void TionApiComponent::update() {
+  TION_ARBITER_LANE(this->get_arbiter(), LANE_POLL);
   this->api_->request_state();
   this->state_check_schedule_();
 }
@@ -63,12 +98,22 @@ void TionApiComponent::on_state_(const TionState &state, const uint32_t request_
   // clear error reporting
   this->status_clear_error();
   this->cancel_timeout(STATE_TIMEOUT);
+  this->update_stats_();
+  this->update_energy_(&state);
   // notify state
-  this->defer([this]() { this->state_callback_.call(&this->state()); });
+  this->defer([this]() {
+    TION_TIMING_SCOPE(this->get_timing(), SECTION_PUBLISH);
+    this->notify_state_(&this->state());
+  });
 }
 
 void TionApiComponent::state_check_schedule_() {
   this->set_timeout(STATE_TIMEOUT, this->state_timeout_, [this]() {
+    if (this->protocol_stats_) {
+      this->protocol_stats_->inc(dentra::tion::TionProtocolStats::TIMEOUTS);
+    }
+    this->update_stats_();
+    this->update_energy_(nullptr);
     // error reporting
     if (this->status_has_error()) {
       ESP_LOGW(TAG, "State was not received in %.1f s", this->state_timeout_ * 0.001f);
@@ -76,11 +121,80 @@ void TionApiComponent::state_check_schedule_() {
       this->status_set_error(str_sprintf("State was not received in %.1f s", this->state_timeout_ * 0.001f).c_str());
     }
     // notify subscribers
-    this->state_callback_.call(nullptr);
+    this->notify_state_(nullptr);
   });
 }
 
-dentra::tion::TionStateCall *TionApiComponent::make_call() {
+void TionApiComponent::add_on_state_listener(TionStateListener *listener) {
+  listener->next_state_listener_ = nullptr;
+  if (this->state_listeners_tail_) {
+    this->state_listeners_tail_->next_state_listener_ = listener;
+  } else {
+    this->state_listeners_ = listener;
+  }
+  this->state_listeners_tail_ = listener;
+}
+
+void TionApiComponent::notify_state_(const TionState *state) {
+  for (auto *listener = this->state_listeners_; listener; listener = listener->next_state_listener_) {
+    listener->on_tion_state(state);
+  }
+  this->state_callback_.call(state);
+}
+
+void TionApiComponent::update_stats_() {
+  // статистика публикуется вместе с состоянием, поэтому ограничиваем частоту ее обновления
+  const uint32_t now = millis();
+  if (this->stats_time_ != 0 && now - this->stats_time_ < this->stats_interval_) {
+    return;
+  }
+  this->stats_time_ = now == 0 ? 1 : now;
+  if (this->protocol_stats_) {
+    for (uint8_t i = 0; i < dentra::tion::TionProtocolStats::COUNTERS; i++) {
+      this->protocol_counters_[i] =
+          this->protocol_stats_->get(static_cast<dentra::tion::TionProtocolStats::Counter>(i));
+    }
+  }
+#ifdef TION_ENABLE_TIMING
+  this->timing_.snapshot();
+  for (uint8_t i = 0; i < TionTiming::SECTIONS; i++) {
+    const auto section = static_cast<TionTiming::Section>(i);
+    const auto &res = this->timing_.get(section);
+    ESP_LOGD(TAG, "Timing %s: count=%" PRIu32 ", max=%" PRIu32 " us, p99=%" PRIu32 " us",
+             TionTiming::get_section_name(section), res.count, res.max, res.p99);
+  }
+  ESP_LOGD(TAG, "Timing worst frame: %04X", this->timing_.get_worst_frame_type());
+#endif
+#ifdef TION_ENABLE_ARBITER
+  this->arbiter_.snapshot();
+  for (uint8_t i = 0; i < TionArbiter::LANES; i++) {
+    const auto lane = static_cast<TionArbiter::Lane>(i);
+    const auto &st = this->arbiter_.get_stats(lane);
+    ESP_LOGD(TAG, "Arbiter %s: sent=%" PRIu32 ", dropped=%" PRIu32 ", delay avg=%" PRIu32 " ms, max=%" PRIu32 " ms",
+             TionArbiter::get_lane_name(lane), st.sent, st.dropped, st.delay_avg, st.delay_max);
+  }
+#endif
+}
+
+void TionApiComponent::update_energy_(const TionState *state) {
+#ifdef TION_ENABLE_ENERGY
+  const uint32_t now = millis();
+  if (state) {
+    this->energy_.add(now, *state, this->traits());
+  } else {
+    // мощность неизвестна, учет возобновится со следующим состоянием
+    this->energy_.reset_time();
+  }
+  // энергия публикуется вместе с состоянием, поэтому ограничиваем частоту ее обновления
+  if (this->energy_time_ != 0 && now - this->energy_time_ < this->energy_interval_) {
+    return;
+  }
+  this->energy_time_ = now == 0 ? 1 : now;
+  this->energy_.snapshot();
+#endif
+}
+
+TionApiComponent::BatchStateCall *TionApiComponent::make_call() {
   const auto batch_start_time = this->batch_call_.get_start_time();
   if (batch_start_time != 0) {
     ESP_LOGD(TAG, "Continue batch update: %" PRIu32 " ms", millis() - batch_start_time);
@@ -90,6 +204,7 @@ dentra::tion::TionStateCall *TionApiComponent::make_call() {
   return &this->batch_call_;
 }
 
+#ifdef TION_API_4S
 #ifdef TION_ENABLE_SCHEDULER
 
 void Tion4sApiComponent::on_time(time_t time, uint32_t request_id) {
@@ -102,31 +217,46 @@ void Tion4sApiComponent::on_time(time_t time, uint32_t request_id) {
   ESP_LOGI(TAG, "Device local time: %s", buf);
 }
 
+// "MON, TUE, WED, THU, FRI, SAT" и завершающий ноль
+static constexpr size_t TIMER_SCHEDULE_SIZE = 29;
+
+// Дни недели таймера в виде "MON, TUE" или "MON-SUN" в буфер buf размером size, возвращает длину строки.
+static size_t timer_schedule(const dentra::tion_4s::tion4s_timer_t &timer, char *buf, size_t size) {
+  if (buf == nullptr || size == 0) {
+    return 0;
+  }
+  size_t len = 0;
+  buf[0] = 0;
+
+  auto add_week_day = [buf, size, &len](bool day, const char *day_name) {
+    // ", MON" - не более 5 символов и завершающий ноль
+    if (!day || size - len < 6) {
+      return;
+    }
+    len += std::snprintf(buf + len, size - len, "%s%s", len ? ", " : "", day_name);
+  };
+
+  const auto &schedule = timer.schedule;
+  if (schedule.monday && schedule.tuesday && schedule.wednesday && schedule.thursday && schedule.friday &&
+      schedule.saturday && schedule.sunday) {
+    add_week_day(true, "MON-SUN");
+    return len;
+  }
+  add_week_day(schedule.monday, "MON");
+  add_week_day(schedule.tuesday, "TUE");
+  add_week_day(schedule.wednesday, "WED");
+  add_week_day(schedule.thursday, "THU");
+  add_week_day(schedule.friday, "FRI");
+  add_week_day(schedule.saturday, "SAT");
+  add_week_day(schedule.sunday, "SUN");
+  return len;
+}
+
 void Tion4sApiComponent::on_timer(uint8_t timer_id, const dentra::tion_4s::tion4s_timer_t &timer, uint32_t request_id) {
-  std::string schedule;
-  if (timer.schedule.monday && timer.schedule.tuesday && timer.schedule.wednesday && timer.schedule.thursday &&
-      timer.schedule.friday && timer.schedule.saturday && timer.schedule.sunday) {
-    schedule = "MON-SUN";
-  } else {
-    auto add_timer_week_day = [](std::string &s, bool day, const char *day_name) {
-      if (day) {
-        if (!s.empty()) {
-          s.append(", ");
-        }
-        s.append(day_name);
-      }
-    };
-    add_timer_week_day(schedule, timer.schedule.monday, "MON");
-    add_timer_week_day(schedule, timer.schedule.tuesday, "TUE");
-    add_timer_week_day(schedule, timer.schedule.wednesday, "WED");
-    add_timer_week_day(schedule, timer.schedule.thursday, "THU");
-    add_timer_week_day(schedule, timer.schedule.friday, "FRI");
-    add_timer_week_day(schedule, timer.schedule.saturday, "SAT");
-    add_timer_week_day(schedule, timer.schedule.sunday, "SUN");
-  }
-
-  ESP_LOGI(TAG, "Timer[%u] %s at %02u:%02u is %s", timer_id, schedule.c_str(), timer.schedule.hours,
-           timer.schedule.minutes, ONOFF(timer.timer_state));
+  char schedule[TIMER_SCHEDULE_SIZE];
+  timer_schedule(timer, schedule, sizeof(schedule));
+  ESP_LOGI(TAG, "Timer[%u] %s at %02u:%02u is %s", timer_id, schedule, timer.schedule.hours, timer.schedule.minutes,
+           ONOFF(timer.timer_state));
 }
 
 void Tion4sApiComponent::on_timers_state(const dentra::tion_4s::tion4s_timers_state_t &timers_state,
@@ -137,20 +267,109 @@ void Tion4sApiComponent::on_timers_state(const dentra::tion_4s::tion4s_timers_st
 }
 
 void Tion4sApiComponent::dump_timers() {
-  this->typed_api()->request_time();
+  TION_ARBITER_LANE(this->get_arbiter(), LANE_POLL);
+  auto *api = this->typed_api();
+  api->request_time();
+  if (!api->is_timers_synced()) {
+    // таймеры будут выведены в лог по мере получения
+    api->timers_sync();
+    return;
+  }
   for (uint8_t timer_id = 0; timer_id < dentra::tion_4s::tion4s_timers_state_t::TIMERS_COUNT; timer_id++) {
-    this->typed_api()->request_timer(timer_id);
+    this->on_timer(timer_id, *api->get_timer(timer_id), 0);
   }
-  this->typed_api()->request_timers_state();
+  this->on_timers_state(*api->get_timers_state(), 0);
 }
 
 void Tion4sApiComponent::reset_timers() {
   const dentra::tion_4s::tion4s_timer_t timer{};
+  uint8_t count = 0;
   for (uint8_t timer_id = 0; timer_id < dentra::tion_4s::tion4s_timers_state_t::TIMERS_COUNT; timer_id++) {
-    this->typed_api()->write_timer(timer_id, timer);
+    count += this->typed_api()->set_timer(timer_id, timer);
+  }
+  ESP_LOGD(TAG, "Reset timers: %u to check or write", count);
+}
+
+size_t Tion4sApiComponent::get_timers_info(char *buf, size_t size) const {
+  if (buf == nullptr || size == 0) {
+    return 0;
+  }
+  buf[0] = 0;
+  const auto *api = this->typed_api();
+  const auto *timers_state = api->get_timers_state();
+  if (timers_state == nullptr) {
+    return 0;
+  }
+  size_t len = 0;
+  for (uint8_t timer_id = 0; timer_id < dentra::tion_4s::tion4s_timers_state_t::TIMERS_COUNT; timer_id++) {
+    const auto *timer = api->get_timer(timer_id);
+    if (timer == nullptr || !timers_state->timers[timer_id].active) {
+      continue;
+    }
+    char schedule[TIMER_SCHEDULE_SIZE];
+    timer_schedule(*timer, schedule, sizeof(schedule));
+    const int n = std::snprintf(buf + len, size - len, "%s%s %02u:%02u %s", len ? "; " : "", schedule,
+                                timer->schedule.hours, timer->schedule.minutes, ONOFF(timer->timer_state));
+    // не помещающиеся в буфер таймеры отбрасываются
+    if (n < 0 || static_cast<size_t>(n) >= size - len) {
+      buf[len] = 0;
+      break;
+    }
+    len += n;
+  }
+  if (len == 0) {
+    len = std::min<size_t>(std::snprintf(buf, size, "none"), size - 1);
   }
+  return len;
+}
+
+void Tion4sApiComponent::update() {
+  TionApiComponent::update();
+  TION_ARBITER_LANE(this->get_arbiter(), LANE_POLL);
+  // первичная синхронизация кэша, далее таймеры перечитываются только по запросу
+  this->typed_api()->timers_sync();
 }
 #endif  // TION_ENABLE_SCHEDULER
 
+#if defined(TION_ENABLE_SCHEDULER) || defined(TION_ENABLE_UPDATE)
+void Tion4sApiComponent::loop() {
+#ifdef TION_ENABLE_SCHEDULER
+  {
+    TION_ARBITER_LANE(this->get_arbiter(), LANE_POLL);
+    this->typed_api()->timers_poll();
+  }
+#endif
+#ifdef TION_ENABLE_UPDATE
+  {
+    TION_ARBITER_LANE(this->get_arbiter(), LANE_UPDATE);
+    this->typed_api()->update_poll();
+  }
+#endif
+}
+#endif
+
+#if defined(TION_ENABLE_UPDATE) && defined(USE_ESP_IDF)
+bool Tion4sApiComponent::update_from_partition(const char *label, uint32_t size, uint8_t window) {
+  const auto *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+  if (part == nullptr) {
+    ESP_LOGW(TAG, "Partition %s not found", label);
+    return false;
+  }
+  if (size == 0 || size > part->size) {
+    size = part->size;
+  }
+  this->update_partition_ = part;
+  TION_ARBITER_LANE(this->get_arbiter(), LANE_UPDATE);
+  using reader_type = dentra::tion_4s::Tion4sApi::update_reader_type;
+  return this->typed_api()->update_start(
+      size, reader_type::create<Tion4sApiComponent, &Tion4sApiComponent::update_read_partition_>(*this), window);
+}
+
+size_t Tion4sApiComponent::update_read_partition_(uint32_t offset, uint8_t *buf, size_t size) {
+  return esp_partition_read(this->update_partition_, offset, buf, size) == ESP_OK ? size : 0;
+}
+#endif
+#endif  // TION_API_4S
+
 }  // namespace tion
 }  // namespace esphome
@@ -9,11 +9,27 @@
 #include "esphome/core/component.h"
 
 #include "../tion-api/tion-api.h"
+#ifdef TION_API_O2
 #include "../tion-api/tion-api-o2.h"
+#endif
+#ifdef TION_API_3S
 #include "../tion-api/tion-api-3s.h"
+#endif
+#ifdef TION_API_4S
 #include "../tion-api/tion-api-4s.h"
+#endif
+#ifdef TION_API_LT
 #include "../tion-api/tion-api-lt.h"
+#endif
 #include "tion_vport.h"
+#include "tion_timing.h"
+#include "tion_arbiter.h"
+#include "tion_energy.h"
+#include "tion_state_listener.h"
+
+#if defined(TION_ENABLE_UPDATE) && defined(USE_ESP_IDF)
+#include <esp_partition.h>
+#endif
 
 namespace esphome {
 namespace tion {
@@ -25,23 +41,30 @@ class TionApiComponent : public PollingComponent {
   using TionStateCall = dentra::tion::TionStateCall;
   using TionGatePosition = dentra::tion::TionGatePosition;
 
+ public:
   class BatchStateCall : public dentra::tion::TionStateCall {
    public:
     explicit BatchStateCall(TionApiComponent *c) : dentra::tion::TionStateCall(c->api_), c_(c) {}
 
+#ifdef TION_ENABLE_VIRTUAL_API
     virtual ~BatchStateCall() {}
+#endif
 
-    void perform() override;
+    // без TION_ENABLE_VIRTUAL_API скрывает TionStateCall::perform, make_call возвращает BatchStateCall
+    void perform() TION_API_OVERRIDE;
 
     uint32_t get_start_time() const { return this->start_time_; };
 
    protected:
     TionApiComponent *c_;
     uint32_t start_time_{};
+#ifdef TION_ENABLE_ARBITER
+    // наиболее приоритетная полоса из объединенных в пакет изменений
+    TionArbiter::Lane lane_{TionArbiter::LANES};
+#endif
     void perform_();
   };
 
- public:
   explicit TionApiComponent(TionApiBase *api) : api_(api), batch_call_(this) {
     api->on_state_fn.set<TionApiComponent, &TionApiComponent::on_state_>(*this);
   }
@@ -63,6 +86,14 @@ class TionApiComponent : public PollingComponent {
     this->state_callback_.add(std::move(callback));
   }
 
+  /**
+   * Add a listener for the breezer state, listeners are notified in order of addition before callbacks.
+   * Unlike add_on_state_callback it does not allocate, so entities should prefer it.
+   *
+   * @param listener The listener to notify, must outlive the component.
+   */
+  void add_on_state_listener(TionStateListener *listener);
+
 #ifdef TION_ENABLE_API_CONTROL_CALLBACK
   /**
    * Add a callback for the breezer configuration, each time the configuration parameters of a device
@@ -79,11 +110,11 @@ class TionApiComponent : public PollingComponent {
   void set_batch_timeout(uint32_t batch_timeout) { this->batch_timeout_ = batch_timeout; };
   void set_force_update(bool force_update) { this->force_update_ = force_update; };
   bool get_force_update() const { return this->force_update_; }
-  void add_preset(const std::string &name, const TionApiBase::PresetData &preset) {
+  void add_preset(const char *name, const TionApiBase::PresetData &preset) {
     this->api_->add_preset(name, preset);
   }
 
-  TionStateCall *make_call();
+  BatchStateCall *make_call();
 
   TionApiBase *api() { return this->api_; }
 
@@ -92,6 +123,55 @@ class TionApiComponent : public PollingComponent {
   const dentra::tion::TionTraits &traits() const { return this->api_->get_traits(); }
   const dentra::tion::TionState &state() const { return this->api_->get_state(); }
 
+  void set_protocol_stats(const dentra::tion::TionProtocolStats *stats) {
+    this->protocol_stats_ = stats;
+#ifdef TION_ENABLE_ARBITER
+    this->arbiter_.set_protocol_stats(stats);
+#endif
+  }
+  bool has_protocol_stats() const { return this->protocol_stats_ != nullptr; }
+  /// Интервал обновления публикуемых значений счетчиков протокола.
+  void set_stats_interval(uint32_t stats_interval) { this->stats_interval_ = stats_interval; }
+  /// Значение счетчика протокола на момент последнего обновления.
+  uint32_t get_protocol_counter(dentra::tion::TionProtocolStats::Counter counter) const {
+    return this->protocol_counters_[counter];
+  }
+
+  /// Замеры времени выполнения, nullptr если сборка без TION_ENABLE_TIMING.
+  TionTiming *get_timing() {
+#ifdef TION_ENABLE_TIMING
+    return &this->timing_;
+#else
+    return nullptr;
+#endif
+  }
+
+#ifdef TION_ENABLE_ARBITER
+  void set_arbiter(uint32_t interval, uint32_t max_wait) {
+    this->arbiter_.set_interval(interval);
+    this->arbiter_.set_max_wait(max_wait);
+  }
+#endif
+  /// Арбитр канала связи, nullptr если сборка без TION_ENABLE_ARBITER.
+  TionArbiter *get_arbiter() {
+#ifdef TION_ENABLE_ARBITER
+    return &this->arbiter_;
+#else
+    return nullptr;
+#endif
+  }
+
+  /// Интервал обновления публикуемых значений энергии.
+  void set_energy_interval(uint32_t energy_interval) { this->energy_interval_ = energy_interval; }
+  /// Учет потребленной энергии, nullptr если сборка без TION_ENABLE_ENERGY.
+  TionEnergy *get_energy() {
+#ifdef TION_ENABLE_ENERGY
+    return &this->energy_;
+#else
+    return nullptr;
+#endif
+  }
+
  protected:
   TionApiBase *api_;
   bool force_update_{};
@@ -100,6 +180,24 @@ class TionApiComponent : public PollingComponent {
   uint32_t state_timeout_{};
   uint32_t batch_timeout_{};
 
+  const dentra::tion::TionProtocolStats *protocol_stats_{};
+  uint32_t stats_interval_{60000};
+  uint32_t stats_time_{};
+  uint32_t protocol_counters_[dentra::tion::TionProtocolStats::COUNTERS]{};
+#ifdef TION_ENABLE_TIMING
+  TionTiming timing_;
+#endif
+#ifdef TION_ENABLE_ARBITER
+  TionArbiter arbiter_;
+#endif
+#ifdef TION_ENABLE_ENERGY
+  TionEnergy energy_;
+  uint32_t energy_interval_{300000};
+  uint32_t energy_time_{};
+#endif
+
+  TionStateListener *state_listeners_{};
+  TionStateListener *state_listeners_tail_{};
   CallbackManager<void(const TionState *)> state_callback_{};
 #ifdef TION_ENABLE_API_CONTROL_CALLBACK
   CallbackManager<void(TionStateCall *)> control_callback_{};
@@ -107,6 +205,9 @@ class TionApiComponent : public PollingComponent {
 
   void on_state_(const TionState &state, const uint32_t request_id);
   void state_check_schedule_();
+  void update_stats_();
+  void update_energy_(const TionState *state);
+  void notify_state_(const TionState *state);
 };
 
 // T - TionApi implementation
@@ -118,8 +219,10 @@ template<class A> class TionApiComponentBase : public TionApiComponent {
 
  protected:
   Api *typed_api() { return reinterpret_cast<Api *>(this->api_); }
+  const Api *typed_api() const { return reinterpret_cast<const Api *>(this->api_); }
 };
 
+#ifdef TION_API_O2
 class TionO2ApiComponent : public TionApiComponentBase<dentra::tion_o2::TionO2Api> {
  public:
   explicit TionO2ApiComponent(TionApiComponentBase::Api *api, TionVPortType vport_type)
@@ -128,9 +231,40 @@ class TionO2ApiComponent : public TionApiComponentBase<dentra::tion_o2::TionO2Ap
     this->set_timeout(200, [api = this->typed_api()]() { api->update_work_mode(); });
   }
 };
+#endif  // TION_API_O2
 
-using Tion3sApiComponent = TionApiComponentBase<dentra::tion::Tion3sApi>;
+#ifdef TION_API_3S
+class Tion3sApiComponent : public TionApiComponentBase<dentra::tion::Tion3sApi> {
+ public:
+  explicit Tion3sApiComponent(TionApiComponentBase::Api *api, TionVPortType vport_type)
+      : TionApiComponentBase(api, vport_type) {
+#ifdef TION_ENABLE_ARBITER
+    api->write_slot().set_tag_source(
+        dentra::tion::TionWriteSlot::tag_source_type::create<Tion3sApiComponent, &Tion3sApiComponent::get_lane_>(
+            *this));
+#endif
+  }
 
+  void loop() override {
+#ifdef TION_ENABLE_ARBITER
+    // отложенная запись уходит в полосе, в которой была сделана
+    TionArbiter::Scope lane_scope(
+        &this->arbiter_, static_cast<TionArbiter::Lane>(this->typed_api()->write_slot().get_tag()));
+#endif
+    this->typed_api()->flush_write();
+  }
+
+  void set_write_after_ack(bool write_after_ack) {
+    this->typed_api()->write_slot().set_write_after_ack(write_after_ack);
+  }
+#ifdef TION_ENABLE_ARBITER
+ protected:
+  uint8_t get_lane_() { return this->arbiter_.get_lane(); }
+#endif
+};
+#endif  // TION_API_3S
+
+#ifdef TION_API_4S
 class Tion4sApiComponent : public TionApiComponentBase<dentra::tion_4s::Tion4sApi> {
  public:
   explicit Tion4sApiComponent(TionApiComponentBase::Api *api, TionVPortType vport_type)
@@ -150,9 +284,36 @@ class Tion4sApiComponent : public TionApiComponentBase<dentra::tion_4s::Tion4sAp
   void on_timers_state(const dentra::tion_4s::tion4s_timers_state_t &timers_state, uint32_t request_id);
   void dump_timers();
   void reset_timers();
+  /// Перечитывает таймеры с бризера.
+  void sync_timers() {
+    TION_ARBITER_LANE(this->get_arbiter(), LANE_POLL);
+    this->typed_api()->timers_sync(true);
+  }
+  /// Размер буфера для get_timers_info, достаточный для всех таймеров.
+  static constexpr size_t TIMERS_INFO_SIZE = 160;
+  /// Описание включенных таймеров из кэша в буфер buf размером size, возвращает длину строки.
+  /// 0 - таймеры еще не получены.
+  size_t get_timers_info(char *buf, size_t size) const;
+
+  void update() override;
+#endif
+#if defined(TION_ENABLE_SCHEDULER) || defined(TION_ENABLE_UPDATE)
+  void loop() override;
+#endif
+#ifdef TION_ENABLE_UPDATE
+#ifdef USE_ESP_IDF
+  /// Обновление прошивки бризера образом из раздела flash с меткой label.
+  bool update_from_partition(const char *label, uint32_t size, uint8_t window = 4);
+
+ protected:
+  const esp_partition_t *update_partition_{};
+  size_t update_read_partition_(uint32_t offset, uint8_t *buf, size_t size);
+#endif
 #endif
 };
+#endif  // TION_API_4S
 
+#ifdef TION_API_LT
 class TionLtApiComponent : public TionApiComponentBase<dentra::tion::TionLtApi> {
  public:
   explicit TionLtApiComponent(TionApiComponentBase::Api *api, TionVPortType vport_type)
@@ -160,12 +321,35 @@ class TionLtApiComponent : public TionApiComponentBase<dentra::tion::TionLtApi>
     if (vport_type == TionVPortType::VPORT_UART) {
       api->enable_kiv_support();
     }
+#ifdef TION_ENABLE_ARBITER
+    api->write_slot().set_tag_source(
+        dentra::tion::TionWriteSlot::tag_source_type::create<TionLtApiComponent, &TionLtApiComponent::get_lane_>(
+            *this));
+#endif
   }
 
   void set_button_presets(const dentra::tion_lt::button_presets_t &button_presets) {
     this->typed_api()->set_button_presets(button_presets);
   }
+
+  void loop() override {
+#ifdef TION_ENABLE_ARBITER
+    // отложенная запись уходит в полосе, в которой была сделана
+    TionArbiter::Scope lane_scope(
+        &this->arbiter_, static_cast<TionArbiter::Lane>(this->typed_api()->write_slot().get_tag()));
+#endif
+    this->typed_api()->flush_write();
+  }
+
+  void set_write_after_ack(bool write_after_ack) {
+    this->typed_api()->write_slot().set_write_after_ack(write_after_ack);
+  }
+#ifdef TION_ENABLE_ARBITER
+ protected:
+  uint8_t get_lane_() { return this->arbiter_.get_lane(); }
+#endif
 };
+#endif  // TION_API_LT
 
 }  // namespace tion
 }  // namespace esphome
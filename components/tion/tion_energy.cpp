@@ -0,0 +1,62 @@
+#include <cstring>
+
+#include "tion_energy.h"
+
+namespace esphome {
+namespace tion {
+
+// мВт*мс в 1 мВт*ч
+static constexpr uint32_t MWMS_PER_MWH = 3600 * 1000;
+
+void TionEnergy::add(uint32_t time, const dentra::tion::TionState &state, const dentra::tion::TionTraits &traits) {
+  // нулевое время зарезервировано для признака отсутствия предыдущего состояния
+  time = time == 0 ? 1 : time;
+  if (this->time_ != 0) {
+    const uint32_t elapsed = time - this->time_;
+    if (elapsed <= MAX_GAP) {
+      this->accumulate_(COUNTER_HEATER, this->heater_power_, elapsed);
+      this->accumulate_(static_cast<Counter>(COUNTER_FAN_SPEED_0 + this->fan_speed_), this->fan_power_, elapsed);
+    }
+  }
+  this->time_ = time;
+
+  if (!state.power_state) {
+    this->heater_power_ = 0;
+  } else if (traits.supports_heater_var) {
+    // max_heater_power в Вт * 0.1, heater_var в процентах
+    this->heater_power_ = uint32_t(traits.max_heater_power) * state.heater_var * 100;
+  } else {
+    this->heater_power_ = state.is_heating(traits) ? traits.get_max_heater_power() * 1000 : 0;
+  }
+  this->fan_speed_ = state.power_state && state.fan_speed < COUNTERS - COUNTER_FAN_SPEED_0 ? state.fan_speed : 0;
+  // max_fan_power в Вт * 100
+  this->fan_power_ = uint32_t(traits.max_fan_power[this->fan_speed_]) * 10;
+}
+
+void TionEnergy::accumulate_(Counter counter, uint32_t power, uint32_t time) {
+  if (power == 0) {
+    return;
+  }
+  const uint64_t energy = uint64_t(power) * time + this->remainders_[counter];
+  this->counters_[counter] += energy / MWMS_PER_MWH;
+  this->remainders_[counter] = energy % MWMS_PER_MWH;
+}
+
+void TionEnergy::restore(const uint64_t *counters) {
+  std::memcpy(this->counters_, counters, sizeof(this->counters_));
+  std::memset(this->remainders_, 0, sizeof(this->remainders_));
+  this->snapshot();
+}
+
+void TionEnergy::snapshot() { std::memcpy(this->published_, this->counters_, sizeof(this->published_)); }
+
+float TionEnergy::get_published_fan() const {
+  uint64_t res = 0;
+  for (uint8_t i = COUNTER_FAN_SPEED_0; i < COUNTERS; i++) {
+    res += this->published_[i];
+  }
+  return res * 0.000001f;
+}
+
+}  // namespace tion
+}  // namespace esphome
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "../tion-api/tion-api.h"
+
+namespace esphome {
+namespace tion {
+
+/// Потребленная энергия по данным состояния бризера.
+/// Мощность рассчитывается при получении состояния и действует до следующего состояния,
+/// энергия накапливается в целых мВт*ч отдельно для обогревателя и каждой скорости вентилятора.
+class TionEnergy {
+ public:
+  enum Counter : uint8_t {
+    COUNTER_HEATER,
+    // COUNTER_FAN_SPEED_0 - режим ожидания или бризер выключен
+    COUNTER_FAN_SPEED_0,
+    COUNTER_FAN_SPEED_1,
+    COUNTER_FAN_SPEED_2,
+    COUNTER_FAN_SPEED_3,
+    COUNTER_FAN_SPEED_4,
+    COUNTER_FAN_SPEED_5,
+    COUNTER_FAN_SPEED_6,
+    COUNTERS,
+  };
+
+  /// Промежуток между состояниями больше этого значения не учитывается, мс.
+  static constexpr uint32_t MAX_GAP = 10 * 60 * 1000;
+
+  /// Учитывает энергию с момента предыдущего состояния и запоминает мощность нового.
+  void add(uint32_t time, const dentra::tion::TionState &state, const dentra::tion::TionTraits &traits);
+  /// Прекращает учет до получения следующего состояния.
+  void reset_time() { this->time_ = 0; }
+
+  /// Накопленная энергия, мВт*ч.
+  uint64_t get(Counter counter) const { return this->counters_[counter]; }
+  const uint64_t *get_counters() const { return this->counters_; }
+  /// Восстанавливает накопленные значения, например после перезагрузки.
+  void restore(const uint64_t *counters);
+
+  /// Фиксирует публикуемые значения.
+  void snapshot();
+  /// Публикуемое значение счетчика, кВт*ч.
+  float get_published(Counter counter) const { return this->published_[counter] * 0.000001f; }
+  /// Публикуемое значение энергии вентилятора на всех скоростях, кВт*ч.
+  float get_published_fan() const;
+  /// Публикуемое значение всей энергии, кВт*ч.
+  float get_published_total() const { return this->get_published_fan() + this->get_published(COUNTER_HEATER); }
+
+ protected:
+  // 32 бит в мВт*ч переполняются на ~4295 кВт*ч
+  uint64_t counters_[COUNTERS]{};
+  /// Остаток меньше 1 мВт*ч, мВт*мс.
+  uint32_t remainders_[COUNTERS]{};
+  uint64_t published_[COUNTERS]{};
+  uint32_t time_{};
+  uint32_t heater_power_{};
+  uint32_t fan_power_{};
+  uint8_t fan_speed_{};
+
+  void accumulate_(Counter counter, uint32_t power, uint32_t time);
+};
+
+}  // namespace tion
+}  // namespace esphome
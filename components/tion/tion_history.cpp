@@ -0,0 +1,393 @@
+#ifdef TION_ENABLE_HISTORY
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(USE_ESP32) && defined(USE_PSRAM)
+#include <esp_heap_caps.h>
+#endif
+
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+
+#include "tion_component.h"
+#include "tion_history.h"
+
+namespace esphome {
+namespace tion {
+
+static const char *const TAG = "tion_history";
+
+namespace {
+
+uint8_t *alloc_buf(size_t size) {
+#if defined(USE_ESP32) && defined(USE_PSRAM)
+  auto *buf = static_cast<uint8_t *>(heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+  if (buf) {
+    return buf;
+  }
+  ESP_LOGW(TAG, "PSRAM is not available, using internal memory");
+#endif
+  return static_cast<uint8_t *>(std::malloc(size));
+}
+
+size_t write_varint(uint8_t *buf, uint32_t value) {
+  size_t size = 0;
+  while (value >= 0x80) {
+    buf[size++] = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  buf[size++] = value;
+  return size;
+}
+
+// at(i) - i-й байт записи, avail - количество доступных байт. Возвращает размер записи или 0.
+template<typename A> size_t read_varint(A &&at, size_t avail, size_t &pos, uint32_t &value) {
+  value = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    if (pos >= avail) {
+      return 0;
+    }
+    const uint8_t b = at(pos++);
+    value |= uint32_t(b & 0x7F) << shift;
+    if ((b & 0x80) == 0) {
+      return pos;
+    }
+  }
+  return 0;
+}
+
+template<typename A> size_t decode_record(A &&at, size_t avail, TionHistory::Sample &sample) {
+  size_t pos = 0;
+  uint32_t dt;
+  if (read_varint(at, avail, pos, dt) == 0 || pos >= avail) {
+    return 0;
+  }
+  const uint8_t mask = at(pos++);
+  TionHistory::Sample res = sample;
+  res.time += dt;
+  for (uint8_t i = 0; i < TionHistory::FIELDS; i++) {
+    if ((mask & (1 << i)) == 0) {
+      continue;
+    }
+    uint32_t zz;
+    if (read_varint(at, avail, pos, zz) == 0) {
+      return 0;
+    }
+    const int32_t delta = (zz >> 1) ^ -int32_t(zz & 1);
+    res.values[i] = res.values[i] + delta;
+  }
+  sample = res;
+  return pos;
+}
+
+void put_u32(uint8_t *buf, uint32_t value) {
+  for (uint8_t i = 0; i < sizeof(value); i++) {
+    buf[i] = value >> (i * 8);
+  }
+}
+
+uint32_t get_u32(const uint8_t *data) {
+  return uint32_t(data[0]) | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24;
+}
+
+int16_t average(int32_t sum, int32_t count) {
+  return sum >= 0 ? (sum + count / 2) / count : (sum - count / 2) / count;
+}
+
+// Добавляет строку в buf размером size, только если она помещается целиком.
+bool append_fmt(char *buf, size_t size, size_t &len, const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  const int n = std::vsnprintf(buf + len, size - len, fmt, args);
+  va_end(args);
+  if (n < 0 || static_cast<size_t>(n) >= size - len) {
+    buf[len] = 0;
+    return false;
+  }
+  len += n;
+  return true;
+}
+
+#ifndef TION_NO_HEAP
+// заголовок JSON с именами полей и завершающие "]}"
+constexpr size_t JSON_HEADER_MAX_SIZE = 256;
+#endif
+
+}  // namespace
+
+TionHistory::TionHistory(TionApiComponent *parent) {
+  if (parent == nullptr) {
+    return;
+  }
+  parent->add_on_state_listener(this);
+}
+
+TionHistory::~TionHistory() {
+  for (uint8_t i = 0; i < this->levels_count_; i++) {
+    std::free(this->levels_[i].buf);
+  }
+}
+
+bool TionHistory::add_level(uint32_t interval, size_t size) {
+  if (this->levels_count_ >= MAX_LEVELS || size < RECORD_MAX_SIZE) {
+    ESP_LOGW(TAG, "Invalid history level %" PRIu32 " s, %zu bytes", interval, size);
+    return false;
+  }
+  auto *buf = alloc_buf(size);
+  if (buf == nullptr) {
+    ESP_LOGW(TAG, "Failed to allocate %zu bytes", size);
+    return false;
+  }
+  auto &lvl = this->levels_[this->levels_count_++];
+  lvl = {};
+  lvl.interval = interval;
+  lvl.buf = buf;
+  lvl.capacity = size;
+  return true;
+}
+
+TionHistory::Sample TionHistory::make_sample(uint32_t time, const dentra::tion::TionState &state) {
+  Sample sample{};
+  sample.time = time;
+  sample.values[FIELD_FLAGS] = (state.power_state ? FLAG_POWER : 0) | (state.heater_state ? FLAG_HEATER : 0) |
+                               (state.auto_state ? FLAG_AUTO : 0) | (state.filter_state ? FLAG_FILTER : 0);
+  sample.values[FIELD_FAN_SPEED] = state.fan_speed;
+  sample.values[FIELD_GATE_POSITION] = static_cast<uint8_t>(state.gate_position);
+  sample.values[FIELD_OUTDOOR_TEMPERATURE] = state.outdoor_temperature;
+  sample.values[FIELD_CURRENT_TEMPERATURE] = state.current_temperature;
+  sample.values[FIELD_TARGET_TEMPERATURE] = state.target_temperature;
+  sample.values[FIELD_PRODUCTIVITY] = state.productivity;
+  sample.values[FIELD_HEATER_VAR] = state.heater_var;
+  return sample;
+}
+
+void TionHistory::add(uint32_t time, const dentra::tion::TionState &state) { this->add(make_sample(time, state)); }
+
+uint32_t TionHistory::get_uptime() const {
+  const uint32_t now = millis();
+  if (now < this->last_millis_) {
+    this->millis_major_++;
+  }
+  this->last_millis_ = now;
+  return ((uint64_t(this->millis_major_) << 32) | now) / 1000;
+}
+
+void TionHistory::add(const Sample &sample) {
+  for (uint8_t i = 0; i < this->levels_count_; i++) {
+    auto &lvl = this->levels_[i];
+    if (lvl.interval == 0) {
+      this->push_(lvl, sample);
+    } else {
+      this->accumulate_(lvl, sample);
+    }
+  }
+}
+
+void TionHistory::accumulate_(Level &lvl, const Sample &sample) {
+  const uint32_t start = sample.time - sample.time % lvl.interval;
+  if (lvl.count > 0 && start != lvl.start) {
+    Sample avg = lvl.pending;
+    avg.time = lvl.start;
+    for (uint8_t i = 0; i < FIELDS; i++) {
+      if (i != FIELD_FLAGS && i != FIELD_GATE_POSITION) {
+        avg.values[i] = average(lvl.sum[i], lvl.count);
+      }
+    }
+    this->push_(lvl, avg);
+    lvl.count = 0;
+  }
+  if (lvl.count == 0) {
+    std::memset(lvl.sum, 0, sizeof(lvl.sum));
+    lvl.start = start;
+  }
+  for (uint8_t i = 0; i < FIELDS; i++) {
+    lvl.sum[i] += sample.values[i];
+  }
+  lvl.count++;
+  lvl.pending = sample;
+}
+
+void TionHistory::push_(Level &lvl, const Sample &sample) {
+  uint8_t rec[RECORD_MAX_SIZE];
+  const size_t size = encode_(rec, lvl.last, sample);
+  // освобождаем место, сдвигая базовый отсчет на вытесняемые записи
+  while (lvl.capacity - lvl.used < size) {
+    const size_t rec_size = decode_(lvl, 0, lvl.base);
+    if (rec_size == 0) {
+      lvl.base = lvl.last;
+      lvl.head = 0;
+      lvl.used = 0;
+      lvl.records = 0;
+      break;
+    }
+    lvl.head = (lvl.head + rec_size) % lvl.capacity;
+    lvl.used -= rec_size;
+    lvl.records--;
+  }
+  for (size_t i = 0; i < size; i++) {
+    lvl.buf[(lvl.head + lvl.used + i) % lvl.capacity] = rec[i];
+  }
+  lvl.used += size;
+  lvl.records++;
+  lvl.last = sample;
+}
+
+size_t TionHistory::encode_(uint8_t *buf, const Sample &prev, const Sample &sample) {
+  size_t size = write_varint(buf, sample.time - prev.time);
+  uint8_t &mask = buf[size++];
+  mask = 0;
+  for (uint8_t i = 0; i < FIELDS; i++) {
+    const int32_t delta = int32_t(sample.values[i]) - prev.values[i];
+    if (delta != 0) {
+      mask |= 1 << i;
+      size += write_varint(buf + size, (uint32_t(delta) << 1) ^ uint32_t(delta >> 31));
+    }
+  }
+  return size;
+}
+
+size_t TionHistory::decode_(const Level &lvl, size_t pos, Sample &sample) {
+  return decode_record([&lvl, pos](size_t i) { return lvl.buf[(lvl.head + pos + i) % lvl.capacity]; },
+                       lvl.used - pos, sample);
+}
+
+size_t TionHistory::query(uint32_t seconds, uint8_t level, uint8_t *buf, size_t size) const {
+  if (buf == nullptr || size < HEADER_SIZE) {
+    return 0;
+  }
+  const uint32_t now = this->get_uptime();
+  std::memcpy(buf, MAGIC, sizeof(MAGIC));
+  buf[4] = VERSION;
+  buf[5] = level;
+  buf[6] = 0;
+  buf[7] = 0;
+  put_u32(buf + 8, now);
+  put_u32(buf + 12, level < this->levels_count_ ? this->levels_[level].interval : 0);
+
+  size_t len = HEADER_SIZE;
+  bool full = false;
+  Sample prev{};
+  uint8_t rec[RECORD_MAX_SIZE];
+  this->for_each(level, now > seconds ? now - seconds : 0, now, [&](const Sample &sample) {
+    if (full) {
+      return;
+    }
+    const size_t rec_size = encode_(rec, prev, sample);
+    if (size - len < rec_size) {
+      full = true;
+      return;
+    }
+    std::memcpy(buf + len, rec, rec_size);
+    len += rec_size;
+    prev = sample;
+  });
+  return len;
+}
+
+size_t TionHistory::query_json(uint32_t seconds, uint8_t level, char *buf, size_t size) const {
+  // место для завершающих "]}"
+  if (buf == nullptr || size <= 2) {
+    return 0;
+  }
+  const size_t limit = size - 2;
+  const uint32_t now = this->get_uptime();
+  size_t len = 0;
+  buf[0] = 0;
+
+  bool ok = append_fmt(buf, limit, len, "{\"uptime\":%" PRIu32 ",\"interval\":%" PRIu32 ",\"fields\":[\"time\"", now,
+                       level < this->levels_count_ ? this->levels_[level].interval : 0);
+  for (uint8_t i = 0; ok && i < FIELDS; i++) {
+    ok = append_fmt(buf, limit, len, ",\"%s\"", get_field_name(static_cast<Field>(i)));
+  }
+  if (!ok || !append_fmt(buf, limit, len, "],\"data\":[")) {
+    buf[0] = 0;
+    return 0;
+  }
+
+  const size_t data_start = len;
+  bool full = false;
+  this->for_each(level, now > seconds ? now - seconds : 0, now, [&](const Sample &sample) {
+    if (full) {
+      return;
+    }
+    const size_t start = len;
+    bool fits = append_fmt(buf, limit, len, "%s[%" PRIu32, start == data_start ? "" : ",", sample.time);
+    for (uint8_t i = 0; fits && i < FIELDS; i++) {
+      fits = append_fmt(buf, limit, len, ",%d", sample.values[i]);
+    }
+    if (!fits || !append_fmt(buf, limit, len, "]")) {
+      len = start;
+      buf[len] = 0;
+      full = true;
+    }
+  });
+  append_fmt(buf, size, len, "]}");
+  return len;
+}
+
+#ifndef TION_NO_HEAP
+std::vector<uint8_t> TionHistory::query(uint32_t seconds, uint8_t level) const {
+  const uint32_t records = level < this->levels_count_ ? this->levels_[level].records : 0;
+  std::vector<uint8_t> res(HEADER_SIZE + records * RECORD_MAX_SIZE);
+  res.resize(this->query(seconds, level, res.data(), res.size()));
+  return res;
+}
+
+std::string TionHistory::query_json(uint32_t seconds, uint8_t level) const {
+  const uint32_t records = level < this->levels_count_ ? this->levels_[level].records : 0;
+  std::string res(JSON_HEADER_MAX_SIZE + records * JSON_RECORD_MAX_SIZE, 0);
+  res.resize(this->query_json(seconds, level, &res[0], res.size()));
+  return res;
+}
+#endif
+
+bool TionHistory::parse(const uint8_t *data, size_t size, Sample *samples, size_t &count) {
+  const size_t max_count = count;
+  count = 0;
+  if (size < HEADER_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0 || data[4] != VERSION) {
+    return false;
+  }
+  Sample sample{};
+  for (size_t pos = HEADER_SIZE; pos < size;) {
+    const size_t rec_size =
+        decode_record([data, pos](size_t i) { return data[pos + i]; }, size - pos, sample);
+    if (rec_size == 0 || count >= max_count) {
+      return false;
+    }
+    samples[count++] = sample;
+    pos += rec_size;
+  }
+  return true;
+}
+
+const char *TionHistory::get_field_name(Field field) {
+  switch (field) {
+    case FIELD_FLAGS:
+      return "flags";
+    case FIELD_FAN_SPEED:
+      return "fan_speed";
+    case FIELD_GATE_POSITION:
+      return "gate_position";
+    case FIELD_OUTDOOR_TEMPERATURE:
+      return "outdoor_temperature";
+    case FIELD_CURRENT_TEMPERATURE:
+      return "current_temperature";
+    case FIELD_TARGET_TEMPERATURE:
+      return "target_temperature";
+    case FIELD_PRODUCTIVITY:
+      return "productivity";
+    case FIELD_HEATER_VAR:
+      return "heater_var";
+    default:
+      return "unknown";
+  }
+}
+
+}  // namespace tion
+}  // namespace esphome
+
+#endif  // TION_ENABLE_HISTORY
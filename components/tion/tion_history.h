@@ -0,0 +1,161 @@
+#pragma once
+#ifdef TION_ENABLE_HISTORY
+
+#include <cstdint>
+#include <cstddef>
+#ifndef TION_NO_HEAP
+#include <string>
+#include <vector>
+#endif
+
+#include "esphome/core/hal.h"
+
+#include "../tion-api/tion-api.h"
+#include "tion_state_listener.h"
+
+namespace esphome {
+namespace tion {
+
+class TionApiComponent;
+
+/// История состояний бризера в кольцевых буферах с несколькими уровнями прореживания.
+///
+/// Каждый уровень хранит дельта-кодированные записи:
+///   varint - время от предыдущей записи, с;
+///   uint8  - маска изменившихся полей;
+///   zigzag varint - изменение значения для каждого поля из маски.
+/// Первая запись буфера кодируется относительно базового отсчета, который сдвигается
+/// при вытеснении старых записей. Уровень с ненулевым интервалом хранит средние значения
+/// за интервал, флаги берутся из последнего состояния интервала.
+class TionHistory : public TionStateListener {
+ public:
+  enum Field : uint8_t {
+    FIELD_FLAGS,
+    FIELD_FAN_SPEED,
+    FIELD_GATE_POSITION,
+    FIELD_OUTDOOR_TEMPERATURE,
+    FIELD_CURRENT_TEMPERATURE,
+    FIELD_TARGET_TEMPERATURE,
+    FIELD_PRODUCTIVITY,
+    FIELD_HEATER_VAR,
+    FIELDS,
+  };
+  enum Flag : uint8_t {
+    FLAG_POWER = 1 << 0,
+    FLAG_HEATER = 1 << 1,
+    FLAG_AUTO = 1 << 2,
+    FLAG_FILTER = 1 << 3,
+  };
+
+  static constexpr uint8_t MAGIC[4] = {'T', 'H', 'S', 'T'};
+  static constexpr uint8_t VERSION = 1;
+  /// Заголовок результата query: "THST", версия, уровень, 2 байта резерв, uint32 время запроса, uint32 интервал.
+  static constexpr size_t HEADER_SIZE = 16;
+  /// Максимальный размер записи: время, маска и поля по 3 байта.
+  static constexpr size_t RECORD_MAX_SIZE = 5 + 1 + FIELDS * 3;
+  /// Максимальный размер записи в JSON: ",[" время и поля через запятую "]".
+  static constexpr size_t JSON_RECORD_MAX_SIZE = 2 + 10 + FIELDS * 7 + 1;
+  static constexpr uint8_t MAX_LEVELS = 4;
+
+  struct Sample {
+    /// Время от загрузки, с (см. get_uptime).
+    uint32_t time;
+    int16_t values[FIELDS];
+  };
+
+  explicit TionHistory(TionApiComponent *parent);
+  ~TionHistory();
+
+  /// Добавляет уровень. interval - период усреднения в секундах, 0 - каждое состояние.
+  /// Буфер размещается в PSRAM, если она доступна.
+  bool add_level(uint32_t interval, size_t size);
+  uint8_t get_levels() const { return this->levels_count_; }
+  uint32_t get_level_interval(uint8_t level) const { return this->levels_[level].interval; }
+  /// Количество записей уровня.
+  uint32_t get_level_records(uint8_t level) const { return this->levels_[level].records; }
+
+  void add(uint32_t time, const dentra::tion::TionState &state);
+  void add(const Sample &sample);
+
+  void on_tion_state(const dentra::tion::TionState *state) override {
+    if (state) {
+      this->add(this->get_uptime(), *state);
+    }
+  }
+
+  /// Время от загрузки, с. В отличие от millis() / 1000 не переполняется через 49 дней,
+  /// если вызывается чаще, чем раз в 49 дней (каждое состояние бризера).
+  uint32_t get_uptime() const;
+
+  /// Перебирает сохраненные отсчеты уровня в интервале [from, to].
+  template<typename F> void for_each(uint8_t level, uint32_t from, uint32_t to, F &&fn) const {
+    if (level >= this->levels_count_) {
+      return;
+    }
+    const auto &lvl = this->levels_[level];
+    Sample sample = lvl.base;
+    for (size_t pos = 0; pos < lvl.used;) {
+      const auto size = decode_(lvl, pos, sample);
+      if (size == 0) {
+        break;
+      }
+      pos += size;
+      if (sample.time >= from && sample.time <= to) {
+        fn(sample);
+      }
+    }
+  }
+
+  /// Компактное двоичное представление отсчетов за последние seconds секунд в буфер buf размером size.
+  /// Записи кодируются так же, как в буфере, первая запись относительно нулевого отсчета.
+  /// Не помещающиеся в буфер записи отбрасываются. Возвращает размер данных, 0 - не помещается заголовок.
+  size_t query(uint32_t seconds, uint8_t level, uint8_t *buf, size_t size) const;
+  /// То же в формате JSON: {"uptime":...,"interval":...,"fields":[...],"data":[[time,...],...]}.
+  /// Возвращает длину строки, 0 - не помещается заголовок.
+  size_t query_json(uint32_t seconds, uint8_t level, char *buf, size_t size) const;
+#ifndef TION_NO_HEAP
+  std::vector<uint8_t> query(uint32_t seconds, uint8_t level = 0) const;
+  std::string query_json(uint32_t seconds, uint8_t level = 0) const;
+#endif
+  /// Разбор результата query в samples размером count, в count возвращается количество отсчетов.
+  /// false - данные повреждены или не помещаются в samples.
+  static bool parse(const uint8_t *data, size_t size, Sample *samples, size_t &count);
+
+  static Sample make_sample(uint32_t time, const dentra::tion::TionState &state);
+  static const char *get_field_name(Field field);
+
+ protected:
+  struct Level {
+    uint32_t interval;
+    uint8_t *buf;
+    size_t capacity;
+    size_t head;
+    size_t used;
+    uint32_t records;
+    /// Отсчет, относительно которого закодирована первая запись.
+    Sample base;
+    /// Последний записанный отсчет.
+    Sample last;
+    /// Накопление средних значений интервала.
+    int32_t sum[FIELDS];
+    uint32_t count;
+    uint32_t start;
+    Sample pending;
+  };
+
+  Level levels_[MAX_LEVELS]{};
+  uint8_t levels_count_{};
+  // отслеживание переполнения millis() для get_uptime
+  mutable uint32_t last_millis_{};
+  mutable uint32_t millis_major_{};
+
+  void push_(Level &lvl, const Sample &sample);
+  void accumulate_(Level &lvl, const Sample &sample);
+  static size_t encode_(uint8_t *buf, const Sample &prev, const Sample &sample);
+  static size_t decode_(const Level &lvl, size_t pos, Sample &sample);
+};
+
+}  // namespace tion
+}  // namespace esphome
+
+#endif  // TION_ENABLE_HISTORY
@@ -0,0 +1,164 @@
+#ifdef TION_ENABLE_MIRROR
+#include <algorithm>
+#include <cerrno>
+
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include "esphome/components/network/util.h"
+
+#include "tion_mirror.h"
+
+namespace esphome {
+namespace tion {
+
+static const char *const TAG = "tion_mirror";
+
+using dentra::tion::TionCapture;
+
+void TionMirror::dump_config() {
+  ESP_LOGCONFIG(TAG, "Tion mirror:");
+  ESP_LOGCONFIG(TAG, "  Address: %s:%u (%s)", this->host_.c_str(), this->port_,
+                this->protocol_ == PROTOCOL_UDP ? "udp" : "tcp");
+  ESP_LOGCONFIG(TAG, "  Buffer size: %zu", this->capacity_);
+}
+
+void TionMirror::loop() {
+  if (!this->socket_ && !this->connect_()) {
+    return;
+  }
+  if (this->protocol_ == PROTOCOL_UDP) {
+    this->loop_udp_();
+  } else {
+    this->loop_tcp_();
+  }
+}
+
+bool TionMirror::connect_() {
+  const uint32_t now = millis();
+  if (this->connect_time_ != 0 && now - this->connect_time_ < RECONNECT_INTERVAL) {
+    return false;
+  }
+  if (!network::is_connected()) {
+    return false;
+  }
+  this->connect_time_ = now == 0 ? 1 : now;
+
+  const bool udp = this->protocol_ == PROTOCOL_UDP;
+  this->socket_ = socket::socket_ip(udp ? SOCK_DGRAM : SOCK_STREAM, 0);
+  if (!this->socket_) {
+    ESP_LOGW(TAG, "Failed to create socket: %d", errno);
+    return false;
+  }
+  this->socket_->setblocking(false);
+
+  struct sockaddr_storage addr {};
+  const auto addr_len = socket::set_sockaddr(reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr), this->host_,
+                                             this->port_);
+  if (addr_len == 0) {
+    ESP_LOGW(TAG, "Invalid address %s", this->host_.c_str());
+    this->socket_.reset();
+    return false;
+  }
+  if (this->socket_->connect(reinterpret_cast<struct sockaddr *>(&addr), addr_len) != 0 && errno != EINPROGRESS) {
+    ESP_LOGW(TAG, "Failed to connect %s:%u: %d", this->host_.c_str(), this->port_, errno);
+    this->socket_.reset();
+    return false;
+  }
+
+  ESP_LOGD(TAG, "Connecting to %s:%u", this->host_.c_str(), this->port_);
+  // поток начинается с границы записи
+  this->clear();
+  this->header_sent_ = 0;
+  return true;
+}
+
+void TionMirror::disconnect_() {
+  if (this->socket_) {
+    this->socket_->close();
+    this->socket_.reset();
+  }
+}
+
+bool TionMirror::check_error_() {
+  if (errno == EWOULDBLOCK || errno == EAGAIN) {
+    return true;
+  }
+  // соединение еще устанавливается
+  if ((errno == ENOTCONN || errno == EINPROGRESS) && millis() - this->connect_time_ < RECONNECT_INTERVAL) {
+    return true;
+  }
+  ESP_LOGW(TAG, "Write failed: %d", errno);
+  this->disconnect_();
+  return false;
+}
+
+void TionMirror::loop_tcp_() {
+  if (this->header_sent_ < TionCapture::HEADER_SIZE) {
+    uint8_t header[TionCapture::HEADER_SIZE];
+    TionCapture::write_header(header, this->device_);
+    const auto res =
+        this->socket_->write(header + this->header_sent_, TionCapture::HEADER_SIZE - this->header_sent_);
+    if (res < 0) {
+      this->check_error_();
+      return;
+    }
+    this->header_sent_ += res;
+    this->sent_ += res;
+    return;
+  }
+
+  size_t limit = MAX_WRITE_SIZE;
+  while (limit > 0) {
+    const uint8_t *data;
+    const size_t size = std::min(this->peek(data), limit);
+    if (size == 0) {
+      return;
+    }
+    const auto res = this->socket_->write(data, size);
+    if (res < 0) {
+      this->check_error_();
+      return;
+    }
+    this->consume(res);
+    this->sent_ += res;
+    limit -= res;
+    if (static_cast<size_t>(res) < size) {
+      return;
+    }
+  }
+}
+
+void TionMirror::loop_udp_() {
+  // каждая датаграмма содержит заголовок и целое количество записей
+  uint8_t buf[MAX_WRITE_SIZE];
+  size_t size = TionCapture::write_header(buf, this->device_);
+  size_t offset = 0;
+  for (size_t rec_size; (rec_size = this->record_size(offset)) != 0; offset += rec_size) {
+    if (size + rec_size > sizeof(buf)) {
+      break;
+    }
+    this->copy(offset, buf + size, rec_size);
+    size += rec_size;
+  }
+  if (offset == 0) {
+    // запись не помещается в датаграмму
+    if (this->used() != 0) {
+      this->consume(this->record_size(0));
+      this->dropped_++;
+    }
+    return;
+  }
+
+  const auto res = this->socket_->write(buf, size);
+  if (res < 0) {
+    this->check_error_();
+    return;
+  }
+  this->consume(offset);
+  this->sent_ += res;
+}
+
+}  // namespace tion
+}  // namespace esphome
+
+#endif  // TION_ENABLE_MIRROR
@@ -0,0 +1,64 @@
+#pragma once
+#ifdef TION_ENABLE_MIRROR
+
+#include <memory>
+#include <string>
+
+#include "esphome/core/component.h"
+#include "esphome/components/socket/socket.h"
+
+#include "../tion-api/tion-api-capture.h"
+
+namespace esphome {
+namespace tion {
+
+/// Зеркалирование обмена с бризером на TCP/UDP приемник в формате TionCapture.
+/// Запись в буфер не блокирует основной цикл, при медленном приемнике новые записи отбрасываются.
+class TionMirror : public Component, public dentra::tion::TionCaptureWriter {
+ public:
+  enum Protocol : uint8_t { PROTOCOL_TCP, PROTOCOL_UDP };
+
+  /// Интервал повторного подключения, мс.
+  static constexpr uint32_t RECONNECT_INTERVAL = 5000;
+  /// Максимальный размер данных, отправляемых за один цикл.
+  static constexpr size_t MAX_WRITE_SIZE = 1400;
+
+  TionMirror(size_t size, dentra::tion::TionCapture::Device device) : TionCaptureWriter(size, device) {
+    this->set_drop_new(true);
+  }
+
+  void set_address(const std::string &host, uint16_t port) {
+    this->host_ = host;
+    this->port_ = port;
+  }
+  void set_protocol(Protocol protocol) { this->protocol_ = protocol; }
+
+  float get_setup_priority() const override { return setup_priority::AFTER_WIFI; }
+  void dump_config() override;
+  void loop() override;
+
+  /// Количество отправленных байт.
+  uint32_t get_sent() const { return this->sent_; }
+
+ protected:
+  std::unique_ptr<socket::Socket> socket_;
+  std::string host_;
+  uint16_t port_{};
+  Protocol protocol_{PROTOCOL_TCP};
+  uint32_t connect_time_{};
+  uint32_t sent_{};
+  /// Количество отправленных байт заголовка TCP потока.
+  uint8_t header_sent_{};
+
+  bool connect_();
+  void disconnect_();
+  void loop_tcp_();
+  void loop_udp_();
+  /// Обрабатывает ошибку записи, возвращает true если запись можно повторить позже.
+  bool check_error_();
+};
+
+}  // namespace tion
+}  // namespace esphome
+
+#endif  // TION_ENABLE_MIRROR
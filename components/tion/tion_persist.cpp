@@ -0,0 +1,149 @@
+#ifdef TION_ENABLE_PERSIST
+#include <cinttypes>
+#include <cstring>
+
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+
+#include "../tion-api/crc.h"
+
+#include "tion_component.h"
+#include "tion_persist.h"
+
+namespace esphome {
+namespace tion {
+
+static const char *const TAG = "tion_persist";
+
+TionPersist::TionPersist(TionApiComponent *parent) : parent_(parent) {
+  parent->add_on_state_listener(this);
+}
+
+uint16_t TionPersist::calc_crc(const Data &data) {
+  // версия и флаги также защищены CRC
+  Data tmp = data;
+  tmp.crc = 0;
+  return dentra::tion::crc16_ccitt_false_ffff(&tmp, sizeof(tmp));
+}
+
+void TionPersist::setup() {
+  this->pref_ = global_preferences->make_preference<Data>(fnv1_hash("tion_persist") ^ VERSION, true);
+  // бюджет начинается с одной записи, чтобы частые перезагрузки не расходовали ресурс flash
+  this->budget_ = this->write_cost_();
+  this->budget_time_ = millis();
+
+  Data data{};
+  if (!this->pref_.load(&data)) {
+    ESP_LOGD(TAG, "No saved data");
+    return;
+  }
+  if (data.version != VERSION || data.crc != calc_crc(data)) {
+    ESP_LOGW(TAG, "Saved data is corrupted, version %u, crc %04X", data.version, data.crc);
+    return;
+  }
+  this->saved_ = data;
+
+  if ((data.flags & FLAG_AIRFLOW) && this->restore_airflow_) {
+    ESP_LOGD(TAG, "Restore airflow counter %" PRIu32 ", fan time %" PRIu32, data.airflow_counter, data.fan_time);
+    this->restore_airflow_(data.airflow_counter, data.fan_time);
+  }
+  if ((data.flags & FLAG_BOOST) && data.boost_time_left > 0) {
+    this->parent_->api()->restore_boost(data.boost_save, data.boost_start_time, data.boost_time_left);
+  }
+  auto *energy = this->parent_->get_energy();
+  if ((data.flags & FLAG_ENERGY) && energy) {
+    ESP_LOGD(TAG, "Restore energy");
+    energy->restore(data.energy);
+  }
+}
+
+void TionPersist::dump_config() {
+  ESP_LOGCONFIG(TAG, "Tion persist:");
+  ESP_LOGCONFIG(TAG, "  Writes per day: %" PRIu32 ", burst: %u", this->writes_per_day_, this->burst_);
+  ESP_LOGCONFIG(TAG, "  Airflow counter: %s", YESNO(this->restore_airflow_));
+  ESP_LOGCONFIG(TAG, "  Energy: %s", YESNO(this->parent_->get_energy()));
+}
+
+void TionPersist::on_shutdown() {
+  if (!this->dirty_) {
+    return;
+  }
+  // при выключении бюджет не учитывается, иначе накопленные изменения будут потеряны
+  if (this->save_(this->make_data_(this->parent_->state()))) {
+    global_preferences->sync();
+  }
+}
+
+TionPersist::Data TionPersist::make_data_(const dentra::tion::TionState &state) const {
+  Data data{};
+  data.version = VERSION;
+  if (this->restore_airflow_) {
+    data.flags |= FLAG_AIRFLOW;
+    data.airflow_counter = state.airflow_counter;
+    data.fan_time = state.fan_time;
+  }
+  const auto *energy = this->parent_->get_energy();
+  if (energy) {
+    data.flags |= FLAG_ENERGY;
+    std::memcpy(data.energy, energy->get_counters(), sizeof(data.energy));
+  }
+  auto *api = this->parent_->api();
+  if (!api->get_traits().supports_boost && state.boost_time_left > 0) {
+    data.flags |= FLAG_BOOST;
+    data.boost_start_time = api->get_boost_start_time();
+    data.boost_time_left = state.boost_time_left;
+    data.boost_save = api->get_boost_save();
+  }
+  data.crc = calc_crc(data);
+  return data;
+}
+
+void TionPersist::update_budget_() {
+  const uint32_t now = millis();
+  const uint32_t max_budget = this->write_cost_() * this->burst_;
+  const uint32_t elapsed = now - this->budget_time_;
+  this->budget_time_ = now;
+  this->budget_ = elapsed >= max_budget - this->budget_ ? max_budget : this->budget_ + elapsed;
+}
+
+void TionPersist::on_state_(const dentra::tion::TionState &state) {
+  const auto data = this->make_data_(state);
+  // time_left уменьшается с наработкой бризера, записываем только начало и окончание турбо-режима
+  const bool boost_changed = (data.flags & FLAG_BOOST) != (this->saved_.flags & FLAG_BOOST) ||
+                             data.boost_start_time != this->saved_.boost_start_time;
+  this->dirty_ = boost_changed || data.airflow_counter != this->saved_.airflow_counter ||
+                 std::memcmp(data.energy, this->saved_.energy, sizeof(data.energy)) != 0;
+  if (!this->dirty_) {
+    return;
+  }
+
+  this->update_budget_();
+  const uint32_t cost = this->write_cost_();
+  // одна запись всегда остается в резерве для турбо-режима
+  const uint32_t required = boost_changed || this->burst_ < 2 ? cost : cost * 2;
+  if (this->budget_ < required) {
+    return;
+  }
+  if (this->save_(data)) {
+    this->budget_ -= cost;
+  }
+}
+
+bool TionPersist::save_(const Data &data) {
+  if (!this->pref_.save(&data)) {
+    ESP_LOGW(TAG, "Failed to save data");
+    return false;
+  }
+  ESP_LOGV(TAG, "Saved airflow counter %" PRIu32 ", boost time left %u", data.airflow_counter,
+           data.boost_time_left);
+  this->saved_ = data;
+  this->dirty_ = false;
+  this->writes_++;
+  return true;
+}
+
+}  // namespace tion
+}  // namespace esphome
+
+#endif  // TION_ENABLE_PERSIST
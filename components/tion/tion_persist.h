@@ -0,0 +1,109 @@
+#pragma once
+#ifdef TION_ENABLE_PERSIST
+
+#include <cstdint>
+#include <functional>
+
+#include "esphome/core/component.h"
+#include "esphome/core/preferences.h"
+
+#include "../tion-api/tion-api.h"
+#include "tion_energy.h"
+#include "tion_state_listener.h"
+
+namespace esphome {
+namespace tion {
+
+class TionApiComponent;
+
+/// Сохранение рассчитываемых счетчиков, потребленной энергии и незавершенного турбо-режима
+/// между перезагрузками.
+///
+/// Запись ограничивается бюджетом износа flash: не более writes_per_day записей в сутки
+/// с возможностью накопить burst записей. Изменение турбо-режима записывается вне очереди
+/// за счет резервной записи, остальные изменения откладываются и записываются при
+/// выключении устройства.
+class TionPersist : public Component, public TionStateListener {
+ public:
+  static constexpr uint8_t VERSION = 3;
+  static constexpr uint32_t DAY_MS = 24 * 60 * 60 * 1000;
+
+  struct Data {
+    uint8_t version;
+    uint8_t flags;
+    /// CRC16 всей записи, вычисляется с нулевым значением этого поля.
+    uint16_t crc;
+    uint32_t airflow_counter;
+    uint32_t fan_time;
+    uint32_t boost_start_time;
+    uint16_t boost_time_left;
+    dentra::tion::TionApiBase::PresetData boost_save;
+    /// Потребленная энергия, мВт*ч.
+    uint64_t energy[TionEnergy::COUNTERS];
+  } __attribute__((packed));
+
+  enum Flag : uint8_t {
+    FLAG_AIRFLOW = 1 << 0,
+    FLAG_BOOST = 1 << 1,
+    FLAG_ENERGY = 1 << 2,
+  };
+
+  explicit TionPersist(TionApiComponent *parent);
+
+  void set_writes_per_day(uint32_t writes_per_day) { this->writes_per_day_ = writes_per_day; }
+  void set_burst(uint8_t burst) { this->burst_ = burst; }
+
+  /// Подключает восстановление рассчитываемого счетчика воздуха, если порт его поддерживает.
+  template<class V> void set_vport(V *vport) {
+    if constexpr (supports_airflow_restore_(static_cast<V *>(nullptr))) {
+      this->restore_airflow_ = [vport](uint32_t airflow_counter, uint32_t fan_time) {
+        vport->restore_airflow_counter(airflow_counter, fan_time);
+      };
+    }
+  }
+
+  void setup() override;
+  void dump_config() override;
+  void on_shutdown() override;
+
+  void on_tion_state(const dentra::tion::TionState *state) override {
+    if (state) {
+      this->on_state_(*state);
+    }
+  }
+
+  /// Количество выполненных записей.
+  uint32_t get_writes() const { return this->writes_; }
+
+  static uint16_t calc_crc(const Data &data);
+
+ protected:
+  TionApiComponent *parent_;
+  ESPPreferenceObject pref_;
+  std::function<void(uint32_t airflow_counter, uint32_t fan_time)> restore_airflow_;
+  uint32_t writes_per_day_{24};
+  uint8_t burst_{3};
+  /// Накопленный бюджет записей, мс (одна запись стоит DAY_MS / writes_per_day_).
+  uint32_t budget_{};
+  uint32_t budget_time_{};
+  uint32_t writes_{};
+  Data saved_{};
+  bool dirty_{};
+
+  void on_state_(const dentra::tion::TionState &state);
+  Data make_data_(const dentra::tion::TionState &state) const;
+  bool save_(const Data &data);
+  void update_budget_();
+  uint32_t write_cost_() const { return DAY_MS / (this->writes_per_day_ ? this->writes_per_day_ : 1); }
+
+  template<class V>
+  static constexpr auto supports_airflow_restore_(V *v) -> decltype(v->restore_airflow_counter(0, 0), true) {
+    return true;
+  }
+  static constexpr bool supports_airflow_restore_(...) { return false; }
+};
+
+}  // namespace tion
+}  // namespace esphome
+
+#endif  // TION_ENABLE_PERSIST
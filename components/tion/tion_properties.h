@@ -1,6 +1,10 @@
 #pragma once
 
+#include <cmath>
+#include <type_traits>
+
 #include "esphome/core/component.h"
+#include "esphome/core/hal.h"
 #include "esphome/core/helpers.h"
 
 #include "../tion-api/tion-api.h"
@@ -8,6 +12,8 @@
 
 namespace esphome {
 namespace tion {
+// Контроллеры свойств не зависят от типа бризера и работают через TionApiComponent и traits,
+// поэтому не ограничиваются TION_API_*: код попадает в сборку только для сущностей из конфигурации.
 namespace property_controller {
 
 using dentra::tion::TionState;
@@ -15,6 +21,42 @@ using dentra::tion::TionTraits;
 using dentra::tion::TionGatePosition;
 using dentra::tion::TionStateCall;
 
+/// Ограничение публикации состояния сущности: зона нечувствительности, минимальный интервал
+/// между публикациями и максимальный интервал без публикации (heartbeat).
+/// Проверки выполняются при получении состояния бризера, поэтому heartbeat не может быть
+/// чаще опроса бризера.
+class PublishFilter {
+ public:
+  void set_deadband(float deadband) { this->deadband_ = deadband; }
+  void set_min_interval(uint32_t min_interval) { this->min_interval_ = min_interval; }
+  void set_heartbeat(uint32_t heartbeat) { this->heartbeat_ = heartbeat; }
+
+  /// changed - значение отличается от опубликованного, delta - величина изменения,
+  /// force - публиковать без учета зоны нечувствительности, min_interval при этом соблюдается.
+  bool check_publish(bool has_state, bool changed, float delta, bool force) {
+    const uint32_t now = millis();
+    const uint32_t elapsed = now - this->publish_time_;
+    bool res;
+    if (!has_state || (this->heartbeat_ != 0 && elapsed >= this->heartbeat_)) {
+      res = true;
+    } else if (!changed || (this->min_interval_ != 0 && elapsed < this->min_interval_)) {
+      res = false;
+    } else {
+      res = force || std::fabs(delta) >= this->deadband_;
+    }
+    if (res) {
+      this->publish_time_ = now;
+    }
+    return res;
+  }
+
+ protected:
+  float deadband_{};
+  uint32_t min_interval_{};
+  uint32_t heartbeat_{};
+  uint32_t publish_time_{};
+};
+
 template<typename C> class Controller {
   constexpr static const auto *TAG = "tion_properties";
 
@@ -100,10 +142,7 @@ template<typename C> class Controller {
 
     if constexpr (checker().has_api_get()) {
       // здесь обработчик не зависит от статуса
-      auto st = C::get(component->get_parent());
-      if (component->get_parent()->get_force_update() || !component->has_state() || st != component->state) {
-        component->publish_state(st);
-      }
+      publish_value_(component, C::get(component->get_parent()));
       return true;
     } else {
       if (state == nullptr) {
@@ -111,15 +150,9 @@ template<typename C> class Controller {
         return false;
       }
       if constexpr (checker().has_api_state_get()) {
-        auto st = C::get(component->get_parent(), *state);
-        if (component->get_parent()->get_force_update() || !component->has_state() || st != component->state) {
-          component->publish_state(st);
-        }
+        publish_value_(component, C::get(component->get_parent(), *state));
       } else {
-        auto st = C::get(*state);
-        if (component->get_parent()->get_force_update() || !component->has_state() || st != component->state) {
-          component->publish_state(st);
-        }
+        publish_value_(component, C::get(*state));
       }
       return true;
     }
@@ -145,6 +178,24 @@ template<typename C> class Controller {
       C::set(component->parent_, state);
     }
   }
+
+ protected:
+  template<typename T, typename V> static void publish_value_(T *component, const V &st) {
+    const bool force = component->get_parent()->get_force_update();
+    if constexpr (std::is_base_of_v<PublishFilter, T>) {
+      float delta = 0;
+      if constexpr (std::is_arithmetic_v<V>) {
+        delta = static_cast<float>(st) - static_cast<float>(component->state);
+      }
+      if (component->check_publish(component->has_state(), force || st != component->state, delta, force)) {
+        component->publish_state(st);
+      }
+    } else {
+      if (force || !component->has_state() || st != component->state) {
+        component->publish_state(st);
+      }
+    }
+  }
 };
 
 namespace binary_sensor {
@@ -396,6 +447,90 @@ struct Power {
   }
 };
 
+template<dentra::tion::TionProtocolStats::Counter N> struct ProtocolCounter {
+  static bool is_supported(TionApiComponent *c) { return c->has_protocol_stats(); }
+
+  static uint32_t get(TionApiComponent *c) { return c->get_protocol_counter(N); }
+};
+
+struct RxFrames : public ProtocolCounter<dentra::tion::TionProtocolStats::RX_FRAMES> {};
+struct TxFrames : public ProtocolCounter<dentra::tion::TionProtocolStats::TX_FRAMES> {};
+struct CrcErrors : public ProtocolCounter<dentra::tion::TionProtocolStats::CRC_ERRORS> {};
+struct InvalidSize : public ProtocolCounter<dentra::tion::TionProtocolStats::INVALID_SIZE> {};
+struct InvalidMagic : public ProtocolCounter<dentra::tion::TionProtocolStats::INVALID_MAGIC> {};
+struct Resyncs : public ProtocolCounter<dentra::tion::TionProtocolStats::RESYNCS> {};
+struct UnknownTypes : public ProtocolCounter<dentra::tion::TionProtocolStats::UNKNOWN_TYPES> {};
+struct ReassemblyDrops : public ProtocolCounter<dentra::tion::TionProtocolStats::REASSEMBLY_DROPS> {};
+struct Timeouts : public ProtocolCounter<dentra::tion::TionProtocolStats::TIMEOUTS> {};
+struct WriteErrors : public ProtocolCounter<dentra::tion::TionProtocolStats::WRITE_ERRORS> {};
+
+template<TionTiming::Section N> struct TimingMax {
+  static bool is_supported(TionApiComponent *c) { return c->get_timing() != nullptr; }
+
+  static float get(TionApiComponent *c) { return c->get_timing()->get(N).max * 0.001f; }
+};
+
+template<TionTiming::Section N> struct TimingP99 {
+  static bool is_supported(TionApiComponent *c) { return c->get_timing() != nullptr; }
+
+  static float get(TionApiComponent *c) { return c->get_timing()->get(N).p99 * 0.001f; }
+};
+
+struct LoopTimeMax : public TimingMax<TionTiming::SECTION_LOOP> {};
+struct LoopTimeP99 : public TimingP99<TionTiming::SECTION_LOOP> {};
+struct PollTimeMax : public TimingMax<TionTiming::SECTION_POLL> {};
+struct PollTimeP99 : public TimingP99<TionTiming::SECTION_POLL> {};
+struct FrameTimeMax : public TimingMax<TionTiming::SECTION_FRAME> {};
+struct FrameTimeP99 : public TimingP99<TionTiming::SECTION_FRAME> {};
+struct WriteTimeMax : public TimingMax<TionTiming::SECTION_WRITE> {};
+struct WriteTimeP99 : public TimingP99<TionTiming::SECTION_WRITE> {};
+struct PublishTimeMax : public TimingMax<TionTiming::SECTION_PUBLISH> {};
+struct PublishTimeP99 : public TimingP99<TionTiming::SECTION_PUBLISH> {};
+struct PerformTimeMax : public TimingMax<TionTiming::SECTION_PERFORM> {};
+struct PerformTimeP99 : public TimingP99<TionTiming::SECTION_PERFORM> {};
+
+struct WorstFrameType {
+  static bool is_supported(TionApiComponent *c) { return c->get_timing() != nullptr; }
+
+  static uint16_t get(TionApiComponent *c) { return c->get_timing()->get_worst_frame_type(); }
+};
+
+struct Energy {
+  static bool is_supported(TionApiComponent *c) { return c->get_energy() != nullptr; }
+
+  static float get(TionApiComponent *c) { return c->get_energy()->get_published_total(); }
+};
+
+struct HeaterEnergy {
+  static bool is_supported(TionApiComponent *c) {
+    return Energy::is_supported(c) && (c->traits().max_heater_power != 0 || c->traits().supports_heater_var);
+  }
+
+  static float get(TionApiComponent *c) { return c->get_energy()->get_published(TionEnergy::COUNTER_HEATER); }
+};
+
+struct FanEnergy {
+  static bool is_supported(TionApiComponent *c) { return Energy::is_supported(c); }
+
+  static float get(TionApiComponent *c) { return c->get_energy()->get_published_fan(); }
+};
+
+template<TionEnergy::Counter N> struct FanSpeedEnergy {
+  static bool is_supported(TionApiComponent *c) {
+    return Energy::is_supported(c) && N - TionEnergy::COUNTER_FAN_SPEED_0 <= c->traits().max_fan_speed;
+  }
+
+  static float get(TionApiComponent *c) { return c->get_energy()->get_published(N); }
+};
+
+struct FanSpeed0Energy : public FanSpeedEnergy<TionEnergy::COUNTER_FAN_SPEED_0> {};
+struct FanSpeed1Energy : public FanSpeedEnergy<TionEnergy::COUNTER_FAN_SPEED_1> {};
+struct FanSpeed2Energy : public FanSpeedEnergy<TionEnergy::COUNTER_FAN_SPEED_2> {};
+struct FanSpeed3Energy : public FanSpeedEnergy<TionEnergy::COUNTER_FAN_SPEED_3> {};
+struct FanSpeed4Energy : public FanSpeedEnergy<TionEnergy::COUNTER_FAN_SPEED_4> {};
+struct FanSpeed5Energy : public FanSpeedEnergy<TionEnergy::COUNTER_FAN_SPEED_5> {};
+struct FanSpeed6Energy : public FanSpeedEnergy<TionEnergy::COUNTER_FAN_SPEED_6> {};
+
 }  // namespace sensor
 
 namespace number {
@@ -460,7 +595,7 @@ namespace text_sensor {
 
 struct Errors {
   static std::string get(TionApiComponent *c, const TionState &state) {
-    return c->traits().errors_decode(state.errors);
+    return c->api()->get_errors_text();
   };
 };
 
@@ -525,7 +660,7 @@ struct Presets {
   };
   static std::string get(TionApiComponent *c) { return c->api()->get_active_preset(); }
   static void set(TionApiComponent *c, TionStateCall *call, const std::string &preset) {
-    c->api()->enable_preset(preset, call);
+    c->api()->enable_preset(preset.c_str(), call);
   }
 };
 
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../tion-api/tion-api.h"
+
+namespace esphome {
+namespace tion {
+
+class TionApiComponent;
+
+/// Подписчик на состояние бризера.
+///
+/// Узел списка подписчиков хранится в самом подписчике, поэтому подписка не требует
+/// выделения памяти, а оповещение выполняется прямым вызовом без std::function.
+class TionStateListener {
+ public:
+  /// Вызывается при получении состояния, nullptr - состояние не получено за state_timeout.
+  virtual void on_tion_state(const dentra::tion::TionState *state) = 0;
+
+ protected:
+  friend class TionApiComponent;
+  TionStateListener *next_state_listener_{};
+};
+
+}  // namespace tion
+}  // namespace esphome
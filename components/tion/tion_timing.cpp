@@ -0,0 +1,88 @@
+#include <algorithm>
+
+#include "tion_timing.h"
+
+namespace esphome {
+namespace tion {
+
+void TionTiming::add(Section section, uint32_t time_us, uint16_t frame_type) {
+  auto &wnd = this->windows_[section];
+  wnd.count++;
+  if (time_us > wnd.max) {
+    wnd.max = time_us;
+    if (section == SECTION_FRAME) {
+      this->frame_type_ = frame_type;
+    }
+  }
+  auto &bucket = wnd.buckets[bucket_(time_us)];
+  if (bucket != UINT16_MAX) {
+    bucket++;
+  }
+}
+
+void TionTiming::snapshot() {
+  for (uint8_t i = 0; i < SECTIONS; i++) {
+    auto &wnd = this->windows_[i];
+    auto &res = this->results_[i];
+    res.count = wnd.count;
+    res.max = wnd.max;
+    res.p99 = 0;
+    // ранг 99-го процентиля с округлением вверх
+    const uint32_t rank = (uint64_t(wnd.count) * 99 + 99) / 100;
+    uint32_t total = 0;
+    for (uint8_t b = 0; b < BUCKETS && rank > 0; b++) {
+      total += wnd.buckets[b];
+      if (total >= rank) {
+        res.p99 = std::min(bucket_upper_(b), wnd.max);
+        break;
+      }
+    }
+    wnd = {};
+  }
+  this->worst_frame_type_ = this->frame_type_;
+  this->frame_type_ = NO_FRAME_TYPE;
+}
+
+const char *TionTiming::get_section_name(Section section) {
+  switch (section) {
+    case SECTION_LOOP:
+      return "loop";
+    case SECTION_POLL:
+      return "poll";
+    case SECTION_FRAME:
+      return "frame";
+    case SECTION_WRITE:
+      return "write";
+    case SECTION_PUBLISH:
+      return "publish";
+    case SECTION_PERFORM:
+      return "perform";
+    default:
+      return "unknown";
+  }
+}
+
+// 0: <16 мкс, далее по 2 интервала на октаву, последний интервал неограничен.
+uint8_t TionTiming::bucket_(uint32_t time_us) {
+  if (time_us < 16) {
+    return 0;
+  }
+  const uint8_t msb = 31 - __builtin_clz(time_us);
+  const uint32_t bucket = 1 + (msb - 4) * 2 + ((time_us >> (msb - 1)) & 1);
+  return std::min<uint32_t>(bucket, BUCKETS - 1);
+}
+
+uint32_t TionTiming::bucket_upper_(uint8_t bucket) {
+  if (bucket == 0) {
+    return 15;
+  }
+  if (bucket == BUCKETS - 1) {
+    return UINT32_MAX;
+  }
+  const uint8_t msb = (bucket - 1) / 2 + 4;
+  const uint32_t lower = (1u << msb) | (((bucket - 1) & 1u) << (msb - 1));
+  return lower + (1u << (msb - 1)) - 1;
+}
+
+}  // namespace tion
+}  // namespace esphome
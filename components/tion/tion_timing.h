@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace tion {
+
+/// Время выполнения участков кода компонента: максимум и 99-й процентиль за окно измерения.
+/// Процентиль вычисляется по логарифмической гистограмме (2 интервала на октаву), поэтому
+/// его точность ограничена шириной интервала.
+class TionTiming {
+ public:
+  enum Section : uint8_t {
+    // TionApiComponent::call_loop
+    SECTION_LOOP,
+    // чтение данных из порта (UART poll, BLE notify)
+    SECTION_POLL,
+    // разбор кадра api и обработка состояния
+    SECTION_FRAME,
+    // запись кадра в порт
+    SECTION_WRITE,
+    // оповещение подписчиков о новом состоянии
+    SECTION_PUBLISH,
+    // отправка пакета изменений
+    SECTION_PERFORM,
+    SECTIONS,
+  };
+
+  static constexpr uint8_t BUCKETS = 32;
+  static constexpr uint16_t NO_FRAME_TYPE = 0;
+
+  struct Result {
+    uint32_t count;
+    uint32_t max;
+    uint32_t p99;
+  };
+
+  void add(Section section, uint32_t time_us, uint16_t frame_type = NO_FRAME_TYPE);
+
+  /// Фиксирует результаты текущего окна и начинает новое.
+  void snapshot();
+  /// Результаты последнего зафиксированного окна, мкс.
+  const Result &get(Section section) const { return this->results_[section]; }
+  /// Тип кадра с максимальным временем обработки в последнем окне.
+  uint16_t get_worst_frame_type() const { return this->worst_frame_type_; }
+
+  static const char *get_section_name(Section section);
+
+  class Scope {
+   public:
+    Scope(TionTiming *timing, Section section, uint16_t frame_type = NO_FRAME_TYPE)
+        : timing_(timing), start_(timing ? micros() : 0), section_(section), frame_type_(frame_type) {}
+    ~Scope() {
+      if (this->timing_) {
+        this->timing_->add(this->section_, micros() - this->start_, this->frame_type_);
+      }
+    }
+
+   protected:
+    TionTiming *timing_;
+    uint32_t start_;
+    Section section_;
+    uint16_t frame_type_;
+  };
+
+ protected:
+  struct Window {
+    uint32_t count;
+    uint32_t max;
+    uint16_t buckets[BUCKETS];
+  };
+  Window windows_[SECTIONS]{};
+  Result results_[SECTIONS]{};
+  uint16_t frame_type_{};
+  uint16_t worst_frame_type_{};
+
+  static uint8_t bucket_(uint32_t time_us);
+  static uint32_t bucket_upper_(uint8_t bucket);
+};
+
+#ifdef TION_ENABLE_TIMING
+#define TION_TIMING_SCOPE(timing, section, ...) \
+  esphome::tion::TionTiming::Scope tion_timing_scope_(timing, esphome::tion::TionTiming::section, ##__VA_ARGS__)
+#else
+#define TION_TIMING_SCOPE(timing, section, ...)
+#endif
+
+}  // namespace tion
+}  // namespace esphome
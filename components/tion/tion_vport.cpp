@@ -0,0 +1,21 @@
+#include "esphome/core/defines.h"
+
+#include "../tion-api/tion-api-uart.h"
+#include "tion_vport_uart.h"
+#include "tion_vport_jtag.h"
+
+#ifndef TION_ENABLE_VIRTUAL_API
+
+#if defined(USE_VPORT_UART) && defined(USE_VPORT_JTAG)
+#error "UART and JTAG transports in one build require TION_ENABLE_VIRTUAL_API"
+#elif defined(USE_VPORT_UART)
+TION_UART_READER_IMPL(esphome::tion::TionUartStream)
+#elif defined(USE_VPORT_JTAG)
+TION_UART_READER_IMPL(esphome::tion::TionJtagStream)
+#else
+// сборка без UART, протоколы UART не используются
+int dentra::tion::TionUartReader::available() { return 0; }
+bool dentra::tion::TionUartReader::read_array(void *data, size_t size) { return false; }
+#endif
+
+#endif  // TION_ENABLE_VIRTUAL_API
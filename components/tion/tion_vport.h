@@ -8,6 +8,12 @@
 
 #include "../tion-api/tion-api-protocol.h"
 #include "../tion-api/tion-api-writer.h"
+#include "tion_timing.h"
+#include "tion_arbiter.h"
+#ifdef TION_ENABLE_CAPTURE
+#include <vector>
+#include "../tion-api/tion-api-capture.h"
+#endif
 
 namespace esphome {
 namespace tion {
@@ -28,8 +34,18 @@ template<class protocol_type> class TionIO {
 
   void set_on_frame(on_frame_type &&reader) { protocol_.reader = std::move(reader); }
 
+  const dentra::tion::TionProtocolStats &get_protocol_stats() const { return this->protocol_.get_stats(); }
+  protocol_type *get_protocol() { return &this->protocol_; }
+
+#ifdef TION_ENABLE_TIMING
+  void set_timing(TionTiming *timing) { this->timing_ = timing; }
+#endif
+
  protected:
   protocol_type protocol_;
+#ifdef TION_ENABLE_TIMING
+  TionTiming *timing_{};
+#endif
 };
 
 // vport wrapper with api support.
@@ -41,25 +57,82 @@ template<class frame_spec_t, class api_t> class TionVPortApi : public api_t, pub
 
   TionVPortApi(vport_t *vport) : vport_(vport) {
     vport->add_listener(this);
+#ifdef TION_ENABLE_VIRTUAL_API
     using this_t = std::remove_pointer_t<decltype(this)>;
     api_t::set_writer(api_t::writer_type::template create<this_t, &this_t::write_frame_>(*this));
+#endif
   }
 
   void on_ready() override { this->on_ready_fn.call_if(); }
 
   void on_frame(const frame_spec_t &frame, size_t size) override {
+    TION_TIMING_SCOPE(this->timing_, SECTION_FRAME, frame.type);
+#ifdef TION_ENABLE_ARBITER
+    // кадры, отправляемые при обработке ответа (цепочка запросов таймеров, обновление прошивки,
+    // турбо, антизамерзание), продолжают полосу запроса
+    TionArbiter::Scope lane_scope(this->arbiter_,
+                                  this->arbiter_ ? this->arbiter_->get_last_lane() : TionArbiter::LANE_AUTO);
+#endif
+#ifdef TION_ENABLE_CAPTURE
+    for (auto *capture : this->captures_) {
+      capture->rx(frame.type, frame.data, size - frame_spec_t::head_size());
+    }
+#endif
     this->read_frame(frame.type, frame.data, size - frame_spec_t::head_size());
   }
 
+#ifdef TION_ENABLE_CAPTURE
+  void add_capture(dentra::tion::TionCaptureWriter *capture) { this->captures_.push_back(capture); }
+#endif
+#ifdef TION_ENABLE_TIMING
+  void set_timing(TionTiming *timing) { this->timing_ = timing; }
+#endif
+#ifdef TION_ENABLE_ARBITER
+  void set_arbiter(TionArbiter *arbiter) {
+    using this_t = std::remove_pointer_t<decltype(this)>;
+    this->arbiter_ = arbiter;
+    arbiter->set_writer(TionArbiter::writer_type::template create<this_t, &this_t::send_frame_>(*this));
+  }
+#endif
+
  protected:
+#ifndef TION_ENABLE_VIRTUAL_API
+  // вызов write_frame_ из TION_API_WRITER_IMPL
+  friend class dentra::tion::TionApiWriter;
+#endif
   vport_t *vport_;
+#ifdef TION_ENABLE_TIMING
+  TionTiming *timing_{};
+#endif
+#ifdef TION_ENABLE_ARBITER
+  TionArbiter *arbiter_{};
+#endif
+#ifdef TION_ENABLE_CAPTURE
+  std::vector<dentra::tion::TionCaptureWriter *> captures_;
+#endif
 
   bool write_frame_(uint16_t type, const void *data, size_t size) {
+#ifdef TION_ENABLE_ARBITER
+    if (this->arbiter_) {
+      // кадр из очереди может быть отброшен позже, такие кадры учитываются арбитром как ошибки записи
+      return this->arbiter_->write(millis(), type, data, size) != TionArbiter::RESULT_FAILED;
+    }
+#endif
+    return this->send_frame_(type, data, size);
+  }
+
+  bool send_frame_(uint16_t type, const void *data, size_t size) {
+    TION_TIMING_SCOPE(this->timing_, SECTION_WRITE);
     uint8_t buf[sizeof(frame_spec_t) + size];
     std::memset(buf, 0, sizeof(buf));
     auto frame = reinterpret_cast<frame_spec_t *>(buf);
     frame->type = type;
     std::memcpy(frame->data, data, size);
+#ifdef TION_ENABLE_CAPTURE
+    for (auto *capture : this->captures_) {
+      capture->tx(type, data, size);
+    }
+#endif
     this->vport_->write(*frame, sizeof(buf));
     return true;
   }
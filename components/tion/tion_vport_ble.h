@@ -27,7 +27,10 @@ template<class protocol_type> class TionBleIO : public TionIO<protocol_type>, pu
   void set_on_ready(on_ready_type &&on_ready) { this->on_ready_ = on_ready; }
 
   void on_ble_ready() override { this->on_ready_.call_if(); }
-  bool on_ble_data(const uint8_t *data, uint16_t size) override { return this->protocol_.read_data(data, size); }
+  bool on_ble_data(const uint8_t *data, uint16_t size) override {
+    TION_TIMING_SCOPE(this->timing_, SECTION_POLL);
+    return this->protocol_.read_data(data, size);
+  }
 
  protected:
   on_ready_type on_ready_;
@@ -41,6 +44,10 @@ class TionVPortBLEComponent : public vport::VPortBLEComponent<io_t, typename io_
   TionVPortBLEComponent(io_t *io) : vport::VPortBLEComponent<io_t, typename io_t::frame_spec_type>(io) {}
 
   TionVPortType get_type() const { return TionVPortType::VPORT_BLE; }
+  const dentra::tion::TionProtocolStats *get_protocol_stats() const { return &this->io_->get_protocol_stats(); }
+#ifdef TION_ENABLE_TIMING
+  void set_timing(TionTiming *timing) { this->io_->set_timing(timing); }
+#endif
 };
 
 }  // namespace tion
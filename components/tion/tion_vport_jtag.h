@@ -22,16 +22,10 @@ namespace tion {
 
 // bool usb_serial_jtag_is_connected(void);
 
-template<class protocol_t> class TionJtagIO : public TionIO<protocol_t>, public dentra::tion::TionUartReader {
+// Чтение USB JTAG, общее для всех протоколов, см. TION_UART_READER_IMPL.
+class TionJtagStream : public dentra::tion::TionUartReader {
  public:
-  explicit TionJtagIO() {
-    using this_t = std::remove_pointer_t<decltype(this)>;
-    this->protocol_.writer.template set<this_t, &this_t::write_>(*this);
-  }
-
-  void poll() { this->protocol_.read_uart_data(this); }
-
-  int available() override {
+  int available() TION_API_OVERRIDE {
     if (this->is_failed_) {
       return 0;
     }
@@ -46,7 +40,7 @@ template<class protocol_t> class TionJtagIO : public TionIO<protocol_t>, public
     }
     return this->buf_len_;
   }
-  bool read_array(void *data, size_t size) override {
+  bool read_array(void *data, size_t size) TION_API_OVERRIDE {
     if (this->is_failed_) {
       return false;
     }
@@ -75,7 +69,21 @@ template<class protocol_t> class TionJtagIO : public TionIO<protocol_t>, public
   uint8_t buf_[256]{};
   size_t buf_len_{};
   bool is_failed_{};
+};
 
+template<class protocol_t> class TionJtagIO : public TionIO<protocol_t>, public TionJtagStream {
+ public:
+  explicit TionJtagIO() {
+    using this_t = std::remove_pointer_t<decltype(this)>;
+    this->protocol_.writer.template set<this_t, &this_t::write_>(*this);
+  }
+
+  void poll() {
+    TION_TIMING_SCOPE(this->timing_, SECTION_POLL);
+    this->protocol_.read_uart_data(this);
+  }
+
+ protected:
   bool write_(const uint8_t *data, size_t size) {
     if (this->is_failed_) {
       ESP_LOGD("JTAG", "jtag driver was not installed");
@@ -107,6 +115,10 @@ class TionVPortJTAGComponent : public vport::VPortUARTComponent<io_t, typename i
   }
 
   TionVPortType get_type() const { return TionVPortType::VPORT_UART; }
+  const dentra::tion::TionProtocolStats *get_protocol_stats() const { return &this->io_->get_protocol_stats(); }
+#ifdef TION_ENABLE_TIMING
+  void set_timing(TionTiming *timing) { this->io_->set_timing(timing); }
+#endif
 };
 
 }  // namespace tion
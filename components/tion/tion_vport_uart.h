@@ -4,7 +4,17 @@
 
 #ifdef USE_TION_HALF_DUPLEX
 // #pragma message("USE_TION_HALF_DUPLEX")
+#include <cstring>
 #include "esphome/core/application.h"
+#ifndef TION_HALF_DUPLEX_BUF_SIZE
+#define TION_HALF_DUPLEX_BUF_SIZE 64
+#endif
+#ifdef TION_NO_HEAP
+#include <etl/queue.h>
+#ifndef TION_HALF_DUPLEX_QUEUE_SIZE
+#define TION_HALF_DUPLEX_QUEUE_SIZE 4
+#endif
+#endif
 #endif
 
 #include "esphome/components/uart/uart_component.h"
@@ -17,22 +27,33 @@
 namespace esphome {
 namespace tion {
 
-template<class protocol_t> class TionUartIO : public TionIO<protocol_t>, public dentra::tion::TionUartReader {
+// Чтение UART, общее для всех протоколов, см. TION_UART_READER_IMPL.
+class TionUartStream : public dentra::tion::TionUartReader {
+ public:
+  explicit TionUartStream(uart::UARTComponent *uart) : uart_(uart) {}
+
+  int available() TION_API_OVERRIDE { return this->uart_->available(); }
+  bool read_array(void *data, size_t size) TION_API_OVERRIDE {
+    return this->uart_->read_array(static_cast<uint8_t *>(data), size);
+  }
+
+ protected:
+  uart::UARTComponent *uart_;
+};
+
+template<class protocol_t> class TionUartIO : public TionIO<protocol_t>, public TionUartStream {
  public:
-  explicit TionUartIO(uart::UARTComponent *uart) : uart_(uart) {
+  explicit TionUartIO(uart::UARTComponent *uart) : TionUartStream(uart) {
     using this_t = std::remove_pointer_t<decltype(this)>;
     this->protocol_.writer.template set<this_t, &this_t::write_>(*this);
   }
 
-  void poll() { this->protocol_.read_uart_data(this); }
-
-  int available() override { return this->uart_->available(); }
-  bool read_array(void *data, size_t size) override {
-    return this->uart_->read_array(static_cast<uint8_t *>(data), size);
+  void poll() {
+    TION_TIMING_SCOPE(this->timing_, SECTION_POLL);
+    this->protocol_.read_uart_data(this);
   }
 
  protected:
-  uart::UARTComponent *uart_;
   bool write_(const uint8_t *data, size_t size) {
     this->uart_->write_array(data, size);
     this->uart_->flush();
@@ -53,6 +74,10 @@ class TionVPortUARTComponent : public vport::VPortUARTComponent<io_t, typename i
   }
 
   TionVPortType get_type() const { return TionVPortType::VPORT_UART; }
+  const dentra::tion::TionProtocolStats *get_protocol_stats() const { return &this->io_->get_protocol_stats(); }
+#ifdef TION_ENABLE_TIMING
+  void set_timing(TionTiming *timing) { this->io_->set_timing(timing); }
+#endif
 
   void call_setup() override {
     super_t::call_setup();
@@ -66,6 +91,38 @@ class TionVPortUARTComponent : public vport::VPortUARTComponent<io_t, typename i
 #ifdef USE_TION_HALF_DUPLEX
   void write(const typename io_t::frame_spec_type &frame, size_t size) override {
     if (this->await_frame_) {
+#ifdef TION_NO_HEAP
+      if (size > TION_HALF_DUPLEX_BUF_SIZE) {
+        ESP_LOGW("tion_vport_uart", "Frame is too large to defer: %zu", size);
+        return;
+      }
+      if (this->deferred_.full()) {
+        ESP_LOGW("tion_vport_uart", "Deferred queue is full, frame dropped");
+        return;
+      }
+      const bool scheduled = !this->deferred_.empty();
+      this->deferred_.emplace();
+      auto &deferred = this->deferred_.back();
+      std::memcpy(deferred.data, &frame, size);
+      deferred.size = size;
+      if (scheduled) {
+        return;
+      }
+      // как и без TION_NO_HEAP, все отложенные кадры отправляются в одном проходе defer
+      this->defer([this]() {
+        while (!this->deferred_.empty()) {
+          const auto &deferred = this->deferred_.front();
+          auto frame = reinterpret_cast<const typename io_t::frame_spec_type *>(deferred.data);
+          if (this->await_frame_) {
+            ESP_LOGW("tion_vport_uart", "prev frame was not recv, may lead to crash");
+          }
+          super_t::write(*frame, deferred.size);
+          this->deferred_.pop();
+          arch_feed_wdt();
+          yield();
+        }
+      });
+#else
       auto data8 = reinterpret_cast<const uint8_t *>(&frame);
       auto datav = std::vector<uint8_t>(data8, data8 + size);
       this->defer([this, datav]() {
@@ -77,6 +134,7 @@ class TionVPortUARTComponent : public vport::VPortUARTComponent<io_t, typename i
         arch_feed_wdt();
         yield();
       });
+#endif
     } else {
       this->await_frame_ = true;
       super_t::write(frame, size);
@@ -87,6 +145,13 @@ class TionVPortUARTComponent : public vport::VPortUARTComponent<io_t, typename i
 
  protected:
   bool await_frame_{};
+#ifdef TION_NO_HEAP
+  struct DeferredFrame {
+    size_t size;
+    uint8_t data[TION_HALF_DUPLEX_BUF_SIZE];
+  };
+  etl::queue<DeferredFrame, TION_HALF_DUPLEX_QUEUE_SIZE> deferred_;
+#endif
   void on_frame_(const typename io_t::frame_spec_type &frame, size_t size) {
     arch_feed_wdt();
     yield();
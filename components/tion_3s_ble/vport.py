@@ -23,6 +23,7 @@ CONFIG_SCHEMA = vport.vport_ble_schema(Tion3sBleVPort, Tion3sBleIO).extend(
 
 async def to_code(config):
     var = await vport.setup_vport_ble(config)
+    tion.setup_build_type("3s", "ble")
     cg.add(var.set_experimental_always_pair(config[CONF_EXPERIMENTAL_ALWAYS_PAIR]))
     vio = await cg.get_variable(config[vport.CONF_VPORT_IO_ID])
     cg.add(vio.set_vport(var))
@@ -1,19 +1,43 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import uart
-from esphome.const import CONF_ID
+from esphome.const import CONF_ID, CONF_UPDATE_INTERVAL
 
-from .. import tion, vport  # pylint: disable=relative-beyond-top-level
+from .. import cgp, tion, vport  # pylint: disable=relative-beyond-top-level
 
 tion_3s_proxy_ns = cg.esphome_ns.namespace("tion_3s_proxy")
 Tion3sBleProxy = tion_3s_proxy_ns.class_("Tion3sBleProxy", cg.Component)
 Tion3sApiProxy = tion_3s_proxy_ns.class_("Tion3sApiProxy")
 
+CONF_TAP = "tap"
+
+# TionApiComponent, получающий состояние из опросов BLE модуля.
+def _validate_tap(config):
+    if config[tion.CONF_STATE_TIMEOUT] >= config[CONF_UPDATE_INTERVAL]:
+        raise cv.Invalid(
+            f"{tion.CONF_STATE_TIMEOUT} must be less than {CONF_UPDATE_INTERVAL}"
+        )
+    return config
+
+
+TAP_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(tion.BREEZER_TYPES["3s"]),
+            # бризер опрашивает BLE модуль, таймаут проверяет что опрос идет
+            cv.Optional(tion.CONF_STATE_TIMEOUT, default="30s"): cv.update_interval,
+            cv.Optional(tion.CONF_FORCE_UPDATE): cv.boolean,
+        }
+    ).extend(cv.polling_component_schema("60s")),
+    _validate_tap,
+)
+
 CONFIG_SCHEMA = (
     cv.Schema(
         {
             cv.GenerateID(): cv.declare_id(Tion3sBleProxy),
             cv.GenerateID(tion.CONF_TION_ID): cv.declare_id(tion.TionVPortApi),
+            cv.Optional(CONF_TAP): TAP_SCHEMA,
         }
     )
     .extend(vport.VPORT_CLIENT_SCHEMA)
@@ -23,7 +47,18 @@ CONFIG_SCHEMA = (
 
 
 async def to_code(config):
-    _, api = await tion.new_vport_api_wrapper(config, Tion3sApiProxy)
+    prt, api = await tion.new_vport_api_wrapper(config, Tion3sApiProxy)
+    tion.setup_build_type("3s", "uart")
     urt = await cg.get_variable(config[uart.CONF_UART_ID])
     ble = cg.new_Pvariable(config[CONF_ID], api, urt)
     await cg.register_component(ble, config)
+
+    if CONF_TAP in config:
+        tap = config[CONF_TAP]
+        var = cg.new_Pvariable(tap[CONF_ID], api, prt.get_type())
+        await cg.register_component(var, tap)
+        cg.add(var.set_component_source("tion[type=3s,tap]"))
+        cg.add_build_flag("-DTION_ESPHOME")
+        cg.add(var.set_state_timeout(tap[tion.CONF_STATE_TIMEOUT]))
+        cg.add(var.set_batch_timeout(0))
+        cgp.setup_value(tap, tion.CONF_FORCE_UPDATE, var.set_force_update)
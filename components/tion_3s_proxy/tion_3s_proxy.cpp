@@ -1,4 +1,5 @@
 #include "esphome/core/log.h"
+#include "esphome/core/hal.h"
 
 #include "../tion-api/tion-api-3s-internal.h"
 
@@ -15,29 +16,67 @@ static const char *const TAG = "tion_3s_proxy";
 #define FRAME_RSP_TO_CMD(rsp) ((rsp) >> 12)
 
 using dentra::tion_3s::FRAME_TYPE_SRV_MODE_SET;
+using dentra::tion_3s::FRAME_TYPE_STATE_GET;
+using dentra::tion_3s::FRAME_TYPE_STATE_SET;
 
 void Tion3sApiProxy::read_frame(uint16_t frame_type, const void *frame_data, size_t frame_data_size) {
   // сюда прилетают команды типа RSP, для прокси RSP это RX
   auto cmd = FRAME_RSP_TO_CMD(frame_type);
+  // декодируем состояние для подключенного TionApiComponent.
+  // BLE модуль опрашивает бризер постоянно, поэтому в обход Tion3sApi::read_frame, без лога на каждый ответ.
+  if (cmd == FRAME_TYPE_STATE_GET || cmd == FRAME_TYPE_STATE_SET) {
+    this->write_slot_.ack();
+    this->update_state_(*static_cast<const dentra::tion_3s::tion3s_state_t *>(frame_data));
+    this->notify_state_(0);
+  }
   // фильтруем команды на которые были запросы.
   // FRAME_TYPE_SRV_MODE_SET прилетает от бризера без специального запроса,
   // после ручного нажатие кнопки сопряжения
-  if (cmd != FRAME_TYPE_SRV_MODE_SET && this->ble_->get_last_cmd() != cmd) {
+  if (cmd != FRAME_TYPE_SRV_MODE_SET && !this->ble_->match_response(cmd)) {
     return;
   }
-  auto *data8 = static_cast<const uint8_t *>(frame_data);
-  ESP_LOGD(TAG, "RX (%04X): %s", frame_type, format_hex_pretty(data8, frame_data_size).c_str());
+  ESP_LOGV(TAG, "RX (%04X): %s", frame_type,
+           format_hex_pretty(static_cast<const uint8_t *>(frame_data), frame_data_size).c_str());
   this->ble_->write_frame(frame_type, frame_data, frame_data_size);
-  this->ble_->reset_last_cmd();
 }
 
 void Tion3sBleProxy::on_frame_(const frame_spec_type &frame, size_t size) {
   // сюда прилетают команды типа REQ, для прокси RSP это TX
   const auto frame_data_size = size - frame_spec_type::head_size();
-  ESP_LOGD(TAG, "TX (%04X): %s", frame.type, format_hex_pretty(frame.data, frame_data_size).c_str());
+  ESP_LOGV(TAG, "TX (%04X): %s", frame.type, format_hex_pretty(frame.data, frame_data_size).c_str());
   this->api_->write_frame(frame.type, frame.data, frame_data_size);
   // сохраняем команду для дальнейшей фильтрации
-  this->last_cmd_ = FRAME_REQ_TO_CMD(frame.type);
+  this->pending_push_(FRAME_REQ_TO_CMD(frame.type));
+}
+
+void Tion3sBleProxy::pending_push_(uint8_t cmd) {
+  if (this->pending_size_ == PENDING_SIZE) {
+    ESP_LOGW(TAG, "Too many pending requests, drop %02X", this->pending_[this->pending_head_].cmd);
+    this->pending_pop_();
+  }
+  auto &req = this->pending_[(this->pending_head_ + this->pending_size_) % PENDING_SIZE];
+  req.time = millis();
+  req.cmd = cmd;
+  this->pending_size_++;
+}
+
+bool Tion3sBleProxy::match_response(uint8_t cmd) {
+  const auto now = millis();
+  // удаляем просроченные запросы
+  while (this->pending_size_ > 0 && now - this->pending_[this->pending_head_].time > PENDING_TIMEOUT) {
+    ESP_LOGV(TAG, "Request %02X timed out", this->pending_[this->pending_head_].cmd);
+    this->pending_pop_();
+  }
+  // бризер отвечает по порядку, поэтому запросы до найденного остались без ответа
+  for (uint8_t i = 0; i < this->pending_size_; i++) {
+    if (this->pending_[(this->pending_head_ + i) % PENDING_SIZE].cmd == cmd) {
+      for (uint8_t j = 0; j <= i; j++) {
+        this->pending_pop_();
+      }
+      return true;
+    }
+  }
+  return false;
 }
 
 void Tion3sBleProxy::dump_config() { ESP_LOGCONFIG(TAG, "Tion 3S Proxy"); }
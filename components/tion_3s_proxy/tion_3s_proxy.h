@@ -13,19 +13,20 @@ namespace tion_3s_proxy {
 class Tion3sBleProxy;
 
 // This component is connected directly to tion breezer.
-class Tion3sApiProxy : public dentra::tion::TionApiBase, public dentra::tion::TionApiWriter {
+// Ответы бризера с состоянием, в том числе на запросы BLE модуля, декодируются в TionState,
+// поэтому к прокси можно подключить TionApiComponent (tap режим) без собственного опроса бризера.
+class Tion3sApiProxy : public dentra::tion::Tion3sApi {
  public:
   using Api = Tion3sApiProxy;  // used in TionVPortApi wrapper
 
   void read_frame(uint16_t frame_type, const void *frame_data, size_t frame_data_size);
   void set_ble(Tion3sBleProxy *ble) { this->ble_ = ble; }
 
+  // состояние запрашивает BLE модуль, собственных запросов не делаем
+  void request_state() TION_API_OVERRIDE {}
+
  protected:
   Tion3sBleProxy *ble_{};
-  // not used here
-  void request_state() override {}
-  void write_state(dentra::tion::TionStateCall *call) override {}
-  void reset_filter() override {}
 };
 
 class Tion3sUartProtocolProxy : public dentra::tion::Tion3sUartProtocol {
@@ -51,14 +52,31 @@ class Tion3sBleProxy : public Component, public tion::TionUartIO<Tion3sUartProto
     this->protocol_.write_frame(frame_type, frame_data, frame_data_size);
   }
 
-  uint8_t get_last_cmd() const { return this->last_cmd_; }
-  void reset_last_cmd() { this->last_cmd_ = 0; }
+  /// Сопоставляет ответ бризера с ожидающим запросом BLE модуля.
+  /// @return true если на команду был запрос и ответ необходимо переслать.
+  bool match_response(uint8_t cmd);
 
  protected:
+  // Максимальное количество запросов, ожидающих ответа.
+  static constexpr uint8_t PENDING_SIZE = 4;
+  // Время ожидания ответа на запрос, мс.
+  static constexpr uint32_t PENDING_TIMEOUT = 1000;
+
   Tion3sApiProxy *api_;
-  uint8_t last_cmd_{};
+
+  struct {
+    uint32_t time;
+    uint8_t cmd;
+  } pending_[PENDING_SIZE]{};
+  uint8_t pending_head_{};
+  uint8_t pending_size_{};
 
   void on_frame_(const frame_spec_type &frame, size_t size);
+  void pending_push_(uint8_t cmd);
+  void pending_pop_() {
+    this->pending_head_ = (this->pending_head_ + 1) % PENDING_SIZE;
+    this->pending_size_--;
+  }
 };
 
 }  // namespace tion_3s_proxy
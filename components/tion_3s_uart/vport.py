@@ -15,6 +15,7 @@ CONFIG_SCHEMA = vport.vport_uart_schema(Tion3sUartVPort, Tion3sUartIO)
 
 async def to_code(config):
     await vport.setup_vport_uart(config)
+    tion.setup_build_type("3s", "uart")
     # enable ota subscription
     cg.add_define("USE_OTA_STATE_CALLBACK")
 
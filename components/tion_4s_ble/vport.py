@@ -17,3 +17,4 @@ CONFIG_SCHEMA = vport.vport_ble_schema(Tion4sBleVPort, Tion4sBleIO)
 
 async def to_code(config):
     await vport.setup_vport_ble(config)
+    tion.setup_build_type("4s", "ble")
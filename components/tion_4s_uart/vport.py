@@ -23,6 +23,7 @@ CONFIG_SCHEMA = vport.vport_uart_schema(Tion4sUartVPort, Tion4sUartIO).extend(
 
 async def to_code(config):
     var = await vport.setup_vport_uart(config)
+    tion.setup_build_type("4s", "uart")
     cg.add(var.set_heartbeat_interval(config[CONF_HEARTBEAT_INTERVAL]))
     cg.add_build_flag("-DTION_ENABLE_HEARTBEAT")
     # enable ota subscription
@@ -17,6 +17,10 @@ class TionLtUartVPort : public TionVPortUARTComponent<TionLtUartIO> {
   void dump_config() override;
 
   void set_api(void *) {}
+
+  void restore_airflow_counter(uint32_t airflow_counter, uint32_t fan_time) {
+    this->io_->get_protocol()->restore_airflow_counter(airflow_counter, fan_time);
+  }
 };
 
 }  // namespace tion
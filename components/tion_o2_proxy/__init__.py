@@ -1,5 +1,3 @@
-import logging
-
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import uart
@@ -11,11 +9,16 @@ tion_o2_proxy_ns = cg.esphome_ns.namespace("tion_o2_proxy")
 TionO2Proxy = tion_o2_proxy_ns.class_("TionO2Proxy", cg.Component)
 TionO2ApiProxy = tion_o2_proxy_ns.class_("TionO2ApiProxy")
 
+CONF_CACHE_TIMEOUT = "cache_timeout"
+
 CONFIG_SCHEMA = (
     cv.Schema(
         {
             cv.GenerateID(): cv.declare_id(TionO2Proxy),
             cv.GenerateID(tion.CONF_TION_ID): cv.declare_id(tion.TionVPortApi),
+            cv.Optional(
+                CONF_CACHE_TIMEOUT, default="1s"
+            ): cv.positive_time_period_milliseconds,
         }
     )
     .extend(vport.VPORT_CLIENT_SCHEMA)
@@ -25,8 +28,9 @@ CONFIG_SCHEMA = (
 
 
 async def to_code(config):
-    logging.error("tion_o2_proxy is not supported at this moment")
-    # _, api = await tion.new_vport_api_wrapper(config, TionO2ApiProxy)
-    # urt = await cg.get_variable(config[uart.CONF_UART_ID])
-    # var = cg.new_Pvariable(config[CONF_ID], api, urt)
-    # await cg.register_component(var, config)
+    _, api = await tion.new_vport_api_wrapper(config, TionO2ApiProxy)
+    tion.setup_build_type("o2", "uart")
+    urt = await cg.get_variable(config[uart.CONF_UART_ID])
+    var = cg.new_Pvariable(config[CONF_ID], api, urt)
+    await cg.register_component(var, config)
+    cg.add(var.set_cache_timeout(config[CONF_CACHE_TIMEOUT]))
@@ -1,4 +1,8 @@
+#include <cstring>
+#include <cinttypes>
+
 #include "esphome/core/log.h"
+#include "esphome/core/hal.h"
 
 #include "../tion-api/tion-api-o2-internal.h"
 
@@ -12,19 +16,110 @@ static const char *const TAG = "tion_o2_proxy";
 #define FRAME_REQ_TO_CMD(req) ((req))
 #define FRAME_RSP_TO_CMD(rsp) ((rsp) >> 4)
 
+using namespace dentra::tion_o2;
+
+// Тип ответа бризера на запрос RF модуля или 0, если запрос не кэшируется.
+// Кэшируются только запросы чтения, запросы изменения (состояние, режим работы, время)
+// всегда передаются бризеру.
+static uint8_t get_cached_rsp_type(uint8_t req_type) {
+  switch (req_type) {
+    case FRAME_TYPE_STATE_GET_REQ:
+      return FRAME_TYPE_STATE_GET_RSP;
+    case FRAME_TYPE_DEV_MODE_REQ:
+      return FRAME_TYPE_DEV_MODE_RSP;
+    case FRAME_TYPE_TIME_GET_REQ:
+      return FRAME_TYPE_TIME_GET_RSP;
+    case FRAME_TYPE_DEV_INFO_REQ:
+      return FRAME_TYPE_DEV_INFO_RSP;
+    default:
+      return 0;
+  }
+}
+
 void TionO2ApiProxy::read_frame(uint16_t frame_type, const void *frame_data, size_t frame_data_size) {
   auto *data8 = static_cast<const uint8_t *>(frame_data);
-  ESP_LOGD(TAG, "RX [%02X]:%s", frame_type, format_hex_pretty(data8, frame_data_size).c_str());
+  ESP_LOGV(TAG, "RX [%02X]:%s", frame_type, format_hex_pretty(data8, frame_data_size).c_str());
+  this->parent_->cache_update_(frame_type, data8, frame_data_size);
   this->parent_->tx_->write_frame(frame_type, frame_data, frame_data_size);
 }
 
 void TionO2Proxy::on_frame_(const dentra::tion_o2::TionO2UartProtocol::frame_spec_type &frame, size_t size) {
   const auto frame_data_size = size - dentra::tion_o2::TionO2UartProtocol::frame_spec_type::head_size();
-  ESP_LOGD(TAG, "TX [%02X]:%s", frame.type, format_hex_pretty(frame.data, frame_data_size).c_str());
+  ESP_LOGV(TAG, "TX [%02X]:%s", frame.type, format_hex_pretty(frame.data, frame_data_size).c_str());
+  if (this->cache_reply_(frame.type, frame.data, frame_data_size)) {
+    return;
+  }
   this->rx_->write_frame(frame.type, frame.data, frame_data_size);
 }
 
-void TionO2Proxy::dump_config() { ESP_LOGCONFIG(TAG, "Tion O2 Proxy"); }
+bool TionO2Proxy::cache_reply_(uint8_t type, const uint8_t *data, size_t size) {
+  this->cache_pending_ = nullptr;
+  if (this->cache_timeout_ == 0) {
+    return false;
+  }
+
+  const uint8_t rsp_type = get_cached_rsp_type(type);
+  if (rsp_type == 0) {
+    // запрос изменяет состояние бризера, ранее полученные ответы более не актуальны
+    for (auto &entry : this->cache_) {
+      entry.time = 0;
+    }
+    return false;
+  }
+
+  if (size > CacheEntry::REQ_DATA_SIZE) {
+    return false;
+  }
+
+  const auto now = millis();
+  CacheEntry *free_entry = nullptr;
+  for (auto &entry : this->cache_) {
+    if (entry.time != 0 && entry.req_type == type && entry.req_size == size &&
+        std::memcmp(entry.req_data, data, size) == 0) {
+      if (now - entry.time > this->cache_timeout_) {
+        entry.time = 0;
+        free_entry = &entry;
+        break;
+      }
+      this->cache_hits_++;
+      ESP_LOGV(TAG, "Cache hit [%02X]", type);
+      this->tx_->write_frame(entry.rsp_type, entry.rsp_data, entry.rsp_size);
+      return true;
+    }
+    if (free_entry == nullptr && entry.time == 0) {
+      free_entry = &entry;
+    }
+  }
+
+  if (free_entry != nullptr) {
+    free_entry->req_type = type;
+    free_entry->req_size = size;
+    std::memcpy(free_entry->req_data, data, size);
+    free_entry->rsp_type = rsp_type;
+    this->cache_pending_ = free_entry;
+  }
+
+  return false;
+}
+
+void TionO2Proxy::cache_update_(uint8_t type, const uint8_t *data, size_t size) {
+  auto *entry = this->cache_pending_;
+  this->cache_pending_ = nullptr;
+  if (entry == nullptr || entry->rsp_type != type || size > CacheEntry::RSP_DATA_SIZE) {
+    return;
+  }
+  entry->rsp_size = size;
+  std::memcpy(entry->rsp_data, data, size);
+  entry->time = millis();
+  if (entry->time == 0) {
+    entry->time = 1;
+  }
+}
+
+void TionO2Proxy::dump_config() {
+  ESP_LOGCONFIG(TAG, "Tion O2 Proxy");
+  ESP_LOGCONFIG(TAG, "  Cache timeout: %" PRIu32 " ms", this->cache_timeout_);
+}
 
 }  // namespace tion_o2_proxy
 }  // namespace esphome
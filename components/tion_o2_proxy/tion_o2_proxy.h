@@ -28,15 +28,18 @@ class TionO2Proxy;
 
 class TionO2ApiProxy : public dentra::tion::TionApiBase, public dentra::tion::TionApiWriter {
  public:
+  using Api = TionO2ApiProxy;  // used in TionVPortApi wrapper
+
   void read_frame(uint16_t frame_type, const void *frame_data, size_t frame_data_size);
   void set_parent(TionO2Proxy *parent) { this->parent_ = parent; }
 
+  // состояние запрашивает RF модуль, собственных запросов не делаем
+  void request_state() TION_API_OVERRIDE {}
+  void write_state(dentra::tion::TionStateCall *call) TION_API_OVERRIDE {}
+  void reset_filter() TION_API_OVERRIDE {}
+
  protected:
   TionO2Proxy *parent_{};
-  // not used here
-  void request_state() override {}
-  void write_state(dentra::tion::TionStateCall *call) override {}
-  void reset_filter() override {}
 };
 
 class TionO2Proxy : public Component {
@@ -52,8 +55,33 @@ class TionO2Proxy : public Component {
   void dump_config() override;
   void loop() override { this->tx_->poll(); }
 
+  /// Время в мс, в течение которого повторные запросы RF модуля обслуживаются из кэша. 0 - кэш отключен.
+  void set_cache_timeout(uint32_t cache_timeout) { this->cache_timeout_ = cache_timeout; }
+
  protected:
+  // Кэшированный ответ бризера на запрос RF модуля.
+  struct CacheEntry {
+    enum { REQ_DATA_SIZE = 2, RSP_DATA_SIZE = 25 };
+    uint32_t time;
+    uint8_t req_type;
+    uint8_t req_size;
+    uint8_t req_data[REQ_DATA_SIZE];
+    uint8_t rsp_type;
+    uint8_t rsp_size;
+    uint8_t rsp_data[RSP_DATA_SIZE];
+  };
+  enum { CACHE_SIZE = 5 };
+  CacheEntry cache_[CACHE_SIZE]{};
+  // Запись кэша, ожидающая ответа бризера.
+  CacheEntry *cache_pending_{};
+  uint32_t cache_timeout_{};
+  uint32_t cache_hits_{};
+
   void on_frame_(const TionO2UartProtocolProxy::frame_spec_type &frame, size_t size);
+  /// Отвечает RF модулю из кэша. @return true если ответ был отправлен.
+  bool cache_reply_(uint8_t type, const uint8_t *data, size_t size);
+  /// Сохраняет ответ бризера для ожидающего запроса.
+  void cache_update_(uint8_t type, const uint8_t *data, size_t size);
   // tion
   TionO2ApiProxy *rx_{};
   // RF module
@@ -13,6 +13,7 @@ AUTO_LOAD = ["esp32_ble_server"]
 CONFLICTS_WITH = ["tion_4s_ble", "tion_4s_uart"]
 
 CONF_PAIR = "pair"
+CONF_MAX_STATE_AGE = "max_state_age"
 
 tion_rc_ns = cg.esphome_ns.namespace("tion_rc")
 TionRC = tion_rc_ns.class_("TionRC", cg.Component, BLEServiceComponent)
@@ -31,6 +32,9 @@ CONFIG_SCHEMA = cv.Schema(
         cv.GenerateID(CONF_BLE_ID): cv.use_id(ESP32BLE),
         cv.GenerateID(CONF_TION_ID): cv.use_id(TionApiComponent),
         cv.Optional(CONF_TYPE, default="4s"): cv.one_of(*RC_TYPES, lower=True),
+        cv.Optional(
+            CONF_MAX_STATE_AGE, default="5s"
+        ): cv.positive_time_period_milliseconds,
         cv.Required(CONF_PAIR): switch.switch_schema(
             TionRCPairSwitch,
             icon="mdi:bluetooth-connect",
@@ -44,9 +48,11 @@ CONFIG_SCHEMA = cv.Schema(
 async def to_code(config):
     api = await cg.get_variable(config[CONF_TION_ID])
     ctl = RC_TYPES[config[CONF_TYPE]].new(api.api())
+    cg.add_build_flag(f"-DTION_RC_{config[CONF_TYPE].upper()}")
     var = cg.new_Pvariable(config[CONF_ID], api, ctl)
 
     await cg.register_component(var, config)
+    cg.add(var.set_max_state_age(config[CONF_MAX_STATE_AGE]))
     ble_server = await cg.get_variable(config[CONF_BLE_SERVER_ID])
     cg.add(ble_server.register_service_component(var))
 
@@ -1,6 +1,8 @@
 #include <cinttypes>
+#include <cstring>
 #include "esphome/core/defines.h"
 #include "esphome/core/log.h"
+#include "esphome/core/hal.h"
 #include "esphome/components/esp32_ble_server/ble_2902.h"
 
 // #include "../tion-api/tion-api-internal.h"
@@ -15,21 +17,53 @@ namespace tion_rc {
 
 static const char *const TAG = "tion_rc";
 
-TionRC::TionRC(tion::TionApiComponent *tion, TionRCControl *control) : control_(control) {
-  this->control_->set_writer([this](const uint8_t *data, size_t size) {
-    TION_RC_DUMP(TAG, "TX RC: %s", format_hex_pretty(data, size).c_str());
-    if (this->char_notify_) {
-      this->char_notify_->set_value(data, size);
-      this->char_notify_->notify();
-    }
-    return true;
-  });
+void TionRCControl::request_state_(uint32_t request_id) {
+  this->state_req_id_ = request_id;
+  const auto &state = this->api_->get_state();
+  if (this->max_state_age_ != 0 && this->state_time_ != 0 && state.is_initialized() &&
+      millis() - this->state_time_ <= this->max_state_age_) {
+    TION_RC_DUMP(TAG, "Reply with cached state, age %" PRIu32 " ms", millis() - this->state_time_);
+    // on_state сбросит state_req_id_, поэтому ответ на фоновый запрос пульту не уйдет
+    this->on_state(state);
+  }
+  this->api_->request_state();
+}
 
-  tion->add_on_state_callback([this](const dentra::tion::TionState *state) {
-    if (state && this->control_->has_state_req()) {
-      this->control_->on_state(*state);
-    }
-  });
+TionRC::TionRC(tion::TionApiComponent *tion, TionRCControl *control)
+    : control_(control), arbiter_(tion->get_arbiter()) {
+  this->control_->set_writer(TionRCControl::writer_type::create<TionRC, &TionRC::write_>(*this));
+  tion->add_on_state_listener(this);
+}
+
+void TionRC::on_tion_state(const dentra::tion::TionState *state) {
+  this->control_->set_state_time(state ? millis() : 0);
+  if (state && this->control_->has_state_req()) {
+    this->control_->on_state(*state);
+  }
+}
+
+bool TionRC::write_(const uint8_t *data, size_t size) {
+  TION_RC_DUMP(TAG, "TX RC: %s", format_hex_pretty(data, size).c_str());
+  this->notify_(data, size);
+  return true;
+}
+
+void TionRC::notify_(const uint8_t *data, size_t size) {
+  if (this->char_notify_ == nullptr) {
+    return;
+  }
+  if (this->gatts_if_ == ESP_GATT_IF_NONE || size > sizeof(this->notify_buf_)) {
+    this->char_notify_->set_value(data, size);
+    this->char_notify_->notify();
+    return;
+  }
+  // esp_ble_gatts_send_indicate требует не константный буфер
+  std::memcpy(this->notify_buf_, data, size);
+  const auto err = esp_ble_gatts_send_indicate(this->gatts_if_, this->conn_id_, this->char_notify_->get_handle(), size,
+                                               this->notify_buf_, false);
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "Notify failed: %d", err);
+  }
 }
 
 void TionRC::setup_service_() {
@@ -52,6 +86,7 @@ void TionRC::setup_service_() {
   char_rx->on_write([this](const std::vector<uint8_t> &data) {
     if (!data.empty()) {
       TION_RC_DUMP(TAG, "RX RC: %s", format_hex_pretty(data).c_str());
+      TION_ARBITER_LANE(this->arbiter_, LANE_RC);
       this->control_->pr_read_data(data.data(), data.size());
     }
   });
@@ -184,6 +219,13 @@ void TionRC::gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts
     case ESP_GATTS_CONNECT_EVT: {
       // start security connect with peer device when receive the connect event sent by the master.
       esp_ble_set_encryption(param->connect.remote_bda, ESP_BLE_SEC_ENCRYPT_MITM);
+      this->gatts_if_ = gatts_if;
+      this->conn_id_ = param->connect.conn_id;
+      break;
+    }
+
+    case ESP_GATTS_DISCONNECT_EVT: {
+      this->gatts_if_ = ESP_GATT_IF_NONE;
       break;
     }
 
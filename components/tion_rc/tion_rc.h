@@ -15,6 +15,11 @@
 #define TION_RC_DUMP ESP_LOGV
 #endif
 
+// Размер буфера notify, пакеты пульта не превышают 20 байт.
+#ifndef TION_RC_NOTIFY_BUF_SIZE
+#define TION_RC_NOTIFY_BUF_SIZE 20
+#endif
+
 namespace esphome {
 namespace tion_rc {
 
@@ -25,7 +30,6 @@ template<class P> class TionRCControlProtocol {
   TionRCControlProtocol() {
     using this_t = std::remove_pointer_t<decltype(this)>;
     this->pr_.reader.template set<this_t, &this_t::pr_on_frame_>(*this);
-    this->pr_.writer.template set<this_t, &this_t::pr_do_write_>(*this);
   }
 
   virtual void on_frame(uint16_t type, const uint8_t *data, size_t size) = 0;
@@ -35,16 +39,7 @@ template<class P> class TionRCControlProtocol {
     this->on_frame(data.type, data.data, size - data.head_size());
   }
 
-  // FIXME directly assign to this->pr_.writer
-  bool pr_do_write_(const uint8_t *data, size_t size) {
-    if (this->pr_writer_) {
-      this->pr_writer_(data, size);
-    }
-    return true;
-  }
-
   P pr_;
-  std::function<void(const uint8_t *data, size_t size)> pr_writer_;
 };
 
 class TionRCControl {
@@ -55,10 +50,16 @@ class TionRCControl {
 
   virtual void pr_read_data(const uint8_t *data, size_t size) = 0;
 
-  virtual void set_writer(std::function<void(const uint8_t *data, size_t size)> &&writer) = 0;
+  using writer_type = etl::delegate<bool(const uint8_t *data, size_t size)>;
+  virtual void set_writer(writer_type &&writer) = 0;
 
   bool has_state_req() const { return this->state_req_id_ != 0; }
 
+  /// Максимальный возраст состояния в мс, при котором пульту отвечаем сразу. 0 - всегда запрашивать бризер.
+  void set_max_state_age(uint32_t max_state_age) { this->max_state_age_ = max_state_age; }
+  /// Время получения последнего состояния, 0 - состояние неактуально.
+  void set_state_time(uint32_t state_time) { this->state_time_ = state_time; }
+
   virtual const char *get_ble_service() const = 0;
   virtual const char *get_ble_char_rx() const = 0;
   virtual const char *get_ble_char_tx() const = 0;
@@ -68,6 +69,12 @@ class TionRCControl {
  protected:
   dentra::tion::TionApiBase *api_;
   uint32_t state_req_id_{};
+  uint32_t max_state_age_{};
+  uint32_t state_time_{};
+
+  /// Отвечает пульту известным состоянием, если оно достаточно свежее, и обновляет его в фоне.
+  /// Иначе запрашивает состояние у бризера, ответ уйдет пульту через on_state.
+  void request_state_(uint32_t request_id);
 };
 
 template<class P> class TionRCControlImpl : public TionRCControl, public TionRCControlProtocol<P> {
@@ -76,16 +83,18 @@ template<class P> class TionRCControlImpl : public TionRCControl, public TionRCC
 
   void pr_read_data(const uint8_t *data, size_t size) override { this->pr_.read_data(data, size); }
 
-  void set_writer(std::function<void(const uint8_t *data, size_t size)> &&writer) override {
-    this->pr_writer_ = std::move(writer);
-  }
+  void set_writer(writer_type &&writer) override { this->pr_.writer = writer; }
 
   const char *get_ble_service() const override { return this->pr_.get_ble_service(); }
   const char *get_ble_char_rx() const override { return this->pr_.get_ble_char_rx(); }
   const char *get_ble_char_tx() const override { return this->pr_.get_ble_char_tx(); }
 };
 
-class TionRC final : public Component, public BLEServiceComponent, public GATTsEventHandler, public GAPEventHandler {
+class TionRC final : public Component,
+                     public BLEServiceComponent,
+                     public GATTsEventHandler,
+                     public GAPEventHandler,
+                     public tion::TionStateListener {
  public:
   TionRC(tion::TionApiComponent *tion, TionRCControl *control);
   float get_setup_priority() const override { return setup_priority::AFTER_BLUETOOTH; }
@@ -101,15 +110,24 @@ class TionRC final : public Component, public BLEServiceComponent, public GATTsE
   void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) override;
 
   void set_pair_mode(switch_::Switch *pair_mode) { this->pair_mode_ = pair_mode; }
+  void set_max_state_age(uint32_t max_state_age) { this->control_->set_max_state_age(max_state_age); }
 
   void adv(bool pair);
 
+  void on_tion_state(const dentra::tion::TionState *state) override;
+
  protected:
   TionRCControl *control_;
+  tion::TionArbiter *arbiter_;
   BLEService *service_{};
   BLECharacteristic *char_notify_{};
   switch_::Switch *pair_mode_{};
+  esp_gatt_if_t gatts_if_{ESP_GATT_IF_NONE};
+  uint16_t conn_id_{};
+  uint8_t notify_buf_[TION_RC_NOTIFY_BUF_SIZE]{};
   void setup_service_();
+  void notify_(const uint8_t *data, size_t size);
+  bool write_(const uint8_t *data, size_t size);
   enum class State { STARTED, STOPPED, INITIALIZED, STARTING } state_{State::STOPPED};
 };
 
@@ -1,3 +1,5 @@
+#include "../tion-api/tion-api-defines.h"
+#ifdef TION_RC_3S
 #include <cinttypes>
 #include "esphome/core/defines.h"
 #include "esphome/core/log.h"
@@ -29,8 +31,7 @@ void Tion3sRC::adv(bool pair) {
 void Tion3sRC::on_frame(uint16_t type, const uint8_t *data, size_t size) {
   switch (type) {
     case FRAME_TYPE_REQ(FRAME_TYPE_STATE_GET): {
-      this->state_req_id_ = 1;
-      this->api_->request_state();
+      this->request_state_(1);
       break;
     }
 
@@ -118,3 +119,5 @@ void Tion3sRC::on_state(const TionState &st) {
 
 }  // namespace tion_rc
 }  // namespace esphome
+
+#endif  // TION_RC_3S
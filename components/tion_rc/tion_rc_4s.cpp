@@ -1,3 +1,5 @@
+#include "../tion-api/tion-api-defines.h"
+#ifdef TION_RC_4S
 #include <cinttypes>
 #include "esphome/core/defines.h"
 #include "esphome/core/log.h"
@@ -123,8 +125,7 @@ void Tion4sRC::on_frame(uint16_t type, const uint8_t *data, size_t size) {
       ESP_LOGV(TAG, "State GET %s", format_hex_pretty(data, size).c_str());
       const auto *get = reinterpret_cast<const tion4s_raw_state_t *>(data);
       TION_RC_DUMP(TAG, "STATE_GET[]");
-      this->state_req_id_ = 1;
-      this->api_->request_state();
+      this->request_state_(1);
       break;
     }
 
@@ -428,3 +429,5 @@ void Tion4sRC::on_state(const TionState &st) {
 
 }  // namespace tion_rc
 }  // namespace esphome
+
+#endif  // TION_RC_4S
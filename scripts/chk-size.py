@@ -0,0 +1,99 @@
+#!/usr/bin/env python
+
+import os
+import struct
+
+import click
+from build import Build, make_builds
+from helpers import info
+
+from esphome.core import CORE
+
+CONFIG_PATH = "./configs"
+
+# sh_flags
+SHF_WRITE = 0x1
+SHF_ALLOC = 0x2
+
+
+class BuildSize(Build):
+    def __init__(
+        self,
+        br_type: str,
+        br_port: str,
+        br_conn: str,
+        is_dev,
+        conf_path: str,
+        prune: bool,
+    ) -> None:
+        super().__init__(br_type, br_port, br_conn, is_dev, conf_path)
+        self.prune = prune
+
+    def compile(self, config):
+        if not self.prune:
+            # сборка со всеми типами бризеров, как до разделения
+            CORE.add_build_flag("-DTION_API_ALL")
+        super().compile(config)
+
+    @property
+    def flash_size(self) -> int:
+        return os.path.getsize(os.path.join(self.build_path, "firmware.bin"))
+
+    @property
+    def ram_size(self) -> int:
+        """Статическая память: размещаемые и записываемые секции ELF (.data, .bss)."""
+        with open(os.path.join(self.build_path, "firmware.elf"), "rb") as f:
+            elf = f.read()
+        # только 32-битные little-endian ELF (xtensa, riscv32)
+        (shoff,) = struct.unpack_from("<I", elf, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", elf, 0x2E)
+        size = 0
+        for i in range(shnum):
+            _, _, flags, _, _, sh_size = struct.unpack_from(
+                "<IIIIII", elf, shoff + i * shentsize
+            )
+            if flags & (SHF_ALLOC | SHF_WRITE) == SHF_ALLOC | SHF_WRITE:
+                size += sh_size
+        return size
+
+
+@click.command()
+@click.option("-v", "--verbose", count=True)
+@click.option(
+    "--types",
+    "-t",
+    default="lt-ble 4s-ble 4s-uart 3s-ble 3s-uart o2-uart",
+    show_default=True,
+)
+def main(verbose: int, types: str):
+    conf_types = [tuple(br.split("-")) + ("",) for br in types.split(" ")]
+
+    def builds(prune: bool):
+        return make_builds(
+            version="dev",
+            compile=True,
+            clean=False,
+            dev=False,
+            verbose=verbose,
+            config_path=CONFIG_PATH,
+            conf_types=conf_types,
+            build_type=BuildSize,
+            build_sub_folder="size" if prune else "size-all",
+            prune=prune,
+        )
+
+    pruned = builds(True)
+    full = builds(False)
+
+    print()
+    info(f"{'config':<16} {'flash':>10} {'saved':>8} {'ram':>8} {'saved':>6}")
+    for p, a in zip(pruned, full):
+        info(
+            f"{p.fw_name:<16} {p.flash_size:>10} {a.flash_size - p.flash_size:>8}"
+            f" {p.ram_size:>8} {a.ram_size - p.ram_size:>6}"
+        )
+
+
+if __name__ == "__main__":
+    # pylint: disable=no-value-for-parameter
+    main()
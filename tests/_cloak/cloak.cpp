@@ -3,6 +3,7 @@
 
 #include "esphome/core/log.h"
 #include "esphome/core/helpers.h"
+#include "esphome/core/application.h"
 #include "esphome/components/logger/logger.h"
 
 #include "cloak.h"
@@ -93,6 +94,34 @@ std::vector<uint8_t> from_hex(const std::string &hex) {
   return res;
 }
 
+VirtualClock::VirtualClock() { esphome::App.scheduler.test_virtual_clock(true); }
+
+VirtualClock::~VirtualClock() { esphome::App.scheduler.test_virtual_clock(false); }
+
+void VirtualClock::advance(uint32_t ms, const std::vector<esphome::Component *> &components, uint32_t step) {
+  const uint32_t end = esphome::millis() + ms;
+  while (true) {
+    const uint32_t now = esphome::millis();
+    uint32_t next = end;
+    if (step != 0 && end - now > step) {
+      next = now + step;
+    }
+    auto sched = esphome::App.scheduler.next_schedule_in();
+    if (sched.has_value() && *sched < next - now) {
+      next = now + *sched;
+    }
+    esphome::test_set_millis(next);
+    esphome::App.scheduler.call();
+    for (auto c : components) {
+      c->call_loop();
+    }
+    this->loops_++;
+    if (next == end) {
+      break;
+    }
+  }
+}
+
 #define print_data1(TAG, expr, name, fmt, act, exp) \
   bool res = expr; \
   if (res) { \
@@ -95,6 +95,24 @@ inline bool test(const char *tag, const std::string &name, cloak::Cloak &data1,
 #define check_data(name, data1, data2) internal::test(TAG, name, data1, data2)
 #define check_data_(data1, data2) check_data(#data1 " == " #data2, data1, data2)
 
+/// Виртуальное время. Пока объект существует, таймауты, интервалы и update() компонентов
+/// выполняются только при продвижении времени через advance(), что делает тесты детерминированными.
+class VirtualClock {
+ public:
+  VirtualClock();
+  ~VirtualClock();
+
+  /// Продвигает время на ms. Если задан step, loop компонентов вызывается каждые step мс,
+  /// иначе только в моменты срабатывания таймеров планировщика.
+  void advance(uint32_t ms, const std::vector<esphome::Component *> &components = {}, uint32_t step = 0);
+
+  /// Количество выполненных циклов loop.
+  uint32_t get_loops() const { return this->loops_; }
+
+ protected:
+  uint32_t loops_{};
+};
+
 inline void setup_and_loop(std::vector<esphome::Component *> components) {
   for (auto c : components) {
     c->call_setup();
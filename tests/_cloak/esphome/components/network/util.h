@@ -0,0 +1,11 @@
+#pragma once
+
+#include "esphome/components/socket/socket.h"
+
+namespace esphome {
+namespace network {
+
+inline bool is_connected() { return !socket::test_sockets().disconnected; }
+
+}  // namespace network
+}  // namespace esphome
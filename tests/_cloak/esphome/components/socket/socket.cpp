@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <netinet/in.h>
+
+#include "socket.h"
+
+namespace esphome {
+namespace socket {
+
+TestSockets &test_sockets() {
+  static TestSockets sockets;
+  return sockets;
+}
+
+ssize_t Socket::write(const void *buf, size_t len) {
+  auto &sockets = test_sockets();
+  if (sockets.write_errno != 0) {
+    errno = sockets.write_errno;
+    return -1;
+  }
+  if (sockets.write_limit != 0) {
+    len = std::min(len, sockets.write_limit);
+  }
+  sockets.test_data_push(static_cast<const uint8_t *>(buf), len);
+  sockets.writes++;
+  return len;
+}
+
+int Socket::close() {
+  test_sockets().closed++;
+  return 0;
+}
+
+std::unique_ptr<Socket> socket_ip(int type, int protocol) {
+  auto &sockets = test_sockets();
+  sockets.created++;
+  sockets.type = type;
+  return std::make_unique<Socket>(type);
+}
+
+socklen_t set_sockaddr(struct sockaddr *addr, socklen_t addrlen, const std::string &ip_address, uint16_t port) {
+  if (ip_address.empty() || addrlen < sizeof(sockaddr_in)) {
+    return 0;
+  }
+  auto *addr4 = reinterpret_cast<sockaddr_in *>(addr);
+  std::memset(addr4, 0, sizeof(*addr4));
+  addr4->sin_family = AF_INET;
+  addr4->sin_port = htons(port);
+  return sizeof(*addr4);
+}
+
+}  // namespace socket
+}  // namespace esphome
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include "cloak.h"
+
+namespace esphome {
+namespace socket {
+
+/// Тестовый сокет, записанные данные сохраняются в TestSockets.
+class Socket {
+ public:
+  explicit Socket(int type) : type_(type) {}
+  virtual ~Socket() = default;
+
+  int connect(const struct sockaddr *addr, socklen_t addrlen) { return 0; }
+  ssize_t write(const void *buf, size_t len);
+  int close();
+  int setblocking(bool blocking) { return 0; }
+
+  int get_type() const { return this->type_; }
+
+ protected:
+  int type_;
+};
+
+/// Состояние тестовых сокетов. test_data содержит все записанные данные.
+class TestSockets : public cloak::Cloak {
+ public:
+  /// Количество созданных сокетов.
+  uint32_t created{};
+  /// Количество закрытых сокетов.
+  uint32_t closed{};
+  /// Тип последнего созданного сокета.
+  int type{};
+  /// Количество успешных вызовов write, для UDP - количество датаграмм.
+  uint32_t writes{};
+  /// Ошибка записи (errno), 0 - запись успешна.
+  int write_errno{};
+  /// Максимальный размер одной записи, 0 - без ограничения.
+  size_t write_limit{};
+  /// Нет подключения к сети.
+  bool disconnected{};
+
+  void reset() {
+    *this = {};
+    this->test_data_clear();
+  }
+
+  void test_data_push(const uint8_t *data, size_t size) override {
+    this->cloak_data_.insert(this->cloak_data_.end(), data, data + size);
+  }
+};
+
+TestSockets &test_sockets();
+
+std::unique_ptr<Socket> socket_ip(int type, int protocol);
+socklen_t set_sockaddr(struct sockaddr *addr, socklen_t addrlen, const std::string &ip_address, uint16_t port);
+
+}  // namespace socket
+}  // namespace esphome
@@ -43,4 +43,22 @@ void Component::set_timeout(uint32_t timeout, std::function<void()> &&f) {
 
 bool Component::cancel_timeout(const std::string &name) { return App.scheduler.cancel_timeout(this, name); }
 
+void Component::set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f) {
+  App.scheduler.set_interval(this, name, interval, std::move(f));
+}
+
+void Component::set_interval(uint32_t interval, std::function<void()> &&f) {
+  App.scheduler.set_interval(this, "", interval, std::move(f));
+}
+
+bool Component::cancel_interval(const std::string &name) { return App.scheduler.cancel_interval(this, name); }
+
+void PollingComponent::call_setup() {
+  Component::call_setup();
+  // update вызывается по интервалу только в режиме виртуального времени
+  if (this->get_update_interval() != 0 && this->get_update_interval() != SCHEDULER_DONT_RUN) {
+    this->set_interval("update", this->get_update_interval(), [this]() { this->update(); });
+  }
+}
+
 }  // namespace esphome
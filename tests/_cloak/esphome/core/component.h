@@ -171,21 +171,16 @@ class Component {
    *
    * @see cancel_interval()
    */
-  void set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f)  // NOLINT
-  {}
+  void set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f);  // NOLINT
 
-  void set_interval(uint32_t interval, std::function<void()> &&f)  // NOLINT
-  {}
+  void set_interval(uint32_t interval, std::function<void()> &&f);  // NOLINT
 
   /** Cancel an interval function.
    *
    * @param name The identifier for this interval function.
    * @return Whether an interval functions was deleted.
    */
-  bool cancel_interval(const std::string &name)  // NOLINT
-  {
-    return true;
-  }
+  bool cancel_interval(const std::string &name);  // NOLINT
 
   /** Set an retry function with a unique name. Empty name means no cancelling possible.
    *
@@ -301,7 +296,7 @@ class PollingComponent : public Component {
 
   // ========== INTERNAL METHODS ==========
   // (In most use cases you won't need these)
-  // void call_setup() override {}
+  void call_setup() override;
 
   /// Get the update interval in ms of this sensor
   virtual uint32_t get_update_interval() const { return this->update_interval_; }
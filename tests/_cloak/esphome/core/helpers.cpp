@@ -128,6 +128,13 @@ uint32_t millis() { return _millis; }
 
 void test_set_millis(uint32_t millis) { _millis = millis; }
 
+uint32_t _micros{};
+
+// микросекунды идут отдельно от millis, чтобы тесты могли задавать длительность участков кода
+uint32_t micros() { return _micros; }
+
+void test_set_micros(uint32_t micros) { _micros = micros; }
+
 std::string _mac_address = "000000000000";
 std::string get_mac_address() { return _mac_address; }
 
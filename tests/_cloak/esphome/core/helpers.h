@@ -63,6 +63,8 @@ using std::is_invocable;
 
 uint32_t millis();
 void test_set_millis(uint32_t millis);
+uint32_t micros();
+void test_set_micros(uint32_t micros);
 
 inline void get_mac_address_raw(uint8_t *mac) { mac[0] = mac[1] = mac[2] = mac[3] = mac[4] = mac[5] = 0; }
 
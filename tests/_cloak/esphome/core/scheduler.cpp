@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "log.h"
 #include "component.h"
 #include "application.h"
@@ -22,11 +24,18 @@ void Scheduler::test_timeout(Component *component, bool start) {
   }
 }
 
+void Scheduler::test_virtual_clock(bool enable) {
+  this->virtual_clock_ = enable;
+  this->items_.clear();
+}
+
 void Scheduler::set_timeout(Component *component, const std::string &name, uint32_t timeout,
                             std::function<void()> func) {
   auto it = this->test_timeouts_.find(component);
   if (it != this->test_timeouts_.end()) {
     it->second.emplace(name, std::move(func));
+  } else if (this->virtual_clock_) {
+    this->set_item_(component, name, SchedulerItem::TIMEOUT, timeout, std::move(func));
   } else {
     func();
   }
@@ -37,17 +46,100 @@ bool Scheduler::cancel_timeout(Component *component, const std::string &name) {
   if (it != this->test_timeouts_.end()) {
     return it->second.erase(name) != 0;
   }
+  if (this->virtual_clock_) {
+    return this->cancel_item_(component, name, SchedulerItem::TIMEOUT);
+  }
   return true;
 }
 
 void Scheduler::set_interval(Component *component, const std::string &name, uint32_t interval,
                              std::function<void()> func) {
-  ESP_LOGE(TAG, "Scheduler::set_interval is not implemented");
+  if (!this->virtual_clock_) {
+    // без виртуального времени интервалы не поддерживаются
+    return;
+  }
+  // нулевой интервал в esphome означает вызов на каждом цикле, здесь - раз в миллисекунду
+  this->set_item_(component, name, SchedulerItem::INTERVAL, interval == 0 ? 1 : interval, std::move(func));
 }
 
 bool Scheduler::cancel_interval(Component *component, const std::string &name) {
-  ESP_LOGE(TAG, "Scheduler::cancel_interval is not implemented");
-  return false;
+  return this->virtual_clock_ && this->cancel_item_(component, name, SchedulerItem::INTERVAL);
+}
+
+void Scheduler::set_item_(Component *component, const std::string &name, SchedulerItem::Type type, uint32_t timeout,
+                          std::function<void()> &&func) {
+  if (!name.empty()) {
+    this->cancel_item_(component, name, type);
+  }
+  auto item = std::make_unique<SchedulerItem>();
+  item->component = component;
+  item->name = name;
+  item->type = type;
+  item->timeout = timeout;
+  item->last_execution = millis();
+  item->last_execution_major = 0;
+  item->callback = std::move(func);
+  item->remove = false;
+  this->items_.push_back(std::move(item));
+}
+
+bool Scheduler::cancel_item_(Component *component, const std::string &name, SchedulerItem::Type type) {
+  bool res = false;
+  for (auto &item : this->items_) {
+    if (!item->remove && item->component == component && item->type == type && item->name == name) {
+      item->remove = true;
+      res = true;
+    }
+  }
+  return res;
+}
+
+void Scheduler::cleanup_() {
+  this->items_.erase(
+      std::remove_if(this->items_.begin(), this->items_.end(), [](const auto &item) { return item->remove; }),
+      this->items_.end());
+}
+
+optional<uint32_t> Scheduler::next_schedule_in() {
+  const uint32_t now = millis();
+  optional<uint32_t> res{};
+  for (auto &item : this->items_) {
+    if (item->remove) {
+      continue;
+    }
+    const uint32_t next = item->next_execution();
+    const uint32_t in = next > now ? next - now : 0;
+    if (!res.has_value() || in < *res) {
+      res = in;
+    }
+  }
+  return res;
+}
+
+void Scheduler::call() {
+  const uint32_t now = millis();
+  while (true) {
+    // выбираем ближайший из сработавших, при равенстве - добавленный раньше
+    SchedulerItem *due = nullptr;
+    for (auto &item : this->items_) {
+      if (!item->remove && item->next_execution() <= now &&
+          (due == nullptr || item->next_execution() < due->next_execution())) {
+        due = item.get();
+      }
+    }
+    if (due == nullptr) {
+      break;
+    }
+    if (due->type == SchedulerItem::TIMEOUT) {
+      due->remove = true;
+    } else {
+      due->last_execution = now;
+    }
+    // callback может добавить новые элементы, поэтому вызываем копию
+    auto callback = due->callback;
+    callback();
+  }
+  this->cleanup_();
 }
 
 }  // namespace esphome
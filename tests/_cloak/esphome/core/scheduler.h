@@ -32,6 +32,11 @@ class Scheduler {
 
   void test_timeout(Component *component, bool start);
 
+  /// Режим виртуального времени. Если выключен, таймауты выполняются немедленно, а интервалы игнорируются.
+  /// Если включен, таймауты и интервалы выполняются в call() при достижении millis() нужного значения.
+  void test_virtual_clock(bool enable);
+  bool is_virtual_clock() const { return this->virtual_clock_; }
+
  protected:
   using TimeoutFunc = std::map<std::string, std::function<void()>>;
   std::map<Component *, TimeoutFunc> test_timeouts_;
@@ -76,6 +81,8 @@ class Scheduler {
   void pop_raw_();
   void push_(std::unique_ptr<SchedulerItem> item);
   bool cancel_item_(Component *component, const std::string &name, SchedulerItem::Type type);
+  void set_item_(Component *component, const std::string &name, SchedulerItem::Type type, uint32_t timeout,
+                 std::function<void()> &&func);
   bool empty_() {
     this->cleanup_();
     return this->items_.empty();
@@ -86,6 +93,7 @@ class Scheduler {
   uint32_t last_millis_{0};
   uint8_t millis_major_{0};
   uint32_t to_remove_{0};
+  bool virtual_clock_{};
 };
 
 }  // namespace esphome
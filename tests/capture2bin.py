@@ -0,0 +1,43 @@
+"""Converts tion capture from esphome log to binary TCAP file.
+
+Usage: capture2bin.py <device: 3s|4s|lt|o2> <log file> <out file>
+
+Supports both dump() output (CAPH:/CAP: lines) and stream mode (CAP: per record).
+If log contains CAPH: line only data after last one is used.
+"""
+
+import re
+import sys
+
+DEVICES = {"3s": 1, "4s": 2, "lt": 3, "o2": 4}
+
+# "[I][tion-api-capture:042]: CAP:..." on device, "tion-api-capture INF: CAP:..." in host tests
+CAP_RE = re.compile(r"\s(CAPH?):([0-9A-Fa-f.]+)")
+
+
+def convert(device: str, log_file: str, out_file: str):
+    header = bytes([ord("T"), ord("C"), ord("A"), ord("P"), 1, DEVICES[device], 0, 0])
+    data = bytearray()
+    with open(log_file, "r", encoding="utf-8", errors="ignore") as f:
+        for line in f:
+            m = CAP_RE.search(line)
+            if not m:
+                continue
+            chunk = bytes.fromhex(m.group(2).replace(".", ""))
+            if m.group(1) == "CAPH":
+                header = chunk
+                data.clear()
+            else:
+                data.extend(chunk)
+
+    with open(out_file, "wb") as f:
+        f.write(header)
+        f.write(data)
+    print(f"Written {len(header) + len(data)} bytes to {out_file}")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 4 or sys.argv[1] not in DEVICES:
+        print(__doc__)
+        sys.exit(1)
+    convert(sys.argv[1], sys.argv[2], sys.argv[3])
@@ -0,0 +1,84 @@
+"""Receives tion mirror traffic and writes it to a binary TCAP file.
+
+Usage: capture_sink.py <tcp|udp> <port> <out file>
+"""
+
+import socket
+import sys
+
+HEADER_SIZE = 8
+
+
+def read_varint(data: bytes, pos: int):
+    value = 0
+    shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if b & 0x80 == 0:
+            return value, pos
+        shift += 7
+
+
+def print_records(data: bytes, time: int = 0):
+    pos = 0
+    while pos < len(data):
+        delta, pos = read_varint(data, pos)
+        size_dir, pos = read_varint(data, pos)
+        size = size_dir >> 1
+        typ = data[pos] | (data[pos + 1] << 8)
+        pos += 2
+        time += delta
+        direction = "TX" if size_dir & 1 else "RX"
+        print(f"{time:>10} {direction} {typ:04X}: {data[pos:pos + size].hex('.')}")
+        pos += size
+    return time
+
+
+def sink_udp(port: int, out):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("", port))
+    header_written = False
+    time = 0
+    while True:
+        data, _ = sock.recvfrom(2048)
+        if not header_written:
+            out.write(data[:HEADER_SIZE])
+            header_written = True
+        out.write(data[HEADER_SIZE:])
+        out.flush()
+        time = print_records(data[HEADER_SIZE:], time)
+
+
+def sink_tcp(port: int, out):
+    srv = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    srv.bind(("", port))
+    srv.listen(1)
+    conn, addr = srv.accept()
+    print(f"Connected {addr}")
+    while True:
+        data = conn.recv(4096)
+        if not data:
+            break
+        out.write(data)
+        out.flush()
+
+
+def main():
+    if len(sys.argv) != 4 or sys.argv[1] not in ["tcp", "udp"]:
+        print(__doc__)
+        sys.exit(1)
+    with open(sys.argv[3], "wb") as out:
+        try:
+            if sys.argv[1] == "udp":
+                sink_udp(int(sys.argv[2]), out)
+            else:
+                sink_tcp(int(sys.argv[2]), out)
+        except KeyboardInterrupt:
+            pass
+
+
+if __name__ == "__main__":
+    main()
@@ -20,6 +20,18 @@ DEFS=(
   TION_ENABLE_HEARTBEAT
   TION_ENABLE_SCHEDULER
   TION_ENABLE_DIAGNOSTIC
+  TION_ENABLE_UPDATE
+  TION_ENABLE_CAPTURE
+  TION_ENABLE_TIMING
+  TION_ENABLE_HISTORY
+  TION_ENABLE_PERSIST
+  TION_ENABLE_ENERGY
+  TION_ENABLE_BULK
+  TION_ENABLE_ARBITER
+  TION_ENABLE_ANTIFREEZE
+  TION_ENABLE_MIRROR
+  TION_NO_HEAP
+  TION_ENABLE_VIRTUAL_API
   USE_VPORT_UART
   USE_VPORT_BLE
   USE_VPORT_COMMAND_QUEUE_SIZE=16
@@ -48,3 +60,11 @@ INCS=(
 )
 
 .  $(dirname $0)/_cloak/runner.sh
+RES=$?
+
+# тесты собираются также без TION_NO_HEAP и без TION_ENABLE_VIRTUAL_API, см. CMakeLists.txt
+if [ "$1" != "build" ] && [ "$1" != "info" ]; then
+  $BLD/tests_heap $* || RES=$?
+  $BLD/tests_static $* || RES=$?
+fi
+exit $RES
@@ -2,6 +2,7 @@
 #include "../components/tion-api/log.h"
 #include "../components/tion-api/tion-api.h"
 #include "../components/tion-api/tion-api-4s.h"
+#include "../components/tion-api/tion-api-write-slot.h"
 #include "test_api.h"
 
 DEFINE_TAG;
@@ -13,6 +14,12 @@ class TestTionApiBase : public dentra::tion::TionApiBase {
   void request_state() override { ESP_LOGE(TAG, "request_state is not implemented."); }
   void write_state(dentra::tion::TionStateCall *call) override { ESP_LOGE(TAG, "write_state is not implemented."); }
   void reset_filter() override { ESP_LOGE(TAG, "reset_filter is not implemented."); }
+
+  TionTraits &traits() { return this->traits_; }
+  void set_errors(uint32_t errors) {
+    this->state_.errors = errors;
+    this->notify_state_(0);
+  }
 };
 
 class ApiTest {
@@ -91,4 +98,74 @@ bool test_api() {
   return res;
 }
 
+namespace {
+uint32_t errors_reported;
+}  // namespace
+
+bool test_api_errors() {
+  bool res = true;
+
+  char buf[8];
+  res &= cloak::check_data("decode len", uint32_t(decode_errors(0x03, buf, sizeof(buf), 0, 7, 8, 15)), 4u);
+  res &= cloak::check_data("decode truncated", std::string(buf), std::string("EC01"));
+
+  TestTionApiBase api;
+  api.traits().errors_decode = [](uint32_t errors, char *buf, size_t size) {
+    return decode_errors(errors, buf, size, 0, 7, 8, 15);
+  };
+  api.traits().errors_report = [](uint32_t errors) { errors_reported |= errors; };
+
+  api.set_errors(0x01);
+  res &= cloak::check_data("errors text", std::string(api.get_errors_text()), std::string("EC01"));
+  res &= cloak::check_data("reported", errors_reported, 0x01u);
+
+  errors_reported = 0;
+  api.set_errors(0x01);
+  res &= cloak::check_data("reported unchanged", errors_reported, 0u);
+
+  api.set_errors(0x0101);
+  res &= cloak::check_data("errors text", std::string(api.get_errors_text()), std::string("EC01, WS01"));
+  res &= cloak::check_data("reported added", errors_reported, 0x0100u);
+
+  api.set_errors(0);
+  res &= cloak::check_data("errors cleared", std::string(api.get_errors_text()), std::string(""));
+
+  api.set_errors(0x01);
+  res &= cloak::check_data("stats size", uint32_t(api.get_errors_stats_size()), 2u);
+  res &= cloak::check_data("stat code", api.get_errors_stats()[0].code, 0x01u);
+  res &= cloak::check_data("stat count", api.get_errors_stats()[0].count, 2);
+  res &= cloak::check_data("stat code", api.get_errors_stats()[1].code, 0x0100u);
+  res &= cloak::check_data("stat count", api.get_errors_stats()[1].count, 1);
+
+  return res;
+}
+
+// Основа следующей записи: ожидающий или неподтвержденный образ, иначе текущее состояние.
+bool test_write_slot() {
+  bool res = true;
+
+  dentra::tion::TionState state{};
+  state.fan_speed = 1;
+  dentra::tion::TionState image{};
+  image.fan_speed = 2;
+
+  dentra::tion::TionWriteSlot slot;
+  slot.put(image);
+  res &= cloak::check_data("pending base", uint32_t(slot.get_base(state).fan_speed), 2u);
+  slot.take(1000);
+  // подтверждение не ожидается, основой служит состояние бризера
+  res &= cloak::check_data("sent base", uint32_t(slot.get_base(state).fan_speed), 1u);
+
+  slot.set_write_after_ack(true);
+  slot.put(image);
+  slot.take(2000);
+  res &= cloak::check_data("unacked base", uint32_t(slot.get_base(state).fan_speed), 2u);
+  slot.ack();
+  res &= cloak::check_data("acked base", uint32_t(slot.get_base(state).fan_speed), 1u);
+
+  return res;
+}
+
 REGISTER_TEST(test_api);
+REGISTER_TEST(test_api_errors);
+REGISTER_TEST(test_write_slot);
@@ -5,7 +5,6 @@
 #include "../components/tion-api/tion-api-3s.h"
 #include "../components/tion-api/tion-api-ble-3s.h"
 #include "../components/tion/tion_component.h"
-#include "../components/tion_3s_proxy/tion_3s_proxy.h"
 
 #include "test_api.h"
 #include "test_vport.h"
@@ -190,35 +189,53 @@ bool test_uart_3s() {
   return res;
 }
 
-bool test_uart_3s_proxy() {
+bool test_write_slot_3s() {
   bool res = true;
 
-  auto inp = "B3.10.00.00.00.00.00.00.00.00.00.0E.00.00.00.00.00.AA.AA.5A";
-  auto out = "3D.01.00.00.00.00.00.00.00.00.00.0E.00.00.00.00.00.FF.FF.5A";
-
-  esphome::uart::UARTComponent uart_inp(inp);
-  Tion3sUartIOTest io(&uart_inp);
+  esphome::uart::UARTComponent uart("B3.10.21.17.0B.00.00.00.00.4F.00.0E.2D.00.00.00.00.FF.FF.5A");
+  Tion3sUartIOTest io(&uart);
   Tion3sUartVPortTest vport(&io);
-
-  // as additional input source
   Tion3sUartVPortApiTest api(&vport);
-  Tion3sTest comp(&api, esphome::tion::TionVPortType::VPORT_UART);
-
-  esphome::uart::UARTComponent uart_out(out);
 
-  esphome::tion::TionVPortApi<esphome::tion::Tion3sUartVPort::frame_spec_type, esphome::tion_3s_proxy::Tion3sApiProxy>
-      api_proxy(&vport);
-
-  esphome::tion_3s_proxy::Tion3sBleProxy proxy(&api_proxy, &uart_out);
-
-  cloak::setup_and_loop({&vport, &comp, &proxy});
+  cloak::setup_and_loop({&vport});
   for (int i = 0; i < 5; i++) {
-    proxy.call_loop();
     vport.call_loop();
   }
 
-  res &= cloak::check_data("inp data", uart_inp, out);
-  res &= cloak::check_data("out data", uart_out, inp);
+  dentra::tion::TionStateCall call(&api);
+  call.set_target_temperature(20);
+  call.perform();
+  call.set_fan_speed(4);
+  call.perform();
+  vport.call_loop();
+  res &= cloak::check_data("pending", api.write_slot().has_pending(), true);
+
+  // оба изменения должны уйти одной записью
+  api.flush_write();
+  vport.call_loop();
+  res &= cloak::check_data("coalesced write", uart, "3D.02.04.14.02.0B.01.00.00.00.00.00.00.00.00.00.00.00.00.5A");
+  res &= cloak::check_data("dropped", api.write_slot().get_dropped(), 1u);
+  res &= cloak::check_data("written", api.write_slot().get_written(), 1u);
+
+  // неподтвержденной записи нет, запись отправляется сразу
+  api.write_slot().set_write_after_ack(true);
+  call.set_fan_speed(5);
+  call.perform();
+  api.flush_write();
+  vport.call_loop();
+  res &= cloak::check_data("write with ack", uart, "3D.02.05.14.02.0B.01.00.00.00.00.00.00.00.00.00.00.00.00.5A");
+
+  call.set_fan_speed(6);
+  call.perform();
+  api.flush_write();
+  vport.call_loop();
+  res &= cloak::check_data("wait for ack", api.write_slot().has_pending(), true);
+
+  esphome::test_set_millis(esphome::millis() + dentra::tion::TionWriteSlot::ACK_TIMEOUT);
+  api.flush_write();
+  vport.call_loop();
+  res &= cloak::check_data("write after timeout", uart, "3D.02.06.14.02.0B.01.00.00.00.00.00.00.00.00.00.00.00.00.5A");
+  res &= cloak::check_data("timeouts", api.write_slot().get_timeouts(), 1u);
 
   return res;
 }
@@ -226,4 +243,4 @@ bool test_uart_3s_proxy() {
 REGISTER_TEST(test_api_3s);
 REGISTER_TEST(test_3s);
 REGISTER_TEST(test_uart_3s);
-REGISTER_TEST(test_uart_3s_proxy);
+REGISTER_TEST(test_write_slot_3s);
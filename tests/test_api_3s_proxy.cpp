@@ -0,0 +1,203 @@
+#include <cstring>
+#include <vector>
+
+#include "esphome/components/vport/vport_uart.h"
+#include "../components/tion-api/tion-api-3s-internal.h"
+#include "../components/tion_3s_uart/tion_3s_uart_vport.h"
+#include "../components/tion/tion_component.h"
+#include "../components/tion_3s_proxy/tion_3s_proxy.h"
+
+#include "test_api.h"
+#include "utils.h"
+
+DEFINE_TAG;
+
+using namespace dentra::tion_3s;
+
+using Tion3sUartIOTest = esphome::tion::Tion3sUartIO;
+using Tion3sUartVPortTest = esphome::vport::VPortUARTComponent<Tion3sUartIOTest, Tion3sUartIOTest::frame_spec_type>;
+using Tion3sUartVPortApiTest =
+    esphome::tion::TionVPortApi<Tion3sUartIOTest::frame_spec_type, dentra::tion::Tion3sApi>;
+using Tion3sProxyApiTest =
+    esphome::tion::TionVPortApi<Tion3sUartIOTest::frame_spec_type, esphome::tion_3s_proxy::Tion3sApiProxy>;
+
+// Запросы BLE модуля передаются прокси напрямую, минуя UART.
+class Tion3sBleProxyTest : public esphome::tion_3s_proxy::Tion3sBleProxy {
+ public:
+  using esphome::tion_3s_proxy::Tion3sBleProxy::Tion3sBleProxy;
+  using esphome::tion_3s_proxy::Tion3sBleProxy::PENDING_SIZE;
+  using esphome::tion_3s_proxy::Tion3sBleProxy::PENDING_TIMEOUT;
+  void ble_request(uint8_t cmd) {
+    const dentra::tion::tion_frame_t<uint8_t[tion3s_frame_t::FRAME_DATA_SIZE]> frame{.type = FRAME_TYPE_REQ(cmd), .data = {}};
+    this->on_frame_(*reinterpret_cast<const frame_spec_type *>(&frame), sizeof(frame));
+  }
+  uint32_t pending_size() const { return this->pending_size_; }
+};
+
+namespace {
+const uint8_t RSP_DATA[tion3s_frame_t::FRAME_DATA_SIZE]{};
+static_assert(sizeof(RSP_DATA) >= sizeof(tion3s_state_t));
+
+// ответ бризера на команду cmd так, как его видит BLE модуль
+std::string rsp_hex(uint8_t cmd) {
+  char buf[8];
+  snprintf(buf, sizeof(buf), "B3.%02X.", cmd << 4);
+  return std::string(buf) + "00.00.00.00.00.00.00.00.00.00.00.00.00.00.00.00.00.5A";
+}
+}  // namespace
+
+bool test_uart_3s_proxy() {
+  bool res = true;
+
+  auto inp = "B3.10.00.00.00.00.00.00.00.00.00.0E.00.00.00.00.00.AA.AA.5A";
+  auto out = "3D.01.00.00.00.00.00.00.00.00.00.0E.00.00.00.00.00.FF.FF.5A";
+
+  esphome::uart::UARTComponent uart_inp(inp);
+  Tion3sUartIOTest io(&uart_inp);
+  Tion3sUartVPortTest vport(&io);
+
+  // as additional input source
+  Tion3sUartVPortApiTest api(&vport);
+  esphome::tion::Tion3sApiComponent comp(&api, esphome::tion::TionVPortType::VPORT_UART);
+
+  esphome::uart::UARTComponent uart_out(out);
+
+  Tion3sProxyApiTest api_proxy(&vport);
+
+  esphome::tion_3s_proxy::Tion3sBleProxy proxy(&api_proxy, &uart_out);
+
+  cloak::setup_and_loop({&vport, &comp, &proxy});
+  for (int i = 0; i < 5; i++) {
+    proxy.call_loop();
+    vport.call_loop();
+  }
+
+  res &= cloak::check_data("inp data", uart_inp, out);
+  res &= cloak::check_data("out data", uart_out, inp);
+  // состояние декодируется прокси для tap режима
+  res &= cloak::check_data("proxy state", uint32_t(api_proxy.get_state().firmware_version), 0xAAAAu);
+
+  return res;
+}
+
+bool test_uart_3s_proxy_burst() {
+  bool res = true;
+
+  // BLE модуль отправляет второй запрос не дождавшись ответа на первый
+  auto inp = "B3.10.00.00.00.00.00.00.00.00.00.0E.00.00.00.00.00.AA.AA.5A"
+             "B3.40.11.00.08.00.08.00.08.00.00.00.00.00.00.00.00.00.00.5A";
+  auto out = "3D.01.00.00.00.00.00.00.00.00.00.00.00.00.00.00.00.00.00.5A"
+             "3D.04.00.00.00.00.00.00.00.00.00.00.00.00.00.00.00.00.00.5A";
+
+  esphome::uart::UARTComponent uart_inp(inp);
+  Tion3sUartIOTest io(&uart_inp);
+  Tion3sUartVPortTest vport(&io);
+
+  esphome::uart::UARTComponent uart_out(out);
+
+  Tion3sProxyApiTest api_proxy(&vport);
+
+  esphome::tion_3s_proxy::Tion3sBleProxy proxy(&api_proxy, &uart_out);
+
+  cloak::setup_and_loop({&vport, &proxy});
+  for (int i = 0; i < 5; i++) {
+    proxy.call_loop();
+    vport.call_loop();
+  }
+
+  res &= cloak::check_data("inp data", uart_inp, out);
+  res &= cloak::check_data("out data", uart_out, inp);
+
+  return res;
+}
+
+// Бризер отвечает по порядку: запросы перед найденным считаются оставшимися без ответа.
+bool test_3s_proxy_order() {
+  bool res = true;
+
+  esphome::test_set_millis(1000);
+  esphome::uart::UARTComponent uart_inp, uart_out;
+  Tion3sUartIOTest io(&uart_inp);
+  Tion3sUartVPortTest vport(&io);
+  Tion3sProxyApiTest api_proxy(&vport);
+  Tion3sBleProxyTest proxy(&api_proxy, &uart_out);
+
+  proxy.ble_request(FRAME_TYPE_STATE_GET);
+  proxy.ble_request(FRAME_TYPE_TIMERS_GET);
+  proxy.ble_request(FRAME_TYPE_STATE_SET);
+  res &= cloak::check_data("pending", proxy.pending_size(), 3u);
+
+  api_proxy.read_frame(FRAME_TYPE_RSP(FRAME_TYPE_TIMERS_GET), RSP_DATA, sizeof(RSP_DATA));
+  res &= cloak::check_data("timers forwarded", uart_out, rsp_hex(FRAME_TYPE_TIMERS_GET));
+  res &= cloak::check_data("skipped dropped", proxy.pending_size(), 1u);
+
+  // ответ на пропущенный запрос уже не ожидается
+  api_proxy.read_frame(FRAME_TYPE_RSP(FRAME_TYPE_STATE_GET), RSP_DATA, sizeof(RSP_DATA));
+  res &= cloak::check_data("late not forwarded", uart_out, "");
+  res &= cloak::check_data("late pending", proxy.pending_size(), 1u);
+
+  api_proxy.read_frame(FRAME_TYPE_RSP(FRAME_TYPE_STATE_SET), RSP_DATA, sizeof(RSP_DATA));
+  res &= cloak::check_data("set forwarded", uart_out, rsp_hex(FRAME_TYPE_STATE_SET));
+  res &= cloak::check_data("empty", proxy.pending_size(), 0u);
+
+  return res;
+}
+
+// Переполнение и просрочка очереди ожидающих запросов.
+bool test_3s_proxy_overflow() {
+  bool res = true;
+
+  esphome::test_set_millis(1000);
+  esphome::uart::UARTComponent uart_inp, uart_out;
+  Tion3sUartIOTest io(&uart_inp);
+  Tion3sUartVPortTest vport(&io);
+  Tion3sProxyApiTest api_proxy(&vport);
+  Tion3sBleProxyTest proxy(&api_proxy, &uart_out);
+
+  // при переполнении вытесняется самый старый запрос
+  for (uint8_t cmd = 1; cmd <= Tion3sBleProxyTest::PENDING_SIZE + 1; cmd++) {
+    proxy.ble_request(cmd);
+  }
+  res &= cloak::check_data("full", proxy.pending_size(), uint32_t(Tion3sBleProxyTest::PENDING_SIZE));
+  res &= cloak::check_data("oldest dropped", proxy.match_response(1), false);
+  res &= cloak::check_data("next kept", proxy.match_response(2), true);
+
+  // просроченные запросы удаляются до сопоставления
+  esphome::test_set_millis(1000 + Tion3sBleProxyTest::PENDING_TIMEOUT + 1);
+  res &= cloak::check_data("timed out", proxy.match_response(3), false);
+  res &= cloak::check_data("timed out empty", proxy.pending_size(), 0u);
+
+  return res;
+}
+
+// Ответы без запроса не пересылаются, кроме сообщений о сопряжении.
+bool test_3s_proxy_unmatched() {
+  bool res = true;
+
+  esphome::test_set_millis(1000);
+  esphome::uart::UARTComponent uart_inp, uart_out;
+  Tion3sUartIOTest io(&uart_inp);
+  Tion3sUartVPortTest vport(&io);
+  Tion3sProxyApiTest api_proxy(&vport);
+  Tion3sBleProxyTest proxy(&api_proxy, &uart_out);
+
+  // состояние без запроса BLE модуля декодируется, но не пересылается
+  api_proxy.read_frame(FRAME_TYPE_RSP(FRAME_TYPE_STATE_GET), RSP_DATA, sizeof(RSP_DATA));
+  res &= cloak::check_data("state not forwarded", uart_out, "");
+  res &= cloak::check_data("state decoded", api_proxy.get_state().initialized, true);
+
+  api_proxy.read_frame(FRAME_TYPE_RSP(FRAME_TYPE_TIMERS_GET), RSP_DATA, sizeof(RSP_DATA));
+  res &= cloak::check_data("timers not forwarded", uart_out, "");
+
+  // сопряжение кнопкой на бризере приходит без запроса
+  api_proxy.read_frame(FRAME_TYPE_RSP(FRAME_TYPE_SRV_MODE_SET), RSP_DATA, sizeof(RSP_DATA));
+  res &= cloak::check_data("pair forwarded", uart_out, rsp_hex(FRAME_TYPE_SRV_MODE_SET));
+
+  return res;
+}
+
+REGISTER_TEST(test_uart_3s_proxy);
+REGISTER_TEST(test_uart_3s_proxy_burst);
+REGISTER_TEST(test_3s_proxy_order);
+REGISTER_TEST(test_3s_proxy_overflow);
+REGISTER_TEST(test_3s_proxy_unmatched);
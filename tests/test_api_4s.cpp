@@ -1,6 +1,9 @@
+#include <cstring>
+
 #include "esphome/components/climate/climate_mode.h"
 
 #include "../components/tion-api/tion-api-4s-internal.h"
+#include "../components/tion-api/crc.h"
 #include "../components/tion_4s_uart/tion_4s_uart_vport.h"
 #include "../components/tion/climate/tion_climate.h"
 #include "../components/tion/tion_component.h"
@@ -86,7 +89,7 @@ class Tion4sTest : public tion::TionClimate {
 
   void update_preset_service(std::string preset_str, std::string mode_str, int fan_speed, int target_temperature,
                              std::string gate_position_str) {
-    auto preset = this->get_parent()->api()->get_preset(preset_str);
+    auto preset = this->get_parent()->api()->get_preset(preset_str.c_str());
     preset.power_state = mode_str == "off" ? 0 : 1;
     preset.heater_state = mode_str == "heat" ? 1 : 0;
     preset.fan_speed = fan_speed;
@@ -95,7 +98,7 @@ class Tion4sTest : public tion::TionClimate {
                            : gate_position_str == "indoor" ? TionGatePosition::INDOOR
                            : gate_position_str == "mixed"  ? TionGatePosition::MIXED
                                                            : TionGatePosition::UNKNOWN;
-    this->get_parent()->api()->add_preset(preset_str, preset);
+    this->get_parent()->api()->add_preset(preset_str.c_str(), preset);
   }
 
   uint8_t get_fan_speed() const {
@@ -332,6 +335,320 @@ bool test_batch() {
   return res;
 }
 
+bool test_state_timeout() {
+  bool res = true;
+
+  cloak::VirtualClock clock;
+
+  esphome::uart::UARTComponent uart;
+  Tion4sUartIOTest io(&uart);
+  Tion4sUartVPort vport(&io);
+  Tion4sUartVPortApiTest api(&vport);
+  Tion4sApiComponent capi(&api, vport.get_type());
+
+  capi.set_update_interval(60000);
+  capi.set_state_timeout(3000);
+  capi.set_protocol_stats(vport.get_protocol_stats());
+  capi.set_stats_interval(0);
+  cloak::setup_and_loop({&vport, &capi});
+
+  // эмулятор не отвечает на запрос состояния
+  clock.advance(60000, {&vport, &capi});
+  res &= cloak::check_data("has_state after update", capi.has_state(), true);
+  clock.advance(2999, {&vport, &capi});
+  res &= cloak::check_data("has_state before timeout", capi.has_state(), true);
+  clock.advance(1, {&vport, &capi});
+  res &= cloak::check_data("has_state after timeout", capi.has_state(), false);
+  res &= cloak::check_data("timeouts", capi.get_protocol_counter(dentra::tion::TionProtocolStats::TIMEOUTS), 1u);
+  res &= cloak::check_data("tx_frames", capi.get_protocol_counter(dentra::tion::TionProtocolStats::TX_FRAMES) > 0, true);
+
+  // сутки работы выполняются за доли секунды
+  const uint32_t start = esphome::millis();
+  clock.advance(24 * 60 * 60 * 1000, {&vport, &capi});
+  res &= cloak::check_data("has_state after day", capi.has_state(), false);
+  res &= cloak::check_data("millis after day", esphome::millis() - start, 24u * 60 * 60 * 1000);
+
+  return res;
+}
+
+// Разбор потока UART с поврежденными данными.
+class Tion4sUartStatsTest : public dentra::tion::TionUartReader {
+ public:
+  Tion4sUartStatsTest() {
+    this->protocol.reader.set<Tion4sUartStatsTest, &Tion4sUartStatsTest::on_frame_>(*this);
+    this->protocol.writer.set<Tion4sUartStatsTest, &Tion4sUartStatsTest::on_write_>(*this);
+  }
+
+  dentra::tion::Tion4sUartProtocol protocol;
+  std::vector<uint8_t> rx;
+  uint32_t frames{};
+
+  int available() override { return this->rx.size() - this->pos_; }
+  bool read_array(void *data, size_t size) override {
+    if (this->pos_ + size > this->rx.size()) {
+      return false;
+    }
+    std::memcpy(data, this->rx.data() + this->pos_, size);
+    this->pos_ += size;
+    return true;
+  }
+
+ protected:
+  size_t pos_{};
+  void on_frame_(const dentra::tion::tion_any_frame_t &data, size_t size) { this->frames++; }
+  bool on_write_(const uint8_t *data, size_t size) {
+    this->rx.insert(this->rx.end(), data, data + size);
+    return true;
+  }
+};
+
+bool test_protocol_stats() {
+  bool res = true;
+
+  using dentra::tion::TionProtocolStats;
+
+  Tion4sUartStatsTest test;
+  const uint8_t data[] = {0x01, 0x02, 0x03};
+  test.protocol.write_frame(0x1234, data, sizeof(data));
+  const auto frame = test.rx;
+  // мусор, кадр с ошибкой CRC и корректный кадр
+  test.rx.assign({0x00, 0x55});
+  test.rx.insert(test.rx.end(), frame.begin(), frame.end());
+  test.rx[test.rx.size() - 1] ^= 0xFF;
+  test.rx.insert(test.rx.end(), frame.begin(), frame.end());
+
+  while (test.available() > 0) {
+    test.protocol.read_uart_data(&test);
+  }
+
+  const auto &stats = test.protocol.get_stats();
+  res &= cloak::check_data("frames", test.frames, 1u);
+  res &= cloak::check_data("rx_frames", stats.get(TionProtocolStats::RX_FRAMES), 1u);
+  res &= cloak::check_data("tx_frames", stats.get(TionProtocolStats::TX_FRAMES), 1u);
+  res &= cloak::check_data("invalid_magic", stats.get(TionProtocolStats::INVALID_MAGIC), 2u);
+  res &= cloak::check_data("crc_errors", stats.get(TionProtocolStats::CRC_ERRORS), 1u);
+  res &= cloak::check_data("resyncs", stats.get(TionProtocolStats::RESYNCS), 1u);
+
+  return res;
+}
+
+#ifdef TION_ENABLE_UPDATE
+// Ответчик с логикой TION_UPDATE_EMU из tion_rc_4s, работающий без BLE.
+// Ответы копятся в очереди, что позволяет проверить отправку окном.
+class Tion4sUpdateEmuTest {
+  using FirmwareChunk = dentra::tion::firmware::FirmwareChunk;
+  using FirmwareChunkCRC = dentra::tion::firmware::FirmwareChunkCRC;
+  using FirmwareInfo = dentra::tion::firmware::FirmwareInfo;
+
+ public:
+  explicit Tion4sUpdateEmuTest(Tion4sApi *api) : api_(api) {
+    api->set_writer(Tion4sApi::writer_type::create<Tion4sUpdateEmuTest, &Tion4sUpdateEmuTest::on_frame_>(*this));
+  }
+
+  // количество запросов, которые будут "потеряны" при передаче
+  int drop{};
+  size_t max_in_flight{};
+  uint32_t fw_load{};
+  uint16_t fw_crc{};
+
+  void process() {
+    while (!this->rsp_.empty()) {
+      auto type = this->rsp_.front();
+      this->rsp_.erase(this->rsp_.begin());
+      this->api_->read_frame(type, nullptr, 0);
+    }
+  }
+
+ protected:
+  Tion4sApi *api_;
+  std::vector<uint16_t> rsp_;
+  uint32_t fw_size_{};
+
+  bool on_frame_(uint16_t type, const void *data, size_t size) {
+    using namespace dentra::tion::firmware;
+    if (type == FRAME_TYPE_UPDATE_CHUNK_REQ && this->drop > 0) {
+      this->drop--;
+      return true;
+    }
+    if (type == FRAME_TYPE_UPDATE_PREPARE_REQ) {
+      this->fw_size_ = 0;
+      this->fw_load = 0;
+      this->fw_crc = 0xFFFF;
+      this->rsp_.push_back(FRAME_TYPE_UPDATE_PREPARE_RSP);
+    } else if (type == FRAME_TYPE_UPDATE_START_REQ) {
+      this->fw_size_ = static_cast<const FirmwareInfo *>(data)->size - sizeof(FirmwareInfo::data);
+      this->rsp_.push_back(FRAME_TYPE_UPDATE_START_RSP);
+    } else if (type == FRAME_TYPE_UPDATE_CHUNK_REQ) {
+      const auto *req = static_cast<const FirmwareChunk *>(data);
+      const auto chunk_size = size - sizeof(FirmwareChunk::offset);
+      if (req->offset == FirmwareChunkCRC::MARKER) {
+        this->fw_crc = dentra::tion::crc16_ccitt_false(this->fw_crc, req->data, chunk_size);
+        this->rsp_.push_back(this->fw_crc == 0 ? FRAME_TYPE_UPDATE_CHUNK_RSP : FRAME_TYPE_UPDATE_ERROR);
+        return true;
+      }
+      if (req->offset != this->fw_load) {
+        // пропускаем части после потерянной, как при обрыве связи
+        return true;
+      }
+      this->fw_load += chunk_size;
+      this->fw_crc = dentra::tion::crc16_ccitt_false(this->fw_crc, req->data, chunk_size);
+      this->rsp_.push_back(FRAME_TYPE_UPDATE_CHUNK_RSP);
+      this->max_in_flight = std::max(this->max_in_flight, this->rsp_.size());
+    } else if (type == FRAME_TYPE_UPDATE_FINISH_REQ) {
+      const auto fw_size = static_cast<const FirmwareInfo *>(data)->size - sizeof(FirmwareInfo::data);
+      this->rsp_.push_back(fw_size == this->fw_size_ ? FRAME_TYPE_UPDATE_FINISH_RSP : FRAME_TYPE_UPDATE_ERROR);
+    }
+    return true;
+  }
+};
+
+class Tion4sUpdateImageTest {
+ public:
+  static constexpr uint32_t SIZE = 2000;
+  size_t read(uint32_t offset, uint8_t *buf, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      buf[i] = (offset + i) * 7;
+    }
+    return size;
+  }
+};
+
+bool test_update_4s() {
+  bool res = true;
+
+  Tion4sApi api;
+  Tion4sUpdateEmuTest emu(&api);
+  Tion4sUpdateImageTest image;
+
+  uint32_t progress = 0;
+  auto on_update = [&progress](Tion4sApi::UpdateState, uint32_t offset, uint32_t) { progress = offset; };
+  api.on_update = Tion4sApi::on_update_type(on_update);
+
+  auto reader = Tion4sApi::update_reader_type::create<Tion4sUpdateImageTest, &Tion4sUpdateImageTest::read>(image);
+  res &= cloak::check_data("update_start", api.update_start(Tion4sUpdateImageTest::SIZE, std::move(reader), 3), true);
+  emu.process();
+
+  res &= cloak::check_data("update done", api.get_update_state() == Tion4sApi::UpdateState::DONE, true);
+  res &= cloak::check_data("update fw_load", emu.fw_load, Tion4sUpdateImageTest::SIZE);
+  res &= cloak::check_data("update fw_crc", emu.fw_crc, 0);
+  res &= cloak::check_data("update window", static_cast<uint32_t>(emu.max_in_flight), 3u);
+  res &= cloak::check_data("update progress", progress, Tion4sUpdateImageTest::SIZE);
+
+  // потеря части прошивки, продолжение с последнего подтвержденного смещения
+  emu.drop = 1;
+  emu.max_in_flight = 0;
+  reader = Tion4sApi::update_reader_type::create<Tion4sUpdateImageTest, &Tion4sUpdateImageTest::read>(image);
+  api.update_start(Tion4sUpdateImageTest::SIZE, std::move(reader), 2);
+  emu.process();
+  res &= cloak::check_data("update stalled", api.get_update_state() == Tion4sApi::UpdateState::CHUNKS, true);
+  res &= cloak::check_data("update stalled offset", api.get_update_offset(), 0u);
+
+  esphome::test_set_millis(esphome::millis() + Tion4sApi::UPDATE_TIMEOUT);
+  api.update_poll();
+  emu.process();
+  res &= cloak::check_data("update resumed", api.get_update_state() == Tion4sApi::UpdateState::DONE, true);
+  res &= cloak::check_data("update resumed fw_crc", emu.fw_crc, 0);
+
+  return res;
+}
+#endif
+
+#ifdef TION_ENABLE_SCHEDULER
+class Tion4sTimersEmuTest {
+  using tion4s_timer_t = dentra::tion_4s::tion4s_timer_t;
+  using tion4s_timers_state_t = dentra::tion_4s::tion4s_timers_state_t;
+
+ public:
+  explicit Tion4sTimersEmuTest(Tion4sApi *api) : api_(api) {
+    api->set_writer(Tion4sApi::writer_type::create<Tion4sTimersEmuTest, &Tion4sTimersEmuTest::on_frame_>(*this));
+  }
+
+  tion4s_timer_t timers[tion4s_timers_state_t::TIMERS_COUNT]{};
+  size_t requests{};
+  size_t writes{};
+  size_t max_in_flight{};
+
+  void process() {
+    while (!this->rsp_.empty()) {
+      auto rsp = this->rsp_.front();
+      this->rsp_.erase(this->rsp_.begin());
+      if (rsp.data.timer_id == tion4s_timers_state_t::TIMERS_COUNT) {
+        dentra::tion_4s::tion4s_raw_frame_t<tion4s_timers_state_t> frame{.request_id = rsp.request_id};
+        for (uint8_t i = 0; i < tion4s_timers_state_t::TIMERS_COUNT; i++) {
+          frame.data.timers[i].active = this->timers[i].timer_state;
+        }
+        this->api_->read_frame(dentra::tion_4s::FRAME_TYPE_TIMERS_STATE_RSP, &frame, sizeof(frame));
+      } else {
+        rsp.data.timer = this->timers[rsp.data.timer_id];
+        this->api_->read_frame(dentra::tion_4s::FRAME_TYPE_TIMER_RSP, &rsp, sizeof(rsp));
+      }
+    }
+  }
+
+ protected:
+  Tion4sApi *api_;
+  std::vector<dentra::tion_4s::tion4s_raw_frame_t<dentra::tion_4s::tion4s_timer_rsp_t>> rsp_;
+
+  bool on_frame_(uint16_t type, const void *data, size_t size) {
+    if (type == dentra::tion_4s::FRAME_TYPE_TIMER_REQ) {
+      const auto *req = static_cast<const dentra::tion_4s::tion4s_raw_frame_t<dentra::tion_4s::tion4s_timer_req_t> *>(data);
+      this->rsp_.push_back({.request_id = req->request_id, .data = {.timer_id = req->data.timer_id}});
+    } else if (type == dentra::tion_4s::FRAME_TYPE_TIMERS_STATE_REQ) {
+      const auto *req = static_cast<const uint32_t *>(data);
+      this->rsp_.push_back({.request_id = *req, .data = {.timer_id = tion4s_timers_state_t::TIMERS_COUNT}});
+    } else if (type == dentra::tion_4s::FRAME_TYPE_TIMER_SET) {
+      // бризер не отвечает на запись таймера
+      const auto *req = static_cast<const uint8_t *>(data) + sizeof(uint32_t);
+      std::memcpy(&this->timers[req[0]], req + 1, sizeof(tion4s_timer_t));
+      this->writes++;
+      return true;
+    }
+    this->requests++;
+    this->max_in_flight = std::max(this->max_in_flight, this->rsp_.size());
+    return true;
+  }
+};
+
+bool test_timers_4s() {
+  bool res = true;
+
+  Tion4sApi api;
+  Tion4sTimersEmuTest emu(&api);
+  emu.timers[3].schedule.monday = true;
+  emu.timers[3].schedule.hours = 7;
+  emu.timers[3].timer_state = true;
+
+  api.timers_sync();
+  emu.process();
+  res &= cloak::check_data("timers sync", api.is_timers_synced(), true);
+  res &= cloak::check_data("timers sync requests", uint32_t(emu.requests), 13u);
+  res &= cloak::check_data("timers sync in flight", uint32_t(emu.max_in_flight), 1u);
+  res &= cloak::check_data("timers cache", api.get_timer(3)->schedule.hours, uint8_t(7));
+  res &= cloak::check_data("timers state cache", api.get_timers_state()->timers[3].active, true);
+
+  // повторная синхронизация не требует запросов
+  api.timers_sync();
+  emu.process();
+  res &= cloak::check_data("timers resync requests", uint32_t(emu.requests), 13u);
+
+  // записывается только отличающийся таймер
+  const dentra::tion_4s::tion4s_timer_t timer{};
+  for (uint8_t i = 0; i < dentra::tion_4s::tion4s_timers_state_t::TIMERS_COUNT; i++) {
+    api.set_timer(i, timer);
+  }
+  res &= cloak::check_data("timers write", uint32_t(emu.writes), 1u);
+
+  esphome::test_set_millis(esphome::millis() + Tion4sApi::TIMERS_TIMEOUT);
+  api.timers_poll();
+  emu.process();
+  res &= cloak::check_data("timers write synced", api.is_timers_synced(), true);
+  res &= cloak::check_data("timers write cache", api.get_timer(3)->schedule.hours, uint8_t(0));
+  res &= cloak::check_data("timers write state", api.get_timers_state()->timers[3].active, false);
+
+  return res;
+}
+#endif
+
 template<typename mode_type, mode_type off_value> struct TionPresetDataTest {
   uint8_t fan_speed;
   int8_t target_temperature;
@@ -376,3 +693,11 @@ REGISTER_TEST(test_presets);
 REGISTER_TEST(test_heat_cool);
 REGISTER_TEST(test_preset_update);
 REGISTER_TEST(test_batch);
+REGISTER_TEST(test_state_timeout);
+REGISTER_TEST(test_protocol_stats);
+#ifdef TION_ENABLE_SCHEDULER
+REGISTER_TEST(test_timers_4s);
+#endif
+#ifdef TION_ENABLE_UPDATE
+REGISTER_TEST(test_update_4s);
+#endif
@@ -100,4 +100,44 @@ bool test_api_lt_uart() {
   return true;
 }
 
+// Восстановление рассчитываемого счетчика воздуха после перезагрузки.
+bool test_api_lt_uart_restore() {
+  bool res = true;
+
+  const char state_data[] = "Speed: 2\r\n"
+                            "Working Time: 27853548\r\n"
+                            "Error register: 0\r\n";
+
+  uint32_t airflow_counter = 0;
+  TionLtUartProtocol pr;
+  auto reader = [&airflow_counter](const TionLtUartProtocol::frame_spec_type &frame, size_t size) {
+    if (frame.type == FRAME_TYPE_STATE_RSP) {
+      airflow_counter = reinterpret_cast<const tionlt_state_get_req_t *>(frame.data)->state.counters.airflow_counter;
+    }
+  };
+  pr.reader = reader;
+
+  static const uint8_t PROD[] = {0, TION_LT_AUTO_PROD};
+  pr.restore_airflow_counter(1000, 27853548 - 100);
+  UARTComponent uart(reinterpret_cast<const uint8_t *>(state_data), sizeof(state_data) - 1);
+  TestTionLtUartReader io(&uart);
+  for (int i = 0; i < 5; i++) {
+    pr.read_uart_data(&io);
+  }
+  res &= cloak::check_data("restored", airflow_counter,
+                           1000 + 100 * PROD[2] / dentra::tion_lt::tion_lt_state_counters_t::AK);
+
+  // счетчик бризера меньше сохраненного, накопленное значение не теряется
+  pr.restore_airflow_counter(1000, 27853548 + 100);
+  UARTComponent uart2(reinterpret_cast<const uint8_t *>(state_data), sizeof(state_data) - 1);
+  TestTionLtUartReader io2(&uart2);
+  for (int i = 0; i < 5; i++) {
+    pr.read_uart_data(&io2);
+  }
+  res &= cloak::check_data("fan time reset", airflow_counter, 1000u);
+
+  return res;
+}
+
 REGISTER_TEST(test_api_lt_uart);
+REGISTER_TEST(test_api_lt_uart_restore);
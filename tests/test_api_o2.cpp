@@ -49,37 +49,92 @@ bool test_api_o2() {
   return res;
 }
 
+// Запросы RF модуля передаются прокси напрямую, минуя UART.
+class TionO2ProxyTest : public esphome::tion_o2_proxy::TionO2Proxy {
+ public:
+  using esphome::tion_o2_proxy::TionO2Proxy::TionO2Proxy;
+  void rf_request(uint8_t type) {
+    const dentra::tion::tion_frame_t<uint8_t[0]> frame{.type = type};
+    this->on_frame_(frame, frame.head_size());
+  }
+  void rf_request(uint8_t type, uint8_t data) {
+    const dentra::tion::tion_frame_t<uint8_t> frame{.type = type, .data = data};
+    this->on_frame_(*reinterpret_cast<const dentra::tion::tion_frame_t<uint8_t[0]> *>(&frame), sizeof(frame));
+  }
+  uint32_t get_cache_hits() const { return this->cache_hits_; }
+};
+
 bool test_api_o2_proxy() {
   bool res = true;
 
-  auto inp = "11 0C 0C 13 10 02 3C 04 00 00 B4 D6 DC 01 01 F6 CA 01 54";
-  auto out = "01 FE";
-
-  esphome::uart::UARTComponent uart_inp(inp);
-  TionO2UartIOTest io(&uart_inp);
-  TionO2UartVPortTest vport(&io);
-
-  // as additional input source
-  TionO2UartVPortApiTest api(&vport);
-  TionO2ApiComponent comp(&api, TionVPortType::VPORT_UART);
-
-  esphome::uart::UARTComponent uart_out(out);
-
-  esphome::tion::TionVPortApi<esphome::tion::TionO2UartVPort::frame_spec_type, esphome::tion_o2_proxy::TionO2ApiProxy>
-      api_proxy(&vport);
-  esphome::tion_o2_proxy::TionO2Proxy proxy(&api_proxy, &uart_out);
-
-  cloak::setup_and_loop({&vport, &comp, &proxy});
+  using namespace dentra::tion_o2;
 
-  res &= cloak::check_data("heartbeat data", uart_inp, "07 F8");
+  // ответ бризера на запрос состояния, данные без типа и crc
+  const auto rsp = "11 0C 0C 13 10 02 3C 04 00 00 B4 D6 DC 01 01 F6 CA 01 54";
+  const auto rsp_data = cloak::from_hex("0C 0C 13 10 02 3C 04 00 00 B4 D6 DC 01 01 F6 CA 01");
 
-  for (int i = 0; i < 5; i++) {
-    proxy.call_loop();
-    vport.call_loop();
+  // бризер
+  esphome::uart::UARTComponent uart_tion;
+  TionO2UartIOTest io(&uart_tion);
+  TionO2UartVPortTest vport(&io);
+  esphome::tion::TionVPortApi<TionO2UartIOTest::frame_spec_type, esphome::tion_o2_proxy::TionO2ApiProxy> api_proxy(
+      &vport);
+
+  // RF модуль
+  esphome::uart::UARTComponent uart_rf;
+  TionO2ProxyTest proxy(&api_proxy, &uart_rf);
+  proxy.set_cache_timeout(1000);
+
+  cloak::setup_and_loop({&vport, &proxy});
+
+  // промах, запрос передается бризеру, ответ - RF модулю
+  proxy.rf_request(FRAME_TYPE_STATE_GET_REQ);
+  res &= cloak::check_data("miss req", uart_tion, "01 FE");
+  api_proxy.read_frame(FRAME_TYPE_STATE_GET_RSP, rsp_data.data(), rsp_data.size());
+  res &= cloak::check_data("miss rsp", uart_rf, rsp);
+
+  // повторный запрос в пределах cache_timeout обслуживается из кэша
+  esphome::test_set_millis(esphome::millis() + 500);
+  proxy.rf_request(FRAME_TYPE_STATE_GET_REQ);
+  res &= cloak::check_data("hit req", uart_tion, "");
+  res &= cloak::check_data("hit rsp", uart_rf, rsp);
+  res &= cloak::check_data("hits", proxy.get_cache_hits(), 1u);
+
+  // устаревший ответ запрашивается заново
+  esphome::test_set_millis(esphome::millis() + 1000);
+  proxy.rf_request(FRAME_TYPE_STATE_GET_REQ);
+  res &= cloak::check_data("expired req", uart_tion, "01 FE");
+  api_proxy.read_frame(FRAME_TYPE_STATE_GET_RSP, rsp_data.data(), rsp_data.size());
+  res &= cloak::check_data("expired rsp", uart_rf, rsp);
+
+  // команда, изменяющая состояние, сбрасывает кэш состояния
+  proxy.rf_request(FRAME_TYPE_CONNECT_REQ);
+  uart_tion.test_data_clear();
+  proxy.rf_request(FRAME_TYPE_STATE_GET_REQ);
+  res &= cloak::check_data("invalidated req", uart_tion, "01 FE");
+  res &= cloak::check_data("invalidated hits", proxy.get_cache_hits(), 1u);
+
+  // запрос изменения режима работы всегда передается бризеру и сбрасывает кэш
+  api_proxy.read_frame(FRAME_TYPE_STATE_GET_RSP, rsp_data.data(), rsp_data.size());
+  uart_rf.test_data_clear();
+  for (int i = 0; i < 2; i++) {
+    proxy.rf_request(FRAME_TYPE_SET_WORK_MODE_REQ, 0x02);
+    res &= cloak::check_data("set req", uart_tion, "04 02 F9");
+    const uint8_t work_mode = 0x02;
+    api_proxy.read_frame(FRAME_TYPE_SET_WORK_MODE_RSP, &work_mode, sizeof(work_mode));
+    res &= cloak::check_data("set rsp", uart_rf, "55 02 A8");
   }
-
-  res &= cloak::check_data("inp data", uart_inp, out);
-  res &= cloak::check_data("out data", uart_out, inp);
+  proxy.rf_request(FRAME_TYPE_STATE_GET_REQ);
+  res &= cloak::check_data("set invalidated req", uart_tion, "01 FE");
+  res &= cloak::check_data("set hits", proxy.get_cache_hits(), 1u);
+
+  // кэш отключен
+  api_proxy.read_frame(FRAME_TYPE_STATE_GET_RSP, rsp_data.data(), rsp_data.size());
+  uart_rf.test_data_clear();
+  proxy.set_cache_timeout(0);
+  proxy.rf_request(FRAME_TYPE_STATE_GET_REQ);
+  res &= cloak::check_data("disabled req", uart_tion, "01 FE");
+  res &= cloak::check_data("disabled rsp", uart_rf, "");
 
   return res;
 }
@@ -171,6 +226,6 @@ bool test_api_o2_new() {
 }
 
 REGISTER_TEST(test_api_o2);
-REGISTER_TEST(test_api_o2_proxy);  // does not work now
+REGISTER_TEST(test_api_o2_proxy);
 REGISTER_TEST(test_api_o2_data);
 REGISTER_TEST(test_api_o2_new);
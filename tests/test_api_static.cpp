@@ -0,0 +1,59 @@
+// Сборка для единственного API (4S по UART), как ее генерирует __init__.py без TION_ENABLE_VIRTUAL_API.
+// В основной сборке тестов с TION_ENABLE_VIRTUAL_API макросы TION_*_IMPL пусты.
+#include "../components/tion-api/tion-api-4s-internal.h"
+#include "../components/tion_4s_uart/tion_4s_uart_vport.h"
+#include "../components/tion/tion_component.h"
+
+#include "utils.h"
+
+DEFINE_TAG;
+
+using Tion4sUartStaticApi =
+    esphome::tion::TionVPortApi<esphome::tion::Tion4sUartIO::frame_spec_type, dentra::tion_4s::Tion4sApi>;
+
+TION_API_IMPL(Tion4sUartStaticApi)
+TION_API_WRITER_IMPL(Tion4sUartStaticApi)
+
+bool test_api_static() {
+  bool res = true;
+
+  esphome::uart::UARTComponent uart;
+  esphome::tion::Tion4sUartIO io(&uart);
+  esphome::tion::Tion4sUartVPort vport(&io);
+  Tion4sUartStaticApi api(&vport);
+  esphome::tion::Tion4sApiComponent capi(&api, vport.get_type());
+  vport.set_api(&api);
+
+  cloak::setup_and_loop({&vport, &capi});
+  uart.test_data_clear();
+
+  // dev_info запрашивается при первом запросе состояния.
+  // TionApiBase::request_state -> Tion4sApi::request_state -> TionApiWriter -> TionVPortApi::write_frame_
+  dentra::tion::TionApiBase *base = &api;
+  base->request_state();
+  vport.call_loop();
+  res &= cloak::check_data("request_state", uart, "3A.07.00.32.33.6F.A6 3A.07.00.32.32.7F.87");
+
+  dentra::tion_4s::tion4s_raw_frame_t<dentra::tion_4s::tion4s_state_t> rsp{};
+  rsp.request_id = 1;
+  rsp.data.fan_speed = 1;
+  api.read_frame(dentra::tion_4s::FRAME_TYPE_STATE_RSP, &rsp, sizeof(rsp));
+  res &= cloak::check_data("state", api.get_state().fan_speed, 1);
+
+  // BatchStateCall::perform без виртуальной таблицы -> TionApiBase::write_state
+  auto *call = capi.make_call();
+  call->set_led_state(true);
+  call->perform();
+  vport.call_loop();
+  res &= cloak::check_data("write_state", uart, "3A.12.00.30.32.01.00.00.00.14.00.00.00.01.00.00.20.A9");
+
+  // TionApiBase::boost_enable_native_ -> Tion4sApi::boost_enable_native_
+  api.enable_native_boost_support();
+  api.enable_boost(true, capi.make_call());
+  vport.call_loop();
+  res &= cloak::check_data("boost_enable_native", uart, "3A.0E.00.30.41.02.00.00.00.B0.04.00.84.E8");
+
+  return res;
+}
+
+REGISTER_TEST(test_api_static);
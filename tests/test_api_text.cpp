@@ -0,0 +1,53 @@
+#include <string>
+
+#include "../components/tion-api/tion-api-text.h"
+
+#include "utils.h"
+
+DEFINE_TAG;
+
+namespace {
+constexpr const char *const TEXT[] = {
+    "Температура платы управления выше допустимого значения",
+    "Температура силовой платы ниже допустимого значения",
+    "Ошибка",
+};
+constexpr const char *const DICT[] = {
+    "Температура ",
+    " допустимого значения",
+    "платы ",
+};
+TION_TEXT_TABLE(TEXT_DICT, TEXT, DICT);
+TION_TEXT_TABLE(TEXT_PLAIN, TEXT);
+
+// управляющие символы совпадают со ссылками словаря, TION_TEXT_TABLE такие строки не принимает
+constexpr const char *const TEXT_CONTROL[] = {"Ошибка\tдатчика"};
+static_assert(dentra::tion::text::is_plain(TEXT), "TEXT is plain");
+static_assert(!dentra::tion::text::is_plain(TEXT_CONTROL), "TEXT_CONTROL has control bytes");
+}  // namespace
+
+bool test_api_text() {
+  bool res = true;
+
+  char buf[TEXT_DICT.buf_size];
+  res &= cloak::check_data("buf size", uint32_t(sizeof(buf)), uint32_t(std::string(TEXT[0]).size() + 1));
+  res &= cloak::check_data("compressed", sizeof(TEXT_DICT) < sizeof(TEXT_PLAIN), true);
+
+  for (size_t i = 0; i < sizeof(TEXT) / sizeof(TEXT[0]); i++) {
+    res &= cloak::check_data("dict get", TEXT_DICT.get(i, buf, sizeof(buf)), true);
+    res &= cloak::check_data("dict text", std::string(buf), std::string(TEXT[i]));
+    res &= cloak::check_data("plain get", TEXT_PLAIN.get(i, buf, sizeof(buf)), true);
+    res &= cloak::check_data("plain text", std::string(buf), std::string(TEXT[i]));
+  }
+
+  res &= cloak::check_data("out of range", TEXT_DICT.get(3, buf, sizeof(buf)), false);
+  res &= cloak::check_data("out of range text", std::string(buf), std::string());
+
+  char small[8];
+  TEXT_DICT.get(2, small, sizeof(small));
+  res &= cloak::check_data("truncated", std::string(small), std::string("Оши"));
+
+  return res;
+}
+
+REGISTER_TEST(test_api_text);
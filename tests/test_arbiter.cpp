@@ -0,0 +1,225 @@
+#include <cstdint>
+#include <vector>
+
+#include "../components/tion-api/tion-api-3s-internal.h"
+#include "../components/tion/tion_arbiter.h"
+#include "../components/tion/tion_component.h"
+
+#include "test_emu.h"
+#include "utils.h"
+
+DEFINE_TAG;
+
+#ifdef TION_ENABLE_ARBITER
+
+using esphome::tion::TionArbiter;
+
+namespace {
+class ArbiterTest {
+ public:
+  TionArbiter arbiter;
+  std::vector<uint8_t> sent;
+  std::vector<TionArbiter::Lane> lanes;
+
+  ArbiterTest() {
+    this->arbiter.set_writer(TionArbiter::writer_type::create<ArbiterTest, &ArbiterTest::write_>(*this));
+    this->arbiter.set_interval(100);
+    this->arbiter.set_max_wait(1000);
+  }
+
+  TionArbiter::Result write(uint32_t now, TionArbiter::Lane lane, uint16_t type, uint8_t param = 0) {
+    TionArbiter::Scope scope(&this->arbiter, lane);
+    const uint8_t data[] = {1, 2, param};
+    return this->arbiter.write(now, type, data, sizeof(data));
+  }
+
+ protected:
+  bool write_(uint16_t type, const void *data, size_t size) {
+    this->sent.push_back(static_cast<uint8_t>(type));
+    this->lanes.push_back(this->arbiter.get_last_lane());
+    return true;
+  }
+};
+}  // namespace
+
+// Приоритет полос и объединение запросов опроса.
+bool test_arbiter_priority() {
+  bool res = true;
+
+  ArbiterTest t;
+  t.write(1000, TionArbiter::LANE_POLL, 0x01);
+  res &= cloak::check_data("pass through", uint32_t(t.sent.size()), 1u);
+
+  t.write(1010, TionArbiter::LANE_POLL, 0x02);
+  t.write(1010, TionArbiter::LANE_POLL, 0x02);
+  t.write(1010, TionArbiter::LANE_AUTO, 0x03);
+  t.write(1010, TionArbiter::LANE_RC, 0x04);
+  res &= cloak::check_data("poll coalesced", uint32_t(t.arbiter.get_queued(TionArbiter::LANE_POLL)), 1u);
+
+  t.arbiter.loop(1050);
+  res &= cloak::check_data("interval", uint32_t(t.sent.size()), 1u);
+  t.arbiter.loop(1100);
+  t.arbiter.loop(1200);
+  t.arbiter.loop(1300);
+  const std::vector<uint8_t> order{0x01, 0x04, 0x03, 0x02};
+  res &= cloak::check_data("order", t.sent, order);
+  res &= cloak::check_data("empty", t.arbiter.is_empty(), true);
+
+  t.arbiter.snapshot();
+  res &= cloak::check_data("rc delay", t.arbiter.get_stats(TionArbiter::LANE_RC).delay_max, 90u);
+  res &= cloak::check_data("poll dropped", t.arbiter.get_stats(TionArbiter::LANE_POLL).dropped, 1u);
+
+  return res;
+}
+
+// Ограничение очереди и защита низких полос от голодания.
+bool test_arbiter_fairness() {
+  bool res = true;
+
+  ArbiterTest t;
+  t.write(1000, TionArbiter::LANE_USER, 0x10);
+  t.write(1010, TionArbiter::LANE_POLL, 0x20);
+  uint32_t poll_time = 0;
+  for (uint32_t now = 1100; now <= 3000; now += 100) {
+    t.write(now, TionArbiter::LANE_USER, 0x10);
+    t.arbiter.loop(now);
+    if (poll_time == 0 && t.sent.back() == 0x20) {
+      poll_time = now;
+    }
+  }
+  res &= cloak::check_data("poll max wait", poll_time, 2100u);
+
+  ArbiterTest f;
+  f.write(1000, TionArbiter::LANE_USER, 0x01);
+  for (uint16_t type = 0x02; type < 0x02 + TION_ARBITER_QUEUE_SIZE + 1; type++) {
+    f.write(1010, TionArbiter::LANE_USER, type);
+  }
+  res &= cloak::check_data("queue bounded", uint32_t(f.arbiter.get_queued(TionArbiter::LANE_USER)),
+                           uint32_t(TION_ARBITER_QUEUE_SIZE));
+  res &= cloak::check_data("user dropped", f.arbiter.get_stats(TionArbiter::LANE_USER).dropped, 1u);
+
+  return res;
+}
+
+// Запросы опроса с разными параметрами не замещают друг друга, результат записи различает очередь.
+bool test_arbiter_poll_params() {
+  bool res = true;
+
+  ArbiterTest t;
+  res &= cloak::check_data("sent", t.write(1000, TionArbiter::LANE_POLL, 0x01) == TionArbiter::RESULT_SENT, true);
+  res &= cloak::check_data("queued", t.write(1010, TionArbiter::LANE_POLL, 0x02, 0) == TionArbiter::RESULT_QUEUED,
+                           true);
+  t.write(1010, TionArbiter::LANE_POLL, 0x02, 1);
+  t.write(1010, TionArbiter::LANE_POLL, 0x02, 1);
+  res &= cloak::check_data("params kept", uint32_t(t.arbiter.get_queued(TionArbiter::LANE_POLL)), 2u);
+  res &= cloak::check_data("same params dropped", t.arbiter.get_stats(TionArbiter::LANE_POLL).dropped, 1u);
+
+  // переполнение очереди учитывается как ошибка записи
+  dentra::tion::TionProtocolStats stats;
+  t.arbiter.set_protocol_stats(&stats);
+  for (uint8_t param = 2; param < 2 + TION_ARBITER_QUEUE_SIZE; param++) {
+    t.write(1010, TionArbiter::LANE_POLL, 0x02, param);
+  }
+  res &= cloak::check_data("write errors", stats.get(dentra::tion::TionProtocolStats::WRITE_ERRORS), 2u);
+
+  return res;
+}
+
+// Кадры обновления прошивки отправляются сразу и по порядку, независимо от очередей.
+bool test_arbiter_update_lane() {
+  bool res = true;
+
+  ArbiterTest t;
+  t.write(1000, TionArbiter::LANE_POLL, 0x01);
+  t.write(1010, TionArbiter::LANE_POLL, 0x02);
+  t.write(1010, TionArbiter::LANE_USER, 0x03);
+  t.write(1020, TionArbiter::LANE_UPDATE, 0x10, 1);
+  t.write(1020, TionArbiter::LANE_UPDATE, 0x10, 2);
+  res &= cloak::check_data("update sent",
+                           t.write(1020, TionArbiter::LANE_UPDATE, 0x10, 2) == TionArbiter::RESULT_SENT, true);
+  const std::vector<uint8_t> sent{0x01, 0x10, 0x10, 0x10};
+  res &= cloak::check_data("update order", t.sent, sent);
+  res &= cloak::check_data("update last lane", t.arbiter.get_last_lane() == TionArbiter::LANE_UPDATE, true);
+
+  t.arbiter.loop(1200);
+  res &= cloak::check_data("user last lane", t.arbiter.get_last_lane() == TionArbiter::LANE_USER, true);
+
+  return res;
+}
+
+namespace {
+// 3S api с отложенной записью, кадры проходят через арбитр компонента.
+class ArbiterWriteSlotTest {
+ public:
+  dentra::tion::Tion3sApi api;
+  esphome::tion::Tion3sApiComponent capi{&api, esphome::tion::TionVPortType::VPORT_UART};
+  std::vector<TionArbiter::Lane> lanes;
+
+  ArbiterWriteSlotTest() {
+    using this_t = ArbiterWriteSlotTest;
+    this->api.set_writer(dentra::tion::TionApiWriter::writer_type::create<this_t, &this_t::write_frame_>(*this));
+    this->capi.get_arbiter()->set_writer(TionArbiter::writer_type::create<this_t, &this_t::send_frame_>(*this));
+    this->capi.set_arbiter(100, 1000);
+    this->capi.set_write_after_ack(true);
+  }
+
+  void read_state(uint8_t cmd) {
+    using namespace dentra::tion_3s;
+    Tion3sEmu emu;
+    this->api.read_frame(FRAME_TYPE_RSP(cmd), &emu.state, sizeof(emu.state));
+  }
+
+  void set_fan_speed(TionArbiter::Lane lane, uint8_t fan_speed) {
+    TionArbiter::Scope scope(this->capi.get_arbiter(), lane);
+    dentra::tion::TionStateCall call(&this->api);
+    call.set_fan_speed(fan_speed);
+    call.perform();
+  }
+
+ protected:
+  bool write_frame_(uint16_t type, const void *data, size_t size) {
+    return this->capi.get_arbiter()->write(esphome::millis(), type, data, size) != TionArbiter::RESULT_FAILED;
+  }
+  bool send_frame_(uint16_t type, const void *data, size_t size) {
+    this->lanes.push_back(this->capi.get_arbiter()->get_last_lane());
+    return true;
+  }
+};
+}  // namespace
+
+// Отложенная до подтверждения запись 3S/LT отправляется в полосе, в которой была сделана.
+bool test_arbiter_write_slot() {
+  bool res = true;
+
+  ArbiterWriteSlotTest t;
+  esphome::test_set_millis(1000);
+  t.read_state(dentra::tion_3s::FRAME_TYPE_STATE_GET);
+
+  t.set_fan_speed(TionArbiter::LANE_AUTO, 2);
+  t.capi.loop();
+  res &= cloak::check_data("auto write", t.lanes.size() == 1 && t.lanes.back() == TionArbiter::LANE_AUTO, true);
+
+  // запись пульта ожидает подтверждения предыдущей записи
+  esphome::test_set_millis(1200);
+  t.set_fan_speed(TionArbiter::LANE_RC, 3);
+  t.capi.loop();
+  res &= cloak::check_data("wait for ack", t.api.write_slot().has_pending(), true);
+
+  // объединенная с автоматикой запись сохраняет приоритет пульта
+  t.set_fan_speed(TionArbiter::LANE_AUTO, 4);
+  esphome::test_set_millis(1400);
+  t.read_state(dentra::tion_3s::FRAME_TYPE_STATE_SET);
+  t.capi.loop();
+  res &= cloak::check_data("rc write", t.lanes.size() == 2 && t.lanes.back() == TionArbiter::LANE_RC, true);
+  res &= cloak::check_data("rc stats", t.capi.get_arbiter()->get_stats(TionArbiter::LANE_RC).sent, 1u);
+
+  return res;
+}
+
+REGISTER_TEST(test_arbiter_priority);
+REGISTER_TEST(test_arbiter_fairness);
+REGISTER_TEST(test_arbiter_poll_params);
+REGISTER_TEST(test_arbiter_update_lane);
+REGISTER_TEST(test_arbiter_write_slot);
+
+#endif  // TION_ENABLE_ARBITER
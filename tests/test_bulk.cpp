@@ -0,0 +1,46 @@
+#include <string>
+#include <vector>
+
+#include "../components/tion/tion_bulk.h"
+
+#include "utils.h"
+
+DEFINE_TAG;
+
+using esphome::tion::TionBulkPublisher;
+
+// Полное состояние, изменения и периодическая передача полного состояния.
+bool test_bulk() {
+  bool res = true;
+
+  dentra::tion::TionState state{};
+  state.power_state = true;
+  state.fan_speed = 2;
+  state.target_temperature = 20;
+  state.outdoor_temperature = -5;
+
+  TionBulkPublisher json(nullptr, TionBulkPublisher::FORMAT_JSON);
+  json.set_full_interval(60000);
+  res &= cloak::check_data("json full", json.make_message(1000, state),
+                           std::string("{\"full\":true,\"p\":1,\"h\":0,\"s\":2,\"tt\":20,\"to\":-5,\"tc\":0,\"g\":0,"
+                                       "\"a\":0,\"pr\":0,\"hv\":0,\"f\":0,\"fl\":0,\"wt\":0,\"af\":0,\"bt\":0,\"e\":0}"));
+  res &= cloak::check_data("json same", json.make_message(2000, state), std::string());
+  state.fan_speed = 3;
+  state.outdoor_temperature = -6;
+  res &= cloak::check_data("json delta", json.make_message(3000, state), std::string("{\"s\":3,\"to\":-6}"));
+  res &= cloak::check_data("json interval", json.make_message(61000, state).substr(0, 13),
+                           std::string("{\"full\":true,"));
+
+  TionBulkPublisher cbor(nullptr, TionBulkPublisher::FORMAT_CBOR);
+  cbor.make_message(1000, state);
+  state.fan_speed = 4;
+  state.outdoor_temperature = -30;
+  state.work_time = 100000;
+  const auto msg = cbor.make_message(2000, state);
+  res &= cloak::check_data("cbor delta", std::vector<uint8_t>(msg.begin(), msg.end()),
+                           "A3.61.73.04.62.74.6F.38.1D.62.77.74.1A.00.01.86.A0");
+
+  return res;
+}
+
+REGISTER_TEST(test_bulk);
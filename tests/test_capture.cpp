@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../components/tion-api/tion-api-4s.h"
+#include "../components/tion/tion_component.h"
+
+#include "test_capture.h"
+#include "test_emu.h"
+#include "utils.h"
+
+DEFINE_TAG;
+
+using dentra::tion::TionCapture;
+using dentra::tion::TionCaptureReader;
+using dentra::tion::TionCaptureWriter;
+
+bool TionCaptureFile::open(const char *path) {
+  this->close();
+  this->fd_ = ::open(path, O_RDONLY);
+  if (this->fd_ < 0) {
+    ESP_LOGE(TAG, "Failed to open %s", path);
+    return false;
+  }
+  struct stat st {};
+  if (::fstat(this->fd_, &st) != 0 || st.st_size == 0) {
+    ESP_LOGE(TAG, "Failed to stat %s", path);
+    this->close();
+    return false;
+  }
+  auto *data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, this->fd_, 0);
+  if (data == MAP_FAILED) {
+    ESP_LOGE(TAG, "Failed to map %s", path);
+    this->close();
+    return false;
+  }
+  this->data_ = static_cast<const uint8_t *>(data);
+  this->size_ = st.st_size;
+  return true;
+}
+
+void TionCaptureFile::close() {
+  if (this->data_) {
+    ::munmap(const_cast<uint8_t *>(this->data_), this->size_);
+    this->data_ = nullptr;
+    this->size_ = 0;
+  }
+  if (this->fd_ >= 0) {
+    ::close(this->fd_);
+    this->fd_ = -1;
+  }
+}
+
+bool TionCaptureFile::save(const char *path, const void *data, size_t size) {
+  auto *f = std::fopen(path, "wb");
+  if (f == nullptr) {
+    ESP_LOGE(TAG, "Failed to create %s", path);
+    return false;
+  }
+  const bool res = std::fwrite(data, 1, size, f) == size;
+  std::fclose(f);
+  return res;
+}
+
+bool TionCaptureReplay::run(TionCaptureReader &reader, cloak::VirtualClock *clock,
+                            const std::vector<esphome::Component *> &components) {
+  TionCapture::Record rec;
+  uint32_t time = 0;
+  while (reader.next(rec)) {
+    if (clock) {
+      clock->advance(rec.time - time, components);
+      time = rec.time;
+    }
+    if (rec.dir == TionCapture::DIR_TX) {
+      this->tx_++;
+      this->tx_types_.push_back(rec.type);
+      continue;
+    }
+    this->rx_++;
+    this->reader_.call_if(rec.type, rec.data, rec.size);
+  }
+  return reader.is_eof();
+}
+
+uint32_t TionCaptureReplay::get_tx_mismatch() const {
+  const size_t size = std::min(this->tx_types_.size(), this->api_tx_.size());
+  uint32_t res = std::max(this->tx_types_.size(), this->api_tx_.size()) - size;
+  for (size_t i = 0; i < size; i++) {
+    if (this->tx_types_[i] != this->api_tx_[i]) {
+      res++;
+    }
+  }
+  return res;
+}
+
+// Формат записи и вытеснение старых записей из кольцевого буфера.
+bool test_capture_format() {
+  bool res = true;
+
+  cloak::VirtualClock clock;
+
+  TionCaptureWriter wr(64, TionCapture::DEVICE_4S);
+  const uint8_t rx_data[] = {0x01, 0x02, 0x03};
+  wr.rx(0x1234, rx_data, sizeof(rx_data));
+  clock.advance(200);
+  wr.tx(0x4321, nullptr, 0);
+
+  std::vector<uint8_t> buf(wr.size());
+  res &= cloak::check_data("read size", uint32_t(wr.read(buf.data(), buf.size())), uint32_t(buf.size()));
+  res &= cloak::check_data("capture", buf, "54.43.41.50.01.02.00.00 00.06.34.12.01.02.03 C8.01.01.21.43");
+
+  TionCaptureReader rd(buf.data(), buf.size());
+  TionCapture::Record rec;
+  res &= cloak::check_data("valid", rd.is_valid(), true);
+  res &= cloak::check_data("device", uint32_t(rd.get_device()), uint32_t(TionCapture::DEVICE_4S));
+  res &= cloak::check_data("rec1", rd.next(rec), true);
+  res &= cloak::check_data("rec1 dir", uint32_t(rec.dir), uint32_t(TionCapture::DIR_RX));
+  res &= cloak::check_data("rec1 type", uint32_t(rec.type), 0x1234u);
+  res &= cloak::check_data("rec1 data", std::vector<uint8_t>(rec.data, rec.data + rec.size), "01.02.03");
+  res &= cloak::check_data("rec2", rd.next(rec), true);
+  res &= cloak::check_data("rec2 dir", uint32_t(rec.dir), uint32_t(TionCapture::DIR_TX));
+  res &= cloak::check_data("rec2 time", rec.time, 200u);
+  res &= cloak::check_data("rec2 size", uint32_t(rec.size), 0u);
+  res &= cloak::check_data("eof", rd.next(rec) == false && rd.is_eof(), true);
+
+  TionCaptureReader truncated(buf.data(), buf.size() - 1);
+  truncated.next(rec);
+  res &= cloak::check_data("truncated", truncated.next(rec) == false && !truncated.is_eof(), true);
+
+  // запись занимает 12 байт, в буфер помещается 5 записей
+  wr.clear();
+  for (uint8_t i = 0; i < 20; i++) {
+    const uint8_t data[8] = {i, i, i, i, i, i, i, i};
+    wr.rx(i, data, sizeof(data));
+    clock.advance(10);
+  }
+  res &= cloak::check_data("records", wr.get_records(), 5u);
+  res &= cloak::check_data("evicted", wr.get_evicted() >= 15, true);
+
+  buf.resize(wr.size());
+  wr.read(buf.data(), buf.size());
+  TionCaptureReader rd2(buf.data(), buf.size());
+  uint32_t count = 0;
+  while (rd2.next(rec)) {
+    count++;
+  }
+  res &= cloak::check_data("ring records", count, 5u);
+  res &= cloak::check_data("ring eof", rd2.is_eof(), true);
+  res &= cloak::check_data("ring last type", uint32_t(rec.type), 19u);
+  res &= cloak::check_data("ring last time", rec.time, 40u);
+
+  wr.rx(0, nullptr, 64);
+  res &= cloak::check_data("skipped", wr.get_skipped(), 1u);
+
+  return res;
+}
+
+// Вычитывание буфера потребителем (зеркалирование), новые записи отбрасываются при переполнении.
+bool test_capture_consume() {
+  bool res = true;
+
+  cloak::VirtualClock clock;
+
+  TionCaptureWriter wr(64, TionCapture::DEVICE_3S);
+  wr.set_drop_new(true);
+  for (uint8_t i = 0; i < 8; i++) {
+    const uint8_t data[8] = {i, i, i, i, i, i, i, i};
+    wr.rx(i, data, sizeof(data));
+    clock.advance(10);
+  }
+  res &= cloak::check_data("dropped", wr.get_dropped(), 3u);
+  res &= cloak::check_data("evicted", wr.get_evicted(), 0u);
+  res &= cloak::check_data("record_size", uint32_t(wr.record_size(0)), 12u);
+  res &= cloak::check_data("record_size end", uint32_t(wr.record_size(60)), 0u);
+
+  // частичное вычитывание с переходом через границу буфера
+  std::vector<uint8_t> stream;
+  const uint8_t *data;
+  size_t size = wr.peek(data);
+  stream.insert(stream.end(), data, data + 30);
+  wr.consume(30);
+  for (uint8_t i = 8; i < 10; i++) {
+    const uint8_t frame[8] = {i, i, i, i, i, i, i, i};
+    wr.tx(i, frame, sizeof(frame));
+  }
+  while ((size = wr.peek(data)) != 0) {
+    stream.insert(stream.end(), data, data + size);
+    wr.consume(size);
+  }
+  res &= cloak::check_data("used", uint32_t(wr.used()), 0u);
+
+  std::vector<uint8_t> buf(TionCapture::HEADER_SIZE);
+  TionCapture::write_header(buf.data(), TionCapture::DEVICE_3S);
+  buf.insert(buf.end(), stream.begin(), stream.end());
+  TionCaptureReader rd(buf.data(), buf.size());
+  TionCapture::Record rec;
+  std::vector<uint8_t> types;
+  while (rd.next(rec)) {
+    types.push_back(rec.type);
+  }
+  res &= cloak::check_data("stream eof", rd.is_eof(), true);
+  res &= cloak::check_data("stream types", types, "00.01.02.03.04.08.09");
+  res &= cloak::check_data("last dir", uint32_t(rec.dir), uint32_t(TionCapture::DIR_TX));
+
+  return res;
+}
+
+// Вывод записей в лог и сборка лога обратно в файл скриптом tests/capture2bin.py.
+bool test_capture_stream() {
+  bool res = true;
+
+  constexpr const char *LOG_PATH = "/tmp/tion_capture_stream.log";
+  constexpr const char *BIN_PATH = "/tmp/tion_capture_stream.bin";
+
+  cloak::VirtualClock clock;
+
+  TionCaptureWriter wr(512, TionCapture::DEVICE_4S);
+  wr.set_stream(true);
+
+  // перенаправляем stdout, куда пишет лог, в файл
+  std::fflush(stdout);
+  const int out_fd = ::dup(STDOUT_FILENO);
+  const int log_fd = ::open(LOG_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  ::dup2(log_fd, STDOUT_FILENO);
+  ::close(log_fd);
+
+  uint8_t data[100];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = i;
+  }
+  wr.rx(0x1234, data, sizeof(data));
+  clock.advance(300);
+  wr.tx(0x4321, nullptr, 0);
+  clock.advance(20);
+  wr.tx(0x4322, data, 3);
+
+  std::fflush(stdout);
+  ::dup2(out_fd, STDOUT_FILENO);
+  ::close(out_fd);
+
+  std::string script(__FILE__);
+  script = script.substr(0, script.rfind('/') + 1) + "capture2bin.py";
+  const std::string cmd = "python3 " + script + " 4s " + LOG_PATH + " " + BIN_PATH + " > /dev/null";
+  res &= cloak::check_data("capture2bin", std::system(cmd.c_str()), 0);
+
+  std::vector<uint8_t> buf(wr.size());
+  wr.read(buf.data(), buf.size());
+  TionCaptureFile file;
+  res &= cloak::check_data("open", file.open(BIN_PATH), true);
+  res &= cloak::check_data("stream", std::vector<uint8_t>(file.data(), file.data() + file.size()), buf);
+
+  std::remove(LOG_PATH);
+  std::remove(BIN_PATH);
+
+  return res;
+}
+
+// Запись сеанса с эмулятором и воспроизведение в новый экземпляр api.
+bool test_capture_replay() {
+  bool res = true;
+
+  constexpr const char *PATH = "/tmp/tion_capture_4s.bin";
+
+  {
+    cloak::VirtualClock clock;
+
+    dentra::tion_4s::Tion4sApi api;
+    esphome::tion::Tion4sApiComponent capi(&api, esphome::tion::TionVPortType::VPORT_UART);
+    Tion4sEmu emu;
+    TionCaptureWriter wr(4096, TionCapture::DEVICE_4S);
+    emu.attach(&api);
+    emu.set_capture(&wr);
+    emu.link.set_latency(20);
+
+    cloak::setup_and_loop({&emu, &capi});
+    api.request_state();
+    clock.advance(100, {&emu, &capi}, 1);
+    for (uint8_t i = 0; i < 20; i++) {
+      auto *call = capi.make_call();
+      call->set_fan_speed(i % 6 + 1);
+      call->perform();
+      clock.advance(500, {&emu, &capi}, 1);
+    }
+    res &= cloak::check_data("evicted", wr.get_evicted(), 0u);
+
+    std::vector<uint8_t> buf(wr.size());
+    wr.read(buf.data(), buf.size());
+    res &= cloak::check_data("save", TionCaptureFile::save(PATH, buf.data(), buf.size()), true);
+    ESP_LOGI(TAG, "Captured %" PRIu32 " records, %zu bytes", wr.get_records(), buf.size());
+  }
+
+  TionCaptureFile file;
+  res &= cloak::check_data("open", file.open(PATH), true);
+  TionCaptureReader rd(file.data(), file.size());
+  res &= cloak::check_data("device", uint32_t(rd.get_device()), uint32_t(TionCapture::DEVICE_4S));
+
+  {
+    cloak::VirtualClock clock;
+    dentra::tion_4s::Tion4sApi api;
+    TionCaptureReplay replay;
+    replay.attach(&api);
+    const uint32_t start = esphome::millis();
+    res &= cloak::check_data("replay", replay.run(rd, &clock), true);
+    res &= cloak::check_data("replay time", esphome::millis() - start >= 19 * 500, true);
+    res &= cloak::check_data("rx", replay.get_rx() > 20, true);
+    res &= cloak::check_data("firmware_version", uint32_t(api.get_state().firmware_version), 0x0230u);
+    res &= cloak::check_data("fan_speed", uint32_t(api.get_state().fan_speed), uint32_t((20 - 1) % 6 + 1));
+  }
+
+  // декодирование записи с максимальной скоростью
+  constexpr uint32_t ROUNDS = 1000;
+  dentra::tion_4s::Tion4sApi api;
+  TionCaptureReplay replay;
+  replay.attach(&api);
+  const auto wall_start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < ROUNDS; i++) {
+    rd.rewind();
+    replay.run(rd);
+  }
+  const auto wall_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wall_start).count();
+  ESP_LOGI(TAG, "Replay: %" PRIu32 " frames, host: %.3f us/frame, api tx: %" PRIu32, replay.get_rx(),
+           float(wall_us) / replay.get_rx(), replay.get_api_tx());
+
+  std::remove(PATH);
+
+  return res;
+}
+
+REGISTER_TEST(test_capture_format);
+REGISTER_TEST(test_capture_consume);
+REGISTER_TEST(test_capture_stream);
+REGISTER_TEST(test_capture_replay);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "etl/delegate.h"
+#include "esphome/core/component.h"
+
+#include "../components/tion-api/tion-api-capture.h"
+#include "../components/tion-api/tion-api-writer.h"
+
+namespace cloak {
+class VirtualClock;
+}
+
+/// Файл записи трафика, отображенный в память.
+class TionCaptureFile {
+ public:
+  ~TionCaptureFile() { this->close(); }
+
+  bool open(const char *path);
+  void close();
+
+  const uint8_t *data() const { return this->data_; }
+  size_t size() const { return this->size_; }
+
+  /// Сохраняет данные в файл.
+  static bool save(const char *path, const void *data, size_t size);
+
+ protected:
+  const uint8_t *data_{};
+  size_t size_{};
+  int fd_{-1};
+};
+
+/// Воспроизведение записи трафика: RX кадры передаются в api, TX кадры api собираются
+/// для сравнения с записанными.
+class TionCaptureReplay {
+ public:
+  using reader_type = etl::delegate<void(uint16_t type, const void *data, size_t size)>;
+
+  template<class A> void attach(A *api) {
+    using writer_type = dentra::tion::TionApiWriter::writer_type;
+    api->set_writer(writer_type::create<TionCaptureReplay, &TionCaptureReplay::on_tx_>(*this));
+    this->reader_ = reader_type::create<A, &A::read_frame>(*api);
+  }
+
+  /// Воспроизводит запись. Если задан clock, время продвигается в соответствии с записью
+  /// и выполняются loop компонентов, иначе кадры передаются с максимальной скоростью.
+  bool run(dentra::tion::TionCaptureReader &reader, cloak::VirtualClock *clock = nullptr,
+           const std::vector<esphome::Component *> &components = {});
+
+  /// Количество переданных в api кадров.
+  uint32_t get_rx() const { return this->rx_; }
+  /// Количество записанных TX кадров.
+  uint32_t get_tx() const { return this->tx_; }
+  /// Количество кадров, отправленных api во время воспроизведения.
+  uint32_t get_api_tx() const { return this->api_tx_.size(); }
+  /// Количество TX кадров api, тип которых не совпал с записанными (по порядку).
+  uint32_t get_tx_mismatch() const;
+
+ protected:
+  reader_type reader_{};
+  uint32_t rx_{};
+  uint32_t tx_{};
+  std::vector<uint16_t> tx_types_;
+  std::vector<uint16_t> api_tx_;
+
+  bool on_tx_(uint16_t type, const void *data, size_t size) {
+    this->api_tx_.push_back(type);
+    return true;
+  }
+};
@@ -0,0 +1,418 @@
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstring>
+
+#include "../components/tion-api/tion-api-3s.h"
+#include "../components/tion-api/tion-api-4s.h"
+#include "../components/tion-api/tion-api-lt.h"
+#include "../components/tion-api/tion-api-o2.h"
+#include "../components/tion/tion_component.h"
+
+#include "test_emu.h"
+#include "utils.h"
+
+DEFINE_TAG;
+
+using dentra::tion::tion_dev_info_t;
+
+void TionEmuLink::send(uint16_t type, const void *data, size_t size) {
+  this->sent_++;
+  if (this->chance_(this->drop_rate_)) {
+    this->dropped_++;
+    return;
+  }
+  const auto *data8 = static_cast<const uint8_t *>(data);
+  Frame frame{.due = esphome::millis() + this->latency_, .type = type, .data = {data8, data8 + size}};
+  if (this->jitter_ != 0) {
+    frame.due += this->random_() % (this->jitter_ + 1);
+  }
+  // канал последовательный, кадр не может обогнать предыдущий
+  if (!this->queue_.empty() && static_cast<int32_t>(frame.due - this->queue_.back().due) < 0) {
+    frame.due = this->queue_.back().due;
+  }
+  if (size != 0 && this->chance_(this->corrupt_rate_)) {
+    this->corrupted_++;
+    const auto bit = this->random_() % (size * 8);
+    frame.data[bit / 8] ^= 1 << (bit % 8);
+  }
+  this->queue_.push_back(std::move(frame));
+}
+
+void TionEmuLink::loop() {
+  const uint32_t now = esphome::millis();
+  while (!this->queue_.empty() && static_cast<int32_t>(now - this->queue_.front().due) >= 0) {
+    auto frame = std::move(this->queue_.front());
+    this->queue_.erase(this->queue_.begin());
+    this->delivered_++;
+    if (this->capture_) {
+      this->capture_->rx(frame.type, frame.data.data(), frame.data.size());
+    }
+    this->reader_.call_if(frame.type, frame.data.data(), frame.data.size());
+  }
+}
+
+uint32_t TionEmuLink::random_() {
+  // xorshift32, воспроизводимая последовательность для заданного seed
+  this->seed_ ^= this->seed_ << 13;
+  this->seed_ ^= this->seed_ >> 17;
+  this->seed_ ^= this->seed_ << 5;
+  return this->seed_;
+}
+
+namespace {
+namespace t4s = dentra::tion_4s;
+namespace t3s = dentra::tion_3s;
+namespace to2 = dentra::tion_o2;
+namespace tlt = dentra::tion_lt;
+}  // namespace
+
+Tion4sEmu::Tion4sEmu() {
+  this->state.sound_state = true;
+  this->state.led_state = true;
+  this->state.heater_mode = t4s::tion4s_state_t::HEATER_MODE_FANONLY;
+  this->state.heater_present = t4s::tion4s_state_t::HEATER_PRESENT_1000W;
+  this->state.target_temperature = 20;
+  this->state.fan_speed = 1;
+  this->state.outdoor_temperature = 5;
+  this->state.current_temperature = 20;
+  this->state.max_fan_speed = 6;
+}
+
+void Tion4sEmu::send_state_(uint32_t request_id) {
+  const t4s::tion4s_raw_frame_t<t4s::tion4s_state_t> rsp{.request_id = request_id, .data = this->state};
+  this->link.send(t4s::FRAME_TYPE_STATE_RSP, rsp);
+}
+
+void Tion4sEmu::on_frame(uint16_t type, const void *data, size_t size) {
+  if (type == t4s::FRAME_TYPE_STATE_REQ) {
+    this->send_state_(1);
+    return;
+  }
+  if (type == t4s::FRAME_TYPE_STATE_SET && size == sizeof(t4s::tion4s_raw_state_set_req_t)) {
+    const auto *req = static_cast<const t4s::tion4s_raw_state_set_req_t *>(data);
+    this->state.power_state = req->data.power_state;
+    this->state.sound_state = req->data.sound_state;
+    this->state.led_state = req->data.led_state;
+    this->state.heater_mode = req->data.heater_mode;
+    this->state.comm_source = req->data.comm_source;
+    this->state.gate_position = req->data.gate_position;
+    this->state.target_temperature = req->data.target_temperature;
+    if (req->data.fan_speed > 0 && req->data.fan_speed <= this->state.max_fan_speed) {
+      this->state.fan_speed = req->data.fan_speed;
+    }
+    this->send_state_(req->request_id);
+    return;
+  }
+  if (type == t4s::FRAME_TYPE_DEV_INFO_REQ) {
+    const tion_dev_info_t rsp{
+        .work_mode = tion_dev_info_t::NORMAL,
+        .device_type = tion_dev_info_t::BR4S,
+        .firmware_version = 0x0230,
+        .hardware_version = 0x1000,
+        .reserved = {},
+    };
+    this->link.send(t4s::FRAME_TYPE_DEV_INFO_RSP, rsp);
+    return;
+  }
+  if (type == t4s::FRAME_TYPE_TURBO_SET && size == sizeof(t4s::tion4s_raw_frame_t<t4s::tion4s_turbo_set_t>)) {
+    const auto *req = static_cast<const t4s::tion4s_raw_frame_t<t4s::tion4s_turbo_set_t> *>(data);
+    this->turbo.is_active = req->data.time != 0;
+    this->turbo.turbo_time = req->data.time;
+    const t4s::tion4s_raw_frame_t<t4s::tion4s_turbo_t> rsp{.request_id = req->request_id, .data = this->turbo};
+    this->link.send(t4s::FRAME_TYPE_TURBO_RSP, rsp);
+    return;
+  }
+  if (type == t4s::FRAME_TYPE_TURBO_REQ) {
+    const t4s::tion4s_raw_frame_t<t4s::tion4s_turbo_t> rsp{.request_id = 1, .data = this->turbo};
+    this->link.send(t4s::FRAME_TYPE_TURBO_RSP, rsp);
+    return;
+  }
+  if (type == t4s::FRAME_TYPE_HEARTBEAT_REQ) {
+    const uint8_t rsp = tion_dev_info_t::NORMAL;
+    this->link.send(t4s::FRAME_TYPE_HEARTBEAT_RSP, &rsp, sizeof(rsp));
+    return;
+  }
+  ESP_LOGW(TAG, "[4S] Unsupported frame %04X: %s", type, hexencode_cstr(data, size));
+}
+
+Tion3sEmu::Tion3sEmu() {
+  this->state.fan_speed = 1;
+  this->state.gate_position = t3s::tion3s_state_t::GATE_POSITION_OUTDOOR;
+  this->state.target_temperature = 20;
+  this->state.flags.sound_state = true;
+  this->state.current_temperature1 = 20;
+  this->state.current_temperature2 = 20;
+  this->state.outdoor_temperature = 5;
+  this->state.filter_time = 180;
+  this->state.firmware_version = 0x003C;
+}
+
+void Tion3sEmu::on_frame(uint16_t type, const void *data, size_t size) {
+  // FRAME_TYPE_REQ/FRAME_TYPE_RSP используют константы из пространства имен tion_3s
+  using namespace dentra::tion_3s;
+  if (type == FRAME_TYPE_REQ(t3s::FRAME_TYPE_STATE_GET)) {
+    this->link.send(FRAME_TYPE_RSP(t3s::FRAME_TYPE_STATE_GET), this->state);
+    return;
+  }
+  if (type == FRAME_TYPE_REQ(t3s::FRAME_TYPE_STATE_SET) && size >= sizeof(t3s::tion3s_state_set_t)) {
+    const auto *req = static_cast<const t3s::tion3s_state_set_t *>(data);
+    this->state.fan_speed = req->fan_speed;
+    this->state.target_temperature = req->target_temperature;
+    this->state.gate_position = req->gate_position;
+    this->state.flags = req->flags;
+    this->link.send(FRAME_TYPE_RSP(t3s::FRAME_TYPE_STATE_SET), this->state);
+    return;
+  }
+  ESP_LOGW(TAG, "[3S] Unsupported frame %04X: %s", type, hexencode_cstr(data, size));
+}
+
+TionO2Emu::TionO2Emu() {
+  this->state.target_temperature = 16;
+  this->state.fan_speed = 1;
+  this->state.outdoor_temperature = 5;
+  this->state.current_temperature = 16;
+  this->state.unknown7 = 4;
+}
+
+void TionO2Emu::on_frame(uint16_t type, const void *data, size_t size) {
+  if (type == to2::FRAME_TYPE_STATE_GET_REQ) {
+    this->link.send(to2::FRAME_TYPE_STATE_GET_RSP, this->state);
+    return;
+  }
+  if (type == to2::FRAME_TYPE_STATE_SET_REQ && size == sizeof(to2::tiono2_state_set_t)) {
+    const auto *req = static_cast<const to2::tiono2_state_set_t *>(data);
+    this->state.fan_speed = req->fan_speed;
+    this->state.target_temperature = req->target_temperature;
+    this->state.power_state = req->power_state;
+    this->state.heater_state = req->heater_state;
+    this->link.send(to2::FRAME_TYPE_STATE_GET_RSP, this->state);
+    return;
+  }
+  if (type == to2::FRAME_TYPE_DEV_MODE_REQ) {
+    const uint8_t rsp = 0;
+    this->link.send(to2::FRAME_TYPE_DEV_MODE_RSP, &rsp, sizeof(rsp));
+    return;
+  }
+  if (type == to2::FRAME_TYPE_SET_WORK_MODE_REQ) {
+    const uint8_t rsp = 0xAA;
+    this->link.send(to2::FRAME_TYPE_SET_WORK_MODE_RSP, &rsp, sizeof(rsp));
+    return;
+  }
+  if (type == to2::FRAME_TYPE_CONNECT_REQ) {
+    const uint8_t rsp[] = {0x04, 0x10, 0x01, 0x00};
+    this->link.send(to2::FRAME_TYPE_CONNECT_RSP, rsp);
+    return;
+  }
+  if (type == to2::FRAME_TYPE_DEV_INFO_REQ) {
+    to2::tiono2_dev_info_t rsp{};
+    rsp.unknown1 = 4;
+    rsp.hardware_version = 0x6108;
+    rsp.firmware_version = 0x130E;
+    rsp.unknown21 = 4;
+    rsp.heater_min = -20;
+    rsp.heater_max = 25;
+    this->link.send(to2::FRAME_TYPE_DEV_INFO_RSP, rsp);
+    return;
+  }
+  if (type == to2::FRAME_TYPE_TIME_GET_REQ) {
+    const to2::tiono2_time_t rsp{.hours = 12, .minutes = 0, .seconds = 0};
+    this->link.send(to2::FRAME_TYPE_TIME_GET_RSP, rsp);
+    return;
+  }
+  ESP_LOGW(TAG, "[O2] Unsupported frame %02X: %s", type, hexencode_cstr(data, size));
+}
+
+TionLtEmu::TionLtEmu() {
+  this->state.sound_state = true;
+  this->state.led_state = true;
+  this->state.heater_present = true;
+  this->state.gate_state = tlt::tionlt_state_t::OPENED;
+  this->state.target_temperature = 20;
+  this->state.fan_speed = 1;
+  this->state.outdoor_temperature = 5;
+  this->state.current_temperature = 20;
+  this->state.max_fan_speed = 6;
+}
+
+void TionLtEmu::send_state_(uint32_t request_id) {
+  const tlt::tionlt_state_get_req_t rsp{.request_id = request_id, .state = this->state};
+  this->link.send(tlt::FRAME_TYPE_STATE_RSP, rsp);
+}
+
+void TionLtEmu::on_frame(uint16_t type, const void *data, size_t size) {
+  if (type == tlt::FRAME_TYPE_STATE_REQ) {
+    this->send_state_(1);
+    return;
+  }
+  if (type == tlt::FRAME_TYPE_STATE_SET && size == sizeof(tlt::tionlt_state_set_req_t)) {
+    const auto *req = static_cast<const tlt::tionlt_state_set_req_t *>(data);
+    this->state.power_state = req->data.power_state;
+    this->state.sound_state = req->data.sound_state;
+    this->state.led_state = req->data.led_state;
+    this->state.heater_state = req->data.heater_state;
+    this->state.target_temperature = req->data.target_temperature;
+    if (req->data.fan_speed > 0 && req->data.fan_speed <= this->state.max_fan_speed) {
+      this->state.fan_speed = req->data.fan_speed;
+    }
+    this->send_state_(req->request_id);
+    return;
+  }
+  if (type == tlt::FRAME_TYPE_DEV_INFO_REQ) {
+    const tion_dev_info_t rsp{
+        .work_mode = tion_dev_info_t::NORMAL,
+        .device_type = tion_dev_info_t::BRLT,
+        .firmware_version = 0x0044,
+        .hardware_version = 0x1000,
+        .reserved = {},
+    };
+    this->link.send(tlt::FRAME_TYPE_DEV_INFO_RSP, rsp);
+    return;
+  }
+  ESP_LOGW(TAG, "[LT] Unsupported frame %04X: %s", type, hexencode_cstr(data, size));
+}
+
+// Время прохождения запрос-ответ через весь стек TionApiComponent -> api -> эмулятор -> api.
+bool test_emu_4s_latency() {
+  bool res = true;
+
+  cloak::VirtualClock clock;
+
+  dentra::tion_4s::Tion4sApi api;
+  esphome::tion::Tion4sApiComponent capi(&api, esphome::tion::TionVPortType::VPORT_UART);
+  Tion4sEmu emu;
+  emu.attach(&api);
+  emu.link.set_latency(20);
+  emu.link.set_jitter(10);
+
+  uint32_t states = 0;
+  capi.add_on_state_callback([&states](const dentra::tion::TionState *state) {
+    if (state != nullptr) {
+      states++;
+    }
+  });
+
+  cloak::setup_and_loop({&emu, &capi});
+
+  api.request_state();
+  clock.advance(100, {&emu, &capi}, 1);
+  res &= cloak::check_data("initialized", api.get_state().is_initialized(), true);
+  res &= cloak::check_data("firmware_version", uint32_t(api.get_state().firmware_version), 0x0230u);
+
+  constexpr uint32_t ROUNDS = 1000;
+  uint32_t total_ms = 0;
+  uint32_t max_ms = 0;
+  const auto wall_start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < ROUNDS; i++) {
+    const uint8_t fan_speed = i % 6 + 1;
+    const uint32_t expected = states + 1;
+    const uint32_t start = esphome::millis();
+    auto *call = capi.make_call();
+    call->set_fan_speed(fan_speed);
+    call->perform();
+    while (states < expected && esphome::millis() - start < 1000) {
+      clock.advance(1, {&emu, &capi});
+    }
+    const uint32_t rtt = esphome::millis() - start;
+    total_ms += rtt;
+    max_ms = std::max(max_ms, rtt);
+  }
+  const auto wall_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wall_start).count();
+
+  ESP_LOGI(TAG, "4S round trips: %" PRIu32 ", avg: %.1f ms, max: %" PRIu32 " ms, host: %.1f us/op", ROUNDS,
+           float(total_ms) / ROUNDS, max_ms, float(wall_us) / ROUNDS);
+
+  res &= cloak::check_data("all delivered", emu.link.get_delivered(), emu.link.get_sent());
+  res &= cloak::check_data("avg latency in range", total_ms >= 20 * ROUNDS && total_ms <= 31 * ROUNDS, true);
+  res &= cloak::check_data("max latency", max_ms <= 31, true);
+  res &= cloak::check_data("fan_speed", uint32_t(emu.state.fan_speed), (ROUNDS - 1) % 6 + 1);
+
+  return res;
+}
+
+// Потеря и порча кадров не должны приводить к рассинхронизации после восстановления канала.
+bool test_emu_3s_lossy() {
+  bool res = true;
+
+  cloak::VirtualClock clock;
+
+  dentra::tion::Tion3sApi api;
+  esphome::tion::Tion3sApiComponent capi(&api, esphome::tion::TionVPortType::VPORT_UART);
+  Tion3sEmu emu;
+  emu.attach(&api);
+  emu.link.set_latency(30);
+  emu.link.set_drop_rate(20);
+  emu.link.set_corrupt_rate(5);
+  emu.link.set_seed(42);
+  capi.set_write_after_ack(true);
+
+  cloak::setup_and_loop({&emu, &capi});
+
+  for (uint32_t i = 0; i < 200; i++) {
+    api.request_state();
+    if (api.get_state().is_initialized()) {
+      auto *call = capi.make_call();
+      call->set_fan_speed(i % 6 + 1);
+      call->perform();
+    }
+    clock.advance(100, {&emu, &capi}, 10);
+  }
+
+  res &= cloak::check_data("dropped", emu.link.get_dropped() > 0, true);
+  res &= cloak::check_data("corrupted", emu.link.get_corrupted() > 0, true);
+
+  // канал восстановлен, состояние должно сойтись с бризером
+  emu.link.set_drop_rate(0);
+  emu.link.set_corrupt_rate(0);
+  clock.advance(dentra::tion::TionWriteSlot::ACK_TIMEOUT, {&emu, &capi}, 10);
+  api.request_state();
+  clock.advance(100, {&emu, &capi}, 10);
+  res &= cloak::check_data("fan_speed synced", uint32_t(api.get_state().fan_speed), uint32_t(emu.state.fan_speed));
+  res &= cloak::check_data("target_temperature synced", int32_t(api.get_state().target_temperature),
+                           int32_t(emu.state.target_temperature));
+
+  return res;
+}
+
+// Базовый обмен для O2 и LT.
+bool test_emu_o2_lt() {
+  bool res = true;
+
+  cloak::VirtualClock clock;
+
+  dentra::tion_o2::TionO2Api o2;
+  TionO2Emu o2_emu;
+  o2_emu.attach(&o2);
+  o2.request_state();
+  clock.advance(10, {&o2_emu}, 1);
+  res &= cloak::check_data("o2 firmware_version", uint32_t(o2.get_state().firmware_version), 0x130Eu);
+  res &= cloak::check_data("o2 initialized", o2.get_state().is_initialized(), true);
+
+  dentra::tion::TionStateCall o2_call(&o2);
+  o2_call.set_fan_speed(3);
+  o2_call.perform();
+  clock.advance(10, {&o2_emu}, 1);
+  res &= cloak::check_data("o2 fan_speed", uint32_t(o2.get_state().fan_speed), 3u);
+
+  dentra::tion::TionLtApi lt;
+  TionLtEmu lt_emu;
+  lt_emu.attach(&lt);
+  lt.request_state();
+  clock.advance(10, {&lt_emu}, 1);
+  res &= cloak::check_data("lt firmware_version", uint32_t(lt.get_state().firmware_version), 0x0044u);
+  res &= cloak::check_data("lt initialized", lt.get_state().is_initialized(), true);
+
+  dentra::tion::TionStateCall lt_call(&lt);
+  lt_call.set_fan_speed(4);
+  lt_call.perform();
+  lt.flush_write();
+  clock.advance(10, {&lt_emu}, 1);
+  res &= cloak::check_data("lt fan_speed", uint32_t(lt.get_state().fan_speed), 4u);
+
+  return res;
+}
+
+REGISTER_TEST(test_emu_4s_latency);
+REGISTER_TEST(test_emu_3s_lossy);
+REGISTER_TEST(test_emu_o2_lt);
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "etl/delegate.h"
+#include "esphome/core/component.h"
+
+#include "../components/tion-api/tion-api-internal.h"
+#include "../components/tion-api/tion-api-writer.h"
+#include "../components/tion-api/tion-api-capture.h"
+#include "../components/tion-api/tion-api-3s-internal.h"
+#include "../components/tion-api/tion-api-4s-internal.h"
+#include "../components/tion-api/tion-api-lt-internal.h"
+#include "../components/tion-api/tion-api-o2-internal.h"
+
+/// Канал между эмулятором бризера и api. Эмулирует задержку, джиттер, потерю и порчу пакетов.
+/// Работает на уровне кадров (тип + данные), время берется из millis(), поэтому
+/// для детерминированных замеров используется совместно с cloak::VirtualClock.
+class TionEmuLink {
+ public:
+  using reader_type = etl::delegate<void(uint16_t type, const void *data, size_t size)>;
+
+  void set_reader(reader_type &&reader) { this->reader_ = reader; }
+
+  /// Задержка доставки ответа, мс.
+  void set_latency(uint32_t latency) { this->latency_ = latency; }
+  /// Случайная добавка к задержке [0:jitter], мс. Порядок кадров при этом сохраняется.
+  void set_jitter(uint32_t jitter) { this->jitter_ = jitter; }
+  /// Вероятность потери кадра (например, по ошибке crc), %.
+  void set_drop_rate(uint8_t drop_rate) { this->drop_rate_ = drop_rate; }
+  /// Вероятность порчи одного бита в данных кадра, %.
+  void set_corrupt_rate(uint8_t corrupt_rate) { this->corrupt_rate_ = corrupt_rate; }
+  void set_seed(uint32_t seed) { this->seed_ = seed == 0 ? 1 : seed; }
+  /// Запись доставленных кадров (RX).
+  void set_capture(dentra::tion::TionCaptureWriter *capture) { this->capture_ = capture; }
+
+  /// Отправка кадра от бризера.
+  void send(uint16_t type, const void *data, size_t size);
+  template<class T> void send(uint16_t type, const T &data) { this->send(type, &data, sizeof(data)); }
+
+  /// Доставка кадров, время которых наступило.
+  void loop();
+
+  /// Время доставки ближайшего кадра, мс. 0 - если кадров нет.
+  uint32_t next_due() const { return this->queue_.empty() ? 0 : this->queue_.front().due; }
+  size_t pending() const { return this->queue_.size(); }
+
+  uint32_t get_sent() const { return this->sent_; }
+  uint32_t get_delivered() const { return this->delivered_; }
+  uint32_t get_dropped() const { return this->dropped_; }
+  uint32_t get_corrupted() const { return this->corrupted_; }
+
+ protected:
+  struct Frame {
+    uint32_t due;
+    uint16_t type;
+    std::vector<uint8_t> data;
+  };
+
+  reader_type reader_{};
+  dentra::tion::TionCaptureWriter *capture_{};
+  std::vector<Frame> queue_;
+  uint32_t latency_{};
+  uint32_t jitter_{};
+  uint8_t drop_rate_{};
+  uint8_t corrupt_rate_{};
+  uint32_t seed_{1};
+  uint32_t sent_{};
+  uint32_t delivered_{};
+  uint32_t dropped_{};
+  uint32_t corrupted_{};
+
+  uint32_t random_();
+  bool chance_(uint8_t rate) { return rate != 0 && this->random_() % 100 < rate; }
+};
+
+/// Эмулятор бризера. Принимает запросы api и отвечает через TionEmuLink.
+class TionEmuDevice : public esphome::Component {
+ public:
+  /// Подключает эмулятор к api: запросы api направляются в эмулятор, ответы - в api.
+  template<class A> void attach(A *api) {
+    using writer_type = dentra::tion::TionApiWriter::writer_type;
+    api->set_writer(writer_type::create<TionEmuDevice, &TionEmuDevice::on_frame_>(*this));
+    this->link.set_reader(TionEmuLink::reader_type::create<A, &A::read_frame>(*api));
+  }
+
+  void loop() override { this->link.loop(); }
+
+  /// Запись трафика между api и эмулятором.
+  void set_capture(dentra::tion::TionCaptureWriter *capture) {
+    this->capture_ = capture;
+    this->link.set_capture(capture);
+  }
+
+  TionEmuLink link;
+
+  /// Количество полученных запросов.
+  uint32_t get_requests() const { return this->requests_; }
+
+ protected:
+  uint32_t requests_{};
+  dentra::tion::TionCaptureWriter *capture_{};
+
+  bool on_frame_(uint16_t type, const void *data, size_t size) {
+    this->requests_++;
+    if (this->capture_) {
+      this->capture_->tx(type, data, size);
+    }
+    this->on_frame(type, data, size);
+    return true;
+  }
+
+  virtual void on_frame(uint16_t type, const void *data, size_t size) = 0;
+};
+
+class Tion4sEmu : public TionEmuDevice {
+ public:
+  Tion4sEmu();
+  dentra::tion_4s::tion4s_state_t state{};
+  dentra::tion_4s::tion4s_turbo_t turbo{};
+
+ protected:
+  void on_frame(uint16_t type, const void *data, size_t size) override;
+  void send_state_(uint32_t request_id);
+};
+
+class Tion3sEmu : public TionEmuDevice {
+ public:
+  Tion3sEmu();
+  dentra::tion_3s::tion3s_state_t state{};
+
+ protected:
+  void on_frame(uint16_t type, const void *data, size_t size) override;
+};
+
+class TionO2Emu : public TionEmuDevice {
+ public:
+  TionO2Emu();
+  dentra::tion_o2::tiono2_state_t state{};
+
+ protected:
+  void on_frame(uint16_t type, const void *data, size_t size) override;
+};
+
+class TionLtEmu : public TionEmuDevice {
+ public:
+  TionLtEmu();
+  dentra::tion_lt::tionlt_state_t state{};
+
+ protected:
+  void on_frame(uint16_t type, const void *data, size_t size) override;
+  void send_state_(uint32_t request_id);
+};
@@ -0,0 +1,88 @@
+#include "../components/tion/tion_energy.h"
+
+#include "utils.h"
+
+DEFINE_TAG;
+
+using esphome::tion::TionEnergy;
+
+// Интегрирование мощности обогревателя и вентилятора по состояниям бризера.
+bool test_energy() {
+  bool res = true;
+
+  dentra::tion::TionTraits traits{};
+  traits.max_heater_power = 145;
+  traits.max_fan_power[0] = 150;
+  traits.max_fan_power[2] = 1500;
+
+  dentra::tion::TionState state{};
+  state.power_state = true;
+  state.heater_state = true;
+  state.fan_speed = 2;
+  state.outdoor_temperature = 0;
+  state.current_temperature = 18;
+  state.target_temperature = 20;
+
+  TionEnergy energy;
+  // час работы с обогревом, состояние каждые 10 секунд
+  uint32_t time = 1000;
+  for (int i = 0; i <= 360; i++, time += 10000) {
+    energy.add(time, state, traits);
+  }
+  res &= cloak::check_data("heater", uint32_t(energy.get(TionEnergy::COUNTER_HEATER)), 1450000u);
+  res &= cloak::check_data("fan speed 2", uint32_t(energy.get(TionEnergy::COUNTER_FAN_SPEED_2)), 15000u);
+
+  // пропуск состояний не учитывается
+  time += TionEnergy::MAX_GAP;
+  state.power_state = false;
+  energy.add(time, state, traits);
+  res &= cloak::check_data("gap", uint32_t(energy.get(TionEnergy::COUNTER_HEATER)), 1450000u);
+
+  // режим ожидания, остаток меньше 1 мВт*ч накапливается
+  for (int i = 0; i < 3600; i++) {
+    time += 1000;
+    energy.add(time, state, traits);
+  }
+  res &= cloak::check_data("standby", uint32_t(energy.get(TionEnergy::COUNTER_FAN_SPEED_0)), 1500u);
+  res &= cloak::check_data("not published", double(energy.get_published_total()), 0.0);
+
+  energy.snapshot();
+  res &= cloak::check_data("total", int32_t(energy.get_published_total() * 1000000 + 0.5f), 1466500);
+  res &= cloak::check_data("fan", int32_t(energy.get_published_fan() * 1000000 + 0.5f), 16500);
+
+  return res;
+}
+
+// Счетчики не переполняются после 4295 кВт*ч.
+bool test_energy_overflow() {
+  bool res = true;
+
+  dentra::tion::TionTraits traits{};
+  traits.max_heater_power = 145;
+
+  dentra::tion::TionState state{};
+  state.power_state = true;
+  state.heater_state = true;
+  state.fan_speed = 2;
+  state.outdoor_temperature = 0;
+  state.current_temperature = 18;
+  state.target_temperature = 20;
+
+  TionEnergy energy;
+  uint64_t counters[TionEnergy::COUNTERS]{};
+  counters[TionEnergy::COUNTER_HEATER] = UINT32_MAX;
+  energy.restore(counters);
+  // час работы обогревателя 1450 Вт
+  for (uint32_t time = 1000; time <= 1000 + 3600 * 1000; time += 10000) {
+    energy.add(time, state, traits);
+  }
+  res &= cloak::check_data("no wrap", energy.get(TionEnergy::COUNTER_HEATER) == uint64_t(UINT32_MAX) + 1450000, true);
+
+  energy.snapshot();
+  res &= cloak::check_data("published", int32_t(energy.get_published(TionEnergy::COUNTER_HEATER)), 4296);
+
+  return res;
+}
+
+REGISTER_TEST(test_energy);
+REGISTER_TEST(test_energy_overflow);
@@ -0,0 +1,116 @@
+#include <string>
+#include <vector>
+
+#include "../components/tion/tion_history.h"
+
+#include "utils.h"
+
+DEFINE_TAG;
+
+using esphome::tion::TionHistory;
+
+// Дельта-кодирование, вытеснение и прореживание истории состояний.
+bool test_history() {
+  bool res = true;
+
+  TionHistory history(nullptr);
+  res &= cloak::check_data("raw level", history.add_level(0, 64), true);
+  res &= cloak::check_data("minute level", history.add_level(60, 256), true);
+
+  dentra::tion::TionState state{};
+  state.power_state = true;
+  state.fan_speed = 2;
+  state.current_temperature = 20;
+  state.target_temperature = 21;
+  state.productivity = 50;
+  // наружная температура растет на 1 градус в минуту, состояние каждые 10 секунд
+  for (uint32_t time = 0; time < 600; time += 10) {
+    state.outdoor_temperature = -10 + time / 60;
+    history.add(time, state);
+  }
+
+  // в 64 байта помещаются только последние записи, базовый отсчет сдвигается при вытеснении
+  std::vector<uint32_t> times;
+  std::vector<int16_t> temps;
+  history.for_each(0, 0, UINT32_MAX, [&](const TionHistory::Sample &sample) {
+    times.push_back(sample.time);
+    temps.push_back(sample.values[TionHistory::FIELD_OUTDOOR_TEMPERATURE]);
+  });
+  res &= cloak::check_data("raw records", uint32_t(times.size()), history.get_level_records(0));
+  res &= cloak::check_data("raw last time", times.back(), 590u);
+  res &= cloak::check_data("raw first temp", int32_t(temps.front()), int32_t(-10 + times.front() / 60));
+  res &= cloak::check_data("raw last temp", int32_t(temps.back()), -1);
+
+  // последний неполный интервал еще не записан
+  res &= cloak::check_data("minute records", history.get_level_records(1), 9u);
+
+  esphome::test_set_millis(600 * 1000);
+  uint8_t blob[256];
+  const size_t blob_size = history.query(300, 1, blob, sizeof(blob));
+  TionHistory::Sample samples[16];
+  size_t count = 16;
+  res &= cloak::check_data("parse", TionHistory::parse(blob, blob_size, samples, count), true);
+  res &= cloak::check_data("query records", uint32_t(count), 4u);
+  res &= cloak::check_data("query first time", samples[0].time, 300u);
+  res &= cloak::check_data("query first temp", int32_t(samples[0].values[TionHistory::FIELD_OUTDOOR_TEMPERATURE]), -5);
+  res &= cloak::check_data("query flags", int32_t(samples[count - 1].values[TionHistory::FIELD_FLAGS]),
+                           int32_t(TionHistory::FLAG_POWER));
+  count = 16;
+  res &= cloak::check_data("parse truncated", TionHistory::parse(blob, blob_size - 1, samples, count), false);
+  count = 2;
+  res &= cloak::check_data("parse overflow", TionHistory::parse(blob, blob_size, samples, count), false);
+
+#ifndef TION_NO_HEAP
+  res &= cloak::check_data("query vector",
+                           history.query(300, 1) == std::vector<uint8_t>(blob, blob + blob_size), true);
+#endif
+
+  // в маленький буфер помещаются только целые записи
+  const size_t small_size = history.query(300, 1, blob, TionHistory::HEADER_SIZE + 3);
+  count = 16;
+  res &= cloak::check_data("small parse", TionHistory::parse(blob, small_size, samples, count), true);
+  res &= cloak::check_data("small records", uint32_t(count) < 4, true);
+  res &= cloak::check_data("no header", uint32_t(history.query(300, 1, blob, TionHistory::HEADER_SIZE - 1)), 0u);
+
+  char json[512];
+  history.query_json(120, 1, json, sizeof(json));
+  const std::string json_str(json);
+  res &= cloak::check_data("json data", json_str.substr(json_str.find("\"data\"")),
+                           std::string("\"data\":[[480,1,2,0,-2,20,21,50,0]]}"));
+
+#ifndef TION_NO_HEAP
+  res &= cloak::check_data("json string", history.query_json(120, 1), json_str);
+#endif
+
+  // запись не помещается, JSON остается корректным
+  const size_t json_size = history.query_json(120, 1, json, json_str.size() - 1);
+  res &= cloak::check_data("json truncated", std::string(json, json_size),
+                           json_str.substr(0, json_str.find("\"data\"")) + "\"data\":[]}");
+
+  return res;
+}
+
+// Время истории не переполняется вместе с millis().
+bool test_history_uptime() {
+  bool res = true;
+
+  TionHistory history(nullptr);
+  history.add_level(0, 64);
+  dentra::tion::TionState state{};
+
+  esphome::test_set_millis(UINT32_MAX - 999);
+  const uint32_t before = history.get_uptime();
+  history.on_tion_state(&state);
+  esphome::test_set_millis(9000);
+  history.on_tion_state(&state);
+  res &= cloak::check_data("after wrap", history.get_uptime(), before + 10);
+
+  std::vector<uint32_t> times;
+  history.for_each(0, 0, UINT32_MAX, [&](const TionHistory::Sample &sample) { times.push_back(sample.time); });
+  res &= cloak::check_data("wrap records", times == (std::vector<uint32_t>{before, before + 10}), true);
+
+  return res;
+}
+
+REGISTER_TEST(test_history);
+REGISTER_TEST(test_history_uptime);
@@ -0,0 +1,182 @@
+#include <cerrno>
+#include <cstdint>
+#include <vector>
+
+#include "esphome/components/socket/socket.h"
+
+#include "../components/tion/tion_mirror.h"
+
+#include "utils.h"
+
+DEFINE_TAG;
+
+#ifdef TION_ENABLE_MIRROR
+
+using dentra::tion::TionCapture;
+using dentra::tion::TionCaptureReader;
+using esphome::tion::TionMirror;
+
+namespace {
+struct MirrorTest {
+  TionMirror mirror;
+  esphome::socket::TestSockets &sockets = esphome::socket::test_sockets();
+
+  MirrorTest(size_t size, TionMirror::Protocol protocol) : mirror(size, TionCapture::DEVICE_4S) {
+    this->sockets.reset();
+    this->mirror.set_address("127.0.0.1", 9000);
+    this->mirror.set_protocol(protocol);
+  }
+
+  // количество записей, false если поток поврежден или обрывается внутри записи
+  static bool parse(const std::vector<uint8_t> &data, std::vector<uint16_t> &types) {
+    TionCaptureReader reader(data.data(), data.size());
+    if (!reader.is_valid() || reader.get_device() != TionCapture::DEVICE_4S) {
+      return false;
+    }
+    TionCapture::Record rec;
+    while (reader.next(rec)) {
+      types.push_back(rec.type);
+    }
+    return reader.is_eof();
+  }
+};
+
+const uint8_t FRAME[] = {1, 2, 3, 4};
+}  // namespace
+
+// Поток TCP: заголовок, целые записи, частичная запись и переподключение.
+bool test_mirror_tcp() {
+  bool res = true;
+
+  esphome::test_set_millis(1000);
+  MirrorTest t(256, TionMirror::PROTOCOL_TCP);
+  auto &mirror = t.mirror;
+  auto &sockets = t.sockets;
+
+  // без сети подключение не выполняется
+  sockets.disconnected = true;
+  mirror.loop();
+  res &= cloak::check_data("no network", sockets.created, 0u);
+  sockets.disconnected = false;
+
+  mirror.loop();
+  res &= cloak::check_data("connected", sockets.created, 1u);
+  res &= cloak::check_data("tcp", sockets.type == SOCK_STREAM, true);
+  res &= cloak::check_data("header", uint32_t(sockets.test_data().size()), uint32_t(TionCapture::HEADER_SIZE));
+
+  // запись блоками по 3 байта, поток не разрывается
+  sockets.write_limit = 3;
+  mirror.tx(0x3230, FRAME, sizeof(FRAME));
+  mirror.rx(0x3231, FRAME, sizeof(FRAME));
+  for (int i = 0; i < 10; i++) {
+    mirror.loop();
+  }
+  std::vector<uint16_t> types;
+  res &= cloak::check_data("stream", MirrorTest::parse(sockets.test_data(), types), true);
+  res &= cloak::check_data("records", types == (std::vector<uint16_t>{0x3230, 0x3231}), true);
+  res &= cloak::check_data("sent", mirror.get_sent(), uint32_t(sockets.test_data().size()));
+
+  // канал занят, данные сохраняются до освобождения
+  sockets.write_limit = 0;
+  sockets.write_errno = EAGAIN;
+  mirror.tx(0x3232, FRAME, sizeof(FRAME));
+  mirror.loop();
+  res &= cloak::check_data("would block", sockets.closed, 0u);
+  res &= cloak::check_data("kept", mirror.used() != 0, true);
+
+  // разрыв соединения, переподключение не ранее RECONNECT_INTERVAL
+  sockets.write_errno = ECONNRESET;
+  mirror.loop();
+  res &= cloak::check_data("closed", sockets.closed, 1u);
+  sockets.write_errno = 0;
+  mirror.loop();
+  res &= cloak::check_data("reconnect interval", sockets.created, 1u);
+
+  sockets.test_data_clear();
+  esphome::test_set_millis(1000 + TionMirror::RECONNECT_INTERVAL);
+  mirror.loop();
+  res &= cloak::check_data("reconnected", sockets.created, 2u);
+  // новый поток начинается с заголовка, данные разорванного потока отброшены
+  mirror.rx(0x3233, FRAME, sizeof(FRAME));
+  mirror.loop();
+  types.clear();
+  res &= cloak::check_data("new stream", MirrorTest::parse(sockets.test_data(), types), true);
+  res &= cloak::check_data("new records", types == std::vector<uint16_t>{0x3233}, true);
+
+  return res;
+}
+
+// Переполнение буфера при медленном приемнике: новые записи отбрасываются целиком.
+bool test_mirror_overflow() {
+  bool res = true;
+
+  esphome::test_set_millis(1000);
+  MirrorTest t(32, TionMirror::PROTOCOL_TCP);
+  auto &mirror = t.mirror;
+  auto &sockets = t.sockets;
+
+  mirror.loop();
+  sockets.write_errno = EAGAIN;
+  for (uint16_t type = 0x3230; type < 0x3230 + 8; type++) {
+    mirror.tx(type, FRAME, sizeof(FRAME));
+    mirror.loop();
+  }
+  res &= cloak::check_data("dropped", mirror.get_dropped() != 0, true);
+
+  sockets.write_errno = 0;
+  mirror.loop();
+  std::vector<uint16_t> types;
+  res &= cloak::check_data("whole records", MirrorTest::parse(sockets.test_data(), types), true);
+  res &= cloak::check_data("oldest kept", !types.empty() && types[0] == 0x3230, true);
+  res &= cloak::check_data("all accounted", uint32_t(types.size()) + mirror.get_dropped(), 8u);
+
+  return res;
+}
+
+// Датаграммы UDP: заголовок и целое количество записей в каждой.
+bool test_mirror_udp() {
+  bool res = true;
+
+  esphome::test_set_millis(1000);
+  MirrorTest t(4096, TionMirror::PROTOCOL_UDP);
+  auto &mirror = t.mirror;
+  auto &sockets = t.sockets;
+
+  mirror.loop();
+  res &= cloak::check_data("udp", sockets.type == SOCK_DGRAM, true);
+  res &= cloak::check_data("nothing to send", sockets.writes, 0u);
+
+  mirror.tx(0x3230, FRAME, sizeof(FRAME));
+  mirror.rx(0x3231, FRAME, sizeof(FRAME));
+  mirror.loop();
+  std::vector<uint16_t> types;
+  res &= cloak::check_data("datagram", MirrorTest::parse(sockets.test_data(), types), true);
+  res &= cloak::check_data("datagram records", types == (std::vector<uint16_t>{0x3230, 0x3231}), true);
+
+  // записи, не помещающиеся в одну датаграмму, уходят следующей
+  const std::vector<uint8_t> big(1000, 0x55);
+  mirror.tx(0x3232, big.data(), big.size());
+  mirror.tx(0x3233, big.data(), big.size());
+  for (int i = 0; i < 2; i++) {
+    sockets.test_data_clear();
+    mirror.loop();
+    types.clear();
+    res &= cloak::check_data("split datagram", MirrorTest::parse(sockets.test_data(), types), true);
+    res &= cloak::check_data("split records", types == std::vector<uint16_t>{uint16_t(0x3232 + i)}, true);
+  }
+
+  // запись больше датаграммы отбрасывается
+  const std::vector<uint8_t> huge(TionMirror::MAX_WRITE_SIZE, 0xAA);
+  mirror.tx(0x3234, huge.data(), huge.size());
+  mirror.loop();
+  res &= cloak::check_data("too large dropped", mirror.get_dropped(), 1u);
+  res &= cloak::check_data("empty", uint32_t(mirror.used()), 0u);
+
+  return res;
+}
+
+REGISTER_TEST(test_mirror_tcp);
+REGISTER_TEST(test_mirror_overflow);
+REGISTER_TEST(test_mirror_udp);
+
+#endif  // TION_ENABLE_MIRROR
@@ -0,0 +1,144 @@
+#include <cstdlib>
+#include <new>
+
+#include "../components/tion-api/tion-api-3s.h"
+#include "../components/tion-api/tion-api-3s-internal.h"
+#include "../components/tion-api/tion-api-4s.h"
+#include "../components/tion-api/tion-api-ble-lt.h"
+#include "../components/tion-api/tion-api-lt-internal.h"
+#include "../components/tion-api/tion-api-uart-lt.h"
+
+#include "test_emu.h"
+#include "utils.h"
+
+DEFINE_TAG;
+
+#ifdef TION_NO_HEAP
+
+namespace {
+bool heap_check_enabled;
+size_t heap_allocs;
+}  // namespace
+
+// в сборке TION_NO_HEAP проверяемые участки не должны выделять память в куче
+void *operator new(size_t size) {
+  if (heap_check_enabled) {
+    heap_allocs++;
+  }
+  if (void *p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+class HeapCheck {
+ public:
+  HeapCheck() {
+    heap_allocs = 0;
+    heap_check_enabled = true;
+  }
+  ~HeapCheck() { heap_check_enabled = false; }
+  size_t allocs() const { return heap_allocs; }
+};
+
+bool test_no_heap_presets() {
+  bool res = true;
+
+  dentra::tion_4s::Tion4sApi api;
+  dentra::tion::TionStateCall call(&api);
+
+  HeapCheck check;
+  api.add_preset("home", {.target_temperature = 20, .heater_state = 1, .power_state = 1, .fan_speed = 2});
+  api.add_preset("away", {.target_temperature = 10, .heater_state = 0, .power_state = 1, .fan_speed = 1});
+  const auto presets = api.get_presets();
+  api.enable_preset("home", &call);
+  const auto preset = api.get_preset("away");
+  api.set_auto_update_func([](uint16_t current) -> uint8_t { return current > 800 ? 3 : 1; });
+  dentra::tion_4s::tion4s_state_t::report_errors(0x0301);
+
+  res &= cloak::check_data("allocs", uint32_t(check.allocs()), 0u);
+  res &= cloak::check_data("presets", uint32_t(presets.size()), 3u);
+  res &= cloak::check_data("presets order", std::string(presets[0]) + presets[1] + presets[2],
+                           std::string("awayhomenone"));
+  res &= cloak::check_data("active preset", std::string(api.get_active_preset()), std::string("home"));
+  res &= cloak::check_data("preset", preset.fan_speed, 1);
+
+  return res;
+}
+
+bool test_no_heap_lt() {
+  bool res = true;
+
+  dentra::tion::TionLtBleProtocol ble(false);
+  dentra::tion_lt::TionLtUartProtocol uart;
+  size_t frames = 0;
+  auto reader = [&frames](const dentra::tion::TionLtBleProtocol::frame_spec_type &, size_t) { frames++; };
+  ble.reader = reader;
+  size_t writes = 0;
+  auto writer = [&writes](const uint8_t *, size_t) {
+    writes++;
+    return true;
+  };
+  uart.writer = writer;
+
+  // кадр 24 байта: size, magic, random, type, request_id, 12 байт данных, crc. FRST, CURR, LAST
+  const uint8_t frst[] = {0x00, 0x18, 0x00, 0x3A, 0xAD, 0x10, 0x12, 0x01, 0x00, 0x00, 0x00};
+  const uint8_t curr[] = {0x40, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A};
+  const uint8_t last[] = {0xC0, 0x0B, 0x0C, 0x00, 0x00};
+
+  dentra::tion::TionState state{};
+  state.fan_speed = 3;
+  state.target_temperature = 18;
+  const dentra::tion_lt::tionlt_state_set_req_t set(state, {}, 1);
+
+  HeapCheck check;
+  ble.read_data(frst, sizeof(frst));
+  ble.read_data(curr, sizeof(curr));
+  ble.read_data(last, sizeof(last));
+  uart.write_frame(dentra::tion_lt::FRAME_TYPE_STATE_SET, &set, sizeof(set));
+
+  res &= cloak::check_data("allocs", uint32_t(check.allocs()), 0u);
+  res &= cloak::check_data("frames", uint32_t(frames), 1u);
+  res &= cloak::check_data("writes", uint32_t(writes), 2u);
+
+  return res;
+}
+
+// отмена турбо-режима и антизамерзание при получении состояния
+bool test_no_heap_state() {
+  bool res = true;
+
+  using namespace dentra::tion_3s;
+
+  dentra::tion::Tion3sApi api;
+  Tion3sEmu emu;
+  emu.state.flags.power_state = true;
+  api.read_frame(FRAME_TYPE_RSP(FRAME_TYPE_STATE_GET), &emu.state, sizeof(emu.state));
+
+  dentra::tion::TionStateCall call(&api);
+  api.enable_boost(true, &call);
+  call.perform();
+  api.flush_write();
+
+  // скорость изменена кнопками бризера, на улице мороз
+  emu.state.fan_speed = 2;
+  emu.state.outdoor_temperature = -5;
+
+  HeapCheck check;
+  api.read_frame(FRAME_TYPE_RSP(FRAME_TYPE_STATE_GET), &emu.state, sizeof(emu.state));
+
+  res &= cloak::check_data("allocs", uint32_t(check.allocs()), 0u);
+  res &= cloak::check_data("boost canceled", uint32_t(api.get_state().boost_time_left), 0u);
+  res &= cloak::check_data("written", api.write_slot().has_pending(), true);
+  res &= cloak::check_data("antifreeze", api.write_slot().get_base(api.get_state()).heater_state, true);
+
+  return res;
+}
+
+REGISTER_TEST(test_no_heap_presets);
+REGISTER_TEST(test_no_heap_lt);
+REGISTER_TEST(test_no_heap_state);
+
+#endif  // TION_NO_HEAP
@@ -0,0 +1,230 @@
+#include <cstring>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "esphome/core/preferences.h"
+
+#include "../components/tion-api/tion-api-4s-internal.h"
+#include "../components/tion_4s_uart/tion_4s_uart_vport.h"
+#include "../components/tion/tion_component.h"
+#include "../components/tion/tion_persist.h"
+
+#include "utils.h"
+
+DEFINE_TAG;
+
+using esphome::tion::TionPersist;
+
+namespace {
+
+// Настройки в памяти, в отличие от настроек cloak сохраненные данные можно прочитать.
+class MemPrefs : public esphome::ESPPreferences {
+  class Backend : public esphome::ESPPreferenceBackend {
+   public:
+    explicit Backend(std::vector<uint8_t> *data) : data_(data) {}
+    bool save(const uint8_t *data, size_t len) override {
+      this->data_->assign(data, data + len);
+      return true;
+    }
+    bool load(uint8_t *data, size_t len) override {
+      if (this->data_->size() != len) {
+        return false;
+      }
+      std::memcpy(data, this->data_->data(), len);
+      return true;
+    }
+
+   protected:
+    std::vector<uint8_t> *data_;
+  };
+
+ public:
+  MemPrefs() : prev_(esphome::global_preferences) { esphome::global_preferences = this; }
+  ~MemPrefs() { esphome::global_preferences = this->prev_; }
+
+  esphome::ESPPreferenceObject make_preference(size_t length, uint32_t type, bool in_flash) override {
+    return this->make_preference(length, type);
+  }
+  esphome::ESPPreferenceObject make_preference(size_t length, uint32_t type) override {
+    this->backends_.emplace_back(&this->data_[type]);
+    return esphome::ESPPreferenceObject(&this->backends_.back());
+  }
+  bool sync() override {
+    this->syncs++;
+    return true;
+  }
+  bool reset() override { return true; }
+
+  TionPersist::Data *data() {
+    auto &data = this->data_.begin()->second;
+    return data.size() == sizeof(TionPersist::Data) ? reinterpret_cast<TionPersist::Data *>(data.data()) : nullptr;
+  }
+
+  int syncs{};
+
+ protected:
+  esphome::ESPPreferences *prev_;
+  std::map<uint32_t, std::vector<uint8_t>> data_;
+  std::list<Backend> backends_;
+};
+
+struct AirflowVPort {
+  uint32_t airflow_counter{};
+  void restore_airflow_counter(uint32_t airflow_counter, uint32_t fan_time) {
+    this->airflow_counter = airflow_counter;
+  }
+};
+
+struct PersistTest {
+  using Api =
+      esphome::tion::TionVPortApi<esphome::tion::Tion4sUartIO::frame_spec_type, dentra::tion_4s::Tion4sApi>;
+
+  esphome::uart::UARTComponent uart;
+  esphome::tion::Tion4sUartIO io{&uart};
+  esphome::tion::Tion4sUartVPort vport{&io};
+  Api api{&vport};
+  esphome::tion::Tion4sApiComponent capi{&api, vport.get_type()};
+  AirflowVPort avp;
+  TionPersist persist{&capi};
+
+  PersistTest() { this->persist.set_vport(&this->avp); }
+
+  // состояние бризера, как при получении ответа, TionPersist получает его через TionApiComponent
+  void set_airflow_counter(uint32_t airflow_counter) {
+    dentra::tion_4s::tion4s_raw_frame_t<dentra::tion_4s::tion4s_state_t> rsp{};
+    rsp.request_id = 1;
+    rsp.data.fan_speed = 1;
+    rsp.data.counters.airflow_counter = airflow_counter;
+    this->api.read_frame(dentra::tion_4s::FRAME_TYPE_STATE_RSP, &rsp, sizeof(rsp));
+  }
+};
+
+constexpr uint32_t ONE_HOUR = 60 * 60 * 1000;
+
+}  // namespace
+
+// Бюджет записей: 24 в сутки (одна в час), до 3 подряд, одна всегда в резерве для турбо-режима.
+bool test_persist_budget() {
+  bool res = true;
+
+  MemPrefs prefs;
+  PersistTest t;
+  auto &persist = t.persist;
+
+  esphome::test_set_millis(1000);
+  persist.setup();
+
+  dentra::tion::TionState state{};
+  state.airflow_counter = 1;
+  persist.on_tion_state(&state);
+  res &= cloak::check_data("initial budget is reserved", persist.get_writes(), 0u);
+
+  esphome::test_set_millis(1000 + ONE_HOUR);
+  persist.on_tion_state(&state);
+  res &= cloak::check_data("write after an hour", persist.get_writes(), 1u);
+
+  state.airflow_counter = 2;
+  persist.on_tion_state(&state);
+  res &= cloak::check_data("no budget", persist.get_writes(), 1u);
+
+  // бюджет ограничен burst записями
+  esphome::test_set_millis(1000 + 10 * 24 * ONE_HOUR);
+  for (uint32_t i = 3; i < 6; i++) {
+    state.airflow_counter = i;
+    persist.on_tion_state(&state);
+  }
+  res &= cloak::check_data("burst", persist.get_writes(), 3u);
+
+  // турбо-режим использует резервную запись
+  state.boost_time_left = 100;
+  persist.on_tion_state(&state);
+  res &= cloak::check_data("boost uses reserve", persist.get_writes(), 4u);
+
+  state.boost_time_left = 0;
+  persist.on_tion_state(&state);
+  res &= cloak::check_data("budget is empty", persist.get_writes(), 4u);
+
+  return res;
+}
+
+// Отложенные изменения записываются при выключении без учета бюджета.
+bool test_persist_shutdown() {
+  bool res = true;
+
+  MemPrefs prefs;
+  PersistTest t;
+  auto &persist = t.persist;
+
+  esphome::test_set_millis(1000);
+  persist.setup();
+
+  persist.on_shutdown();
+  res &= cloak::check_data("nothing to save", persist.get_writes(), 0u);
+  res &= cloak::check_data("no sync", prefs.syncs, 0);
+
+  t.set_airflow_counter(42);
+  res &= cloak::check_data("deferred", persist.get_writes(), 0u);
+
+  persist.on_shutdown();
+  res &= cloak::check_data("saved on shutdown", persist.get_writes(), 1u);
+  res &= cloak::check_data("sync", prefs.syncs, 1);
+  res &= cloak::check_data("saved data", prefs.data() != nullptr, true);
+  if (prefs.data()) {
+    res &= cloak::check_data("saved airflow_counter", prefs.data()->airflow_counter, 42u);
+  }
+
+  return res;
+}
+
+// Восстановление отбрасывает данные с неверной CRC или версией.
+bool test_persist_restore() {
+  bool res = true;
+
+  MemPrefs prefs;
+  {
+    PersistTest t;
+    t.persist.setup();
+    t.set_airflow_counter(42);
+    t.persist.on_shutdown();
+  }
+
+  auto restore = []() {
+    PersistTest t;
+    t.persist.setup();
+    return t.avp.airflow_counter;
+  };
+
+  res &= cloak::check_data("restore", restore(), 42u);
+
+  auto *data = prefs.data();
+  res &= cloak::check_data("saved data", data != nullptr, true);
+  if (data == nullptr) {
+    return res;
+  }
+
+  data->airflow_counter = 43;
+  res &= cloak::check_data("bad crc", restore(), 0u);
+
+  // флаги покрыты CRC
+  data->airflow_counter = 42;
+  data->flags ^= TionPersist::FLAG_BOOST;
+  res &= cloak::check_data("bad flags", restore(), 0u);
+  data->flags ^= TionPersist::FLAG_BOOST;
+  res &= cloak::check_data("restored flags", restore(), 42u);
+  data->airflow_counter = 43;
+
+  data->version = TionPersist::VERSION - 1;
+  data->crc = TionPersist::calc_crc(*data);
+  res &= cloak::check_data("bad version", restore(), 0u);
+
+  data->version = TionPersist::VERSION;
+  data->crc = TionPersist::calc_crc(*data);
+  res &= cloak::check_data("fixed", restore(), 43u);
+
+  return res;
+}
+
+REGISTER_TEST(test_persist_budget);
+REGISTER_TEST(test_persist_shutdown);
+REGISTER_TEST(test_persist_restore);
@@ -0,0 +1,82 @@
+#include "../components/tion/tion_properties.h"
+
+#include "utils.h"
+
+DEFINE_TAG;
+
+using esphome::tion::property_controller::PublishFilter;
+
+bool test_publish_filter_deadband() {
+  bool res = true;
+
+  esphome::test_set_millis(1000);
+
+  PublishFilter pf;
+  pf.set_deadband(0.5f);
+
+  res &= cloak::check_data("no state", pf.check_publish(false, false, 0, false), true);
+  res &= cloak::check_data("unchanged", pf.check_publish(true, false, 0, false), false);
+  res &= cloak::check_data("small delta", pf.check_publish(true, true, 0.3f, false), false);
+  res &= cloak::check_data("small negative delta", pf.check_publish(true, true, -0.3f, false), false);
+  res &= cloak::check_data("delta", pf.check_publish(true, true, 0.5f, false), true);
+  res &= cloak::check_data("negative delta", pf.check_publish(true, true, -0.6f, false), true);
+  res &= cloak::check_data("force small delta", pf.check_publish(true, true, 0.1f, true), true);
+
+  return res;
+}
+
+bool test_publish_filter_min_interval() {
+  bool res = true;
+
+  esphome::test_set_millis(1000);
+
+  PublishFilter pf;
+  pf.set_min_interval(5000);
+
+  res &= cloak::check_data("no state", pf.check_publish(false, true, 1, false), true);
+
+  esphome::test_set_millis(3000);
+  res &= cloak::check_data("changed in interval", pf.check_publish(true, true, 1, false), false);
+  // force_update не отменяет min_interval
+  res &= cloak::check_data("force in interval", pf.check_publish(true, true, 0, true), false);
+
+  esphome::test_set_millis(6000);
+  res &= cloak::check_data("unchanged after interval", pf.check_publish(true, false, 0, false), false);
+  res &= cloak::check_data("changed after interval", pf.check_publish(true, true, 1, false), true);
+
+  esphome::test_set_millis(7000);
+  res &= cloak::check_data("changed in next interval", pf.check_publish(true, true, 1, false), false);
+
+  esphome::test_set_millis(11000);
+  res &= cloak::check_data("force after interval", pf.check_publish(true, true, 0, true), true);
+
+  return res;
+}
+
+bool test_publish_filter_heartbeat() {
+  bool res = true;
+
+  esphome::test_set_millis(1000);
+
+  PublishFilter pf;
+  pf.set_deadband(1);
+  pf.set_min_interval(5000);
+  pf.set_heartbeat(60000);
+
+  res &= cloak::check_data("no state", pf.check_publish(false, false, 0, false), true);
+
+  esphome::test_set_millis(60999);
+  res &= cloak::check_data("before heartbeat", pf.check_publish(true, true, 0.1f, false), false);
+
+  esphome::test_set_millis(61000);
+  res &= cloak::check_data("heartbeat", pf.check_publish(true, false, 0, false), true);
+
+  esphome::test_set_millis(62000);
+  res &= cloak::check_data("after heartbeat", pf.check_publish(true, false, 0, false), false);
+
+  return res;
+}
+
+REGISTER_TEST(test_publish_filter_deadband);
+REGISTER_TEST(test_publish_filter_min_interval);
+REGISTER_TEST(test_publish_filter_heartbeat);
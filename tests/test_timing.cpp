@@ -0,0 +1,44 @@
+#include "../components/tion/tion_timing.h"
+
+#include "utils.h"
+
+DEFINE_TAG;
+
+#ifdef TION_ENABLE_TIMING
+
+using esphome::tion::TionTiming;
+
+// Максимум, процентиль и худший кадр за окно измерения.
+bool test_timing() {
+  bool res = true;
+
+  TionTiming timing;
+  // 99 быстрых кадров по 100 мкс и один медленный
+  for (uint16_t i = 0; i < 99; i++) {
+    esphome::test_set_micros(0);
+    TION_TIMING_SCOPE(&timing, SECTION_FRAME, 0x3232);
+    esphome::test_set_micros(100);
+  }
+  timing.add(TionTiming::SECTION_FRAME, 5000, 0x3233);
+  timing.add(TionTiming::SECTION_LOOP, 10);
+  timing.snapshot();
+
+  const auto &frame = timing.get(TionTiming::SECTION_FRAME);
+  res &= cloak::check_data("frame count", frame.count, 100u);
+  res &= cloak::check_data("frame max", frame.max, 5000u);
+  // 100 мкс попадает в интервал 96..127
+  res &= cloak::check_data("frame p99", frame.p99, 127u);
+  res &= cloak::check_data("worst frame", uint32_t(timing.get_worst_frame_type()), 0x3233u);
+  res &= cloak::check_data("loop p99", timing.get(TionTiming::SECTION_LOOP).p99, 10u);
+
+  // новое окно начинается с нуля
+  timing.snapshot();
+  res &= cloak::check_data("reset count", timing.get(TionTiming::SECTION_FRAME).count, 0u);
+  res &= cloak::check_data("reset p99", timing.get(TionTiming::SECTION_FRAME).p99, 0u);
+
+  return res;
+}
+
+REGISTER_TEST(test_timing);
+
+#endif  // TION_ENABLE_TIMING